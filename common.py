@@ -74,6 +74,7 @@ def get_sources(env, is_editor_build):
         "storage/*.cpp",
         "storage/metadata/*.cpp",
 
+        "generators/generate_block_batch_task.cpp",
         "generators/generate_block_task.cpp",
         "generators/voxel_generator_script.cpp",
         "generators/voxel_generator.cpp",
@@ -193,6 +194,7 @@ def get_sources(env, is_editor_build):
             "tests/voxel/test_octree.cpp",
             "tests/voxel/test_raycast.cpp",
             "tests/voxel/test_region_file.cpp",
+            "tests/voxel/test_session_trace.cpp",
             "tests/voxel/test_storage_funcs.cpp",
             "tests/voxel/test_util.cpp",
             "tests/voxel/test_voxel_buffer.cpp",
@@ -200,6 +202,8 @@ def get_sources(env, is_editor_build):
             "tests/voxel/test_voxel_graph.cpp",
             "tests/voxel/test_voxel_instancer.cpp",
             "tests/voxel/test_voxel_mesher_cubes.cpp",
+            "tests/voxel/test_voxel_terrain.cpp",
+            "tests/voxel/test_voxel_terrain_multiplayer_synchronizer.cpp",
         ]
 
     if smoosh_meshing_enabled:
@@ -1,4 +1,5 @@
 #include "voxel_tool.h"
+#include "../engine/voxel_engine.h"
 #include "../storage/voxel_buffer_gd.h"
 #include "../storage/voxel_data.h"
 #include "../util/godot/core/packed_arrays.h"
@@ -413,6 +414,10 @@ void VoxelTool::_post_edit(const Box3i &box) {
 	ERR_PRINT("Not implemented");
 }
 
+bool VoxelTool::_get_edited_volume_id(VolumeID &out_id) const {
+	return false;
+}
+
 void VoxelTool::set_voxel_metadata(Vector3i pos, Variant meta) {
 	ERR_PRINT("Not implemented");
 }
@@ -516,10 +521,12 @@ float VoxelTool::_b_get_voxel_f(Vector3i pos) {
 }
 
 void VoxelTool::_b_set_voxel(Vector3i pos, uint64_t v) {
+	record_edit(SessionTrace::EDIT_SET_VOXEL, to_vec3f(pos), Vector3i(), 0.f);
 	set_voxel(pos, v);
 }
 
 void VoxelTool::_b_set_voxel_f(Vector3i pos, float v) {
+	record_edit(SessionTrace::EDIT_SET_VOXEL_F, to_vec3f(pos), Vector3i(), v);
 	set_voxel_f(pos, v);
 }
 
@@ -528,14 +535,17 @@ Ref<VoxelRaycastResult> VoxelTool::_b_raycast(Vector3 pos, Vector3 dir, float ma
 }
 
 void VoxelTool::_b_do_point(Vector3i pos) {
+	record_edit(SessionTrace::EDIT_POINT, to_vec3f(pos), Vector3i(), 0.f);
 	do_point(pos);
 }
 
 void VoxelTool::_b_do_sphere(Vector3 pos, float radius) {
+	record_edit(SessionTrace::EDIT_SPHERE, to_vec3f(pos), Vector3i(), radius);
 	do_sphere(pos, radius);
 }
 
 void VoxelTool::_b_do_box(Vector3i begin, Vector3i end) {
+	record_edit(SessionTrace::EDIT_BOX, to_vec3f(begin), end, 0.f);
 	do_box(begin, end);
 }
 
@@ -634,6 +644,29 @@ godot::VoxelBuffer::ChannelId VoxelTool::_b_get_channel() const {
 	return godot::VoxelBuffer::ChannelId(get_channel());
 }
 
+void VoxelTool::record_edit(SessionTrace::EditType type, Vector3f position, Vector3i end, float param) {
+	SessionRecorder &recorder = VoxelEngine::get_singleton().get_session_recorder();
+	if (!recorder.is_recording()) {
+		return;
+	}
+	VolumeID volume_id;
+	if (!_get_edited_volume_id(volume_id)) {
+		return;
+	}
+	SessionTrace::Edit edit;
+	edit.type = type;
+	edit.mode = _mode;
+	edit.channel = _channel;
+	edit.value = _value;
+	edit.eraser_value = _eraser_value;
+	edit.sdf_scale = _sdf_scale;
+	edit.sdf_strength = _sdf_strength;
+	edit.position = position;
+	edit.end = end;
+	edit.param = param;
+	recorder.record_edit(volume_id, edit);
+}
+
 void VoxelTool::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("set_value", "v"), &VoxelTool::set_value);
 	ClassDB::bind_method(D_METHOD("get_value"), &VoxelTool::get_value);
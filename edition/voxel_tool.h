@@ -1,6 +1,8 @@
 #ifndef VOXEL_TOOL_H
 #define VOXEL_TOOL_H
 
+#include "../engine/ids.h"
+#include "../engine/session_trace.h"
 #include "../storage/funcs.h"
 #include "../storage/voxel_buffer_gd.h"
 #include "../storage/voxel_format.h"
@@ -133,6 +135,9 @@ protected:
 	virtual void _set_voxel_f(Vector3i pos, float v);
 	virtual void _post_edit(const Box3i &box);
 
+	// Gets which volume of `VoxelEngine` the tool edits, if any. Used to record sessions.
+	virtual bool _get_edited_volume_id(VolumeID &out_id) const;
+
 #ifdef VOXEL_ENABLE_MESH_SDF
 	void do_mesh_chunked(
 			const VoxelMeshSDF &mesh_sdf,
@@ -175,6 +180,8 @@ private:
 
 	godot::VoxelBuffer::ChannelId _b_get_channel() const;
 
+	void record_edit(SessionTrace::EditType type, Vector3f position, Vector3i end, float param);
+
 protected:
 	uint64_t _value = 0;
 	uint64_t _eraser_value = 0; // air
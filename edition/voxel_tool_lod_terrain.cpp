@@ -299,6 +299,14 @@ void VoxelToolLodTerrain::_post_edit(const Box3i &box) {
 	_terrain->post_edit_area(box, true);
 }
 
+bool VoxelToolLodTerrain::_get_edited_volume_id(VolumeID &out_id) const {
+	if (_terrain == nullptr) {
+		return false;
+	}
+	out_id = _terrain->get_volume_id();
+	return true;
+}
+
 int VoxelToolLodTerrain::get_raycast_binary_search_iterations() const {
 	return _raycast_binary_search_iterations;
 }
@@ -244,6 +244,14 @@ void VoxelToolTerrain::_post_edit(const Box3i &box) {
 	_terrain->post_edit_area(box, true);
 }
 
+bool VoxelToolTerrain::_get_edited_volume_id(VolumeID &out_id) const {
+	if (_terrain == nullptr) {
+		return false;
+	}
+	out_id = _terrain->get_volume_id();
+	return true;
+}
+
 void VoxelToolTerrain::set_voxel_metadata(Vector3i pos, Variant meta) {
 	ERR_FAIL_COND(_terrain == nullptr);
 	VoxelData &data = _terrain->get_storage();
@@ -70,6 +70,7 @@ protected:
 	void _set_voxel(Vector3i pos, uint64_t v) override;
 	void _set_voxel_f(Vector3i pos, float v) override;
 	void _post_edit(const Box3i &box) override;
+	bool _get_edited_volume_id(VolumeID &out_id) const override;
 
 private:
 	static void _bind_methods();
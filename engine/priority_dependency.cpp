@@ -4,26 +4,93 @@
 
 namespace zylann::voxel {
 
+namespace {
+
+inline uint8_t get_distance_band(const int distance, const uint8_t lod_index) {
+	// Closer is higher priority. Decreases over distance.
+	// Scaled by LOD because we segment priority by LOD too in band 1.
+	return math::max(TaskPriority::BAND_MAX - math::arithmetic_rshift(distance, 4 + lod_index), 0);
+}
+
+inline int to_distance_int(const float distance) {
+	// Clamping because distances are not bounded when viewers move far away
+	return static_cast<int>(math::min(distance, 1'000'000'000.f));
+}
+
+} // namespace
+
+bool PriorityDependency::can_reuse_cached_distance(
+		const uint8_t lod_index,
+		const bool check_drop_distance,
+		const double travelled_distance,
+		const uint32_t viewers_version
+) const {
+	if (_cached_closest_distance_sq < 0.f || _cached_viewers_version != viewers_version) {
+		return false;
+	}
+
+	// Viewers moved by at most this much since the last evaluation, so the closest distance is within that range
+	const float max_change = static_cast<float>(travelled_distance - _cached_travelled_distance);
+	if (max_change == 0.f) {
+		return true;
+	}
+
+	const float cached_distance = Math::sqrt(_cached_closest_distance_sq);
+	const float min_distance = math::max(cached_distance - max_change, 0.f);
+	const float max_distance = cached_distance + max_change;
+
+	if (get_distance_band(to_distance_int(min_distance), lod_index) !=
+		get_distance_band(to_distance_int(max_distance), lod_index)) {
+		return false;
+	}
+
+	if (check_drop_distance &&
+		(math::squared(min_distance) > drop_distance_squared) !=
+				(math::squared(max_distance) > drop_distance_squared)) {
+		return false;
+	}
+
+	return true;
+}
+
 TaskPriority PriorityDependency::evaluate(uint8_t lod_index, uint8_t band2_priority, float *out_closest_distance_sq) {
 	TaskPriority priority;
 	ZN_ASSERT_RETURN_V(shared != nullptr, priority);
 
-	const StdVector<Vector3f> &viewer_positions = shared->viewers;
-	const unsigned int viewer_count = shared->viewers_count;
-
-	const Vector3f block_position = world_position;
+	// Must be read before viewer positions, so if they are being updated at the same time, the cached result will be
+	// considered older than it actually is
+	const double travelled_distance = shared->travelled_distance;
+	const uint32_t viewers_version = shared->version;
 
 	float closest_distance_sq = 99999.f;
-	if (viewer_positions.size() == 0) {
-		// Assume origin
-		closest_distance_sq = math::length_squared(block_position);
+
+	if (can_reuse_cached_distance(
+				lod_index, out_closest_distance_sq != nullptr, travelled_distance, viewers_version
+		)) {
+		// Viewers did not move enough to change the result, skip going through all of them
+		closest_distance_sq = _cached_closest_distance_sq;
+
 	} else {
-		for (unsigned int i = 0; i < viewer_count; ++i) {
-			const float d = math::distance_squared(viewer_positions[i], block_position);
-			if (d < closest_distance_sq) {
-				closest_distance_sq = d;
+		const StdVector<Vector3f> &viewer_positions = shared->viewers;
+		const unsigned int viewer_count = shared->viewers_count;
+
+		const Vector3f block_position = world_position;
+
+		if (viewer_positions.size() == 0) {
+			// Assume origin
+			closest_distance_sq = math::length_squared(block_position);
+		} else {
+			for (unsigned int i = 0; i < viewer_count; ++i) {
+				const float d = math::distance_squared(viewer_positions[i], block_position);
+				if (d < closest_distance_sq) {
+					closest_distance_sq = d;
+				}
 			}
 		}
+
+		_cached_closest_distance_sq = closest_distance_sq;
+		_cached_travelled_distance = travelled_distance;
+		_cached_viewers_version = viewers_version;
 	}
 
 	if (out_closest_distance_sq != nullptr) {
@@ -33,7 +100,7 @@ TaskPriority PriorityDependency::evaluate(uint8_t lod_index, uint8_t band2_prior
 	// TODO Any way to optimize out the sqrt? Maybe with a fast integer version?
 	// I added it because the LOD modifier was not working with squared distances,
 	// which led blocks to subdivide too much compared to their neighbors, making cracks more likely to happen
-	const int distance = static_cast<int>(Math::sqrt(closest_distance_sq));
+	const int distance = to_distance_int(Math::sqrt(closest_distance_sq));
 
 	// TODO Prioritizing LOD makes generation slower... but not prioritizing makes cracks more likely to appear...
 	// This could be fixed by allowing the volume to preemptively request blocks of the next LOD?
@@ -42,9 +109,7 @@ TaskPriority PriorityDependency::evaluate(uint8_t lod_index, uint8_t band2_prior
 	// Then comes distance, which is modified by how much in view the block is
 	// priority += (constants::MAX_LOD - lod_index) * 10000;
 
-	// Closer is higher priority. Decreases over distance.
-	// Scaled by LOD because we segment priority by LOD too in band 1.
-	priority.band0 = math::max(TaskPriority::BAND_MAX - math::arithmetic_rshift(distance, 4 + lod_index), 0);
+	priority.band0 = get_distance_band(distance, lod_index);
 	// Note: in the past, making lower LOD indices (aka closer detailed ones) have higher priority made cracks between
 	// meshes more likely to appear somehow, so for a while I had it inverted. But that priority makes sense so I
 	// changed it back. Will see later if that really causes any issue.
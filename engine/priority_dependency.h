@@ -22,6 +22,13 @@ struct PriorityDependency {
 		// Use this count instead of `viewers.size()`. Can change, but will always be <= `viewers.size()`
 		std::atomic_uint32_t viewers_count;
 		float highest_view_distance = 999999;
+		// Sum of the largest distance any viewer moved at each update. The distance to the closest viewer of any
+		// position cannot have changed more than the difference between two values of this, which allows to skip
+		// evaluating priority when the result can't have changed.
+		// Written after viewer positions.
+		std::atomic<double> travelled_distance = { 0.0 };
+		// Incremented when the number of viewers changes, which invalidates `travelled_distance`.
+		std::atomic_uint32_t version = { 0 };
 	};
 
 	// TODO If viewers are created at the same time as the first terrain for the first time in a session, loading tasks
@@ -45,7 +52,23 @@ struct PriorityDependency {
 	// it's not always reliable and requires to handle "task drops" which is annoying
 	float drop_distance_squared;
 
+	// Computes priority from the distance to the closest viewer.
+	// Results are cached, so calling this again is cheap if viewers did not move enough to change them.
 	TaskPriority evaluate(uint8_t lod_index, uint8_t band2_priority, float *out_closest_distance_sq);
+
+private:
+	bool can_reuse_cached_distance(
+			uint8_t lod_index,
+			bool check_drop_distance,
+			double travelled_distance,
+			uint32_t viewers_version
+	) const;
+
+	// Closest viewer distance found at the last full evaluation. Negative if there was none.
+	// Assumes `world_position` does not change after the first evaluation.
+	float _cached_closest_distance_sq = -1.f;
+	double _cached_travelled_distance = 0.0;
+	uint32_t _cached_viewers_version = 0;
 };
 
 } // namespace zylann::voxel
@@ -0,0 +1,99 @@
+#include "session_recorder.h"
+#include "../util/errors.h"
+
+namespace zylann::voxel {
+
+void SessionRecorder::start(VolumeID volume_id, const Transform3f &world_to_local, const Dictionary &config) {
+	MutexLock lock(_mutex);
+	ZN_ASSERT_RETURN_MSG(!_recording, "A session is already being recorded");
+
+	_trace.clear();
+	_trace.config = config;
+	_last_viewers.clear();
+	_pending_edits.clear();
+	_volume_id = volume_id;
+	_world_to_local = world_to_local;
+	_recording = true;
+}
+
+void SessionRecorder::stop(SessionTrace &out_trace) {
+	MutexLock lock(_mutex);
+	ZN_ASSERT_RETURN_MSG(_recording, "No session is being recorded");
+
+	_recording = false;
+
+	// Edits done after the last frame still go in the trace
+	if (_pending_edits.size() > 0) {
+		SessionTrace::Frame frame;
+		frame.edits = std::move(_pending_edits);
+		_trace.frames.push_back(std::move(frame));
+		_pending_edits.clear();
+	}
+
+	out_trace = std::move(_trace);
+	_trace.clear();
+	_last_viewers.clear();
+}
+
+bool SessionRecorder::is_recording_volume(VolumeID volume_id) const {
+	if (!_recording) {
+		return false;
+	}
+	MutexLock lock(_mutex);
+	return _recording && _volume_id == volume_id;
+}
+
+void SessionRecorder::set_world_to_local_transform(VolumeID volume_id, const Transform3f &world_to_local) {
+	if (!_recording) {
+		return;
+	}
+	MutexLock lock(_mutex);
+	if (_recording && _volume_id == volume_id) {
+		_world_to_local = world_to_local;
+	}
+}
+
+void SessionRecorder::record_frame(uint32_t delta_usec, const StdVector<SessionTrace::ViewerState> &viewers) {
+	if (!_recording) {
+		return;
+	}
+
+	MutexLock lock(_mutex);
+	// Recording could have stopped since the check above
+	if (!_recording) {
+		return;
+	}
+
+	StdVector<SessionTrace::ViewerState> local_viewers = viewers;
+	for (SessionTrace::ViewerState &viewer : local_viewers) {
+		viewer.position = _world_to_local.xform(viewer.position);
+	}
+
+	SessionTrace::Frame frame;
+	frame.delta_usec = delta_usec;
+
+	// The first frame always has viewers, so replay starts from a known state
+	if (_trace.frames.size() == 0 || local_viewers != _last_viewers) {
+		frame.viewers_changed = true;
+		frame.viewers = local_viewers;
+		_last_viewers = std::move(local_viewers);
+	}
+
+	frame.edits = std::move(_pending_edits);
+	_pending_edits.clear();
+
+	_trace.frames.push_back(std::move(frame));
+}
+
+void SessionRecorder::record_edit(VolumeID volume_id, const SessionTrace::Edit &edit) {
+	if (!_recording) {
+		return;
+	}
+	MutexLock lock(_mutex);
+	if (!_recording || _volume_id != volume_id) {
+		return;
+	}
+	_pending_edits.push_back(edit);
+}
+
+} // namespace zylann::voxel
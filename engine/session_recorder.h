@@ -0,0 +1,50 @@
+#ifndef VOXEL_SESSION_RECORDER_H
+#define VOXEL_SESSION_RECORDER_H
+
+#include "../util/math/transform3f.h"
+#include "../util/thread/mutex.h"
+#include "ids.h"
+#include "session_trace.h"
+#include <atomic>
+
+namespace zylann::voxel {
+
+// Collects what happens to one volume every frame into a `SessionTrace`, so it can be replayed later.
+// Frames are recorded by `VoxelEngine`. Edits may be recorded from any thread, they will be part of the next frame.
+// Positions are stored in the local space of the volume, so a session can be replayed on a volume placed differently.
+class SessionRecorder {
+public:
+	void start(VolumeID volume_id, const Transform3f &world_to_local, const Dictionary &config);
+	void stop(SessionTrace &out_trace);
+
+	// Only a hint, recording can start or stop from another thread right after.
+	inline bool is_recording() const {
+		return _recording;
+	}
+
+	bool is_recording_volume(VolumeID volume_id) const;
+
+	// Must be called when the volume moves, otherwise viewers will be recorded at the wrong place
+	void set_world_to_local_transform(VolumeID volume_id, const Transform3f &world_to_local);
+
+	// Viewer positions are in world space.
+	// Viewers are only stored in the trace if they differ from the previous frame
+	void record_frame(uint32_t delta_usec, const StdVector<SessionTrace::ViewerState> &viewers);
+	// Edit positions are in the local space of the volume.
+	// Ignored if the given volume isn't the one being recorded.
+	void record_edit(VolumeID volume_id, const SessionTrace::Edit &edit);
+
+private:
+	// Written under the mutex, can be read without it to skip locking when not recording
+	std::atomic_bool _recording = { false };
+	VolumeID _volume_id;
+	Transform3f _world_to_local;
+	mutable Mutex _mutex;
+	SessionTrace _trace;
+	StdVector<SessionTrace::ViewerState> _last_viewers;
+	StdVector<SessionTrace::Edit> _pending_edits;
+};
+
+} // namespace zylann::voxel
+
+#endif // VOXEL_SESSION_RECORDER_H
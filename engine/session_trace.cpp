@@ -0,0 +1,222 @@
+#include "session_trace.h"
+#include "../edition/voxel_tool.h"
+#include "../streams/compressed_data.h"
+#include "../util/errors.h"
+#include "../util/godot/core/variant.h"
+#include "../util/io/serialization.h"
+#include "../util/string/format.h"
+
+namespace zylann::voxel {
+
+namespace {
+
+const char *MAGIC = "VXST";
+const unsigned int MAGIC_SIZE = 4;
+
+const uint8_t VIEWER_FLAG_VISUALS = 1;
+const uint8_t VIEWER_FLAG_COLLISIONS = 2;
+
+const uint8_t FRAME_FLAG_VIEWERS_CHANGED = 1;
+
+// Sizes of fixed-size records, used to check data is long enough before reading
+const unsigned int VIEWER_STATE_SIZE = 4 + 3 * 4 + 4 + 4 + 1;
+const unsigned int EDIT_SIZE = 1 + 1 + 1 + 8 + 8 + 4 + 4 + 3 * 4 + 3 * 4 + 4;
+const unsigned int FRAME_HEADER_SIZE = 4 + 1;
+
+void write_vector3f(MemoryWriter &w, const Vector3f v) {
+	w.store_float(v.x);
+	w.store_float(v.y);
+	w.store_float(v.z);
+}
+
+Vector3f read_vector3f(MemoryReader &r) {
+	Vector3f v;
+	v.x = r.get_float();
+	v.y = r.get_float();
+	v.z = r.get_float();
+	return v;
+}
+
+inline bool can_read(const MemoryReader &r, const size_t size) {
+	return r.pos + size <= r.data.size();
+}
+
+} // namespace
+
+void SessionTrace::clear() {
+	config = Dictionary();
+	frames.clear();
+}
+
+void SessionTrace::serialize(StdVector<uint8_t> &dst) const {
+	StdVector<uint8_t> payload;
+	MemoryWriter w(payload, ENDIANNESS_LITTLE_ENDIAN);
+
+	w.store_8(VERSION);
+
+	const size_t config_size = zylann::godot::get_variant_encoded_size(config);
+	w.store_32(config_size);
+	const size_t config_pos = payload.size();
+	payload.resize(payload.size() + config_size);
+	zylann::godot::encode_variant(config, Span<uint8_t>(payload.data() + config_pos, config_size));
+
+	w.store_32(frames.size());
+
+	for (const Frame &frame : frames) {
+		w.store_32(frame.delta_usec);
+		w.store_8(frame.viewers_changed ? FRAME_FLAG_VIEWERS_CHANGED : 0);
+
+		if (frame.viewers_changed) {
+			w.store_16(frame.viewers.size());
+			for (const ViewerState &viewer : frame.viewers) {
+				w.store_32(viewer.id);
+				write_vector3f(w, viewer.position);
+				w.store_32(viewer.horizontal_distance);
+				w.store_32(viewer.vertical_distance);
+				uint8_t flags = 0;
+				if (viewer.requires_visuals) {
+					flags |= VIEWER_FLAG_VISUALS;
+				}
+				if (viewer.requires_collisions) {
+					flags |= VIEWER_FLAG_COLLISIONS;
+				}
+				w.store_8(flags);
+			}
+		}
+
+		w.store_32(frame.edits.size());
+		for (const Edit &edit : frame.edits) {
+			w.store_8(edit.type);
+			w.store_8(edit.mode);
+			w.store_8(edit.channel);
+			w.store_64(edit.value);
+			w.store_64(edit.eraser_value);
+			w.store_float(edit.sdf_scale);
+			w.store_float(edit.sdf_strength);
+			write_vector3f(w, edit.position);
+			w.store_32(edit.end.x);
+			w.store_32(edit.end.y);
+			w.store_32(edit.end.z);
+			w.store_float(edit.param);
+		}
+	}
+
+	// Viewers often move by small amounts and edits are similar to each other, so this compresses well
+	StdVector<uint8_t> compressed;
+	ZN_ASSERT_RETURN(CompressedData::compress(to_span_const(payload), compressed, CompressedData::COMPRESSION_LZ4));
+
+	dst.clear();
+	dst.reserve(MAGIC_SIZE + compressed.size());
+	for (unsigned int i = 0; i < MAGIC_SIZE; ++i) {
+		dst.push_back(MAGIC[i]);
+	}
+	dst.insert(dst.end(), compressed.begin(), compressed.end());
+}
+
+bool SessionTrace::deserialize(Span<const uint8_t> src) {
+	clear();
+	if (!deserialize_internal(src)) {
+		// Don't leave a partial trace behind
+		clear();
+		return false;
+	}
+	return true;
+}
+
+bool SessionTrace::deserialize_internal(Span<const uint8_t> src) {
+	ZN_ASSERT_RETURN_V_MSG(src.size() >= MAGIC_SIZE, false, "Session trace is too small");
+	for (unsigned int i = 0; i < MAGIC_SIZE; ++i) {
+		ZN_ASSERT_RETURN_V_MSG(src[i] == MAGIC[i], false, "Data is not a session trace");
+	}
+
+	StdVector<uint8_t> payload;
+	ZN_ASSERT_RETURN_V_MSG(
+			CompressedData::decompress(src.sub(MAGIC_SIZE), payload), false, "Failed to decompress session trace"
+	);
+
+	MemoryReader r(to_span_const(payload), ENDIANNESS_LITTLE_ENDIAN);
+
+	ZN_ASSERT_RETURN_V(can_read(r, 1 + 4), false);
+	const uint8_t version = r.get_8();
+	ZN_ASSERT_RETURN_V_MSG(
+			version == VERSION, false, format("Unsupported session trace version {}, expected {}", version, VERSION)
+	);
+
+	const uint32_t config_size = r.get_32();
+	ZN_ASSERT_RETURN_V(can_read(r, config_size), false);
+	Variant config_v;
+	size_t config_read_size;
+	ZN_ASSERT_RETURN_V(
+			zylann::godot::decode_variant(
+					Span<const uint8_t>(payload.data() + r.pos, config_size), config_v, config_read_size
+			),
+			false
+	);
+	r.pos += config_size;
+	if (config_v.get_type() == Variant::DICTIONARY) {
+		config = config_v;
+	}
+
+	ZN_ASSERT_RETURN_V(can_read(r, 4), false);
+	const uint32_t frame_count = r.get_32();
+	// Check before allocating, the count could be corrupted
+	ZN_ASSERT_RETURN_V(can_read(r, static_cast<size_t>(frame_count) * FRAME_HEADER_SIZE), false);
+	frames.resize(frame_count);
+
+	for (Frame &frame : frames) {
+		ZN_ASSERT_RETURN_V(can_read(r, FRAME_HEADER_SIZE), false);
+		frame.delta_usec = r.get_32();
+		const uint8_t frame_flags = r.get_8();
+		frame.viewers_changed = (frame_flags & FRAME_FLAG_VIEWERS_CHANGED) != 0;
+
+		if (frame.viewers_changed) {
+			ZN_ASSERT_RETURN_V(can_read(r, 2), false);
+			const uint16_t viewer_count = r.get_16();
+			ZN_ASSERT_RETURN_V(can_read(r, viewer_count * VIEWER_STATE_SIZE), false);
+			frame.viewers.resize(viewer_count);
+
+			for (ViewerState &viewer : frame.viewers) {
+				viewer.id = r.get_32();
+				viewer.position = read_vector3f(r);
+				viewer.horizontal_distance = r.get_32();
+				viewer.vertical_distance = r.get_32();
+				const uint8_t viewer_flags = r.get_8();
+				viewer.requires_visuals = (viewer_flags & VIEWER_FLAG_VISUALS) != 0;
+				viewer.requires_collisions = (viewer_flags & VIEWER_FLAG_COLLISIONS) != 0;
+			}
+		}
+
+		ZN_ASSERT_RETURN_V(can_read(r, 4), false);
+		const uint32_t edit_count = r.get_32();
+		ZN_ASSERT_RETURN_V(can_read(r, static_cast<size_t>(edit_count) * EDIT_SIZE), false);
+		frame.edits.resize(edit_count);
+
+		for (Edit &edit : frame.edits) {
+			const uint8_t type = r.get_8();
+			ZN_ASSERT_RETURN_V_MSG(type < EDIT_TYPE_COUNT, false, format("Invalid edit type {}", type));
+			edit.type = static_cast<EditType>(type);
+			edit.mode = r.get_8();
+			// The tool doesn't check the mode when replaying
+			ZN_ASSERT_RETURN_V_MSG(
+					edit.mode <= VoxelTool::MODE_TEXTURE_PAINT, false, format("Invalid edit mode {}", edit.mode)
+			);
+			edit.channel = r.get_8();
+			ZN_ASSERT_RETURN_V_MSG(
+					edit.channel < VoxelBuffer::MAX_CHANNELS, false, format("Invalid edit channel {}", edit.channel)
+			);
+			edit.value = r.get_64();
+			edit.eraser_value = r.get_64();
+			edit.sdf_scale = r.get_float();
+			edit.sdf_strength = r.get_float();
+			edit.position = read_vector3f(r);
+			edit.end.x = static_cast<int32_t>(r.get_32());
+			edit.end.y = static_cast<int32_t>(r.get_32());
+			edit.end.z = static_cast<int32_t>(r.get_32());
+			edit.param = r.get_float();
+		}
+	}
+
+	return true;
+}
+
+} // namespace zylann::voxel
@@ -0,0 +1,87 @@
+#ifndef VOXEL_SESSION_TRACE_H
+#define VOXEL_SESSION_TRACE_H
+
+#include "../util/containers/span.h"
+#include "../util/containers/std_vector.h"
+#include "../util/godot/core/dictionary.h"
+#include "../util/math/vector3f.h"
+#include "../util/math/vector3i.h"
+#include <cstdint>
+
+namespace zylann::voxel {
+
+// What happened in a session of a game using voxel terrain, frame by frame, so it can be replayed later to reproduce
+// the same load on the engine. It contains viewer states and edits, but no voxel data.
+struct SessionTrace {
+	static const uint8_t VERSION = 1;
+
+	struct ViewerState {
+		// Identifies the viewer during the whole session
+		uint32_t id = 0;
+		// In the local space of the recorded volume, like edits
+		Vector3f position;
+		uint32_t horizontal_distance = 0;
+		uint32_t vertical_distance = 0;
+		bool requires_visuals = false;
+		bool requires_collisions = false;
+
+		bool operator==(const ViewerState &other) const {
+			return id == other.id && position == other.position && horizontal_distance == other.horizontal_distance &&
+					vertical_distance == other.vertical_distance && requires_visuals == other.requires_visuals &&
+					requires_collisions == other.requires_collisions;
+		}
+	};
+
+	// Mirrors operations of `VoxelTool`
+	enum EditType : uint8_t {
+		EDIT_SET_VOXEL = 0,
+		EDIT_SET_VOXEL_F,
+		EDIT_POINT,
+		EDIT_SPHERE,
+		EDIT_BOX,
+		EDIT_TYPE_COUNT
+	};
+
+	struct Edit {
+		EditType type = EDIT_POINT;
+		// State of the tool when the edit was done
+		uint8_t mode = 0;
+		uint8_t channel = 0;
+		uint64_t value = 0;
+		uint64_t eraser_value = 0;
+		float sdf_scale = 1.f;
+		float sdf_strength = 1.f;
+		// Position of voxel edits, center of spheres, or beginning of boxes
+		Vector3f position;
+		// End of boxes
+		Vector3i end;
+		// Value of `set_voxel_f`, or radius of spheres
+		float param = 0.f;
+	};
+
+	struct Frame {
+		// Time elapsed since the previous frame
+		uint32_t delta_usec = 0;
+		// Only stored when they changed since the previous frame
+		bool viewers_changed = false;
+		StdVector<ViewerState> viewers;
+		StdVector<Edit> edits;
+	};
+
+	// Properties of the terrain and its resources at the time recording started, for reference. It can be used to
+	// set up a similar terrain for replay.
+	Dictionary config;
+	StdVector<Frame> frames;
+
+	void clear();
+
+	void serialize(StdVector<uint8_t> &dst) const;
+	bool deserialize(Span<const uint8_t> src);
+
+private:
+	bool deserialize_internal(Span<const uint8_t> src);
+};
+
+} // namespace zylann::voxel
+
+#endif // VOXEL_SESSION_TRACE_H
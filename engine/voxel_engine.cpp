@@ -10,6 +10,8 @@
 #include "../util/godot/classes/rd_sampler_state.h"
 #include "../util/godot/classes/rendering_device.h"
 #include "../util/godot/classes/rendering_server.h"
+#include "../util/godot/classes/time.h"
+#include "../util/containers/container_funcs.h"
 #include "../util/io/log.h"
 #include "../util/macros.h"
 #include "../util/math/conv.h"
@@ -43,9 +45,10 @@ VoxelEngine::VoxelEngine(Config config) {
 	ZN_ASSERT(config.thread_count_margin_below_max >= 0);
 	ZN_ASSERT(config.thread_count_minimum >= 1);
 	ZN_ASSERT(config.thread_count_ratio_over_max >= 0.f);
+	ZN_ASSERT(config.io_thread_count >= 1);
 
 	// Compute thread count for general pool.
-	// Note that the I/O thread counts as one used thread and will always be present.
+	// I/O threads are not accounted for, since they mostly wait on files.
 
 	const int maximum_thread_count =
 			math::max(hw_threads_hint - config.thread_count_margin_below_max, config.thread_count_minimum);
@@ -61,6 +64,11 @@ VoxelEngine::VoxelEngine(Config config) {
 	_general_thread_pool.set_thread_count(thread_count);
 	_general_thread_pool.set_priority_update_period(200);
 
+	ZN_PRINT_VERBOSE(format("Voxel: I/O thread count set to {}", config.io_thread_count));
+	_io_thread_pool.set_name("Voxel I/O");
+	_io_thread_pool.set_thread_count(config.io_thread_count);
+	_io_thread_pool.set_priority_update_period(200);
+
 	// Init world
 	_world.shared_priority_dependency = make_shared_instance<PriorityDependency::ViewersData>();
 	// Give initial capacity to make invalidation less likely
@@ -71,6 +79,13 @@ VoxelEngine::VoxelEngine(Config config) {
 	ZN_PRINT_VERBOSE(format("Size of MeshBlockTask: {}", sizeof(MeshBlockTask)));
 
 	set_main_thread_time_budget_usec(config.main_thread_budget_usec);
+	set_main_thread_target_fps(config.main_thread_target_fps);
+	set_main_thread_time_budget_adaptive(config.main_thread_budget_adaptive);
+	for (unsigned int i = 0; i < MAIN_THREAD_CATEGORY_COUNT; ++i) {
+		set_main_thread_category_budget_ratio(
+				static_cast<MainThreadCategory>(i), config.main_thread_category_budget_ratios[i]
+		);
+	}
 }
 
 VoxelEngine::~VoxelEngine() {
@@ -132,7 +147,12 @@ void VoxelEngine::try_initialize_gpu_features() {
 }
 
 void VoxelEngine::wait_and_clear_all_tasks(bool warn) {
-	_general_thread_pool.wait_for_all_tasks();
+	// Tasks of one pool can schedule tasks in the other. For example, loading a block that isn't found schedules its
+	// generation, which can in turn schedule saving it.
+	do {
+		_general_thread_pool.wait_for_all_tasks();
+		_io_thread_pool.wait_for_all_tasks();
+	} while (_general_thread_pool.has_waiting_tasks());
 
 	_general_thread_pool.dequeue_completed_tasks([warn](zylann::IThreadedTask *task) {
 		if (warn) {
@@ -143,6 +163,16 @@ void VoxelEngine::wait_and_clear_all_tasks(bool warn) {
 		}
 		ZN_DELETE(task);
 	});
+
+	_io_thread_pool.dequeue_completed_tasks([warn](zylann::IThreadedTask *task) {
+		if (warn) {
+			ZN_PRINT_WARNING(
+					"I/O tasks remain on module cleanup, "
+					"this could become a problem if they reference scripts"
+			);
+		}
+		ZN_DELETE(task);
+	});
 }
 
 VolumeID VoxelEngine::add_volume(VolumeCallbacks callbacks) {
@@ -255,11 +285,38 @@ void VoxelEngine::push_main_thread_progressive_task(zylann::IProgressiveTask *ta
 }
 
 int VoxelEngine::get_main_thread_time_budget_usec() const {
-	return _main_thread_time_budget_usec;
+	return _main_thread_time_budget.get_budget_usec();
 }
 
 void VoxelEngine::set_main_thread_time_budget_usec(unsigned int usec) {
-	_main_thread_time_budget_usec = usec;
+	_main_thread_time_budget.set_fixed_budget_usec(usec);
+}
+
+void VoxelEngine::set_main_thread_time_budget_adaptive(bool enabled) {
+	_main_thread_time_budget.set_adaptive_enabled(enabled);
+}
+
+bool VoxelEngine::is_main_thread_time_budget_adaptive() const {
+	return _main_thread_time_budget.is_adaptive_enabled();
+}
+
+void VoxelEngine::set_main_thread_target_fps(unsigned int fps) {
+	ZN_ASSERT_RETURN(fps > 0);
+	_main_thread_time_budget.set_target_frame_time_usec(1'000'000 / fps);
+}
+
+unsigned int VoxelEngine::get_main_thread_target_fps() const {
+	return 1'000'000 / _main_thread_time_budget.get_target_frame_time_usec();
+}
+
+void VoxelEngine::set_main_thread_category_budget_ratio(MainThreadCategory category, float ratio) {
+	ZN_ASSERT_RETURN(category >= 0 && category < MAIN_THREAD_CATEGORY_COUNT);
+	_main_thread_time_budget.set_category_ratio(category, ratio);
+}
+
+float VoxelEngine::get_main_thread_category_budget_ratio(MainThreadCategory category) const {
+	ZN_ASSERT_RETURN_V(category >= 0 && category < MAIN_THREAD_CATEGORY_COUNT, 0.f);
+	return _main_thread_time_budget.get_category_ratio(category);
 }
 
 bool VoxelEngine::is_threaded_graphics_resource_building_enabled() const {
@@ -279,12 +336,13 @@ void VoxelEngine::push_async_tasks(Span<zylann::IThreadedTask *> tasks) {
 }
 
 void VoxelEngine::push_async_io_task(zylann::IThreadedTask *task) {
-	// I/O tasks run in serial because they usually can't run well in parallel due to locking shared resources.
-	_general_thread_pool.enqueue(task, true);
+	// Not scheduled as serial: tasks using a stream that can't run well in parallel due to locking shared resources
+	// provide a serial key, so they run one at a time without blocking tasks of other streams.
+	_io_thread_pool.enqueue(task, false);
 }
 
 void VoxelEngine::push_async_io_tasks(Span<zylann::IThreadedTask *> tasks) {
-	_general_thread_pool.enqueue(tasks, true);
+	_io_thread_pool.enqueue(tasks, false);
 }
 
 #ifdef VOXEL_ENABLE_GPU
@@ -297,18 +355,54 @@ uint32_t VoxelEngine::get_pending_gpu_tasks_count() const {
 }
 #endif
 
+void VoxelEngine::record_session_frame(uint64_t frame_time_usec) {
+	StdVector<SessionTrace::ViewerState> viewers;
+	for_each_viewer([&viewers](ViewerID id, const Viewer &viewer) {
+		SessionTrace::ViewerState state;
+		state.id = id.index | (static_cast<uint32_t>(id.version.value) << 16);
+		state.position = to_vec3f(viewer.world_position);
+		state.horizontal_distance = viewer.view_distances.horizontal;
+		state.vertical_distance = viewer.view_distances.vertical;
+		state.requires_visuals = viewer.require_visuals;
+		state.requires_collisions = viewer.require_collisions;
+		viewers.push_back(state);
+	});
+	_session_recorder.record_frame(math::min(frame_time_usec, uint64_t(0xffffffff)), viewers);
+}
+
 void VoxelEngine::process() {
 	ZN_PROFILE_SCOPE();
+
+	{
+		// This is expected to be called once per frame
+		const uint64_t now_usec = Time::get_singleton()->get_ticks_usec();
+		const uint64_t frame_time_usec = _last_process_time_usec != 0 ? now_usec - _last_process_time_usec : 0;
+		_last_process_time_usec = now_usec;
+		_main_thread_time_budget.begin_frame(frame_time_usec, _time_spread_task_runner.get_pending_count() > 0);
+
+		if (_session_recorder.is_recording()) {
+			record_session_frame(frame_time_usec);
+		}
+	}
+
 	ZN_PROFILE_PLOT("Static memory usage", int64_t(OS::get_singleton()->get_static_memory_usage()));
 	ZN_PROFILE_PLOT("TimeSpread tasks", int64_t(_time_spread_task_runner.get_pending_count()));
 	ZN_PROFILE_PLOT("Progressive tasks", int64_t(_progressive_task_runner.get_pending_count()));
 	ZN_PROFILE_PLOT("Threaded tasks", int64_t(_general_thread_pool.get_debug_remaining_tasks()));
+	ZN_PROFILE_PLOT("I/O tasks", int64_t(_io_thread_pool.get_debug_remaining_tasks()));
+	ZN_PROFILE_PLOT("Main thread budget", int64_t(_main_thread_time_budget.get_budget_usec()));
 	ZN_PROFILE_PLOT("Objects", int64_t(ObjectDB::get_object_count()));
 	ZN_PROFILE_PLOT(
 			"ZN Std Allocator",
 			int64_t(StdDefaultAllocatorCounters::g_allocated - StdDefaultAllocatorCounters::g_deallocated)
 	);
 
+	// Receive loading and saving results
+	_io_thread_pool.dequeue_completed_tasks([](zylann::IThreadedTask *task) {
+		task->apply_result();
+		ZN_DELETE(task);
+	});
+
 	// Receive generation and meshing results
 	_general_thread_pool.dequeue_completed_tasks([](zylann::IThreadedTask *task) {
 		task->apply_result();
@@ -317,7 +411,11 @@ void VoxelEngine::process() {
 
 	// Run this after dequeueing threaded tasks, because they can add some to this runner,
 	// which could in turn complete right away (we avoid 1-frame delays this way).
-	_time_spread_task_runner.process(_main_thread_time_budget_usec);
+	{
+		// Tasks measure collision separately
+		MainThreadTimeBudgetScope budget_scope(_main_thread_time_budget, MAIN_THREAD_CATEGORY_MESH);
+		_time_spread_task_runner.process(_main_thread_time_budget.get_budget_usec());
+	}
 
 	_progressive_task_runner.process();
 
@@ -349,16 +447,31 @@ void VoxelEngine::sync_viewers_task_priority_data() {
 
 	PriorityDependency::ViewersData &dep = *_world.shared_priority_dependency;
 
+	const unsigned int prev_viewer_count = dep.viewers_count;
+
 	size_t i = 0;
 	unsigned int max_distance = 0;
-	_world.viewers.for_each_value([&i, &max_distance, &dep](Viewer &viewer) {
-		dep.viewers[i] = to_vec3f(viewer.world_position);
+	float max_movement = 0.f;
+	_world.viewers.for_each_value([&i, &max_distance, &max_movement, &dep, prev_viewer_count](Viewer &viewer) {
+		const Vector3f position = to_vec3f(viewer.world_position);
+		if (i < prev_viewer_count) {
+			// Viewers may not be in the same order if some were added and removed, but that only makes this larger
+			// than it needs to be. Tasks only need an upper bound of how much the closest viewer distance changed.
+			max_movement = math::max(max_movement, math::distance(dep.viewers[i], position));
+		}
+		dep.viewers[i] = position;
 		max_distance = math::max(max_distance, viewer.view_distances.max());
 		++i;
 	});
 
 	dep.viewers_count = viewer_count;
 
+	if (viewer_count != prev_viewer_count) {
+		++dep.version;
+	} else if (max_movement > 0.f) {
+		dep.travelled_distance = dep.travelled_distance + max_movement;
+	}
+
 	// Cancel distance is increased because of two reasons:
 	// - Some volumes use a cubic area which has higher distances on their corners
 	// - Hysteresis is needed to reduce ping-pong
@@ -397,6 +510,13 @@ VoxelEngine::Stats::ThreadPoolStats debug_get_pool_stats(const zylann::ThreadedT
 VoxelEngine::Stats VoxelEngine::get_stats() const {
 	Stats s;
 	s.general = debug_get_pool_stats(_general_thread_pool);
+	s.io = debug_get_pool_stats(_io_thread_pool);
+	s.main_thread.budget_usec = _main_thread_time_budget.get_budget_usec();
+	s.main_thread.average_frame_time_usec = _main_thread_time_budget.get_average_frame_time_usec();
+	s.main_thread.adaptive = _main_thread_time_budget.is_adaptive_enabled();
+	for (unsigned int i = 0; i < s.main_thread.categories.size(); ++i) {
+		s.main_thread.categories[i] = _main_thread_time_budget.get_category_stats(i);
+	}
 	s.generation_tasks = _debug_generate_block_task_count;
 	s.meshing_tasks = MeshBlockTask::debug_get_running_count();
 	s.streaming_tasks = LoadBlockDataTask::debug_get_running_count() + SaveBlockDataTask::debug_get_running_count();
@@ -404,9 +524,19 @@ VoxelEngine::Stats VoxelEngine::get_stats() const {
 #ifdef VOXEL_ENABLE_GPU
 	s.gpu_tasks = _gpu_task_runner.get_pending_task_count();
 #endif
+	_general_thread_pool.get_task_latency_stats(s.task_latencies);
+	// Pools run different types of tasks
+	StdVector<TaskLatencyStats::TaskTypeStats> io_task_latencies;
+	_io_thread_pool.get_task_latency_stats(io_task_latencies);
+	append_array(s.task_latencies, io_task_latencies);
 	return s;
 }
 
+void VoxelEngine::clear_task_latency_stats() {
+	_general_thread_pool.clear_task_latency_stats();
+	_io_thread_pool.clear_task_latency_stats();
+}
+
 int VoxelEngine::get_thread_count() const {
 	return _general_thread_pool.get_thread_count();
 }
@@ -8,11 +8,13 @@
 #include "../util/io/file_locker.h"
 #include "../util/memory/memory.h"
 #include "../util/string/std_string.h"
+#include "../util/tasks/main_thread_time_budget.h"
 #include "../util/tasks/progressive_task_runner.h"
 #include "../util/tasks/threaded_task_runner.h"
 #include "../util/tasks/time_spread_task_runner.h"
 #include "ids.h"
 #include "priority_dependency.h"
+#include "session_recorder.h"
 
 #ifdef VOXEL_ENABLE_SMOOTH_MESHING
 #include "detail_rendering/detail_rendering.h"
@@ -147,6 +149,19 @@ public:
 	};
 
 	static constexpr unsigned int DEFAULT_MAIN_THREAD_BUDGET_USEC = 8000;
+	static constexpr unsigned int DEFAULT_MAIN_THREAD_TARGET_FPS = 60;
+	static constexpr unsigned int DEFAULT_IO_THREAD_COUNT = 2;
+
+	// Kinds of work done on the main thread. Each can be limited to a portion of the main thread time budget.
+	enum MainThreadCategory {
+		// Applying meshes, and other main thread tasks such as freeing resources
+		MAIN_THREAD_CATEGORY_MESH = 0,
+		// Building and applying collision shapes of terrains
+		MAIN_THREAD_CATEGORY_COLLISION,
+		// Updates of instancers
+		MAIN_THREAD_CATEGORY_INSTANCER,
+		MAIN_THREAD_CATEGORY_COUNT
+	};
 
 	struct Config {
 		int thread_count_minimum = 1;
@@ -154,7 +169,15 @@ public:
 		int thread_count_margin_below_max = 1;
 		// Portion of available CPU threads to attempt using
 		float thread_count_ratio_over_max = 0.5;
+		// Threads dedicated to loading and saving. They are separate from the general pool, so I/O waiting on files
+		// doesn't delay generation and meshing.
+		int io_thread_count = DEFAULT_IO_THREAD_COUNT;
 		unsigned int main_thread_budget_usec = DEFAULT_MAIN_THREAD_BUDGET_USEC;
+		// If enabled, the main thread budget is adjusted every frame to keep the given frame rate, instead of being
+		// fixed
+		bool main_thread_budget_adaptive = false;
+		unsigned int main_thread_target_fps = DEFAULT_MAIN_THREAD_TARGET_FPS;
+		float main_thread_category_budget_ratios[MAIN_THREAD_CATEGORY_COUNT] = { 1.f, 1.f, 1.f };
 	};
 
 	static VoxelEngine &get_singleton();
@@ -203,8 +226,22 @@ public:
 			ITimeSpreadTask *task,
 			TimeSpreadTaskRunner::Priority priority = TimeSpreadTaskRunner::PRIORITY_NORMAL
 	);
+	// Gets the main thread time budget of the current frame
 	int get_main_thread_time_budget_usec() const;
+	// Sets the main thread time budget used when it isn't adaptive
 	void set_main_thread_time_budget_usec(unsigned int usec);
+	void set_main_thread_time_budget_adaptive(bool enabled);
+	bool is_main_thread_time_budget_adaptive() const;
+	void set_main_thread_target_fps(unsigned int fps);
+	unsigned int get_main_thread_target_fps() const;
+	void set_main_thread_category_budget_ratio(MainThreadCategory category, float ratio);
+	float get_main_thread_category_budget_ratio(MainThreadCategory category) const;
+
+	// Main thread only. Used to measure time spent in each category with `MainThreadTimeBudgetScope`, and to check if
+	// there is budget left.
+	inline MainThreadTimeBudget &get_main_thread_time_budget() {
+		return _main_thread_time_budget;
+	}
 
 	// This should be fast and safe to access from multiple threads.
 	bool is_threaded_graphics_resource_building_enabled() const;
@@ -217,6 +254,8 @@ public:
 	// Thread-safe.
 	void push_async_tasks(Span<IThreadedTask *> tasks);
 	// Thread-safe.
+	// I/O tasks run in a separate pool. Tasks returning the same serial key (usually their stream, if it isn't
+	// thread-safe) run one at a time.
 	void push_async_io_task(IThreadedTask *task);
 	// Thread-safe.
 	void push_async_io_tasks(Span<IThreadedTask *> tasks);
@@ -247,6 +286,10 @@ public:
 		return _file_locker;
 	}
 
+	inline SessionRecorder &get_session_recorder() {
+		return _session_recorder;
+	}
+
 	static inline int get_octree_lod_block_region_extent(float lod_distance, float block_size) {
 		// This is a bounding radius of blocks around a viewer within which we may load them.
 		// `lod_distance` is the distance under which a block should subdivide into a smaller one.
@@ -262,7 +305,16 @@ public:
 			FixedArray<const char *, ThreadedTaskRunner::MAX_THREADS> active_task_names;
 		};
 
+		struct MainThreadStats {
+			uint32_t budget_usec;
+			uint32_t average_frame_time_usec;
+			bool adaptive;
+			FixedArray<MainThreadTimeBudget::CategoryStats, MAIN_THREAD_CATEGORY_COUNT> categories;
+		};
+
 		ThreadPoolStats general;
+		ThreadPoolStats io;
+		MainThreadStats main_thread;
 		int generation_tasks;
 		int streaming_tasks;
 		int meshing_tasks;
@@ -270,9 +322,12 @@ public:
 #ifdef VOXEL_ENABLE_GPU
 		int gpu_tasks;
 #endif
+		// Timings of threaded tasks, per type of task
+		StdVector<TaskLatencyStats::TaskTypeStats> task_latencies;
 	};
 
 	Stats get_stats() const;
+	void clear_task_latency_stats();
 
 	int get_thread_count() const;
 	void set_thread_count(uint32_t count);
@@ -315,6 +370,8 @@ public:
 private:
 	VoxelEngine(Config config);
 
+	void record_session_frame(uint64_t frame_time_usec);
+
 	// Since we are going to send data to tasks running in multiple threads, a few strategies are in place:
 	//
 	// - Copy the data for each task. This is suitable for simple information that doesn't change after scheduling.
@@ -343,12 +400,16 @@ private:
 	World _world;
 
 	ThreadedTaskRunner _general_thread_pool;
+	// For loading and saving, which spends time waiting on files rather than computing
+	ThreadedTaskRunner _io_thread_pool;
 	// For tasks that can only run on the main thread and be spread out over frames
 	TimeSpreadTaskRunner _time_spread_task_runner;
-	unsigned int _main_thread_time_budget_usec = DEFAULT_MAIN_THREAD_BUDGET_USEC;
 	ProgressiveTaskRunner _progressive_task_runner;
+	MainThreadTimeBudget _main_thread_time_budget;
+	uint64_t _last_process_time_usec = 0;
 
 	FileLocker _file_locker;
+	SessionRecorder _session_recorder;
 
 	// Caches whether building Mesh and Texture resources is allowed from inside threads.
 	// Depends on Godot's efficiency at doing so, and which renderer is used.
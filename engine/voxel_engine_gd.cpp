@@ -5,13 +5,17 @@
 #include "../util/godot/classes/project_settings.h"
 #include "../util/godot/classes/rendering_server.h"
 #include "../util/godot/core/packed_arrays.h"
+#include "../util/godot/core/string.h"
 #include "../util/macros.h"
 #include "../util/profiling.h"
+#include "../util/string/std_string.h"
 #include "../util/tasks/godot/threaded_task_gd.h"
+#include "../util/trace_recorder.h"
 #include "voxel_engine.h"
 
 #ifdef VOXEL_TESTS
 #include "../tests/tests.h"
+#include "../util/testing/benchmark.h"
 #include "../util/testing/test_options.h"
 #endif
 
@@ -54,10 +58,46 @@ VoxelEngine::Config VoxelEngine::get_config_from_godot() {
 	add_custom_project_setting(
 			Variant::INT, "voxel/threads/main/time_budget_ms", PROPERTY_HINT_RANGE, "0,1000", 8, true
 	);
+	add_custom_project_setting(
+			Variant::BOOL, "voxel/threads/main/adaptive_time_budget", PROPERTY_HINT_NONE, "", false, true
+	);
+	add_custom_project_setting(
+			Variant::INT,
+			"voxel/threads/main/target_fps",
+			PROPERTY_HINT_RANGE,
+			"1,1000",
+			int(zylann::voxel::VoxelEngine::DEFAULT_MAIN_THREAD_TARGET_FPS),
+			true
+	);
+	add_custom_project_setting(
+			Variant::FLOAT, "voxel/threads/main/budget_ratio/mesh", PROPERTY_HINT_RANGE, "0,1,0.01", 1.f, true
+	);
+	add_custom_project_setting(
+			Variant::FLOAT, "voxel/threads/main/budget_ratio/collision", PROPERTY_HINT_RANGE, "0,1,0.01", 1.f, true
+	);
+	add_custom_project_setting(
+			Variant::FLOAT, "voxel/threads/main/budget_ratio/instancer", PROPERTY_HINT_RANGE, "0,1,0.01", 1.f, true
+	);
+	add_custom_project_setting(
+			Variant::INT,
+			"voxel/threads/io/count",
+			PROPERTY_HINT_RANGE,
+			"1,16",
+			int(zylann::voxel::VoxelEngine::DEFAULT_IO_THREAD_COUNT),
+			true
+	);
 
 	add_custom_project_setting(Variant::BOOL, "voxel/ownership_checks", PROPERTY_HINT_NONE, "", true, true);
 
 	config.inner.main_thread_budget_usec = 1000 * int(ps.get("voxel/threads/main/time_budget_ms"));
+	config.inner.main_thread_budget_adaptive = ps.get("voxel/threads/main/adaptive_time_budget");
+	config.inner.main_thread_target_fps = math::max(1, int(ps.get("voxel/threads/main/target_fps")));
+	config.inner.main_thread_category_budget_ratios[MAIN_THREAD_CATEGORY_MESH] =
+			math::clamp(float(ps.get("voxel/threads/main/budget_ratio/mesh")), 0.f, 1.f);
+	config.inner.main_thread_category_budget_ratios[MAIN_THREAD_CATEGORY_COLLISION] =
+			math::clamp(float(ps.get("voxel/threads/main/budget_ratio/collision")), 0.f, 1.f);
+	config.inner.main_thread_category_budget_ratios[MAIN_THREAD_CATEGORY_INSTANCER] =
+			math::clamp(float(ps.get("voxel/threads/main/budget_ratio/instancer")), 0.f, 1.f);
 
 	config.inner.thread_count_minimum = math::max(1, int(ps.get("voxel/threads/count/minimum")));
 
@@ -68,14 +108,23 @@ VoxelEngine::Config VoxelEngine::get_config_from_godot() {
 	config.inner.thread_count_ratio_over_max =
 			math::clamp(float(ps.get("voxel/threads/count/ratio_over_max")), 0.f, 1.f);
 
+	config.inner.io_thread_count = math::max(1, int(ps.get("voxel/threads/io/count")));
+
 	config.ownership_checks = ps.get("voxel/ownership_checks");
 
 	return config;
 }
 
 VoxelEngine::VoxelEngine() {
+#if defined(ZN_PROFILER_ENABLED) || defined(ZN_PROFILER_TRACE_RECORDER)
 #ifdef ZN_PROFILER_ENABLED
 	CRASH_COND(RenderingServer::get_singleton() == nullptr);
+#else
+	// The built-in trace recorder is compiled in every build, frames are only marked when rendering is available
+	if (RenderingServer::get_singleton() == nullptr) {
+		return;
+	}
+#endif
 	RenderingServer::get_singleton()->connect(
 			VoxelStringNames::get_singleton().frame_post_draw,
 			callable_mp(this, &VoxelEngine::_on_rendering_server_frame_post_draw)
@@ -135,9 +184,57 @@ Dictionary to_dict(const zylann::voxel::VoxelEngine::Stats::ThreadPoolStats &sta
 	return d;
 }
 
+Dictionary to_dict(const MainThreadTimeBudget::CategoryStats &stats) {
+	Dictionary d;
+	d["budget_usec"] = stats.budget_usec;
+	d["spent_usec"] = stats.spent_usec;
+	d["average_spent_usec"] = stats.average_spent_usec;
+	return d;
+}
+
+Dictionary to_dict(const zylann::voxel::VoxelEngine::Stats::MainThreadStats &stats) {
+	Dictionary categories;
+	categories["mesh"] = to_dict(stats.categories[zylann::voxel::VoxelEngine::MAIN_THREAD_CATEGORY_MESH]);
+	categories["collision"] = to_dict(stats.categories[zylann::voxel::VoxelEngine::MAIN_THREAD_CATEGORY_COLLISION]);
+	categories["instancer"] = to_dict(stats.categories[zylann::voxel::VoxelEngine::MAIN_THREAD_CATEGORY_INSTANCER]);
+
+	Dictionary d;
+	d["budget_usec"] = stats.budget_usec;
+	d["adaptive"] = stats.adaptive;
+	d["average_frame_time_usec"] = stats.average_frame_time_usec;
+	d["categories"] = categories;
+	return d;
+}
+
+Dictionary to_dict(const uint64_t count, const TaskLatencyStats::Percentiles &percentiles) {
+	Dictionary d;
+	d["count"] = static_cast<int64_t>(count);
+	d["p50"] = static_cast<int64_t>(percentiles.p50);
+	d["p90"] = static_cast<int64_t>(percentiles.p90);
+	d["p99"] = static_cast<int64_t>(percentiles.p99);
+	return d;
+}
+
+Dictionary to_dict(const TaskLatencyStats::TaskTypeStats &stats) {
+	Dictionary d;
+	d["wait_usec"] = to_dict(
+			stats.counts[TaskLatencyStats::METRIC_WAIT], stats.percentiles_usec[TaskLatencyStats::METRIC_WAIT]
+	);
+	d["run_usec"] =
+			to_dict(stats.counts[TaskLatencyStats::METRIC_RUN], stats.percentiles_usec[TaskLatencyStats::METRIC_RUN]);
+	d["apply_usec"] = to_dict(
+			stats.counts[TaskLatencyStats::METRIC_APPLY], stats.percentiles_usec[TaskLatencyStats::METRIC_APPLY]
+	);
+	d["total_usec"] = to_dict(
+			stats.counts[TaskLatencyStats::METRIC_TOTAL], stats.percentiles_usec[TaskLatencyStats::METRIC_TOTAL]
+	);
+	return d;
+}
+
 Dictionary to_dict(const zylann::voxel::VoxelEngine::Stats &stats) {
 	Dictionary pools;
 	pools["general"] = to_dict(stats.general);
+	pools["io"] = to_dict(stats.io);
 
 	Dictionary tasks;
 	tasks["streaming"] = stats.streaming_tasks;
@@ -148,6 +245,11 @@ Dictionary to_dict(const zylann::voxel::VoxelEngine::Stats &stats) {
 	tasks["gpu"] = stats.gpu_tasks;
 #endif
 
+	Dictionary task_latencies;
+	for (const TaskLatencyStats::TaskTypeStats &task_stats : stats.task_latencies) {
+		task_latencies[String(task_stats.name)] = to_dict(task_stats);
+	}
+
 	// This part is additional for scripts because VoxelMemoryPool is not exposed
 	Dictionary mem;
 	mem["voxel_total"] = ZN_SIZE_T_TO_VARIANT(VoxelMemoryPool::get_singleton().debug_get_total_memory());
@@ -169,6 +271,8 @@ Dictionary to_dict(const zylann::voxel::VoxelEngine::Stats &stats) {
 	d["thread_pools"] = pools;
 	d["tasks"] = tasks;
 	d["memory_pools"] = mem;
+	d["task_latencies"] = task_latencies;
+	d["main_thread"] = to_dict(stats.main_thread);
 	return d;
 }
 
@@ -177,6 +281,29 @@ Dictionary VoxelEngine::get_stats() const {
 	return to_dict(zylann::voxel::VoxelEngine::get_singleton().get_stats());
 }
 
+void VoxelEngine::set_trace_recording_enabled(bool enabled) {
+	zylann::trace_recorder::set_enabled(enabled);
+}
+
+bool VoxelEngine::is_trace_recording_enabled() const {
+	return zylann::trace_recorder::is_enabled();
+}
+
+void VoxelEngine::clear_recorded_trace() {
+	zylann::trace_recorder::clear();
+}
+
+String VoxelEngine::get_recorded_trace_json(float window_seconds) const {
+	ERR_FAIL_COND_V(window_seconds < 0.f, String());
+	StdString json;
+	zylann::trace_recorder::get_chrome_trace_json(json, static_cast<uint64_t>(window_seconds * 1'000'000.0));
+	return to_godot(json);
+}
+
+void VoxelEngine::clear_task_latency_stats() {
+	zylann::voxel::VoxelEngine::get_singleton().clear_task_latency_stats();
+}
+
 int VoxelEngine::get_thread_count() const {
 	return zylann::voxel::VoxelEngine::get_singleton().get_thread_count();
 }
@@ -188,6 +315,37 @@ void VoxelEngine::set_thread_count(int count) {
 	zylann::voxel::VoxelEngine::get_singleton().set_thread_count(static_cast<uint32_t>(count));
 }
 
+void VoxelEngine::set_main_thread_time_budget_adaptive(bool enabled) {
+	zylann::voxel::VoxelEngine::get_singleton().set_main_thread_time_budget_adaptive(enabled);
+}
+
+bool VoxelEngine::is_main_thread_time_budget_adaptive() const {
+	return zylann::voxel::VoxelEngine::get_singleton().is_main_thread_time_budget_adaptive();
+}
+
+void VoxelEngine::set_main_thread_target_fps(int fps) {
+	ERR_FAIL_COND(fps < 1);
+	zylann::voxel::VoxelEngine::get_singleton().set_main_thread_target_fps(static_cast<unsigned int>(fps));
+}
+
+int VoxelEngine::get_main_thread_target_fps() const {
+	return zylann::voxel::VoxelEngine::get_singleton().get_main_thread_target_fps();
+}
+
+void VoxelEngine::set_main_thread_category_budget_ratio(MainThreadCategory category, float ratio) {
+	ERR_FAIL_INDEX(category, MAIN_THREAD_CATEGORY_COUNT);
+	zylann::voxel::VoxelEngine::get_singleton().set_main_thread_category_budget_ratio(
+			static_cast<zylann::voxel::VoxelEngine::MainThreadCategory>(category), ratio
+	);
+}
+
+float VoxelEngine::get_main_thread_category_budget_ratio(MainThreadCategory category) const {
+	ERR_FAIL_INDEX_V(category, MAIN_THREAD_CATEGORY_COUNT, 0.f);
+	return zylann::voxel::VoxelEngine::get_singleton().get_main_thread_category_budget_ratio(
+			static_cast<zylann::voxel::VoxelEngine::MainThreadCategory>(category)
+	);
+}
+
 void VoxelEngine::schedule_task(Ref<ZN_ThreadedTask> task) {
 	ERR_FAIL_COND(task.is_null());
 	ERR_FAIL_COND_MSG(task->is_scheduled(), "Cannot schedule again a task that is already scheduled");
@@ -195,7 +353,7 @@ void VoxelEngine::schedule_task(Ref<ZN_ThreadedTask> task) {
 }
 
 void VoxelEngine::_on_rendering_server_frame_post_draw() {
-#ifdef ZN_PROFILER_ENABLED
+#if defined(ZN_PROFILER_ENABLED) || defined(ZN_PROFILER_TRACE_RECORDER)
 	ZN_PROFILE_MARK_FRAME();
 #endif
 }
@@ -224,6 +382,15 @@ void VoxelEngine::run_tests(Dictionary options_dict) {
 	zylann::voxel::tests::run_voxel_tests(options);
 }
 
+String VoxelEngine::run_benchmarks(Dictionary options_dict) {
+	zylann::testing::TestOptions options(options_dict);
+	const int iterations =
+			options_dict.get("iterations", int(zylann::testing::BenchmarkRunner::DEFAULT_ITERATIONS));
+	StdString json;
+	zylann::voxel::tests::run_voxel_benchmarks(options, math::max(iterations, 1), json);
+	return to_godot(json);
+}
+
 #endif
 
 bool VoxelEngine::_b_get_threaded_graphics_resource_building_enabled() const {
@@ -246,9 +413,37 @@ void VoxelEngine::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("get_version_status"), &VoxelEngine::get_version_status);
 	ClassDB::bind_method(D_METHOD("get_version_git_hash"), &VoxelEngine::get_version_git_hash);
 	ClassDB::bind_method(D_METHOD("get_stats"), &VoxelEngine::get_stats);
+	ClassDB::bind_method(D_METHOD("clear_task_latency_stats"), &VoxelEngine::clear_task_latency_stats);
+
+	ClassDB::bind_method(
+			D_METHOD("set_trace_recording_enabled", "enabled"), &VoxelEngine::set_trace_recording_enabled
+	);
+	ClassDB::bind_method(D_METHOD("is_trace_recording_enabled"), &VoxelEngine::is_trace_recording_enabled);
+	ClassDB::bind_method(D_METHOD("clear_recorded_trace"), &VoxelEngine::clear_recorded_trace);
+	ClassDB::bind_method(
+			D_METHOD("get_recorded_trace_json", "window_seconds"), &VoxelEngine::get_recorded_trace_json, DEFVAL(0.f)
+	);
 	ClassDB::bind_method(D_METHOD("get_thread_count"), &VoxelEngine::get_thread_count);
 	ClassDB::bind_method(D_METHOD("set_thread_count", "count"), &VoxelEngine::set_thread_count);
 
+	ClassDB::bind_method(
+			D_METHOD("set_main_thread_time_budget_adaptive", "enabled"),
+			&VoxelEngine::set_main_thread_time_budget_adaptive
+	);
+	ClassDB::bind_method(
+			D_METHOD("is_main_thread_time_budget_adaptive"), &VoxelEngine::is_main_thread_time_budget_adaptive
+	);
+	ClassDB::bind_method(D_METHOD("set_main_thread_target_fps", "fps"), &VoxelEngine::set_main_thread_target_fps);
+	ClassDB::bind_method(D_METHOD("get_main_thread_target_fps"), &VoxelEngine::get_main_thread_target_fps);
+	ClassDB::bind_method(
+			D_METHOD("set_main_thread_category_budget_ratio", "category", "ratio"),
+			&VoxelEngine::set_main_thread_category_budget_ratio
+	);
+	ClassDB::bind_method(
+			D_METHOD("get_main_thread_category_budget_ratio", "category"),
+			&VoxelEngine::get_main_thread_category_budget_ratio
+	);
+
 	ClassDB::bind_method(
 			D_METHOD("get_threaded_graphics_resource_building_enabled"),
 			&VoxelEngine::_b_get_threaded_graphics_resource_building_enabled
@@ -256,12 +451,18 @@ void VoxelEngine::_bind_methods() {
 
 #ifdef VOXEL_TESTS
 	ClassDB::bind_method(D_METHOD("run_tests", "options"), &VoxelEngine::run_tests);
+	ClassDB::bind_method(D_METHOD("run_benchmarks", "options"), &VoxelEngine::run_benchmarks);
 #endif
 
 	// ClassDB::bind_method(
 	// 		D_METHOD("set_threaded_graphics_resource_building_enabled", "enabled"),
 	// 		&VoxelEngine::_b_set_threaded_graphics_resource_building_enabled
 	// );
+
+	BIND_ENUM_CONSTANT(MAIN_THREAD_CATEGORY_MESH);
+	BIND_ENUM_CONSTANT(MAIN_THREAD_CATEGORY_COLLISION);
+	BIND_ENUM_CONSTANT(MAIN_THREAD_CATEGORY_INSTANCER);
+	BIND_ENUM_CONSTANT(MAIN_THREAD_CATEGORY_COUNT);
 }
 
 } // namespace zylann::voxel::godot
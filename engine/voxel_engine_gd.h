@@ -14,6 +14,13 @@ namespace zylann::voxel::godot {
 class VoxelEngine : public Object {
 	GDCLASS(VoxelEngine, Object)
 public:
+	enum MainThreadCategory {
+		MAIN_THREAD_CATEGORY_MESH = zylann::voxel::VoxelEngine::MAIN_THREAD_CATEGORY_MESH,
+		MAIN_THREAD_CATEGORY_COLLISION = zylann::voxel::VoxelEngine::MAIN_THREAD_CATEGORY_COLLISION,
+		MAIN_THREAD_CATEGORY_INSTANCER = zylann::voxel::VoxelEngine::MAIN_THREAD_CATEGORY_INSTANCER,
+		MAIN_THREAD_CATEGORY_COUNT = zylann::voxel::VoxelEngine::MAIN_THREAD_CATEGORY_COUNT
+	};
+
 	static VoxelEngine *get_singleton();
 	static void create_singleton();
 	static void destroy_singleton();
@@ -36,11 +43,24 @@ public:
 	String get_version_git_hash() const;
 
 	Dictionary get_stats() const;
+	void clear_task_latency_stats();
+
+	void set_trace_recording_enabled(bool enabled);
+	bool is_trace_recording_enabled() const;
+	void clear_recorded_trace();
+	String get_recorded_trace_json(float window_seconds) const;
 	void schedule_task(Ref<ZN_ThreadedTask> task);
 
 	int get_thread_count() const;
 	void set_thread_count(int count);
 
+	void set_main_thread_time_budget_adaptive(bool enabled);
+	bool is_main_thread_time_budget_adaptive() const;
+	void set_main_thread_target_fps(int fps);
+	int get_main_thread_target_fps() const;
+	void set_main_thread_category_budget_ratio(MainThreadCategory category, float ratio);
+	float get_main_thread_category_budget_ratio(MainThreadCategory category) const;
+
 #ifdef TOOLS_ENABLED
 	void set_editor_camera_info(Vector3 position, Vector3 direction);
 	Vector3 get_editor_camera_position() const;
@@ -49,6 +69,7 @@ public:
 
 #ifdef VOXEL_TESTS
 	void run_tests(Dictionary options_dict);
+	String run_benchmarks(Dictionary options_dict);
 #endif
 
 private:
@@ -67,4 +88,6 @@ private:
 
 } // namespace zylann::voxel::godot
 
+VARIANT_ENUM_CAST(zylann::voxel::godot::VoxelEngine::MainThreadCategory)
+
 #endif // VOXEL_ENGINE_GD_H
@@ -0,0 +1,205 @@
+#include "generate_block_batch_task.h"
+#include "../engine/voxel_engine.h"
+#include "../storage/voxel_buffer.h"
+#include "../storage/voxel_data.h"
+#include "../streams/save_block_data_task.h"
+#include "../util/dstack.h"
+#include "../util/io/log.h"
+#include "../util/math/conv.h"
+#include "../util/profiling.h"
+#include "../util/string/format.h"
+#include "../util/tasks/async_dependency_tracker.h"
+
+namespace zylann::voxel {
+
+GenerateBlockBatchTask::GenerateBlockBatchTask(Span<const VoxelGenerator::BlockTaskParams> params) {
+	ZN_ASSERT(params.size() > 0);
+
+	const VoxelGenerator::BlockTaskParams &first = params[0];
+	_format = first.format;
+	_volume_id = first.volume_id;
+	_lod_index = first.lod_index;
+	_block_size = first.block_size;
+	_drop_beyond_max_distance = first.drop_beyond_max_distance;
+	_stream_dependency = first.stream_dependency;
+	_data = first.data;
+	_cancellation_token = first.cancellation_token;
+
+	_blocks.reserve(params.size());
+
+	for (const VoxelGenerator::BlockTaskParams &p : params) {
+#ifdef DEBUG_ENABLED
+		ZN_ASSERT(p.volume_id == _volume_id);
+		ZN_ASSERT(p.lod_index == _lod_index);
+		ZN_ASSERT(p.block_size == _block_size);
+		ZN_ASSERT(p.stream_dependency == _stream_dependency);
+#endif
+		Block block;
+		block.voxels = p.voxels;
+		block.position = p.block_position;
+		block.priority_dependency = p.priority_dependency;
+		block.tracker = p.tracker;
+		_blocks.push_back(std::move(block));
+	}
+
+	VoxelEngine::get_singleton().debug_increment_generate_block_task_counter();
+}
+
+GenerateBlockBatchTask::~GenerateBlockBatchTask() {
+	VoxelEngine::get_singleton().debug_decrement_generate_block_task_counter();
+}
+
+void GenerateBlockBatchTask::run(zylann::ThreadedTaskContext &ctx) {
+	ZN_DSTACK();
+	ZN_PROFILE_SCOPE();
+
+	CRASH_COND(_stream_dependency == nullptr);
+	Ref<VoxelGenerator> generator = _stream_dependency->generator;
+	ERR_FAIL_COND(generator.is_null());
+
+	static thread_local StdVector<VoxelGenerator::VoxelQueryData> tls_queries;
+	static thread_local StdVector<VoxelGenerator::Result> tls_results;
+	tls_queries.clear();
+	tls_results.clear();
+
+	for (Block &block : _blocks) {
+		if (block.voxels == nullptr) {
+			block.voxels = make_shared_instance<VoxelBuffer>(VoxelBuffer::ALLOCATOR_POOL);
+			block.voxels->create(Vector3iUtil::create(_block_size), &_format);
+
+		} else if (!block.voxels->has_format(_format)) {
+			block.voxels->create(Vector3iUtil::create(_block_size), &_format);
+		}
+
+		const Vector3i origin_in_voxels = (block.position << _lod_index) * _block_size;
+		tls_queries.push_back(VoxelGenerator::VoxelQueryData{ *block.voxels, origin_in_voxels, _lod_index });
+	}
+
+	tls_results.resize(tls_queries.size());
+	generator->generate_blocks(to_span(tls_queries), to_span(tls_results));
+
+	for (unsigned int i = 0; i < _blocks.size(); ++i) {
+		Block &block = _blocks[i];
+		block.max_lod_hint = tls_results[i].max_lod_hint;
+
+#ifdef VOXEL_ENABLE_MODIFIERS
+		if (_data != nullptr) {
+			const VoxelGenerator::VoxelQueryData &query = tls_queries[i];
+			_data->get_modifiers().apply(
+					query.voxel_buffer, AABB(query.origin_in_voxels, query.voxel_buffer.get_size() << _lod_index)
+			);
+		}
+#endif
+	}
+
+	// Queries reference our buffers, don't keep them around
+	tls_queries.clear();
+
+	if (_stream_dependency->valid) {
+		Ref<VoxelStream> stream = _stream_dependency->stream;
+
+		if (stream.is_valid() && stream->get_save_generator_output()) {
+			for (const Block &block : _blocks) {
+				ZN_PRINT_VERBOSE(format(
+						"Requesting save of generator output for block {} lod {}", block.position, int(_lod_index)
+				));
+
+				std::shared_ptr<VoxelBuffer> voxels_copy =
+						make_shared_instance<VoxelBuffer>(VoxelBuffer::ALLOCATOR_POOL);
+				block.voxels->copy_to(*voxels_copy, true);
+
+				SaveBlockDataTask *save_task = ZN_NEW(SaveBlockDataTask(
+						_volume_id, block.position, _lod_index, voxels_copy, _stream_dependency, nullptr, false
+				));
+
+				VoxelEngine::get_singleton().push_async_io_task(save_task);
+			}
+		}
+	}
+
+	_has_run = true;
+}
+
+TaskPriority GenerateBlockBatchTask::get_priority() {
+	// The batch runs as soon as its most urgent block would
+	TaskPriority priority = TaskPriority::min();
+	bool all_too_far = true;
+
+	for (Block &block : _blocks) {
+		float closest_viewer_distance_sq;
+		const TaskPriority p = block.priority_dependency.evaluate(
+				_lod_index, constants::TASK_PRIORITY_GENERATE_BAND2, &closest_viewer_distance_sq
+		);
+		if (p > priority) {
+			priority = p;
+		}
+		if (closest_viewer_distance_sq <= block.priority_dependency.drop_distance_squared) {
+			all_too_far = false;
+		}
+	}
+
+	_too_far = _drop_beyond_max_distance && all_too_far;
+	return priority;
+}
+
+bool GenerateBlockBatchTask::is_cancelled() {
+	if (_stream_dependency->valid == false) {
+		return false;
+	}
+	if (_cancellation_token.is_valid()) {
+		return _cancellation_token.is_cancelled();
+	}
+	return _too_far;
+}
+
+void GenerateBlockBatchTask::apply_result() {
+	bool aborted = true;
+
+	if (VoxelEngine::get_singleton().is_volume_valid(_volume_id)) {
+		// The request response must match the dependency it would have been requested with.
+		// If it doesn't match, we are no longer interested in the result.
+		if (_stream_dependency->valid) {
+			Ref<VoxelStream> stream = _stream_dependency->stream;
+
+			VoxelEngine::VolumeCallbacks callbacks = VoxelEngine::get_singleton().get_volume_callbacks(_volume_id);
+			ERR_FAIL_COND(callbacks.data_output_callback == nullptr);
+
+			for (Block &block : _blocks) {
+				VoxelEngine::BlockDataOutput o;
+				o.voxels = block.voxels;
+				o.position = block.position;
+				o.lod_index = _lod_index;
+				o.dropped = !_has_run;
+				if (stream.is_valid() && stream->get_save_generator_output()) {
+					// We can't consider the block as "generated" since there is no state to tell that once saved,
+					// so it has to be considered an edited block
+					o.type = VoxelEngine::BlockDataOutput::TYPE_LOADED;
+				} else {
+					o.type = VoxelEngine::BlockDataOutput::TYPE_GENERATED;
+				}
+				o.max_lod_hint = block.max_lod_hint;
+				o.initial_load = false;
+
+				callbacks.data_output_callback(callbacks.data, o);
+			}
+
+			aborted = !_has_run;
+		}
+
+	} else {
+		// This can happen if the user removes the volume while requests are still about to return
+		ZN_PRINT_VERBOSE("Generated data batch response came back but volume wasn't found");
+	}
+
+	for (Block &block : _blocks) {
+		if (block.tracker != nullptr) {
+			if (aborted) {
+				block.tracker->abort();
+			} else {
+				block.tracker->post_complete();
+			}
+		}
+	}
+}
+
+} // namespace zylann::voxel
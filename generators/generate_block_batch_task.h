@@ -0,0 +1,62 @@
+#ifndef VOXEL_GENERATE_BLOCK_BATCH_TASK_H
+#define VOXEL_GENERATE_BLOCK_BATCH_TASK_H
+
+#include "../engine/ids.h"
+#include "../engine/priority_dependency.h"
+#include "../engine/streaming_dependency.h"
+#include "../util/containers/span.h"
+#include "../util/containers/std_vector.h"
+#include "../util/tasks/threaded_task.h"
+
+namespace zylann {
+
+class AsyncDependencyTracker;
+
+namespace voxel {
+
+class VoxelData;
+
+// Generic task to procedurally generate multiple blocks at once on the CPU, usually neighbors.
+// It allows generators to share work between blocks with `VoxelGenerator::generate_blocks`. Results are returned like
+// `GenerateBlockTask` would, one output per block.
+class GenerateBlockBatchTask : public IThreadedTask {
+public:
+	GenerateBlockBatchTask(Span<const VoxelGenerator::BlockTaskParams> params);
+	~GenerateBlockBatchTask();
+
+	const char *get_debug_name() const override {
+		return "GenerateBlockBatch";
+	}
+
+	void run(ThreadedTaskContext &ctx) override;
+	TaskPriority get_priority() override;
+	bool is_cancelled() override;
+	void apply_result() override;
+
+private:
+	struct Block {
+		std::shared_ptr<VoxelBuffer> voxels;
+		Vector3i position;
+		PriorityDependency priority_dependency;
+		std::shared_ptr<AsyncDependencyTracker> tracker;
+		bool max_lod_hint = false;
+	};
+
+	StdVector<Block> _blocks;
+	VoxelFormat _format;
+	VolumeID _volume_id;
+	uint8_t _lod_index = 0;
+	uint8_t _block_size = 0;
+	bool _drop_beyond_max_distance = true;
+	std::shared_ptr<StreamingDependency> _stream_dependency; // For saving generator output
+	std::shared_ptr<VoxelData> _data; // Just for modifiers
+	TaskCancellationToken _cancellation_token;
+
+	bool _has_run = false;
+	bool _too_far = false;
+};
+
+} // namespace voxel
+} // namespace zylann
+
+#endif // VOXEL_GENERATE_BLOCK_BATCH_TASK_H
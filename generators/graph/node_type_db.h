@@ -82,6 +82,12 @@ struct NodeType {
 	bool debug_only = false;
 	// Pseudo nodes are replaced during compilation with one or multiple real nodes, they have no logic on their own
 	bool is_pseudo_node = false;
+	// Fusable nodes only read and write values at the same index in their buffers, and are cheap enough that running
+	// chains of them one tile at a time is faster than running each of them over whole buffers.
+	bool is_fusable = false;
+	// If true, the node may read values at other indices than the one it writes, so programs using it cannot run over
+	// separate tiles of their buffers.
+	bool requires_whole_buffers = false;
 	Category category;
 	StdVector<Port> inputs;
 	StdVector<Port> outputs;
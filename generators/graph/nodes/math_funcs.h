@@ -14,6 +14,7 @@ void register_math_func_nodes(Span<NodeType> types) {
 		NodeType &t = types[VoxelGraphFunction::NODE_SIN];
 		t.name = "Sin";
 		t.category = CATEGORY_MATH;
+		t.is_fusable = true;
 		t.inputs.push_back(NodeType::Port("x", 0.f, VoxelGraphFunction::AUTO_CONNECT_NONE, false));
 		t.outputs.push_back(NodeType::Port("out"));
 		t.process_buffer_func = [](ProcessBufferContext &ctx) { //
@@ -35,10 +36,11 @@ void register_math_func_nodes(Span<NodeType> types) {
 		NodeType &t = types[VoxelGraphFunction::NODE_FLOOR];
 		t.name = "Floor";
 		t.category = CATEGORY_MATH;
+		t.is_fusable = true;
 		t.inputs.push_back(NodeType::Port("x", 0.f, VoxelGraphFunction::AUTO_CONNECT_NONE, false));
 		t.outputs.push_back(NodeType::Port("out"));
 		t.process_buffer_func = [](ProcessBufferContext &ctx) {
-			do_monop(ctx, [](float a) { return Math::floor(a); });
+			do_monop_simd(ctx, [](auto a) { return math::floor(a); });
 		};
 		t.range_analysis_func = [](RangeAnalysisContext &ctx) {
 			const Interval a = ctx.get_input(0);
@@ -56,10 +58,11 @@ void register_math_func_nodes(Span<NodeType> types) {
 		NodeType &t = types[VoxelGraphFunction::NODE_ABS];
 		t.name = "Abs";
 		t.category = CATEGORY_MATH;
+		t.is_fusable = true;
 		t.inputs.push_back(NodeType::Port("x", 0.f, VoxelGraphFunction::AUTO_CONNECT_NONE, false));
 		t.outputs.push_back(NodeType::Port("out"));
 		t.process_buffer_func = [](ProcessBufferContext &ctx) { //
-			do_monop(ctx, [](float a) { return Math::abs(a); });
+			do_monop_simd(ctx, [](auto a) { return math::abs(a); });
 		};
 		t.range_analysis_func = [](RangeAnalysisContext &ctx) {
 			const Interval a = ctx.get_input(0);
@@ -77,10 +80,11 @@ void register_math_func_nodes(Span<NodeType> types) {
 		NodeType &t = types[VoxelGraphFunction::NODE_SQRT];
 		t.name = "Sqrt";
 		t.category = CATEGORY_MATH;
+		t.is_fusable = true;
 		t.inputs.push_back(NodeType::Port("x", 0.f, VoxelGraphFunction::AUTO_CONNECT_NONE, false));
 		t.outputs.push_back(NodeType::Port("out"));
 		t.process_buffer_func = [](ProcessBufferContext &ctx) { //
-			do_monop(ctx, [](float a) { return Math::sqrt(math::max(a, 0.f)); });
+			do_monop_simd(ctx, [](auto a) { return math::sqrt(math::max(a, decltype(a)(0.f))); });
 		};
 		t.range_analysis_func = [](RangeAnalysisContext &ctx) {
 			const Interval a = ctx.get_input(0);
@@ -98,10 +102,11 @@ void register_math_func_nodes(Span<NodeType> types) {
 		NodeType &t = types[VoxelGraphFunction::NODE_FRACT];
 		t.name = "Fract";
 		t.category = CATEGORY_MATH;
+		t.is_fusable = true;
 		t.inputs.push_back(NodeType::Port("x", 0.f, VoxelGraphFunction::AUTO_CONNECT_NONE, false));
 		t.outputs.push_back(NodeType::Port("out"));
 		t.process_buffer_func = [](ProcessBufferContext &ctx) {
-			do_monop(ctx, [](float a) { return a - Math::floor(a); });
+			do_monop_simd(ctx, [](auto a) { return a - math::floor(a); });
 		};
 		t.range_analysis_func = [](RangeAnalysisContext &ctx) {
 			const Interval a = ctx.get_input(0);
@@ -119,6 +124,7 @@ void register_math_func_nodes(Span<NodeType> types) {
 		NodeType &t = types[VoxelGraphFunction::NODE_STEPIFY];
 		t.name = "Stepify";
 		t.category = CATEGORY_CONVERT;
+		t.is_fusable = true;
 		t.inputs.push_back(NodeType::Port("x", 0.f, VoxelGraphFunction::AUTO_CONNECT_NONE, false));
 		t.inputs.push_back(NodeType::Port("step", 1.f, VoxelGraphFunction::AUTO_CONNECT_NONE, false));
 		t.outputs.push_back(NodeType::Port("out"));
@@ -150,6 +156,7 @@ void register_math_func_nodes(Span<NodeType> types) {
 		NodeType &t = types[VoxelGraphFunction::NODE_WRAP];
 		t.name = "Wrap";
 		t.category = CATEGORY_MATH;
+		t.is_fusable = true;
 		t.inputs.push_back(NodeType::Port("x", 0.f, VoxelGraphFunction::AUTO_CONNECT_NONE, false));
 		t.inputs.push_back(NodeType::Port("length", 1.f, VoxelGraphFunction::AUTO_CONNECT_NONE, false));
 		t.outputs.push_back(NodeType::Port("out"));
@@ -181,11 +188,12 @@ void register_math_func_nodes(Span<NodeType> types) {
 		NodeType &t = types[VoxelGraphFunction::NODE_MIN];
 		t.name = "Min";
 		t.category = CATEGORY_MATH;
+		t.is_fusable = true;
 		t.inputs.push_back(NodeType::Port("a", 0.f, VoxelGraphFunction::AUTO_CONNECT_NONE, false));
 		t.inputs.push_back(NodeType::Port("b", 0.f, VoxelGraphFunction::AUTO_CONNECT_NONE, false));
 		t.outputs.push_back(NodeType::Port("out"));
 		t.process_buffer_func = [](ProcessBufferContext &ctx) {
-			do_binop(ctx, [](float a, float b) { return min(a, b); });
+			do_binop_simd(ctx, [](auto a, auto b) { return math::min(a, b); });
 		};
 		t.range_analysis_func = [](RangeAnalysisContext &ctx) {
 			const Interval a = ctx.get_input(0);
@@ -204,11 +212,12 @@ void register_math_func_nodes(Span<NodeType> types) {
 		NodeType &t = types[VoxelGraphFunction::NODE_MAX];
 		t.name = "Max";
 		t.category = CATEGORY_MATH;
+		t.is_fusable = true;
 		t.inputs.push_back(NodeType::Port("a", 0.f, VoxelGraphFunction::AUTO_CONNECT_NONE, false));
 		t.inputs.push_back(NodeType::Port("b", 0.f, VoxelGraphFunction::AUTO_CONNECT_NONE, false));
 		t.outputs.push_back(NodeType::Port("out"));
 		t.process_buffer_func = [](ProcessBufferContext &ctx) {
-			do_binop(ctx, [](float a, float b) { return max(a, b); });
+			do_binop_simd(ctx, [](auto a, auto b) { return math::max(a, b); });
 		};
 		t.range_analysis_func = [](RangeAnalysisContext &ctx) {
 			const Interval a = ctx.get_input(0);
@@ -227,6 +236,7 @@ void register_math_func_nodes(Span<NodeType> types) {
 		NodeType &t = types[VoxelGraphFunction::NODE_CLAMP];
 		t.name = "Clamp";
 		t.category = CATEGORY_CONVERT;
+		t.is_fusable = true;
 		t.inputs.push_back(NodeType::Port("x"));
 		t.inputs.push_back(NodeType::Port("min", -1.f));
 		t.inputs.push_back(NodeType::Port("max", 1.f));
@@ -236,9 +246,16 @@ void register_math_func_nodes(Span<NodeType> types) {
 			const Runtime::Buffer &minv = ctx.get_input(1);
 			const Runtime::Buffer &maxv = ctx.get_input(2);
 			Runtime::Buffer &out = ctx.get_output(0);
-			for (uint32_t i = 0; i < out.size; ++i) {
-				out.data[i] = clamp(a.data[i], minv.data[i], maxv.data[i]);
-			}
+			simd_map(
+					out.data,
+					out.size,
+					[](auto x, auto lo, auto hi) { //
+						return math::clamp(x, lo, hi);
+					},
+					a.data,
+					minv.data,
+					maxv.data
+			);
 		};
 		t.range_analysis_func = [](RangeAnalysisContext &ctx) {
 			const Interval a = ctx.get_input(0);
@@ -268,6 +285,7 @@ void register_math_func_nodes(Span<NodeType> types) {
 		NodeType &t = types[VoxelGraphFunction::NODE_CLAMP_C];
 		t.name = "ClampC";
 		t.category = CATEGORY_CONVERT;
+		t.is_fusable = true;
 		t.inputs.push_back(NodeType::Port("x"));
 		t.outputs.push_back(NodeType::Port("out"));
 		t.params.push_back(NodeType::Param("min", Variant::FLOAT, -1.f));
@@ -282,9 +300,15 @@ void register_math_func_nodes(Span<NodeType> types) {
 			const Runtime::Buffer &a = ctx.get_input(0);
 			Runtime::Buffer &out = ctx.get_output(0);
 			const Params p = ctx.get_params<Params>();
-			for (uint32_t i = 0; i < out.size; ++i) {
-				out.data[i] = clamp(a.data[i], p.min, p.max);
-			}
+			simd_map(
+					out.data,
+					out.size,
+					[p](auto x) {
+						using T = decltype(x);
+						return math::clamp(x, T(p.min), T(p.max));
+					},
+					a.data
+			);
 		};
 		t.range_analysis_func = [](RangeAnalysisContext &ctx) {
 			const Interval a = ctx.get_input(0);
@@ -307,6 +331,7 @@ void register_math_func_nodes(Span<NodeType> types) {
 		NodeType &t = types[VoxelGraphFunction::NODE_MIX];
 		t.name = "Mix";
 		t.category = CATEGORY_CONVERT;
+		t.is_fusable = true;
 		t.inputs.push_back(NodeType::Port("a"));
 		t.inputs.push_back(NodeType::Port("b"));
 		t.inputs.push_back(NodeType::Port("ratio"));
@@ -324,18 +349,30 @@ void register_math_func_nodes(Span<NodeType> types) {
 				const float ca = a.constant_value;
 				if (b.is_constant) {
 					const float cb = b.constant_value;
-					for (uint32_t i = 0; i < buffer_size; ++i) {
-						out.data[i] = Math::lerp(ca, cb, r.data[i]);
-					}
+					simd_map(
+							out.data,
+							buffer_size,
+							[ca, cb](auto v) {
+								using T = decltype(v);
+								return math::lerp(T(ca), T(cb), v);
+							},
+							r.data
+					);
 				} else {
 					if (b_ignored) {
 						for (uint32_t i = 0; i < buffer_size; ++i) {
 							out.data[i] = ca;
 						}
 					} else {
-						for (uint32_t i = 0; i < buffer_size; ++i) {
-							out.data[i] = Math::lerp(ca, b.data[i], r.data[i]);
-						}
+						simd_map(
+								out.data,
+								buffer_size,
+								[ca](auto vb, auto vr) { //
+									return math::lerp(decltype(vb)(ca), vb, vr);
+								},
+								b.data,
+								r.data
+						);
 					}
 				}
 			} else if (b.is_constant) {
@@ -345,9 +382,15 @@ void register_math_func_nodes(Span<NodeType> types) {
 						out.data[i] = cb;
 					}
 				} else {
-					for (uint32_t i = 0; i < buffer_size; ++i) {
-						out.data[i] = Math::lerp(a.data[i], cb, r.data[i]);
-					}
+					simd_map(
+							out.data,
+							buffer_size,
+							[cb](auto va, auto vr) { //
+								return math::lerp(va, decltype(va)(cb), vr);
+							},
+							a.data,
+							r.data
+					);
 				}
 			} else {
 				if (a_ignored) {
@@ -359,9 +402,16 @@ void register_math_func_nodes(Span<NodeType> types) {
 						out.data[i] = a.data[i];
 					}
 				} else {
-					for (uint32_t i = 0; i < buffer_size; ++i) {
-						out.data[i] = Math::lerp(a.data[i], b.data[i], r.data[i]);
-					}
+					simd_map(
+							out.data,
+							buffer_size,
+							[](auto va, auto vb, auto vr) { //
+								return math::lerp(va, vb, vr);
+							},
+							a.data,
+							b.data,
+							r.data
+					);
 				}
 			}
 		};
@@ -411,6 +461,7 @@ void register_math_func_nodes(Span<NodeType> types) {
 		NodeType &t = types[VoxelGraphFunction::NODE_REMAP];
 		t.name = "Remap";
 		t.category = CATEGORY_CONVERT;
+		t.is_fusable = true;
 		t.inputs.push_back(NodeType::Port("x"));
 		t.outputs.push_back(NodeType::Port("out"));
 		t.params.push_back(NodeType::Param("min0", Variant::FLOAT, -1.f));
@@ -428,9 +479,15 @@ void register_math_func_nodes(Span<NodeType> types) {
 			const Runtime::Buffer &x = ctx.get_input(0);
 			Runtime::Buffer &out = ctx.get_output(0);
 			const Params p = ctx.get_params<Params>();
-			for (uint32_t i = 0; i < out.size; ++i) {
-				out.data[i] = p.a * x.data[i] + p.b;
-			}
+			simd_map(
+					out.data,
+					out.size,
+					[p](auto v) {
+						using T = decltype(v);
+						return T(p.a) * v + T(p.b);
+					},
+					x.data
+			);
 		};
 		t.range_analysis_func = [](RangeAnalysisContext &ctx) {
 			const Interval x = ctx.get_input(0);
@@ -452,6 +509,7 @@ void register_math_func_nodes(Span<NodeType> types) {
 		NodeType &t = types[VoxelGraphFunction::NODE_SMOOTHSTEP];
 		t.name = "Smoothstep";
 		t.category = CATEGORY_CONVERT;
+		t.is_fusable = true;
 		t.inputs.push_back(NodeType::Port("x"));
 		t.outputs.push_back(NodeType::Port("out"));
 		t.params.push_back(NodeType::Param("edge0", Variant::FLOAT, 0.f));
@@ -466,9 +524,23 @@ void register_math_func_nodes(Span<NodeType> types) {
 			const Runtime::Buffer &a = ctx.get_input(0);
 			Runtime::Buffer &out = ctx.get_output(0);
 			const Params p = ctx.get_params<Params>();
-			for (uint32_t i = 0; i < out.size; ++i) {
-				out.data[i] = smoothstep(p.edge0, p.edge1, a.data[i]);
+			if (Math::is_equal_approx(p.edge0, p.edge1)) {
+				// Same as `smoothstep`
+				for (uint32_t i = 0; i < out.size; ++i) {
+					out.data[i] = p.edge0;
+				}
+				return;
 			}
+			simd_map(
+					out.data,
+					out.size,
+					[p](auto x) {
+						using T = decltype(x);
+						const T w = math::clamp((x - T(p.edge0)) / T(p.edge1 - p.edge0), T(0.f), T(1.f));
+						return w * w * (T(3.f) - T(2.f) * w);
+					},
+					a.data
+			);
 		};
 		t.range_analysis_func = [](RangeAnalysisContext &ctx) {
 			const Interval a = ctx.get_input(0);
@@ -493,6 +565,7 @@ void register_math_func_nodes(Span<NodeType> types) {
 		NodeType &t = types[VoxelGraphFunction::NODE_POWI];
 		t.name = "Powi";
 		t.category = CATEGORY_MATH;
+		t.is_fusable = true;
 		t.inputs.push_back(NodeType::Port("x"));
 		t.params.push_back(NodeType::Param("power", Variant::INT, 2));
 		t.outputs.push_back(NodeType::Port("out"));
@@ -556,6 +629,7 @@ void register_math_func_nodes(Span<NodeType> types) {
 		NodeType &t = types[VoxelGraphFunction::NODE_POW];
 		t.name = "Pow";
 		t.category = CATEGORY_MATH;
+		t.is_fusable = true;
 		t.inputs.push_back(NodeType::Port("x"));
 		t.inputs.push_back(NodeType::Port("p", 2.f));
 		t.outputs.push_back(NodeType::Port("out"));
@@ -14,10 +14,14 @@ void do_division(Runtime::ProcessBufferContext &ctx) {
 	if (a.is_constant || b.is_constant) {
 		if (!b.is_constant) {
 			const float c = a.constant_value;
-			const float *v = b.data;
-			for (uint32_t i = 0; i < buffer_size; ++i) {
-				out.data[i] = v[i] == 0.f ? 0.f : c / v[i];
-			}
+			simd_map(
+					out.data,
+					buffer_size,
+					[c](auto v) { //
+						return math::div_or_zero(decltype(v)(c), v);
+					},
+					b.data
+			);
 
 		} else if (!a.is_constant) {
 			if (b.constant_value == 0.f) {
@@ -26,10 +30,14 @@ void do_division(Runtime::ProcessBufferContext &ctx) {
 				}
 			} else {
 				const float c = 1.f / b.constant_value;
-				const float *v = a.data;
-				for (uint32_t i = 0; i < buffer_size; ++i) {
-					out.data[i] = v[i] * c;
-				}
+				simd_map(
+						out.data,
+						buffer_size,
+						[c](auto v) { //
+							return v * decltype(v)(c);
+						},
+						a.data
+				);
 			}
 		} else {
 			// Normally this case should have been optimized out at compile-time
@@ -40,13 +48,15 @@ void do_division(Runtime::ProcessBufferContext &ctx) {
 		}
 
 	} else {
-		for (uint32_t i = 0; i < buffer_size; ++i) {
-			if (b.data[i] == 0.f) {
-				out.data[i] = 0.f;
-			} else {
-				out.data[i] = a.data[i] / b.data[i];
-			}
-		}
+		simd_map(
+				out.data,
+				buffer_size,
+				[](auto x, auto y) { //
+					return math::div_or_zero(x, y);
+				},
+				a.data,
+				b.data
+		);
 	}
 }
 
@@ -57,12 +67,13 @@ void register_math_ops_nodes(Span<NodeType> types) {
 		NodeType &t = types[VoxelGraphFunction::NODE_ADD];
 		t.name = "Add";
 		t.category = CATEGORY_MATH;
+		t.is_fusable = true;
 		t.inputs.push_back(NodeType::Port("a", 0.f, VoxelGraphFunction::AUTO_CONNECT_NONE, false));
 		t.inputs.push_back(NodeType::Port("b", 0.f, VoxelGraphFunction::AUTO_CONNECT_NONE, false));
 		t.outputs.push_back(NodeType::Port("out"));
 		t.compile_func = nullptr;
 		t.process_buffer_func = [](Runtime::ProcessBufferContext &ctx) {
-			do_binop(ctx, [](float a, float b) { return a + b; });
+			do_binop_simd(ctx, [](auto a, auto b) { return a + b; });
 		};
 		t.range_analysis_func = [](Runtime::RangeAnalysisContext &ctx) {
 			const Interval a = ctx.get_input(0);
@@ -77,11 +88,12 @@ void register_math_ops_nodes(Span<NodeType> types) {
 		NodeType &t = types[VoxelGraphFunction::NODE_SUBTRACT];
 		t.name = "Subtract";
 		t.category = CATEGORY_MATH;
+		t.is_fusable = true;
 		t.inputs.push_back(NodeType::Port("a", 0.f, VoxelGraphFunction::AUTO_CONNECT_NONE, false));
 		t.inputs.push_back(NodeType::Port("b", 0.f, VoxelGraphFunction::AUTO_CONNECT_NONE, false));
 		t.outputs.push_back(NodeType::Port("out"));
 		t.process_buffer_func = [](Runtime::ProcessBufferContext &ctx) {
-			do_binop(ctx, [](float a, float b) { return a - b; });
+			do_binop_simd(ctx, [](auto a, auto b) { return a - b; });
 		};
 		t.range_analysis_func = [](Runtime::RangeAnalysisContext &ctx) {
 			const Interval a = ctx.get_input(0);
@@ -96,11 +108,12 @@ void register_math_ops_nodes(Span<NodeType> types) {
 		NodeType &t = types[VoxelGraphFunction::NODE_MULTIPLY];
 		t.name = "Multiply";
 		t.category = CATEGORY_MATH;
+		t.is_fusable = true;
 		t.inputs.push_back(NodeType::Port("a", 0.f, VoxelGraphFunction::AUTO_CONNECT_NONE, false));
 		t.inputs.push_back(NodeType::Port("b", 0.f, VoxelGraphFunction::AUTO_CONNECT_NONE, false));
 		t.outputs.push_back(NodeType::Port("out"));
 		t.process_buffer_func = [](Runtime::ProcessBufferContext &ctx) {
-			do_binop(ctx, [](float a, float b) { return a * b; });
+			do_binop_simd(ctx, [](auto a, auto b) { return a * b; });
 		};
 		t.range_analysis_func = [](Runtime::RangeAnalysisContext &ctx) {
 			const Interval a = ctx.get_input(0);
@@ -120,6 +133,7 @@ void register_math_ops_nodes(Span<NodeType> types) {
 		NodeType &t = types[VoxelGraphFunction::NODE_DIVIDE];
 		t.name = "Divide";
 		t.category = CATEGORY_MATH;
+		t.is_fusable = true;
 		t.inputs.push_back(NodeType::Port("a", 0.f, VoxelGraphFunction::AUTO_CONNECT_NONE, false));
 		t.inputs.push_back(NodeType::Port("b", 1.f, VoxelGraphFunction::AUTO_CONNECT_NONE, false));
 		t.outputs.push_back(NodeType::Port("out"));
@@ -1,5 +1,6 @@
 #include "../../../util/profiling.h"
 #include "../node_type_db.h"
+#include "util.h"
 
 namespace zylann::voxel::pg {
 
@@ -10,6 +11,7 @@ void register_math_vector_nodes(Span<NodeType> types) {
 		NodeType &t = types[VoxelGraphFunction::NODE_DISTANCE_2D];
 		t.name = "Distance2D";
 		t.category = CATEGORY_MATH;
+		t.is_fusable = true;
 		t.inputs.push_back(NodeType::Port("x0"));
 		t.inputs.push_back(NodeType::Port("y0"));
 		t.inputs.push_back(NodeType::Port("x1", 0.f, VoxelGraphFunction::AUTO_CONNECT_X));
@@ -21,9 +23,17 @@ void register_math_vector_nodes(Span<NodeType> types) {
 			const Runtime::Buffer &x1 = ctx.get_input(2);
 			const Runtime::Buffer &y1 = ctx.get_input(3);
 			Runtime::Buffer &out = ctx.get_output(0);
-			for (uint32_t i = 0; i < out.size; ++i) {
-				out.data[i] = Math::sqrt(squared(x1.data[i] - x0.data[i]) + squared(y1.data[i] - y0.data[i]));
-			}
+			simd_map(
+					out.data,
+					out.size,
+					[](auto vx0, auto vy0, auto vx1, auto vy1) { //
+						return math::sqrt(squared(vx1 - vx0) + squared(vy1 - vy0));
+					},
+					x0.data,
+					y0.data,
+					x1.data,
+					y1.data
+			);
 		};
 		t.range_analysis_func = [](Runtime::RangeAnalysisContext &ctx) {
 			const Interval x0 = ctx.get_input(0);
@@ -50,6 +60,7 @@ void register_math_vector_nodes(Span<NodeType> types) {
 		NodeType &t = types[VoxelGraphFunction::NODE_DISTANCE_3D];
 		t.name = "Distance3D";
 		t.category = CATEGORY_MATH;
+		t.is_fusable = true;
 		t.inputs.push_back(NodeType::Port("x0"));
 		t.inputs.push_back(NodeType::Port("y0"));
 		t.inputs.push_back(NodeType::Port("z0"));
@@ -65,12 +76,19 @@ void register_math_vector_nodes(Span<NodeType> types) {
 			const Runtime::Buffer &y1 = ctx.get_input(4);
 			const Runtime::Buffer &z1 = ctx.get_input(5);
 			Runtime::Buffer &out = ctx.get_output(0);
-			for (uint32_t i = 0; i < out.size; ++i) {
-				out.data[i] = Math::sqrt(
-						squared(x1.data[i] - x0.data[i]) + squared(y1.data[i] - y0.data[i]) +
-						squared(z1.data[i] - z0.data[i])
-				);
-			}
+			simd_map(
+					out.data,
+					out.size,
+					[](auto vx0, auto vy0, auto vz0, auto vx1, auto vy1, auto vz1) { //
+						return math::sqrt(squared(vx1 - vx0) + squared(vy1 - vy0) + squared(vz1 - vz0));
+					},
+					x0.data,
+					y0.data,
+					z0.data,
+					x1.data,
+					y1.data,
+					z1.data
+			);
 		};
 		t.range_analysis_func = [](Runtime::RangeAnalysisContext &ctx) {
 			const Interval x0 = ctx.get_input(0);
@@ -102,6 +120,7 @@ void register_math_vector_nodes(Span<NodeType> types) {
 		NodeType &t = types[VoxelGraphFunction::NODE_NORMALIZE_3D];
 		t.name = "Normalize";
 		t.category = CATEGORY_MATH;
+		t.is_fusable = true;
 		t.inputs.push_back(NodeType::Port("x", 1.f, VoxelGraphFunction::AUTO_CONNECT_X));
 		t.inputs.push_back(NodeType::Port("y", 1.f, VoxelGraphFunction::AUTO_CONNECT_Y));
 		t.inputs.push_back(NodeType::Port("z", 1.f, VoxelGraphFunction::AUTO_CONNECT_Z));
@@ -120,7 +139,19 @@ void register_math_vector_nodes(Span<NodeType> types) {
 			Runtime::Buffer &out_nz = ctx.get_output(2);
 			Runtime::Buffer &out_len = ctx.get_output(3);
 			const uint32_t buffer_size = out_nx.size;
-			for (uint32_t i = 0; i < buffer_size; ++i) {
+			const uint32_t simd_size = buffer_size - buffer_size % Float4::SIZE;
+			uint32_t i = 0;
+			for (; i < simd_size; i += Float4::SIZE) {
+				const Float4 x = Float4::load(xb.data + i);
+				const Float4 y = Float4::load(yb.data + i);
+				const Float4 z = Float4::load(zb.data + i);
+				const Float4 len = math::sqrt(x * x + y * y + z * z);
+				(x / len).store(out_nx.data + i);
+				(y / len).store(out_ny.data + i);
+				(z / len).store(out_nz.data + i);
+				len.store(out_len.data + i);
+			}
+			for (; i < buffer_size; ++i) {
 				const float x = xb.data[i];
 				const float y = yb.data[i];
 				const float z = zb.data[i];
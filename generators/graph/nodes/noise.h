@@ -300,9 +300,11 @@ void register_noise_nodes(Span<NodeType> types) {
 			const Runtime::Buffer &y = ctx.get_input(1);
 			Runtime::Buffer &out = ctx.get_output(0);
 			const Params p = ctx.get_params<Params>();
-			for (uint32_t i = 0; i < out.size; ++i) {
-				out.data[i] = p.noise->get_noise_2d(x.data[i], y.data[i]);
-			}
+			p.noise->get_noise_2d_series(
+					Span<const float>(x.data, x.size),
+					Span<const float>(y.data, y.size),
+					Span<float>(out.data, out.size)
+			);
 		};
 
 		t.range_analysis_func = [](Runtime::RangeAnalysisContext &ctx) {
@@ -371,9 +373,12 @@ void register_noise_nodes(Span<NodeType> types) {
 			const Runtime::Buffer &z = ctx.get_input(2);
 			Runtime::Buffer &out = ctx.get_output(0);
 			const Params p = ctx.get_params<Params>();
-			for (uint32_t i = 0; i < out.size; ++i) {
-				out.data[i] = p.noise->get_noise_3d(x.data[i], y.data[i], z.data[i]);
-			}
+			p.noise->get_noise_3d_series(
+					Span<const float>(x.data, x.size),
+					Span<const float>(y.data, y.size),
+					Span<const float>(z.data, z.size),
+					Span<float>(out.data, out.size)
+			);
 		};
 
 		t.range_analysis_func = [](Runtime::RangeAnalysisContext &ctx) {
@@ -620,6 +625,27 @@ void register_noise_nodes(Span<NodeType> types) {
 			const Runtime::Buffer &y = ctx.get_input(1);
 			Runtime::Buffer &out = ctx.get_output(0);
 			const Params p = ctx.get_params<Params>();
+
+			const Runtime::InputGrid *grid = ctx.get_input_grid();
+			if (grid != nullptr && ctx.get_input_grid_axis(0) == 0 && ctx.get_input_grid_axis(1) == 2) {
+				// Inputs are directly X and Z of a grid, which is faster to generate. The result only changes
+				// along X and Z, so it is generated once and copied to every Y layer.
+				const unsigned int layer_volume = grid->size.x * grid->size.z;
+				if (layer_volume >= FastNoise2::MIN_BUFFER_SIZE && layer_volume * grid->size.y == out.size) {
+					Span<float> layer(out.data, layer_volume);
+					p.noise->get_noise_2d_grid(
+							Vector2i(grid->origin.x, grid->origin.z),
+							Vector2i(grid->size.x, grid->size.z),
+							grid->step,
+							layer
+					);
+					for (int layer_index = 1; layer_index < grid->size.y; ++layer_index) {
+						layer.copy_to(Span<float>(out.data + layer_index * layer_volume, layer_volume));
+					}
+					return;
+				}
+			}
+
 			p.noise->get_noise_2d_series(
 					Span<const float>(x.data, x.size),
 					Span<const float>(y.data, y.size),
@@ -674,6 +700,26 @@ void register_noise_nodes(Span<NodeType> types) {
 			const Runtime::Buffer &z = ctx.get_input(2);
 			Runtime::Buffer &out = ctx.get_output(0);
 			const Params p = ctx.get_params<Params>();
+
+			const Runtime::InputGrid *grid = ctx.get_input_grid();
+			if (grid != nullptr && ctx.get_input_grid_axis(0) == 0 && ctx.get_input_grid_axis(1) == 1 &&
+				ctx.get_input_grid_axis(2) == 2) {
+				// Inputs are directly X, Y and Z of a grid, which is faster to generate.
+				// FastNoise2 orders grids with Z last, while ours has Y last, so it is generated one layer at a time.
+				const unsigned int layer_volume = grid->size.x * grid->size.z;
+				if (layer_volume >= FastNoise2::MIN_BUFFER_SIZE && layer_volume * grid->size.y == out.size) {
+					for (int layer_index = 0; layer_index < grid->size.y; ++layer_index) {
+						p.noise->get_noise_3d_grid(
+								Vector3i(grid->origin.x, grid->origin.y + layer_index, grid->origin.z),
+								Vector3i(grid->size.x, 1, grid->size.z),
+								grid->step,
+								Span<float>(out.data + layer_index * layer_volume, layer_volume)
+						);
+					}
+					return;
+				}
+			}
+
 			p.noise->get_noise_3d_series(
 					Span<const float>(x.data, x.size),
 					Span<const float>(y.data, y.size),
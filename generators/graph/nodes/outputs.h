@@ -9,6 +9,7 @@ void register_output_nodes(Span<NodeType> types) {
 		NodeType &t = types[VoxelGraphFunction::NODE_OUTPUT_SDF];
 		t.name = "OutputSDF";
 		t.category = CATEGORY_OUTPUT;
+		t.is_fusable = true;
 		t.inputs.push_back(NodeType::Port("sdf", 0.f, VoxelGraphFunction::AUTO_CONNECT_Y));
 		t.outputs.push_back(NodeType::Port("_out"));
 		t.process_buffer_func = [](Runtime::ProcessBufferContext &ctx) {
@@ -26,6 +27,7 @@ void register_output_nodes(Span<NodeType> types) {
 		NodeType &t = types[VoxelGraphFunction::NODE_OUTPUT_WEIGHT];
 		t.name = "OutputWeight";
 		t.category = CATEGORY_OUTPUT;
+		t.is_fusable = true;
 		t.inputs.push_back(NodeType::Port("weight"));
 		t.outputs.push_back(NodeType::Port("_out"));
 		NodeType::Param layer_param("layer", Variant::INT, 0);
@@ -49,6 +51,7 @@ void register_output_nodes(Span<NodeType> types) {
 		NodeType &t = types[VoxelGraphFunction::NODE_OUTPUT_TYPE];
 		t.name = "OutputType";
 		t.category = CATEGORY_OUTPUT;
+		t.is_fusable = true;
 		t.inputs.push_back(NodeType::Port("type"));
 		t.outputs.push_back(NodeType::Port("_out"));
 		t.process_buffer_func = [](Runtime::ProcessBufferContext &ctx) {
@@ -12,11 +12,12 @@ void register_sdf_nodes(Span<NodeType> types) {
 		NodeType &t = types[VoxelGraphFunction::NODE_SDF_PLANE];
 		t.name = "SdfPlane";
 		t.category = CATEGORY_SDF;
+		t.is_fusable = true;
 		t.inputs.push_back(NodeType::Port("y", 0.f, VoxelGraphFunction::AUTO_CONNECT_Y));
 		t.inputs.push_back(NodeType::Port("height"));
 		t.outputs.push_back(NodeType::Port("sdf"));
 		t.process_buffer_func = [](Runtime::ProcessBufferContext &ctx) {
-			do_binop(ctx, [](float a, float b) { return a - b; });
+			do_binop_simd(ctx, [](auto a, auto b) { return a - b; });
 		};
 		t.range_analysis_func = [](Runtime::RangeAnalysisContext &ctx) {
 			const Interval a = ctx.get_input(0);
@@ -36,6 +37,7 @@ void register_sdf_nodes(Span<NodeType> types) {
 		NodeType &t = types[VoxelGraphFunction::NODE_SDF_BOX];
 		t.name = "SdfBox";
 		t.category = CATEGORY_SDF;
+		t.is_fusable = true;
 		t.inputs.push_back(NodeType::Port("x", 0.f, VoxelGraphFunction::AUTO_CONNECT_X));
 		t.inputs.push_back(NodeType::Port("y", 0.f, VoxelGraphFunction::AUTO_CONNECT_Y));
 		t.inputs.push_back(NodeType::Port("z", 0.f, VoxelGraphFunction::AUTO_CONNECT_Z));
@@ -56,10 +58,26 @@ void register_sdf_nodes(Span<NodeType> types) {
 			const Runtime::Buffer &z = ctx.get_input(2);
 			const Params p = ctx.get_params<Params>();
 			Runtime::Buffer &out = ctx.get_output(0);
-			const Vector3f size(p.size_x, p.size_y, p.size_z);
-			for (uint32_t i = 0; i < out.size; ++i) {
-				out.data[i] = math::sdf_box(Vector3f(x.data[i], y.data[i], z.data[i]), size);
-			}
+			simd_map(
+					out.data,
+					out.size,
+					[p](auto vx, auto vy, auto vz) {
+						// Same as `math::sdf_box`, written per component so it also works with `Float4`
+						using T = decltype(vx);
+						const T zero(0.f);
+						const T dx = math::abs(vx) - T(p.size_x);
+						const T dy = math::abs(vy) - T(p.size_y);
+						const T dz = math::abs(vz) - T(p.size_z);
+						const T mx = math::max(dx, zero);
+						const T my = math::max(dy, zero);
+						const T mz = math::max(dz, zero);
+						return math::min(math::max(dx, math::max(dy, dz)), zero) +
+								math::sqrt(mx * mx + my * my + mz * mz);
+					},
+					x.data,
+					y.data,
+					z.data
+			);
 		};
 		t.range_analysis_func = [](Runtime::RangeAnalysisContext &ctx) {
 			const Interval x = ctx.get_input(0);
@@ -95,6 +113,7 @@ void register_sdf_nodes(Span<NodeType> types) {
 		NodeType &t = types[VoxelGraphFunction::NODE_SDF_SPHERE];
 		t.name = "SdfSphere";
 		t.category = CATEGORY_SDF;
+		t.is_fusable = true;
 		t.inputs.push_back(NodeType::Port("x", 0.f, VoxelGraphFunction::AUTO_CONNECT_X));
 		t.inputs.push_back(NodeType::Port("y", 0.f, VoxelGraphFunction::AUTO_CONNECT_Y));
 		t.inputs.push_back(NodeType::Port("z", 0.f, VoxelGraphFunction::AUTO_CONNECT_Z));
@@ -108,14 +127,30 @@ void register_sdf_nodes(Span<NodeType> types) {
 			const Runtime::Buffer &r = ctx.get_input(3);
 			Runtime::Buffer &out = ctx.get_output(0);
 			if (r.is_constant) {
-				for (uint32_t i = 0; i < out.size; ++i) {
-					out.data[i] =
-							Math::sqrt(squared(x.data[i]) + squared(y.data[i]) + squared(z.data[i])) - r.constant_value;
-				}
+				const float radius = r.constant_value;
+				simd_map(
+						out.data,
+						out.size,
+						[radius](auto vx, auto vy, auto vz) {
+							using T = decltype(vx);
+							return math::sqrt(squared(vx) + squared(vy) + squared(vz)) - T(radius);
+						},
+						x.data,
+						y.data,
+						z.data
+				);
 			} else {
-				for (uint32_t i = 0; i < out.size; ++i) {
-					out.data[i] = Math::sqrt(squared(x.data[i]) + squared(y.data[i]) + squared(z.data[i])) - r.data[i];
-				}
+				simd_map(
+						out.data,
+						out.size,
+						[](auto vx, auto vy, auto vz, auto vr) {
+							return math::sqrt(squared(vx) + squared(vy) + squared(vz)) - vr;
+						},
+						x.data,
+						y.data,
+						z.data,
+						r.data
+				);
 			}
 		};
 		t.range_analysis_func = [](Runtime::RangeAnalysisContext &ctx) {
@@ -144,6 +179,7 @@ void register_sdf_nodes(Span<NodeType> types) {
 		NodeType &t = types[VoxelGraphFunction::NODE_SDF_TORUS];
 		t.name = "SdfTorus";
 		t.category = CATEGORY_SDF;
+		t.is_fusable = true;
 		t.inputs.push_back(NodeType::Port("x", 0.f, VoxelGraphFunction::AUTO_CONNECT_X));
 		t.inputs.push_back(NodeType::Port("y", 0.f, VoxelGraphFunction::AUTO_CONNECT_Y));
 		t.inputs.push_back(NodeType::Port("z", 0.f, VoxelGraphFunction::AUTO_CONNECT_Z));
@@ -162,9 +198,19 @@ void register_sdf_nodes(Span<NodeType> types) {
 			const Runtime::Buffer &z = ctx.get_input(2);
 			const Params p = ctx.get_params<Params>();
 			Runtime::Buffer &out = ctx.get_output(0);
-			for (uint32_t i = 0; i < out.size; ++i) {
-				out.data[i] = math::sdf_torus(x.data[i], y.data[i], z.data[i], p.r1, p.r2);
-			}
+			simd_map(
+					out.data,
+					out.size,
+					[p](auto vx, auto vy, auto vz) {
+						// Same as `math::sdf_torus`, written per component so it also works with `Float4`
+						using T = decltype(vx);
+						const T qx = math::sqrt(vx * vx + vz * vz) - T(p.r1);
+						return math::sqrt(qx * qx + vy * vy) - T(p.r2);
+					},
+					x.data,
+					y.data,
+					z.data
+			);
 		};
 		t.range_analysis_func = [](Runtime::RangeAnalysisContext &ctx) {
 			const Interval x = ctx.get_input(0);
@@ -201,6 +247,7 @@ void register_sdf_nodes(Span<NodeType> types) {
 		NodeType &t = types[VoxelGraphFunction::NODE_SDF_SMOOTH_UNION];
 		t.name = "SdfSmoothUnion";
 		t.category = CATEGORY_SDF;
+		t.is_fusable = true;
 		t.inputs.push_back(NodeType::Port("a"));
 		t.inputs.push_back(NodeType::Port("b"));
 		t.outputs.push_back(NodeType::Port("sdf"));
@@ -227,14 +274,27 @@ void register_sdf_nodes(Span<NodeType> types) {
 					out.data[i] = a.data[i];
 				}
 			} else if (params.smoothness > 0.0001f) {
-				for (uint32_t i = 0; i < out.size; ++i) {
-					out.data[i] = math::sdf_smooth_union(a.data[i], b.data[i], params.smoothness);
-				}
+				const float smoothness = params.smoothness;
+				simd_map(
+						out.data,
+						out.size,
+						[smoothness](auto va, auto vb) { //
+							return math::sdf_smooth_union(va, vb, decltype(va)(smoothness));
+						},
+						a.data,
+						b.data
+				);
 			} else {
 				// Fallback on hard-union, smooth union does not support zero smoothness
-				for (uint32_t i = 0; i < out.size; ++i) {
-					out.data[i] = math::sdf_union(a.data[i], b.data[i]);
-				}
+				simd_map(
+						out.data,
+						out.size,
+						[](auto va, auto vb) { //
+							return math::sdf_union(va, vb);
+						},
+						a.data,
+						b.data
+				);
 			}
 		};
 		t.range_analysis_func = [](Runtime::RangeAnalysisContext &ctx) {
@@ -305,6 +365,7 @@ void register_sdf_nodes(Span<NodeType> types) {
 		NodeType &t = types[VoxelGraphFunction::NODE_SDF_SMOOTH_SUBTRACT];
 		t.name = "SdfSmoothSubtract";
 		t.category = CATEGORY_SDF;
+		t.is_fusable = true;
 		t.inputs.push_back(NodeType::Port("a"));
 		t.inputs.push_back(NodeType::Port("b"));
 		t.outputs.push_back(NodeType::Port("sdf"));
@@ -331,14 +392,27 @@ void register_sdf_nodes(Span<NodeType> types) {
 					out.data[i] = a.data[i];
 				}
 			} else if (params.smoothness > 0.0001f) {
-				for (uint32_t i = 0; i < out.size; ++i) {
-					out.data[i] = math::sdf_smooth_subtract(a.data[i], b.data[i], params.smoothness);
-				}
+				const float smoothness = params.smoothness;
+				simd_map(
+						out.data,
+						out.size,
+						[smoothness](auto va, auto vb) { //
+							return math::sdf_smooth_subtract(va, vb, decltype(va)(smoothness));
+						},
+						a.data,
+						b.data
+				);
 			} else {
 				// Fallback on hard-subtract, smooth subtract does not support zero smoothness
-				for (uint32_t i = 0; i < out.size; ++i) {
-					out.data[i] = math::sdf_subtract(a.data[i], b.data[i]);
-				}
+				simd_map(
+						out.data,
+						out.size,
+						[](auto va, auto vb) { //
+							return math::sdf_subtract(va, vb);
+						},
+						a.data,
+						b.data
+				);
 			}
 		};
 		t.range_analysis_func = [](Runtime::RangeAnalysisContext &ctx) {
@@ -1,6 +1,7 @@
 #ifndef VOXEL_GRAPH_NODES_UTIL_H
 #define VOXEL_GRAPH_NODES_UTIL_H
 
+#include "../../../util/math/float4.h"
 #include "../voxel_graph_runtime.h"
 
 namespace zylann::voxel::pg {
@@ -59,6 +60,80 @@ inline void do_binop(pg::Runtime::ProcessBufferContext &ctx, F f) {
 	}
 }
 
+// Computes `out[i] = f(inputs[i]...)`, several values at a time using `math::Float4`, then one by one for the
+// remainder. `f` must be a generic lambda working with both `float` and `math::Float4`.
+template <typename F, typename... TInputs>
+inline void simd_map(float *out, const uint32_t size, F f, const TInputs *...inputs) {
+	const uint32_t simd_size = size - size % math::Float4::SIZE;
+	uint32_t i = 0;
+	for (; i < simd_size; i += math::Float4::SIZE) {
+		f(math::Float4::load(inputs + i)...).store(out + i);
+	}
+	for (; i < size; ++i) {
+		out[i] = f(inputs[i]...);
+	}
+}
+
+// Variant of `do_monop` where `f` is a generic lambda, see `simd_map`
+template <typename F>
+inline void do_monop_simd(pg::Runtime::ProcessBufferContext &ctx, F f) {
+	const Runtime::Buffer &a = ctx.get_input(0);
+	Runtime::Buffer &out = ctx.get_output(0);
+	if (a.is_constant) {
+		// Normally this case should have been optimized out at compile-time
+		const float v = f(a.constant_value);
+		for (uint32_t i = 0; i < a.size; ++i) {
+			out.data[i] = v;
+		}
+	} else {
+		simd_map(out.data, a.size, f, a.data);
+	}
+}
+
+// Variant of `do_binop` where `f` is a generic lambda, see `simd_map`
+template <typename F>
+inline void do_binop_simd(pg::Runtime::ProcessBufferContext &ctx, F f) {
+	const Runtime::Buffer &a = ctx.get_input(0);
+	const Runtime::Buffer &b = ctx.get_input(1);
+	Runtime::Buffer &out = ctx.get_output(0);
+	const uint32_t buffer_size = out.size;
+
+	if (a.is_constant || b.is_constant) {
+		if (!b.is_constant) {
+			const float c = a.constant_value;
+			simd_map(
+					out.data,
+					buffer_size,
+					[f, c](auto v) { //
+						return f(decltype(v)(c), v);
+					},
+					b.data
+			);
+
+		} else if (!a.is_constant) {
+			const float c = b.constant_value;
+			simd_map(
+					out.data,
+					buffer_size,
+					[f, c](auto v) { //
+						return f(v, decltype(v)(c));
+					},
+					a.data
+			);
+
+		} else {
+			// Normally this case should have been optimized out at compile-time
+			const float c = f(a.constant_value, b.constant_value);
+			for (uint32_t i = 0; i < buffer_size; ++i) {
+				out.data[i] = c;
+			}
+		}
+
+	} else {
+		simd_map(out.data, buffer_size, f, a.data, b.data);
+	}
+}
+
 } // namespace zylann::voxel::pg
 
 #endif // VOXEL_GRAPH_NODES_UTIL_H
@@ -18,6 +18,8 @@
 #include "../../util/string/format.h"
 #include "node_type_db.h"
 #include "voxel_graph_function.h"
+#include <algorithm>
+#include <tuple>
 
 namespace zylann::voxel {
 
@@ -47,6 +49,10 @@ void VoxelGeneratorGraph::clear() {
 		RWLockWrite wlock(_runtime_lock);
 		_runtime.reset();
 	}
+
+	_column_cache.clear();
+	_block_cache.clear();
+	_profiler.clear();
 }
 
 Ref<pg::VoxelGraphFunction> VoxelGeneratorGraph::get_main_function() const {
@@ -79,14 +85,18 @@ int VoxelGeneratorGraph::get_used_channels_mask() const {
 		// The graph hasn't been compiled yet, we can't tell which channels it produces.
 		return 0;
 	}
+	return get_used_channels_mask(*runtime_ptr);
+}
+
+int VoxelGeneratorGraph::get_used_channels_mask(const Runtime &runtime) const {
 	int mask = 0;
-	if (runtime_ptr->sdf_output_index != -1) {
+	if (runtime.sdf_output_index != -1) {
 		mask |= (1 << VoxelBuffer::CHANNEL_SDF);
 	}
-	if (runtime_ptr->type_output_index != -1) {
+	if (runtime.type_output_index != -1) {
 		mask |= (1 << VoxelBuffer::CHANNEL_TYPE);
 	}
-	if (runtime_ptr->weight_outputs_count > 0 || runtime_ptr->single_texture_output_index != -1) {
+	if (runtime.weight_outputs_count > 0 || runtime.single_texture_output_index != -1) {
 		switch (_texture_mode) {
 			case TEXTURE_MODE_MIXEL4:
 				mask |= (1 << VoxelBuffer::CHANNEL_INDICES);
@@ -121,6 +131,49 @@ int VoxelGeneratorGraph::get_subdivision_size() const {
 	return _subdivision_size;
 }
 
+void VoxelGeneratorGraph::set_use_adaptive_subdivision(bool enabled) {
+	_use_adaptive_subdivision = enabled;
+}
+
+bool VoxelGeneratorGraph::is_using_adaptive_subdivision() const {
+	return _use_adaptive_subdivision;
+}
+
+void VoxelGeneratorGraph::set_adaptive_subdivision_min_size(int size) {
+	ZN_ASSERT_RETURN(size >= 1);
+	_adaptive_subdivision_min_size = size;
+}
+
+int VoxelGeneratorGraph::get_adaptive_subdivision_min_size() const {
+	return _adaptive_subdivision_min_size;
+}
+
+void VoxelGeneratorGraph::set_sparse_sampling_factor(int factor) {
+	ZN_ASSERT_RETURN_MSG(factor == 1 || factor == 2 || factor == 4, "Sparse sampling factor must be 1, 2 or 4");
+	_sparse_sampling_factor = factor;
+}
+
+int VoxelGeneratorGraph::get_sparse_sampling_factor() const {
+	return _sparse_sampling_factor;
+}
+
+void VoxelGeneratorGraph::set_sparse_sampling_min_lod(int lod_index) {
+	ZN_ASSERT_RETURN(lod_index >= 0 && lod_index < static_cast<int>(constants::MAX_LOD));
+	_sparse_sampling_min_lod = lod_index;
+}
+
+int VoxelGeneratorGraph::get_sparse_sampling_min_lod() const {
+	return _sparse_sampling_min_lod;
+}
+
+void VoxelGeneratorGraph::set_sparse_sampling_error_guard(bool enabled) {
+	_sparse_sampling_error_guard = enabled;
+}
+
+bool VoxelGeneratorGraph::is_sparse_sampling_error_guard() const {
+	return _sparse_sampling_error_guard;
+}
+
 void VoxelGeneratorGraph::set_debug_clipped_blocks(bool enabled) {
 	_debug_clipped_blocks = enabled;
 }
@@ -137,6 +190,113 @@ bool VoxelGeneratorGraph::is_using_xz_caching() const {
 	return _use_xz_caching;
 }
 
+void VoxelGeneratorGraph::set_use_grid_queries(bool enabled) {
+	_use_grid_queries = enabled;
+}
+
+bool VoxelGeneratorGraph::is_using_grid_queries() const {
+	return _use_grid_queries;
+}
+
+void VoxelGeneratorGraph::set_use_column_cache(bool enabled) {
+	_use_column_cache = enabled;
+	if (!enabled) {
+		_column_cache.clear();
+	}
+}
+
+bool VoxelGeneratorGraph::is_using_column_cache() const {
+	return _use_column_cache;
+}
+
+void VoxelGeneratorGraph::set_column_cache_capacity(int capacity_bytes) {
+	ZN_ASSERT_RETURN(capacity_bytes >= 0);
+	_column_cache.set_capacity(capacity_bytes);
+}
+
+int VoxelGeneratorGraph::get_column_cache_capacity() const {
+	return _column_cache.get_capacity();
+}
+
+GraphColumnCache::Stats VoxelGeneratorGraph::get_column_cache_stats() const {
+	return _column_cache.get_stats();
+}
+
+void VoxelGeneratorGraph::clear_column_cache() {
+	_column_cache.clear();
+	_column_cache.reset_stats();
+}
+
+void VoxelGeneratorGraph::set_use_block_cache(bool enabled) {
+	_use_block_cache = enabled;
+	if (!enabled) {
+		_block_cache.clear();
+	}
+}
+
+bool VoxelGeneratorGraph::is_using_block_cache() const {
+	return _use_block_cache;
+}
+
+void VoxelGeneratorGraph::set_block_cache_capacity(int capacity_bytes) {
+	ZN_ASSERT_RETURN(capacity_bytes >= 0);
+	_block_cache.set_capacity(capacity_bytes);
+}
+
+int VoxelGeneratorGraph::get_block_cache_capacity() const {
+	return _block_cache.get_capacity();
+}
+
+GraphBlockCache::Stats VoxelGeneratorGraph::get_block_cache_stats() const {
+	return _block_cache.get_stats();
+}
+
+void VoxelGeneratorGraph::clear_block_cache() {
+	_block_cache.clear();
+	_block_cache.reset_stats();
+}
+
+void VoxelGeneratorGraph::set_use_profiling(bool enabled) {
+	_use_profiling = enabled;
+}
+
+bool VoxelGeneratorGraph::is_using_profiling() const {
+	return _use_profiling;
+}
+
+void VoxelGeneratorGraph::set_profiling_sample_interval(int interval) {
+	ZN_ASSERT_RETURN(interval >= 1);
+	_profiler.set_sample_interval(interval);
+}
+
+int VoxelGeneratorGraph::get_profiling_sample_interval() const {
+	return _profiler.get_sample_interval();
+}
+
+void VoxelGeneratorGraph::get_profiling_results(
+		StdVector<GraphProfiler::NodeStats> &out_nodes,
+		uint64_t &out_sample_count
+) const {
+	_profiler.get_results(out_nodes);
+	out_sample_count = _profiler.get_sample_count();
+}
+
+void VoxelGeneratorGraph::clear_profiling_results() {
+	_profiler.clear();
+}
+
+uint64_t VoxelGeneratorGraph::get_block_cache_settings_hash() const {
+	uint64_t h = hash_djb2_one_64(math::get_float_bits(_sdf_clip_threshold));
+	h = hash_djb2_one_64(_use_subdivision ? _subdivision_size : 0, h);
+	h = hash_djb2_one_64(_use_adaptive_subdivision ? _adaptive_subdivision_min_size : 0, h);
+	h = hash_djb2_one_64(_sparse_sampling_factor, h);
+	h = hash_djb2_one_64(_sparse_sampling_min_lod, h);
+	h = hash_djb2_one_64(_sparse_sampling_error_guard, h);
+	h = hash_djb2_one_64(_use_optimized_execution_map, h);
+	h = hash_djb2_one_64(_debug_clipped_blocks, h);
+	return hash_djb2_one_64(_texture_mode, h);
+}
+
 void VoxelGeneratorGraph::set_texture_mode(const TextureMode mode) {
 	ZN_ASSERT_RETURN(mode >= 0 && mode < TEXTURE_MODE_COUNT);
 	_texture_mode = mode;
@@ -466,7 +626,7 @@ void fill_zx_sdf_slice(
 }
 
 void fill_zx_sdf_slice(
-		const pg::Runtime::Buffer &sdf_buffer,
+		const float *sdf_data,
 		VoxelBuffer &out_buffer,
 		unsigned int channel,
 		VoxelBuffer::Depth channel_depth,
@@ -489,7 +649,7 @@ void fill_zx_sdf_slice(
 	switch (channel_depth) {
 		case VoxelBuffer::DEPTH_8_BIT:
 			fill_zx_sdf_slice(
-					channel_bytes, sdf_scale, rmin, rmax, ry, x_stride, sdf_buffer.data, buffer_size, snorm_to_s8
+					channel_bytes, sdf_scale, rmin, rmax, ry, x_stride, sdf_data, buffer_size, snorm_to_s8
 			);
 			break;
 
@@ -501,7 +661,7 @@ void fill_zx_sdf_slice(
 					rmax,
 					ry,
 					x_stride,
-					sdf_buffer.data,
+					sdf_data,
 					buffer_size,
 					snorm_to_s16
 			);
@@ -515,7 +675,7 @@ void fill_zx_sdf_slice(
 					rmax,
 					ry,
 					x_stride,
-					sdf_buffer.data,
+					sdf_data,
 					buffer_size,
 					[](float v) { return v; }
 			);
@@ -529,7 +689,7 @@ void fill_zx_sdf_slice(
 					rmax,
 					ry,
 					x_stride,
-					sdf_buffer.data,
+					sdf_data,
 					buffer_size,
 					[](double v) { return v; }
 			);
@@ -632,72 +792,268 @@ void fill_zx_integer_slice(
 } // namespace
 
 VoxelGenerator::Result VoxelGeneratorGraph::generate_block(VoxelGenerator::VoxelQueryData input) {
+	Result result;
+	generate_blocks(Span<VoxelGenerator::VoxelQueryData>(&input, 1), Span<Result>(&result, 1));
+	return result;
+}
+
+namespace {
+
+// Tells if block `b` is right above block `a`, with the same size and LOD, so they can be generated as one column
+bool is_block_stacked_above(const VoxelGenerator::VoxelQueryData &a, const VoxelGenerator::VoxelQueryData &b) {
+	const Vector3i size = a.voxel_buffer.get_size();
+	return a.lod == b.lod && size == b.voxel_buffer.get_size() && a.origin_in_voxels.x == b.origin_in_voxels.x &&
+			a.origin_in_voxels.z == b.origin_in_voxels.z &&
+			b.origin_in_voxels.y == a.origin_in_voxels.y + (size.y << a.lod);
+}
+
+// Tells if a box can be split in 8 boxes of equal size, each at least `min_size` voxels wide
+inline bool can_split_box(const Vector3i size, const int min_size) {
+	return size.x % 2 == 0 && size.y % 2 == 0 && size.z % 2 == 0 && size.x / 2 >= min_size &&
+			size.y / 2 >= min_size && size.z / 2 >= min_size;
+}
+
+// Splits a box in 8 and adds them to a stack, such that boxes with the same X and Z are popped one after the other,
+// from bottom to top. This allows values depending only on X and Z to be re-used between them.
+void push_box_octants(StdVector<Box3i> &stack, const Box3i &box) {
+	const Vector3i half_size = box.size / 2;
+	for (int z = 1; z >= 0; --z) {
+		for (int x = 1; x >= 0; --x) {
+			for (int y = 1; y >= 0; --y) {
+				stack.push_back(Box3i(box.position + Vector3i(x, y, z) * half_size, half_size));
+			}
+		}
+	}
+}
+
+inline bool is_same_xz_area(const Box3i &a, const Box3i &b) {
+	return a.position.x == b.position.x && a.position.z == b.position.z && a.size.x == b.size.x &&
+			a.size.z == b.size.z;
+}
+
+// Lists operations of the outer group that run with an execution map, and constants they fill. Values of the outer
+// group can only be re-used if they were computed by the same operations.
+void get_outer_group_signature(const pg::Runtime::ExecutionMap &execution_map, StdVector<uint32_t> &dst) {
+	dst.clear();
+	unsigned int constant_fill_index = 0;
+	for (unsigned int i = 0; i < execution_map.inner_group_start_index; ++i) {
+		const pg::Runtime::ExecutionMap::OperationInfo &op_info = execution_map.operations[i];
+		dst.push_back(op_info.address);
+		for (unsigned int j = 0; j < op_info.constant_fill_count; ++j) {
+			const pg::Runtime::ExecutionMap::ConstantFill &cf = execution_map.constant_fills[constant_fill_index];
+			dst.push_back(cf.buffer_address);
+			dst.push_back(math::get_float_bits(cf.value));
+			++constant_fill_index;
+		}
+	}
+}
+
+// Adds times measured while running `execution_map` to a profiling sample. Operations of the outer group ran
+// `outer_group_call_count` times, others ran `inner_group_call_count` times. If `execution_map` is null, nothing ran.
+// Nodes of the default execution map missing from `execution_map` were removed by range analysis, so they are counted
+// as skipped.
+void gather_profiling_sample(
+		const pg::Runtime &runtime,
+		const pg::Runtime::State &state,
+		const pg::Runtime::ExecutionMap *execution_map,
+		const unsigned int outer_group_call_count,
+		const unsigned int inner_group_call_count,
+		StdVector<GraphProfiler::NodeStats> &sample
+) {
+	using OperationInfo = pg::Runtime::ExecutionMap::OperationInfo;
+
+	if (execution_map != nullptr) {
+		for (unsigned int i = 0; i < execution_map->operations.size(); ++i) {
+			GraphProfiler::NodeStats stats;
+			stats.node_id = runtime.get_operation_node_id(execution_map->operations[i].address);
+			stats.nanoseconds = state.get_execution_time_nanoseconds(i);
+			stats.call_count =
+					i < execution_map->inner_group_start_index ? outer_group_call_count : inner_group_call_count;
+			sample.push_back(stats);
+		}
+	}
+
+	const pg::Runtime::ExecutionMap &default_execution_map = runtime.get_default_execution_map();
+	if (execution_map == &default_execution_map) {
+		return;
+	}
+
+	for (const OperationInfo &op_info : default_execution_map.operations) {
+		if (execution_map != nullptr &&
+			std::find_if(
+					execution_map->operations.begin(),
+					execution_map->operations.end(),
+					[&op_info](const OperationInfo &other) { return other.address == op_info.address; }
+			) != execution_map->operations.end()) {
+			continue;
+		}
+		const uint32_t node_id = runtime.get_operation_node_id(op_info.address);
+		// Nodes compiled into several operations are only counted once
+		if (std::find_if(sample.begin(), sample.end(), [node_id](const GraphProfiler::NodeStats &stats) {
+				return stats.node_id == node_id && stats.skip_count > 0;
+			}) != sample.end()) {
+			continue;
+		}
+		GraphProfiler::NodeStats stats;
+		stats.node_id = node_id;
+		stats.skip_count = 1;
+		sample.push_back(stats);
+	}
+}
+
+} // namespace
+
+void VoxelGeneratorGraph::generate_blocks(Span<VoxelGenerator::VoxelQueryData> queries, Span<Result> out_results) {
+	ZN_PROFILE_SCOPE();
+	ZN_ASSERT_RETURN(queries.size() == out_results.size());
+
 	std::shared_ptr<Runtime> runtime_ptr;
 	{
 		RWLockRead rlock(_runtime_lock);
 		runtime_ptr = _runtime;
 	}
 
-	Result result;
+	for (Result &result : out_results) {
+		result = Result();
+	}
 
 	if (runtime_ptr == nullptr) {
-		return result;
+		return;
 	}
 
-	VoxelBuffer &out_buffer = input.voxel_buffer;
-
 #ifdef TOOLS_ENABLED
-	switch (_texture_mode) {
-		case TEXTURE_MODE_MIXEL4: {
-			const VoxelBuffer::Depth indices_depth = out_buffer.get_channel_depth(VoxelBuffer::CHANNEL_INDICES);
-			if (indices_depth != VoxelBuffer::DEPTH_16_BIT) {
-				ZN_PRINT_ERROR_ONCE(format(
-						"The Indices channel is set to {} bits, but 16 bits are necessary to use the Mixel4 texturing "
-						"mode.",
-						VoxelBuffer::get_depth_byte_count(indices_depth)
-				));
-			}
-			const VoxelBuffer::Depth weights_depth = out_buffer.get_channel_depth(VoxelBuffer::CHANNEL_WEIGHTS);
-			if (weights_depth != VoxelBuffer::DEPTH_16_BIT) {
-				ZN_PRINT_ERROR_ONCE(format(
-						"The Weights channel is set to {} bits, but 16 bits are necessary to use the Mixel4 texturing "
-						"mode.",
-						VoxelBuffer::get_depth_byte_count(weights_depth)
-				));
-			}
-		} break;
+	for (const VoxelQueryData &query : queries) {
+		const VoxelBuffer &out_buffer = query.voxel_buffer;
 
-		case TEXTURE_MODE_SINGLE: {
-			const VoxelBuffer::Depth indices_depth = out_buffer.get_channel_depth(VoxelBuffer::CHANNEL_INDICES);
-			if (indices_depth != VoxelBuffer::DEPTH_8_BIT) {
-				ZN_PRINT_WARNING_ONCE(
-						format("The Indices channel is set to {} bits, but only 8 bits are required to use the Single "
-							   "texturing mode.",
-							   VoxelBuffer::get_depth_byte_count(indices_depth))
-				);
-			}
-		} break;
+		switch (_texture_mode) {
+			case TEXTURE_MODE_MIXEL4: {
+				const VoxelBuffer::Depth indices_depth = out_buffer.get_channel_depth(VoxelBuffer::CHANNEL_INDICES);
+				if (indices_depth != VoxelBuffer::DEPTH_16_BIT) {
+					ZN_PRINT_ERROR_ONCE(format(
+							"The Indices channel is set to {} bits, but 16 bits are necessary to use the Mixel4 "
+							"texturing mode.",
+							VoxelBuffer::get_depth_byte_count(indices_depth)
+					));
+				}
+				const VoxelBuffer::Depth weights_depth = out_buffer.get_channel_depth(VoxelBuffer::CHANNEL_WEIGHTS);
+				if (weights_depth != VoxelBuffer::DEPTH_16_BIT) {
+					ZN_PRINT_ERROR_ONCE(format(
+							"The Weights channel is set to {} bits, but 16 bits are necessary to use the Mixel4 "
+							"texturing mode.",
+							VoxelBuffer::get_depth_byte_count(weights_depth)
+					));
+				}
+			} break;
 
-		default:
-			ZN_PRINT_ERROR_ONCE("Unknown texture mode");
-			break;
+			case TEXTURE_MODE_SINGLE: {
+				const VoxelBuffer::Depth indices_depth = out_buffer.get_channel_depth(VoxelBuffer::CHANNEL_INDICES);
+				if (indices_depth != VoxelBuffer::DEPTH_8_BIT) {
+					ZN_PRINT_WARNING_ONCE(format(
+							"The Indices channel is set to {} bits, but only 8 bits are required to use the Single "
+							"texturing mode.",
+							VoxelBuffer::get_depth_byte_count(indices_depth)
+					));
+				}
+			} break;
+
+			default:
+				ZN_PRINT_ERROR_ONCE("Unknown texture mode");
+				break;
+		}
 	}
 #endif
 
-	const Vector3i bs = out_buffer.get_size();
-	const VoxelBuffer::ChannelId sdf_channel = VoxelBuffer::CHANNEL_SDF;
-	const Vector3i origin = input.origin_in_voxels;
+	Cache &cache = get_tls_cache();
 
-	// TODO This may be shared across the module
-	// Storing voxels is lossy on some depth configurations. They use normalized SDF,
-	// so we must scale the values to make better use of the offered resolution
-	const VoxelBuffer::Depth sdf_channel_depth = out_buffer.get_channel_depth(sdf_channel);
-	const float sdf_scale = VoxelBuffer::get_sdf_quantization_scale(sdf_channel_depth);
+	// Blocks generated recently may be found in the block cache. The SDF input makes blocks depend on their previous
+	// contents, so it can't be used in that case.
+	const bool use_block_cache = _use_block_cache && runtime_ptr->sdf_input_index == -1;
+	StdVector<GraphBlockCache::Key> &block_cache_keys = cache.block_cache_keys;
+	if (use_block_cache) {
+		const uint8_t channels_mask = get_used_channels_mask(*runtime_ptr);
+		const uint64_t settings_hash = get_block_cache_settings_hash();
+		block_cache_keys.clear();
+		for (const VoxelQueryData &query : queries) {
+			block_cache_keys.push_back(GraphBlockCache::make_key(
+					query.voxel_buffer,
+					query.origin_in_voxels,
+					query.lod,
+					channels_mask,
+					runtime_ptr->program_hash,
+					settings_hash
+			));
+		}
+	}
+
+	// Sort blocks so those on top of each other end up next to each other, bottom first
+	StdVector<unsigned int> &order = cache.block_order;
+	order.clear();
+	for (unsigned int i = 0; i < queries.size(); ++i) {
+		if (use_block_cache &&
+			_block_cache.try_load(block_cache_keys[i], queries[i].voxel_buffer, out_results[i].max_lod_hint)) {
+			continue;
+		}
+		order.push_back(i);
+	}
+	if (order.size() > 1) {
+		std::sort(order.begin(), order.end(), [&queries](const unsigned int ia, const unsigned int ib) {
+			const VoxelQueryData &a = queries[ia];
+			const VoxelQueryData &b = queries[ib];
+			const Vector3i sa = a.voxel_buffer.get_size();
+			const Vector3i sb = b.voxel_buffer.get_size();
+			return std::tie(a.lod, sa.x, sa.y, sa.z, a.origin_in_voxels.x, a.origin_in_voxels.z, a.origin_in_voxels.y) <
+					std::tie(b.lod, sb.x, sb.y, sb.z, b.origin_in_voxels.x, b.origin_in_voxels.z, b.origin_in_voxels.y);
+		});
+	}
+
+	// The SDF input requires a copy of each block's voxels, so in that case blocks are generated one by one
+	const bool can_stack = runtime_ptr->sdf_input_index == -1;
+
+	unsigned int stack_begin = 0;
+	while (stack_begin < order.size()) {
+		unsigned int stack_end = stack_begin + 1;
+		if (can_stack) {
+			while (stack_end < order.size() &&
+				   is_block_stacked_above(queries[order[stack_end - 1]], queries[order[stack_end]])) {
+				++stack_end;
+			}
+		}
+		generate_block_stack(
+				*runtime_ptr,
+				cache,
+				queries,
+				out_results,
+				to_span_const(order).sub(stack_begin, stack_end - stack_begin)
+		);
+		stack_begin = stack_end;
+	}
+
+	if (use_block_cache) {
+		for (const unsigned int i : order) {
+			_block_cache.store(block_cache_keys[i], queries[i].voxel_buffer, out_results[i].max_lod_hint);
+		}
+	}
+}
+
+// Generates a column of blocks stacked along Y, with the same size and LOD. Sections are processed column by column,
+// so values depending only on X and Z can be re-used across sections and blocks of the column.
+void VoxelGeneratorGraph::generate_block_stack(
+		const Runtime &runtime_wrapper,
+		Cache &cache,
+		Span<VoxelGenerator::VoxelQueryData> queries,
+		Span<Result> out_results,
+		Span<const unsigned int> stack
+) {
+	ZN_PROFILE_SCOPE();
+	ZN_ASSERT_RETURN(stack.size() > 0);
 
+	const VoxelQueryData &first_query = queries[stack[0]];
+	const Vector3i bs = first_query.voxel_buffer.get_size();
+	const uint32_t lod = first_query.lod;
+	const VoxelBuffer::ChannelId sdf_channel = VoxelBuffer::CHANNEL_SDF;
 	const VoxelBuffer::ChannelId type_channel = VoxelBuffer::CHANNEL_TYPE;
-	const VoxelBuffer::Depth type_channel_depth = out_buffer.get_channel_depth(type_channel);
 
-	const int stride = 1 << input.lod;
+	const int stride = 1 << lod;
 
 	// Clip threshold must be higher for higher lod indexes because distances for one sampled voxel are also larger
 	const float clip_threshold = _sdf_clip_threshold * stride;
@@ -712,13 +1068,25 @@ VoxelGenerator::Result VoxelGeneratorGraph::generate_block(VoxelGenerator::Voxel
 	// ERR_FAIL_COND_V(bs.y % section_size != 0, result);
 	// ERR_FAIL_COND_V(bs.z % section_size != 0, result);
 
-	Cache &cache = get_tls_cache();
-
 	// Slice is on the Y axis
 	const unsigned int slice_buffer_size = section_size.x * section_size.z;
-	pg::Runtime &runtime = runtime_ptr->runtime;
+	const pg::Runtime &runtime = runtime_wrapper.runtime;
 	runtime.prepare_state(cache.state, slice_buffer_size, false);
 
+	// Values of the outer group may also be cached after the stack is generated. Graphs using the SDF input are
+	// excluded, as values are then not only depending on X and Z.
+	const bool use_column_cache = _use_xz_caching && _use_column_cache && runtime_wrapper.sdf_input_index == -1 &&
+			runtime.get_outer_group_output_addresses().size() > 0;
+	if (use_column_cache) {
+		cache.outer_group_buffers.clear();
+		for (const uint16_t address : runtime.get_outer_group_output_addresses()) {
+			float *data = cache.state.get_buffer(address).data;
+			if (data != nullptr) {
+				cache.outer_group_buffers.push_back(data);
+			}
+		}
+	}
+
 	cache.x_cache.resize(slice_buffer_size);
 	cache.y_cache.resize(slice_buffer_size);
 	cache.z_cache.resize(slice_buffer_size);
@@ -730,18 +1098,30 @@ VoxelGenerator::Result VoxelGeneratorGraph::generate_block(VoxelGenerator::Voxel
 	const float air_sdf = _debug_clipped_blocks ? constants::SDF_FAR_INSIDE : constants::SDF_FAR_OUTSIDE;
 	const float matter_sdf = _debug_clipped_blocks ? constants::SDF_FAR_OUTSIDE : constants::SDF_FAR_INSIDE;
 
-	FixedArray<uint8_t, 4> spare_texture_indices = runtime_ptr->spare_texture_indices;
-	const int sdf_output_buffer_index = runtime_ptr->sdf_output_buffer_index;
-	const int type_output_buffer_index = runtime_ptr->type_output_buffer_index;
+	// The SDF input is given per voxel, so it can't be used with sparse sampling
+	const int sparse_factor =
+			static_cast<int>(lod) >= _sparse_sampling_min_lod && runtime_wrapper.sdf_input_index == -1
+			? _sparse_sampling_factor
+			: 1;
 
-	bool all_sdf_is_air = (sdf_output_buffer_index != -1) && (type_output_buffer_index == -1);
-	bool all_sdf_is_matter = all_sdf_is_air;
+	FixedArray<uint8_t, 4> spare_texture_indices = runtime_wrapper.spare_texture_indices;
+	const int sdf_output_buffer_index = runtime_wrapper.sdf_output_buffer_index;
+	const int type_output_buffer_index = runtime_wrapper.type_output_buffer_index;
+
+	cache.stacked_block_states.clear();
+	{
+		const bool all_uniform_init = (sdf_output_buffer_index != -1) && (type_output_buffer_index == -1);
+		cache.stacked_block_states.resize(stack.size(), StackedBlockState{ all_uniform_init, all_uniform_init });
+	}
 
 	math::Interval sdf_input_range;
 	Span<float> input_sdf_full_cache;
 	Span<float> input_sdf_slice_cache;
-	if (runtime_ptr->sdf_input_index != -1) {
+	if (runtime_wrapper.sdf_input_index != -1) {
 		ZN_PROFILE_SCOPE();
+		// Blocks are not stacked in this case
+		ZN_ASSERT_RETURN(stack.size() == 1);
+
 		cache.input_sdf_slice_cache.resize(slice_buffer_size);
 		input_sdf_slice_cache = to_span(cache.input_sdf_slice_cache);
 
@@ -750,7 +1130,7 @@ VoxelGenerator::Result VoxelGeneratorGraph::generate_block(VoxelGenerator::Voxel
 		input_sdf_full_cache = to_span(cache.input_sdf_full_cache);
 
 		// Note, a copy of the data is notably needed because we are going to write into that same buffer.
-		get_unscaled_sdf(out_buffer, input_sdf_full_cache);
+		get_unscaled_sdf(first_query.voxel_buffer, input_sdf_full_cache);
 
 		sdf_input_range = math::Interval::from_single_value(input_sdf_full_cache[0]);
 		for (const float sd : input_sdf_full_cache) {
@@ -758,228 +1138,610 @@ VoxelGenerator::Result VoxelGeneratorGraph::generate_block(VoxelGenerator::Voxel
 		}
 	}
 
-	// For each subdivision of the block
+	// For each column of subdivisions
 	for (int sz = 0; sz < bs.z; sz += section_size.z) {
-		for (int sy = 0; sy < bs.y; sy += section_size.y) {
-			for (int sx = 0; sx < bs.x; sx += section_size.x) {
-				ZN_PROFILE_SCOPE_NAMED("Section");
-
-				const Vector3i rmin(sx, sy, sz);
-				const Vector3i rmax = rmin + Vector3i(section_size);
-				const Vector3i gmin = origin + (rmin << input.lod);
-				const Vector3i gmax = origin + (rmax << input.lod);
-
-				// Do a quick analysis of the area. We'll only compute voxels if necessary.
-				{
-					QueryInputs<math::Interval> range_inputs(
-							*runtime_ptr,
-							math::Interval(gmin.x, gmax.x),
-							math::Interval(gmin.y, gmax.y),
-							math::Interval(gmin.z, gmax.z),
-							sdf_input_range
-					);
-					runtime.analyze_range(cache.state, range_inputs.get());
-				}
+		for (int sx = 0; sx < bs.x; sx += section_size.x) {
+			// True when buffers of nodes only depending on X and Z contain values for `outer_group_cached_box`,
+			// computed with the execution map stored in `previous_execution_map`
+			bool outer_group_cached = false;
+			Box3i outer_group_cached_box;
+
+			// For each block of the stack, from bottom to top
+			for (unsigned int stack_index = 0; stack_index < stack.size(); ++stack_index) {
+				VoxelQueryData &query = queries[stack[stack_index]];
+				VoxelBuffer &out_buffer = query.voxel_buffer;
+				const Vector3i origin = query.origin_in_voxels;
+				StackedBlockState &block_state = cache.stacked_block_states[stack_index];
+
+				// TODO This may be shared across the module
+				// Storing voxels is lossy on some depth configurations. They use normalized SDF,
+				// so we must scale the values to make better use of the offered resolution
+				const VoxelBuffer::Depth sdf_channel_depth = out_buffer.get_channel_depth(sdf_channel);
+				const float sdf_scale = VoxelBuffer::get_sdf_quantization_scale(sdf_channel_depth);
+
+				const VoxelBuffer::Depth type_channel_depth = out_buffer.get_channel_depth(type_channel);
+
+				// For each subdivision of the column within the block
+				for (int sy = 0; sy < bs.y; sy += section_size.y) {
+					// Sections may be split into smaller boxes when adaptive subdivision is enabled
+					cache.section_boxes.clear();
+					cache.section_boxes.push_back(Box3i(Vector3i(sx, sy, sz), section_size));
+
+					while (cache.section_boxes.size() > 0) {
+						ZN_PROFILE_SCOPE_NAMED("Section");
+
+						const Box3i box = cache.section_boxes.back();
+						cache.section_boxes.pop_back();
+
+						const Vector3i rmin = box.position;
+						const Vector3i rmax = box.position + box.size;
+						const Vector3i gmin = origin + (rmin << lod);
+						const Vector3i gmax = origin + (rmax << lod);
+
+						// Do a quick analysis of the area. We'll only compute voxels if necessary.
+						{
+							QueryInputs<math::Interval> range_inputs(
+									runtime_wrapper,
+									math::Interval(gmin.x, gmax.x),
+									math::Interval(gmin.y, gmax.y),
+									math::Interval(gmin.z, gmax.z),
+									sdf_input_range
+							);
+							runtime.analyze_range(cache.state, range_inputs.get());
+						}
 
-				SmallVector<unsigned int, pg::Runtime::MAX_OUTPUTS> required_outputs;
-
-				bool sdf_is_air = true;
-				bool sdf_is_uniform = true;
-				if (sdf_output_buffer_index != -1) {
-					const math::Interval sdf_range = cache.state.get_range(sdf_output_buffer_index);
-					bool sdf_is_matter = false;
-
-					if (sdf_range.min > clip_threshold && sdf_range.max > clip_threshold) {
-						out_buffer.fill_area_f(air_sdf, rmin, rmax, sdf_channel);
-						sdf_is_air = true;
-
-					} else if (sdf_range.min < -clip_threshold && sdf_range.max < -clip_threshold) {
-						out_buffer.fill_area_f(matter_sdf, rmin, rmax, sdf_channel);
-						sdf_is_air = false;
-						sdf_is_matter = true;
-
-					} else if (sdf_range.is_single_value()) {
-						out_buffer.fill_area_f(sdf_range.min, rmin, rmax, sdf_channel);
-						sdf_is_air = sdf_range.min > 0.f;
-						sdf_is_matter = !sdf_is_air;
-
-					} else {
-						// SDF is not uniform, we'll need to compute it per voxel
-						required_outputs.push_back(runtime_ptr->sdf_output_index);
-						sdf_is_air = false;
-						sdf_is_uniform = false;
-					}
+						SmallVector<unsigned int, pg::Runtime::MAX_OUTPUTS> required_outputs;
 
-					all_sdf_is_air = all_sdf_is_air && sdf_is_air;
-					all_sdf_is_matter = all_sdf_is_matter && sdf_is_matter;
-				}
+						bool sdf_is_air = true;
+						bool sdf_is_uniform = true;
+						if (sdf_output_buffer_index != -1) {
+							const math::Interval sdf_range = cache.state.get_range(sdf_output_buffer_index);
+							bool sdf_is_matter = false;
 
-				bool type_is_uniform = false;
-				if (type_output_buffer_index != -1) {
-					const math::Interval type_range = cache.state.get_range(type_output_buffer_index);
-					if (type_range.is_single_value()) {
-						out_buffer.fill_area(int(type_range.min), rmin, rmax, type_channel);
-						type_is_uniform = true;
-					} else {
-						// Types are not uniform, we'll need to compute them per voxel
-						required_outputs.push_back(runtime_ptr->type_output_index);
-					}
-				}
+							if (sdf_range.min > clip_threshold && sdf_range.max > clip_threshold) {
+								out_buffer.fill_area_f(air_sdf, rmin, rmax, sdf_channel);
+								sdf_is_air = true;
 
-				if (runtime_ptr->weight_outputs_count > 0 && !sdf_is_air) {
-					// We can skip this when SDF is air because there won't be any matter to give a texture to
-					// TODO Range analysis on that?
-					// Not easy to do that from here, they would have to ALL be locally constant in order to use a
-					// short-circuit...
-					for (unsigned int i = 0; i < runtime_ptr->weight_outputs_count; ++i) {
-						required_outputs.push_back(runtime_ptr->weight_output_indices[i]);
-					}
-				}
+							} else if (sdf_range.min < -clip_threshold && sdf_range.max < -clip_threshold) {
+								out_buffer.fill_area_f(matter_sdf, rmin, rmax, sdf_channel);
+								sdf_is_air = false;
+								sdf_is_matter = true;
 
-				// TODO Instead of filling this ourselves, can we leave this to the graph runtime?
-				// Because currently our logic seems redundant and more complicated, since we also have to not request
-				// those outputs later if any other output isn't uniform. Instead, the graph runtime can figure out
-				// that stuff is constant.
-				bool single_texture_is_uniform = false;
-				if (runtime_ptr->single_texture_output_index != -1 && !sdf_is_air) {
-					const math::Interval index_range =
-							cache.state.get_range(runtime_ptr->single_texture_output_buffer_index);
-
-					if (index_range.is_single_value()) {
-						single_texture_is_uniform = true;
-						fill_texturing_data_from_single_texture_index(
-								out_buffer, static_cast<int>(index_range.min), rmin, rmax, _texture_mode
-						);
-					} else {
-						required_outputs.push_back(runtime_ptr->single_texture_output_index);
-					}
-				}
+							} else if (sdf_range.is_single_value()) {
+								out_buffer.fill_area_f(sdf_range.min, rmin, rmax, sdf_channel);
+								sdf_is_air = sdf_range.min > 0.f;
+								sdf_is_matter = !sdf_is_air;
 
-				if (required_outputs.size() == 0) {
-					// We found all we need with range analysis, no need to calculate per voxel.
-					continue;
-				}
+							} else if (_use_adaptive_subdivision &&
+									   can_split_box(box.size, _adaptive_subdivision_min_size)) {
+								// The surface may only cross part of the box, analyze its octants separately
+								push_box_octants(cache.section_boxes, box);
+								continue;
 
-				// At least one channel needs per-voxel computation.
+							} else {
+								// SDF is not uniform, we'll need to compute it per voxel
+								required_outputs.push_back(runtime_wrapper.sdf_output_index);
+								sdf_is_air = false;
+								sdf_is_uniform = false;
+							}
 
-				if (_use_optimized_execution_map) {
-					runtime.generate_optimized_execution_map(
-							cache.state, cache.optimized_execution_map, to_span(required_outputs), false
-					);
-				}
+							block_state.all_sdf_is_air = block_state.all_sdf_is_air && sdf_is_air;
+							block_state.all_sdf_is_matter = block_state.all_sdf_is_matter && sdf_is_matter;
+						}
 
-				{
-					unsigned int i = 0;
-					for (int rz = rmin.z, gz = gmin.z; rz < rmax.z; ++rz, gz += stride) {
-						for (int rx = rmin.x, gx = gmin.x; rx < rmax.x; ++rx, gx += stride) {
-							x_cache[i] = gx;
-							z_cache[i] = gz;
-							++i;
+						bool type_is_uniform = false;
+						if (type_output_buffer_index != -1) {
+							const math::Interval type_range = cache.state.get_range(type_output_buffer_index);
+							if (type_range.is_single_value()) {
+								out_buffer.fill_area(int(type_range.min), rmin, rmax, type_channel);
+								type_is_uniform = true;
+							} else {
+								// Types are not uniform, we'll need to compute them per voxel
+								required_outputs.push_back(runtime_wrapper.type_output_index);
+							}
 						}
-					}
-				}
 
-				for (int ry = rmin.y, gy = gmin.y; ry < rmax.y; ++ry, gy += stride) {
-					ZN_PROFILE_SCOPE_NAMED("Full slice");
+						if (runtime_wrapper.weight_outputs_count > 0 && !sdf_is_air) {
+							// We can skip this when SDF is air because there won't be any matter to give a texture to
+							// TODO Range analysis on that?
+							// Not easy to do that from here, they would have to ALL be locally constant in order to use
+							// a short-circuit...
+							for (unsigned int i = 0; i < runtime_wrapper.weight_outputs_count; ++i) {
+								required_outputs.push_back(runtime_wrapper.weight_output_indices[i]);
+							}
+						}
 
-					y_cache.fill(gy);
+						// TODO Instead of filling this ourselves, can we leave this to the graph runtime?
+						// Because currently our logic seems redundant and more complicated, since we also have to not
+						// request those outputs later if any other output isn't uniform. Instead, the graph runtime can
+						// figure out that stuff is constant.
+						bool single_texture_is_uniform = false;
+						if (runtime_wrapper.single_texture_output_index != -1 && !sdf_is_air) {
+							const math::Interval index_range =
+									cache.state.get_range(runtime_wrapper.single_texture_output_buffer_index);
+
+							if (index_range.is_single_value()) {
+								single_texture_is_uniform = true;
+								fill_texturing_data_from_single_texture_index(
+										out_buffer, static_cast<int>(index_range.min), rmin, rmax, _texture_mode
+								);
+							} else {
+								required_outputs.push_back(runtime_wrapper.single_texture_output_index);
+							}
+						}
+
+						// Only some sections are measured, so profiling can stay enabled while streaming
+						const bool profile_section = _use_profiling && _profiler.pick_sample();
 
-					if (input_sdf_full_cache.size() != 0) {
-						// Copy input SDF using expected coordinate convention.
-						// VoxelBuffer is ZXY, but the graph runs in YXZ.
-						unsigned int i = 0;
-						for (int rz = rmin.z; rz < rmax.z; ++rz) {
-							for (int rx = rmin.x; rx < rmax.x; ++rx) {
-								const unsigned int loc = Vector3iUtil::get_zxy_index(rx, ry, rz, bs.x, bs.y);
-								input_sdf_slice_cache[i] = input_sdf_full_cache[loc];
-								++i;
+						if (required_outputs.size() == 0) {
+							// We found all we need with range analysis, no need to calculate per voxel.
+							if (profile_section) {
+								gather_profiling_sample(runtime, cache.state, nullptr, 0, 0, cache.profiling_sample);
+								_profiler.add_sample(to_span(cache.profiling_sample));
+								cache.profiling_sample.clear();
 							}
+							continue;
 						}
-					}
 
-					// Full query (unless using execution map)
-					{
-						QueryInputs<Span<const float>> query_inputs(
-								*runtime_ptr, x_cache, y_cache, z_cache, input_sdf_slice_cache
-						);
-						runtime.generate_set(
-								cache.state,
-								query_inputs.get(),
-								_use_xz_caching && ry != rmin.y,
-								_use_optimized_execution_map ? &cache.optimized_execution_map : nullptr
-						);
-					}
+						// Far away, only SDF is needed to be smooth, so it can be computed on a coarser lattice
+						if (sparse_factor > 1 && required_outputs.size() == 1 &&
+							required_outputs[0] == static_cast<unsigned int>(runtime_wrapper.sdf_output_index) &&
+							box.size.x % sparse_factor == 0 && box.size.y % sparse_factor == 0 &&
+							box.size.z % sparse_factor == 0) {
+							generate_sparse_sdf(
+									runtime_wrapper,
+									cache,
+									out_buffer,
+									origin,
+									lod,
+									box,
+									sparse_factor,
+									clip_threshold,
+									profile_section
+							);
+							if (profile_section) {
+								_profiler.add_sample(to_span(cache.profiling_sample));
+								cache.profiling_sample.clear();
+							}
+							continue;
+						}
 
-					if (sdf_output_buffer_index != -1
-						// If SDF was found uniform, we already filled the results, and we did not require it in the
-						// query. But if another output exists, a query might still run (so we end up at this
-						// `if`), and we should not gather SDF results. Otherwise it would overwrite the slice with
-						// garbage since SDF was skipped.
-						// The same logic goes for other outputs: if they aren't in the query, we must not fill
-						// them.
-						&& !sdf_is_uniform) {
-						const pg::Runtime::Buffer &sdf_buffer = cache.state.get_buffer(sdf_output_buffer_index);
-						fill_zx_sdf_slice(
-								sdf_buffer, out_buffer, sdf_channel, sdf_channel_depth, sdf_scale, rmin, rmax, ry
-						);
-					}
+						// At least one channel needs per-voxel computation.
 
-					if (type_output_buffer_index != -1 && !type_is_uniform) {
-						const pg::Runtime::Buffer &type_buffer = cache.state.get_buffer(type_output_buffer_index);
-						fill_zx_integer_slice(
-								type_buffer, out_buffer, type_channel, type_channel_depth, rmin, rmax, ry
-						);
-					}
+						// Boxes coming from adaptive subdivision can be smaller than sections
+						const unsigned int box_slice_size = box.size.x * box.size.z;
+						if (cache.state.get_buffer_size() != box_slice_size) {
+							runtime.prepare_state(cache.state, box_slice_size, false);
+						}
+						if (profile_section) {
+							runtime.reset_profiling(cache.state, true);
+						}
+						Span<float> box_x_cache = x_cache.sub(0, box_slice_size);
+						Span<float> box_y_cache = y_cache.sub(0, box_slice_size);
+						Span<float> box_z_cache = z_cache.sub(0, box_slice_size);
+						Span<float> box_input_sdf_slice_cache = input_sdf_slice_cache.size() != 0
+								? input_sdf_slice_cache.sub(0, box_slice_size)
+								: input_sdf_slice_cache;
+
+						if (_use_optimized_execution_map) {
+							runtime.generate_optimized_execution_map(
+									cache.state, cache.optimized_execution_map, to_span(required_outputs), false
+							);
+						}
 
-					if (runtime_ptr->single_texture_output_index != -1 && !single_texture_is_uniform) {
-						gather_texturing_data_from_single_texture_output(
-								runtime_ptr->single_texture_output_buffer_index,
-								cache.state,
-								rmin,
-								rmax,
-								ry,
-								out_buffer,
-								_texture_mode
-						);
-					}
+						// Values depending only on X and Z can be kept from the previous section of the column if they
+						// were computed for the same area, the same way
+						const bool reuse_outer_group = _use_xz_caching && outer_group_cached &&
+								is_same_xz_area(box, outer_group_cached_box) &&
+								(!_use_optimized_execution_map ||
+								 cache.optimized_execution_map.has_same_operations(cache.previous_execution_map));
+
+						// Otherwise, they might have been cached when generating other blocks of this column
+						bool outer_group_loaded = false;
+						bool store_in_column_cache = false;
+						GraphColumnCache::Key column_key;
+						if (use_column_cache && !reuse_outer_group) {
+							column_key.origin_x = gmin.x;
+							column_key.origin_z = gmin.z;
+							column_key.size_x = box.size.x;
+							column_key.size_z = box.size.z;
+							column_key.lod_index = lod;
+							column_key.program_hash = runtime_wrapper.program_hash;
+
+							get_outer_group_signature(
+									_use_optimized_execution_map ? cache.optimized_execution_map
+																 : runtime.get_default_execution_map(),
+									cache.outer_group_signature
+							);
+
+							outer_group_loaded = _column_cache.try_load(
+									column_key,
+									to_span(cache.outer_group_signature),
+									to_span(cache.outer_group_buffers),
+									box_slice_size
+							);
+							store_in_column_cache = !outer_group_loaded;
+						}
 
-					if (runtime_ptr->weight_outputs_count > 0) {
-						gather_texturing_data_from_weight_outputs(
-								to_span_const(runtime_ptr->weight_outputs, runtime_ptr->weight_outputs_count),
-								cache.state,
-								rmin,
-								rmax,
-								ry,
-								out_buffer,
-								spare_texture_indices,
-								_texture_mode
-						);
+						// X and Z inputs may still be read by the inner group
+						if (!reuse_outer_group) {
+							unsigned int i = 0;
+							for (int rz = rmin.z, gz = gmin.z; rz < rmax.z; ++rz, gz += stride) {
+								for (int rx = rmin.x, gx = gmin.x; rx < rmax.x; ++rx, gx += stride) {
+									box_x_cache[i] = gx;
+									box_z_cache[i] = gz;
+									++i;
+								}
+							}
+						}
+
+						// Positions of a slice form a grid if they are aligned to the step between voxels, which is
+						// almost always the case
+						const bool use_grid = _use_grid_queries && (gmin.x & (stride - 1)) == 0 &&
+								(gmin.y & (stride - 1)) == 0 && (gmin.z & (stride - 1)) == 0;
+						pg::Runtime::InputGrid slice_grid;
+						if (use_grid) {
+							slice_grid.origin = Vector3i(gmin.x >> lod, gmin.y >> lod, gmin.z >> lod);
+							slice_grid.size = Vector3i(box.size.x, 1, box.size.z);
+							slice_grid.step = stride;
+							slice_grid.axis_input_indices[0] = runtime_wrapper.x_input_index;
+							slice_grid.axis_input_indices[1] = runtime_wrapper.y_input_index;
+							slice_grid.axis_input_indices[2] = runtime_wrapper.z_input_index;
+						}
+
+						// How many slices ran operations of the outer group, for profiling
+						unsigned int outer_group_call_count = 0;
+
+						for (int ry = rmin.y, gy = gmin.y; ry < rmax.y; ++ry, gy += stride) {
+							ZN_PROFILE_SCOPE_NAMED("Full slice");
+
+							box_y_cache.fill(gy);
+							slice_grid.origin.y = gy >> lod;
+
+							if (input_sdf_full_cache.size() != 0) {
+								// Copy input SDF using expected coordinate convention.
+								// VoxelBuffer is ZXY, but the graph runs in YXZ.
+								unsigned int i = 0;
+								for (int rz = rmin.z; rz < rmax.z; ++rz) {
+									for (int rx = rmin.x; rx < rmax.x; ++rx) {
+										const unsigned int loc = Vector3iUtil::get_zxy_index(rx, ry, rz, bs.x, bs.y);
+										box_input_sdf_slice_cache[i] = input_sdf_full_cache[loc];
+										++i;
+									}
+								}
+							}
+
+							// Full query (unless using execution map)
+							{
+								QueryInputs<Span<const float>> query_inputs(
+										runtime_wrapper,
+										box_x_cache,
+										box_y_cache,
+										box_z_cache,
+										box_input_sdf_slice_cache
+								);
+								const bool skip_outer_group = _use_xz_caching &&
+										(ry != rmin.y || reuse_outer_group || outer_group_loaded);
+								runtime.generate_set(
+										cache.state,
+										query_inputs.get(),
+										skip_outer_group,
+										_use_optimized_execution_map ? &cache.optimized_execution_map : nullptr,
+										use_grid ? &slice_grid : nullptr
+								);
+								if (!skip_outer_group) {
+									++outer_group_call_count;
+								}
+							}
+
+							if (store_in_column_cache && ry == rmin.y) {
+								_column_cache.store(
+										column_key,
+										to_span(cache.outer_group_signature),
+										to_span_const(cache.outer_group_buffers),
+										box_slice_size
+								);
+							}
+
+							if (sdf_output_buffer_index != -1
+								// If SDF was found uniform, we already filled the results, and we did not require it
+								// in the query. But if another output exists, a query might still run (so we end up at
+								// this `if`), and we should not gather SDF results. Otherwise it would overwrite the
+								// slice with garbage since SDF was skipped.
+								// The same logic goes for other outputs: if they aren't in the query, we must not fill
+								// them.
+								&& !sdf_is_uniform) {
+								const pg::Runtime::Buffer &sdf_buffer = cache.state.get_buffer(sdf_output_buffer_index);
+								fill_zx_sdf_slice(
+										sdf_buffer.data,
+										out_buffer,
+										sdf_channel,
+										sdf_channel_depth,
+										sdf_scale,
+										rmin,
+										rmax,
+										ry
+								);
+							}
+
+							if (type_output_buffer_index != -1 && !type_is_uniform) {
+								const pg::Runtime::Buffer &type_buffer =
+										cache.state.get_buffer(type_output_buffer_index);
+								fill_zx_integer_slice(
+										type_buffer, out_buffer, type_channel, type_channel_depth, rmin, rmax, ry
+								);
+							}
+
+							if (runtime_wrapper.single_texture_output_index != -1 && !single_texture_is_uniform) {
+								gather_texturing_data_from_single_texture_output(
+										runtime_wrapper.single_texture_output_buffer_index,
+										cache.state,
+										rmin,
+										rmax,
+										ry,
+										out_buffer,
+										_texture_mode
+								);
+							}
+
+							if (runtime_wrapper.weight_outputs_count > 0) {
+								gather_texturing_data_from_weight_outputs(
+										to_span_const(
+												runtime_wrapper.weight_outputs, runtime_wrapper.weight_outputs_count
+										),
+										cache.state,
+										rmin,
+										rmax,
+										ry,
+										out_buffer,
+										spare_texture_indices,
+										_texture_mode
+								);
+							}
+						}
+
+						if (profile_section) {
+							gather_profiling_sample(
+									runtime,
+									cache.state,
+									_use_optimized_execution_map ? &cache.optimized_execution_map
+																 : &runtime.get_default_execution_map(),
+									outer_group_call_count,
+									box.size.y,
+									cache.profiling_sample
+							);
+							_profiler.add_sample(to_span(cache.profiling_sample));
+							cache.profiling_sample.clear();
+							runtime.reset_profiling(cache.state, false);
+						}
+
+						outer_group_cached = true;
+						outer_group_cached_box = box;
+						if (_use_optimized_execution_map) {
+							// Keep the map that was used, the next section will compare with it
+							std::swap(cache.optimized_execution_map, cache.previous_execution_map);
+						}
 					}
 				}
 			}
 		}
 	}
 
-	out_buffer.compress_uniform_channels();
+	for (unsigned int stack_index = 0; stack_index < stack.size(); ++stack_index) {
+		const unsigned int query_index = stack[stack_index];
+		queries[query_index].voxel_buffer.compress_uniform_channels();
+
+		// This is different from finding out that the buffer is uniform.
+		// This really means we predicted SDF will never cross zero in this area, no matter how precise we get.
+		// Relying on the block's uniform channels would bring up false positives due to LOD aliasing.
+		const StackedBlockState &block_state = cache.stacked_block_states[stack_index];
+		const bool all_sdf_is_uniform = block_state.all_sdf_is_air || block_state.all_sdf_is_matter;
+		if (all_sdf_is_uniform) {
+			// TODO If voxel texure weights are used, octree compression might be a bit more complicated.
+			// For now we only look at SDF but if texture weights are used and the player digs a bit inside terrain,
+			// they will find it's all default weights.
+			// Possible workarounds:
+			// - Only do it for air
+			// - Also take indices and weights into account, but may lead to way less compression, or none, for stuff
+			// that
+			//   essentially isnt showing up until dug out
+			// - Invoke generator to produce LOD0 blocks somehow, but main thread could stall
+			out_results[query_index].max_lod_hint = true;
+		}
+	}
+}
 
-	// This is different from finding out that the buffer is uniform.
-	// This really means we predicted SDF will never cross zero in this area, no matter how precise we get.
-	// Relying on the block's uniform channels would bring up false positives due to LOD aliasing.
-	const bool all_sdf_is_uniform = all_sdf_is_air || all_sdf_is_matter;
-	if (all_sdf_is_uniform) {
-		// TODO If voxel texure weights are used, octree compression might be a bit more complicated.
-		// For now we only look at SDF but if texture weights are used and the player digs a bit inside terrain,
-		// they will find it's all default weights.
-		// Possible workarounds:
-		// - Only do it for air
-		// - Also take indices and weights into account, but may lead to way less compression, or none, for stuff
-		// that
-		//   essentially isnt showing up until dug out
-		// - Invoke generator to produce LOD0 blocks somehow, but main thread could stall
-		result.max_lod_hint = true;
+// Computes SDF of a box on a lattice of points `factor` voxels apart, and fills voxels in between with trilinear
+// interpolation. If the error guard is enabled, cells of the lattice close to the surface are computed at every voxel.
+void VoxelGeneratorGraph::generate_sparse_sdf(
+		const Runtime &runtime_wrapper,
+		Cache &cache,
+		VoxelBuffer &out_buffer,
+		const Vector3i origin,
+		const uint32_t lod,
+		const Box3i box,
+		const int factor,
+		const float clip_threshold,
+		const bool profile
+) const {
+	ZN_PROFILE_SCOPE();
+
+	const pg::Runtime &runtime = runtime_wrapper.runtime;
+	const Vector3i cell_counts = box.size / factor;
+	// Points are also needed on the far side of the last cells
+	const Vector3i lattice_size = cell_counts + Vector3i(1, 1, 1);
+	const unsigned int lattice_volume = Vector3iUtil::get_volume_u64(lattice_size);
+
+	// Lattice points are ordered with X first, then Z, then Y, like slices
+	cache.sparse_x_cache.resize(lattice_volume);
+	cache.sparse_y_cache.resize(lattice_volume);
+	cache.sparse_z_cache.resize(lattice_volume);
+	{
+		unsigned int i = 0;
+		for (int ly = 0; ly < lattice_size.y; ++ly) {
+			for (int lz = 0; lz < lattice_size.z; ++lz) {
+				for (int lx = 0; lx < lattice_size.x; ++lx) {
+					const Vector3i gpos = origin + ((box.position + Vector3i(lx, ly, lz) * factor) << lod);
+					cache.sparse_x_cache[i] = gpos.x;
+					cache.sparse_y_cache[i] = gpos.y;
+					cache.sparse_z_cache[i] = gpos.z;
+					++i;
+				}
+			}
+		}
 	}
 
-	return result;
+	runtime.prepare_state(cache.sparse_state, lattice_volume, profile);
+	{
+		QueryInputs<Span<const float>> query_inputs(
+				runtime_wrapper,
+				to_span(cache.sparse_x_cache),
+				to_span(cache.sparse_y_cache),
+				to_span(cache.sparse_z_cache),
+				Span<const float>()
+		);
+		runtime.generate_set(cache.sparse_state, query_inputs.get(), false, nullptr);
+	}
+	if (profile) {
+		gather_profiling_sample(
+				runtime, cache.sparse_state, &runtime.get_default_execution_map(), 1, 1, cache.profiling_sample
+		);
+	}
+	{
+		const pg::Runtime::Buffer &sdf_buffer = cache.sparse_state.get_buffer(runtime_wrapper.sdf_output_buffer_index);
+		cache.sparse_lattice.assign(sdf_buffer.data, sdf_buffer.data + lattice_volume);
+	}
+	Span<const float> lattice = to_span(cache.sparse_lattice);
+
+	// Interpolate values of the box, also ordered in slices
+	const unsigned int box_volume = Vector3iUtil::get_volume_u64(box.size);
+	cache.sparse_values.resize(box_volume);
+	Span<float> values = to_span(cache.sparse_values);
+	const float inv_factor = 1.f / factor;
+	// Offsets from the first corner of a cell to its other corners, in the same order as `interpolate_trilinear`
+	const unsigned int lattice_y_jump = lattice_size.x * lattice_size.z;
+	FixedArray<unsigned int, 8> corner_offsets;
+	corner_offsets[0] = 0;
+	corner_offsets[1] = 1;
+	corner_offsets[2] = 1 + lattice_size.x;
+	corner_offsets[3] = lattice_size.x;
+	for (unsigned int i = 0; i < 4; ++i) {
+		corner_offsets[i + 4] = corner_offsets[i] + lattice_y_jump;
+	}
+	{
+		unsigned int i = 0;
+		for (int y = 0; y < box.size.y; ++y) {
+			for (int z = 0; z < box.size.z; ++z) {
+				for (int x = 0; x < box.size.x; ++x) {
+					const unsigned int li =
+							(x / factor) + lattice_size.x * ((z / factor) + lattice_size.z * (y / factor));
+					const Vector3f t = Vector3f(x % factor, y % factor, z % factor) * inv_factor;
+					values[i] = math::interpolate_trilinear(
+							lattice[li + corner_offsets[0]],
+							lattice[li + corner_offsets[1]],
+							lattice[li + corner_offsets[2]],
+							lattice[li + corner_offsets[3]],
+							lattice[li + corner_offsets[4]],
+							lattice[li + corner_offsets[5]],
+							lattice[li + corner_offsets[6]],
+							lattice[li + corner_offsets[7]],
+							t
+					);
+					++i;
+				}
+			}
+		}
+	}
+
+	if (_sparse_sampling_error_guard) {
+		// Interpolation errors matter where the surface can be, which is only where SDF is below the clip threshold.
+		// Voxels of cells whose corners are all far from the surface, on the same side, keep interpolated values.
+		StdVector<unsigned int> &exact_indices = cache.sparse_exact_indices;
+		exact_indices.clear();
+		for (int cy = 0; cy < cell_counts.y; ++cy) {
+			for (int cz = 0; cz < cell_counts.z; ++cz) {
+				for (int cx = 0; cx < cell_counts.x; ++cx) {
+					const unsigned int li = cx + lattice_size.x * (cz + lattice_size.z * cy);
+					const bool first_is_positive = lattice[li] > 0.f;
+					bool near_surface = false;
+					for (const unsigned int corner_offset : corner_offsets) {
+						const float sd = lattice[li + corner_offset];
+						if (Math::abs(sd) < clip_threshold || (sd > 0.f) != first_is_positive) {
+							near_surface = true;
+							break;
+						}
+					}
+					if (!near_surface) {
+						continue;
+					}
+					for (int y = cy * factor; y < (cy + 1) * factor; ++y) {
+						for (int z = cz * factor; z < (cz + 1) * factor; ++z) {
+							for (int x = cx * factor; x < (cx + 1) * factor; ++x) {
+								exact_indices.push_back(x + box.size.x * (z + box.size.z * y));
+							}
+						}
+					}
+				}
+			}
+		}
+
+		if (exact_indices.size() > 0) {
+			ZN_PROFILE_SCOPE_NAMED("Exact cells");
+
+			cache.sparse_x_cache.resize(exact_indices.size());
+			cache.sparse_y_cache.resize(exact_indices.size());
+			cache.sparse_z_cache.resize(exact_indices.size());
+			const unsigned int slice_size = box.size.x * box.size.z;
+			for (unsigned int i = 0; i < exact_indices.size(); ++i) {
+				const unsigned int vi = exact_indices[i];
+				const Vector3i rpos(vi % box.size.x, vi / slice_size, (vi / box.size.x) % box.size.z);
+				const Vector3i gpos = origin + ((box.position + rpos) << lod);
+				cache.sparse_x_cache[i] = gpos.x;
+				cache.sparse_y_cache[i] = gpos.y;
+				cache.sparse_z_cache[i] = gpos.z;
+			}
+
+			runtime.prepare_state(cache.sparse_state, exact_indices.size(), profile);
+			QueryInputs<Span<const float>> query_inputs(
+					runtime_wrapper,
+					to_span(cache.sparse_x_cache),
+					to_span(cache.sparse_y_cache),
+					to_span(cache.sparse_z_cache),
+					Span<const float>()
+			);
+			runtime.generate_set(cache.sparse_state, query_inputs.get(), false, nullptr);
+			if (profile) {
+				gather_profiling_sample(
+						runtime, cache.sparse_state, &runtime.get_default_execution_map(), 1, 1, cache.profiling_sample
+				);
+			}
+
+			const pg::Runtime::Buffer &sdf_buffer =
+					cache.sparse_state.get_buffer(runtime_wrapper.sdf_output_buffer_index);
+			for (unsigned int i = 0; i < exact_indices.size(); ++i) {
+				values[exact_indices[i]] = sdf_buffer.data[i];
+			}
+		}
+	}
+
+	const VoxelBuffer::ChannelId sdf_channel = VoxelBuffer::CHANNEL_SDF;
+	const VoxelBuffer::Depth sdf_channel_depth = out_buffer.get_channel_depth(sdf_channel);
+	const float sdf_scale = VoxelBuffer::get_sdf_quantization_scale(sdf_channel_depth);
+	const Vector3i rmin = box.position;
+	const Vector3i rmax = box.position + box.size;
+	const unsigned int slice_size = box.size.x * box.size.z;
+	for (int y = 0; y < box.size.y; ++y) {
+		fill_zx_sdf_slice(
+				values.data() + y * slice_size,
+				out_buffer,
+				sdf_channel,
+				sdf_channel_depth,
+				sdf_scale,
+				rmin,
+				rmax,
+				rmin.y + y
+		);
+	}
 }
 
 bool VoxelGeneratorGraph::generate_broad_block(VoxelGenerator::VoxelQueryData input) {
@@ -1310,9 +2072,19 @@ pg::CompilationResult VoxelGeneratorGraph::compile(bool debug) {
 		r->spare_texture_indices = spare_indices;
 	}
 
+	r->program_hash = runtime.get_program_hash();
+
 	// Store valid result
-	RWLockWrite wlock(_runtime_lock);
-	_runtime = r;
+	{
+		RWLockWrite wlock(_runtime_lock);
+		_runtime = r;
+	}
+
+	// Values of the previous program can't be used anymore
+	_column_cache.clear();
+	_block_cache.clear();
+	// Node IDs may refer to different nodes
+	_profiler.clear();
 
 	const int64_t time_spent = Time::get_singleton()->get_ticks_usec() - time_before;
 	ZN_PRINT_VERBOSE(format("Voxel graph compiled in {} us", time_spent));
@@ -2239,18 +3011,76 @@ Dictionary VoxelGeneratorGraph::_b_compile() {
 	pg::CompilationResult res = compile(false);
 	Dictionary d;
 	d["success"] = res.success;
-	if (!res.success) {
+	if (res.success) {
+		d["fused_operations"] = res.fusion_stats.fused_operations_count;
+		d["buffer_passes"] = res.fusion_stats.buffer_passes_count;
+		d["fused_reads"] = res.fusion_stats.fused_reads_count;
+		d["tile_streaming"] = res.tile_streaming;
+	} else {
 		d["message"] = res.message;
 		d["node_id"] = res.node_id;
 	}
 	return d;
 }
 
+Dictionary VoxelGeneratorGraph::_b_get_block_cache_stats() const {
+	const GraphBlockCache::Stats stats = get_block_cache_stats();
+	const uint64_t lookup_count = stats.hit_count + stats.miss_count;
+	Dictionary d;
+	d["hits"] = stats.hit_count;
+	d["misses"] = stats.miss_count;
+	d["hit_rate"] = lookup_count > 0 ? static_cast<float>(stats.hit_count) / lookup_count : 0.f;
+	d["memory_usage"] = static_cast<int64_t>(stats.memory_usage);
+	d["entries"] = stats.entry_count;
+	return d;
+}
+
+Dictionary VoxelGeneratorGraph::_b_get_profiling_results() const {
+	StdVector<GraphProfiler::NodeStats> nodes;
+	uint64_t sample_count;
+	get_profiling_results(nodes, sample_count);
+
+	Array nodes_array;
+	nodes_array.resize(nodes.size());
+	for (unsigned int i = 0; i < nodes.size(); ++i) {
+		const GraphProfiler::NodeStats &stats = nodes[i];
+		Dictionary d;
+		d["node_id"] = stats.node_id;
+		const double microseconds = static_cast<double>(stats.nanoseconds) / 1000.0;
+		d["microseconds"] = microseconds;
+		d["calls"] = stats.call_count;
+		d["microseconds_per_call"] = stats.call_count > 0 ? microseconds / stats.call_count : 0.0;
+		d["skipped"] = stats.skip_count;
+		d["skip_rate"] = sample_count > 0 ? static_cast<float>(stats.skip_count) / sample_count : 0.f;
+		nodes_array[i] = d;
+	}
+
+	Dictionary d;
+	d["sampled_sections"] = sample_count;
+	d["nodes"] = nodes_array;
+	return d;
+}
+
+Dictionary VoxelGeneratorGraph::_b_get_column_cache_stats() const {
+	const GraphColumnCache::Stats stats = get_column_cache_stats();
+	const uint64_t lookup_count = stats.hit_count + stats.miss_count;
+	Dictionary d;
+	d["hits"] = stats.hit_count;
+	d["misses"] = stats.miss_count;
+	d["hit_rate"] = lookup_count > 0 ? static_cast<float>(stats.hit_count) / lookup_count : 0.f;
+	d["memory_usage"] = static_cast<int64_t>(stats.memory_usage);
+	d["entries"] = stats.entry_count;
+	return d;
+}
+
 float VoxelGeneratorGraph::_b_debug_measure_microseconds_per_voxel(bool singular) {
 	return debug_measure_microseconds_per_voxel(singular, nullptr);
 }
 
 void VoxelGeneratorGraph::_on_subresource_changed() {
+	// Resources used by nodes can change without the graph being recompiled
+	_column_cache.clear();
+	_block_cache.clear();
 	emit_changed();
 }
 
@@ -2286,12 +3116,61 @@ void VoxelGeneratorGraph::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("set_subdivision_size", "size"), &Self::set_subdivision_size);
 	ClassDB::bind_method(D_METHOD("get_subdivision_size"), &Self::get_subdivision_size);
 
+	ClassDB::bind_method(D_METHOD("set_use_adaptive_subdivision", "enabled"), &Self::set_use_adaptive_subdivision);
+	ClassDB::bind_method(D_METHOD("is_using_adaptive_subdivision"), &Self::is_using_adaptive_subdivision);
+
+	ClassDB::bind_method(
+			D_METHOD("set_adaptive_subdivision_min_size", "size"), &Self::set_adaptive_subdivision_min_size
+	);
+	ClassDB::bind_method(D_METHOD("get_adaptive_subdivision_min_size"), &Self::get_adaptive_subdivision_min_size);
+
+	ClassDB::bind_method(D_METHOD("set_sparse_sampling_factor", "factor"), &Self::set_sparse_sampling_factor);
+	ClassDB::bind_method(D_METHOD("get_sparse_sampling_factor"), &Self::get_sparse_sampling_factor);
+
+	ClassDB::bind_method(D_METHOD("set_sparse_sampling_min_lod", "lod_index"), &Self::set_sparse_sampling_min_lod);
+	ClassDB::bind_method(D_METHOD("get_sparse_sampling_min_lod"), &Self::get_sparse_sampling_min_lod);
+
+	ClassDB::bind_method(
+			D_METHOD("set_sparse_sampling_error_guard", "enabled"), &Self::set_sparse_sampling_error_guard
+	);
+	ClassDB::bind_method(D_METHOD("is_sparse_sampling_error_guard"), &Self::is_sparse_sampling_error_guard);
+
 	ClassDB::bind_method(D_METHOD("set_debug_clipped_blocks", "enabled"), &Self::set_debug_clipped_blocks);
 	ClassDB::bind_method(D_METHOD("is_debug_clipped_blocks"), &Self::is_debug_clipped_blocks);
 
 	ClassDB::bind_method(D_METHOD("set_use_xz_caching", "enabled"), &Self::set_use_xz_caching);
 	ClassDB::bind_method(D_METHOD("is_using_xz_caching"), &Self::is_using_xz_caching);
 
+	ClassDB::bind_method(D_METHOD("set_use_column_cache", "enabled"), &Self::set_use_column_cache);
+	ClassDB::bind_method(D_METHOD("is_using_column_cache"), &Self::is_using_column_cache);
+
+	ClassDB::bind_method(D_METHOD("set_use_grid_queries", "enabled"), &Self::set_use_grid_queries);
+	ClassDB::bind_method(D_METHOD("is_using_grid_queries"), &Self::is_using_grid_queries);
+
+	ClassDB::bind_method(D_METHOD("set_column_cache_capacity", "capacity_bytes"), &Self::set_column_cache_capacity);
+	ClassDB::bind_method(D_METHOD("get_column_cache_capacity"), &Self::get_column_cache_capacity);
+
+	ClassDB::bind_method(D_METHOD("get_column_cache_stats"), &Self::_b_get_column_cache_stats);
+	ClassDB::bind_method(D_METHOD("clear_column_cache"), &Self::clear_column_cache);
+
+	ClassDB::bind_method(D_METHOD("set_use_block_cache", "enabled"), &Self::set_use_block_cache);
+	ClassDB::bind_method(D_METHOD("is_using_block_cache"), &Self::is_using_block_cache);
+
+	ClassDB::bind_method(D_METHOD("set_block_cache_capacity", "capacity_bytes"), &Self::set_block_cache_capacity);
+	ClassDB::bind_method(D_METHOD("get_block_cache_capacity"), &Self::get_block_cache_capacity);
+
+	ClassDB::bind_method(D_METHOD("get_block_cache_stats"), &Self::_b_get_block_cache_stats);
+	ClassDB::bind_method(D_METHOD("clear_block_cache"), &Self::clear_block_cache);
+
+	ClassDB::bind_method(D_METHOD("set_use_profiling", "enabled"), &Self::set_use_profiling);
+	ClassDB::bind_method(D_METHOD("is_using_profiling"), &Self::is_using_profiling);
+
+	ClassDB::bind_method(D_METHOD("set_profiling_sample_interval", "interval"), &Self::set_profiling_sample_interval);
+	ClassDB::bind_method(D_METHOD("get_profiling_sample_interval"), &Self::get_profiling_sample_interval);
+
+	ClassDB::bind_method(D_METHOD("get_profiling_results"), &Self::_b_get_profiling_results);
+	ClassDB::bind_method(D_METHOD("clear_profiling_results"), &Self::clear_profiling_results);
+
 	ClassDB::bind_method(D_METHOD("set_texture_mode", "mode"), &Self::set_texture_mode);
 	ClassDB::bind_method(D_METHOD("get_texture_mode"), &Self::get_texture_mode);
 
@@ -2351,7 +3230,49 @@ void VoxelGeneratorGraph::_bind_methods() {
 	);
 	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "use_subdivision"), "set_use_subdivision", "is_using_subdivision");
 	ADD_PROPERTY(PropertyInfo(Variant::INT, "subdivision_size"), "set_subdivision_size", "get_subdivision_size");
+	ADD_PROPERTY(
+			PropertyInfo(Variant::BOOL, "use_adaptive_subdivision"),
+			"set_use_adaptive_subdivision",
+			"is_using_adaptive_subdivision"
+	);
+	ADD_PROPERTY(
+			PropertyInfo(Variant::INT, "adaptive_subdivision_min_size", PROPERTY_HINT_RANGE, "1,64,1"),
+			"set_adaptive_subdivision_min_size",
+			"get_adaptive_subdivision_min_size"
+	);
+	ADD_PROPERTY(
+			PropertyInfo(Variant::INT, "sparse_sampling_factor", PROPERTY_HINT_ENUM, "Disabled:1,2:2,4:4"),
+			"set_sparse_sampling_factor",
+			"get_sparse_sampling_factor"
+	);
+	ADD_PROPERTY(
+			PropertyInfo(Variant::INT, "sparse_sampling_min_lod", PROPERTY_HINT_RANGE, "0,23,1"),
+			"set_sparse_sampling_min_lod",
+			"get_sparse_sampling_min_lod"
+	);
+	ADD_PROPERTY(
+			PropertyInfo(Variant::BOOL, "sparse_sampling_error_guard"),
+			"set_sparse_sampling_error_guard",
+			"is_sparse_sampling_error_guard"
+	);
 	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "use_xz_caching"), "set_use_xz_caching", "is_using_xz_caching");
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "use_column_cache"), "set_use_column_cache", "is_using_column_cache");
+	ADD_PROPERTY(
+			PropertyInfo(Variant::INT, "column_cache_capacity"),
+			"set_column_cache_capacity",
+			"get_column_cache_capacity"
+	);
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "use_grid_queries"), "set_use_grid_queries", "is_using_grid_queries");
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "use_block_cache"), "set_use_block_cache", "is_using_block_cache");
+	ADD_PROPERTY(
+			PropertyInfo(Variant::INT, "block_cache_capacity"), "set_block_cache_capacity", "get_block_cache_capacity"
+	);
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "use_profiling"), "set_use_profiling", "is_using_profiling");
+	ADD_PROPERTY(
+			PropertyInfo(Variant::INT, "profiling_sample_interval", PROPERTY_HINT_RANGE, "1,1024,1,or_greater"),
+			"set_profiling_sample_interval",
+			"get_profiling_sample_interval"
+	);
 	ADD_PROPERTY(
 			PropertyInfo(Variant::BOOL, "debug_block_clipping"), "set_debug_clipped_blocks", "is_debug_clipped_blocks"
 	);
@@ -6,6 +6,7 @@
 #include "../../util/containers/std_vector.h"
 #include "../../util/godot/core/dictionary.h"
 #include "../../util/macros.h"
+#include "../../util/math/box3i.h"
 #include "../../util/math/vector2.h"
 #include "../../util/math/vector3.h"
 #include "../../util/math/vector3f.h"
@@ -13,7 +14,10 @@
 #include "../../util/thread/rw_lock.h"
 #include "../voxel_generator.h"
 #include "program_graph.h"
+#include "voxel_graph_block_cache.h"
+#include "voxel_graph_column_cache.h"
 #include "voxel_graph_function.h"
+#include "voxel_graph_profiler.h"
 #include "voxel_graph_runtime.h"
 
 #include <memory>
@@ -61,12 +65,57 @@ public:
 	void set_subdivision_size(int size);
 	int get_subdivision_size() const;
 
+	void set_use_adaptive_subdivision(bool enabled);
+	bool is_using_adaptive_subdivision() const;
+
+	void set_adaptive_subdivision_min_size(int size);
+	int get_adaptive_subdivision_min_size() const;
+
+	void set_sparse_sampling_factor(int factor);
+	int get_sparse_sampling_factor() const;
+
+	void set_sparse_sampling_min_lod(int lod_index);
+	int get_sparse_sampling_min_lod() const;
+
+	void set_sparse_sampling_error_guard(bool enabled);
+	bool is_sparse_sampling_error_guard() const;
+
 	void set_debug_clipped_blocks(bool enabled);
 	bool is_debug_clipped_blocks() const;
 
 	void set_use_xz_caching(bool enabled);
 	bool is_using_xz_caching() const;
 
+	void set_use_column_cache(bool enabled);
+	bool is_using_column_cache() const;
+
+	void set_use_grid_queries(bool enabled);
+	bool is_using_grid_queries() const;
+
+	void set_column_cache_capacity(int capacity_bytes);
+	int get_column_cache_capacity() const;
+
+	GraphColumnCache::Stats get_column_cache_stats() const;
+	void clear_column_cache();
+
+	void set_use_block_cache(bool enabled);
+	bool is_using_block_cache() const;
+
+	void set_block_cache_capacity(int capacity_bytes);
+	int get_block_cache_capacity() const;
+
+	GraphBlockCache::Stats get_block_cache_stats() const;
+	void clear_block_cache();
+
+	void set_use_profiling(bool enabled);
+	bool is_using_profiling() const;
+
+	void set_profiling_sample_interval(int interval);
+	int get_profiling_sample_interval() const;
+
+	void get_profiling_results(StdVector<GraphProfiler::NodeStats> &out_nodes, uint64_t &out_sample_count) const;
+	void clear_profiling_results();
+
 	void set_texture_mode(const TextureMode mode);
 	TextureMode get_texture_mode() const;
 
@@ -75,6 +124,7 @@ public:
 	int get_used_channels_mask() const override;
 
 	Result generate_block(VoxelGenerator::VoxelQueryData input) override;
+	void generate_blocks(Span<VoxelGenerator::VoxelQueryData> queries, Span<Result> out_results) override;
 	bool generate_broad_block(VoxelGenerator::VoxelQueryData input) override;
 	// float generate_single(const Vector3i &position);
 	bool supports_single_generation() const override {
@@ -157,6 +207,9 @@ private:
 	float _b_generate_single(Vector3 pos);
 	Vector2 _b_debug_analyze_range(Vector3 min_pos, Vector3 max_pos) const;
 	Dictionary _b_compile();
+	Dictionary _b_get_column_cache_stats() const;
+	Dictionary _b_get_block_cache_stats() const;
+	Dictionary _b_get_profiling_results() const;
 	float _b_debug_measure_microseconds_per_voxel(bool singular);
 #ifdef TOOLS_ENABLED
 	// This exists because some custom editors will edit an internal object instead of the resource itself
@@ -199,13 +252,34 @@ private:
 	// Blocks size must be a multiple of the subdivision size.
 	bool _use_subdivision = true;
 	int _subdivision_size = 16;
+	// When enabled, subdivisions where range analysis finds the surface might be present are split recursively in
+	// octants, down to a minimum size. Octants found to be fully air or matter are filled without computing voxels.
+	bool _use_adaptive_subdivision = false;
+	int _adaptive_subdivision_min_size = 4;
+	// At LODs from `_sparse_sampling_min_lod`, SDF may be computed only every N voxels, and interpolated in between.
+	// Far meshes only need a smooth field, so this saves a lot of computations. 1 means disabled.
+	int _sparse_sampling_factor = 1;
+	int _sparse_sampling_min_lod = 2;
+	// When enabled, cells of the sparse lattice where SDF is close to the surface are computed at every voxel
+	bool _sparse_sampling_error_guard = true;
 	// When enabled, the generator will attempt to optimize out nodes that don't need to run in specific areas,
 	// if their output range is considered to not affect the final result.
 	bool _use_optimized_execution_map = true;
 	// When enabled, nodes using only the X and Z coordinates will be cached when generating blocks in slices along Y.
-	// This prevents recalculating values that would otherwise be the same on each slice.
+	// This prevents recalculating values that would otherwise be the same on each slice. When multiple blocks stacked
+	// along Y are generated at once, this also applies across them.
 	// It helps a lot when part of the graph is generating a heightmap for example.
 	bool _use_xz_caching = true;
+	// When enabled, values only depending on X and Z are also kept after blocks are generated, so blocks generated
+	// later in the same columns don't have to compute them again. Only applies if XZ caching is enabled.
+	bool _use_column_cache = true;
+	// When enabled, blocks are generated telling nodes that their positions form a regular grid, so those that support it
+	// can use faster algorithms (such as FastNoise2 nodes directly connected to X, Y and Z).
+	bool _use_grid_queries = true;
+	// When enabled, generated blocks are kept compressed, so generating them again only requires decompressing them.
+	bool _use_block_cache = false;
+	// When enabled, time spent in each node is measured on a sample of the sections generated by worker threads.
+	bool _use_profiling = false;
 	// If true, inverts clipped blocks so they create visual artifacts making the clipped area visible.
 	bool _debug_clipped_blocks = false;
 	TextureMode _texture_mode = TEXTURE_MODE_MIXEL4;
@@ -221,6 +295,9 @@ private:
 		// This is used when there are less than 4 texture weight outputs.
 		FixedArray<uint8_t, 4> spare_texture_indices;
 
+		// Identifies the compiled program in the column cache
+		uint64_t program_hash = 0;
+
 		int x_input_index = -1;
 		int y_input_index = -1;
 		int z_input_index = -1;
@@ -271,6 +348,16 @@ private:
 	std::shared_ptr<Runtime> _runtime = nullptr;
 	RWLock _runtime_lock;
 
+	// Shared by all threads generating with this generator
+	GraphColumnCache _column_cache;
+	GraphBlockCache _block_cache;
+	GraphProfiler _profiler;
+
+	struct StackedBlockState {
+		bool all_sdf_is_air;
+		bool all_sdf_is_matter;
+	};
+
 	struct Cache {
 		StdVector<float> x_cache;
 		StdVector<float> y_cache;
@@ -280,9 +367,55 @@ private:
 		// TODO Use the runtime and state from `VoxelGraphFunction`
 		pg::Runtime::State state;
 		pg::Runtime::ExecutionMap optimized_execution_map;
+		// Map used by the last query, to know if values depending only on X and Z can be re-used
+		pg::Runtime::ExecutionMap previous_execution_map;
+		// Order in which blocks of a batch are generated
+		StdVector<unsigned int> block_order;
+		StdVector<StackedBlockState> stacked_block_states;
+		// Boxes of the current section left to process
+		StdVector<Box3i> section_boxes;
+		// Describes how values of the outer group were computed, for the column cache
+		StdVector<uint32_t> outer_group_signature;
+		StdVector<float *> outer_group_buffers;
+		// Keys of blocks of a batch in the block cache
+		StdVector<GraphBlockCache::Key> block_cache_keys;
+		// Used when SDF is computed on a sparse lattice. The state is separate so values of the outer group aren't lost.
+		pg::Runtime::State sparse_state;
+		StdVector<float> sparse_x_cache;
+		StdVector<float> sparse_y_cache;
+		StdVector<float> sparse_z_cache;
+		StdVector<float> sparse_lattice;
+		StdVector<float> sparse_values;
+		StdVector<unsigned int> sparse_exact_indices;
+		// Measurements of the current section, when it is sampled by the profiler
+		StdVector<GraphProfiler::NodeStats> profiling_sample;
 	};
 
 	static Cache &get_tls_cache();
+
+	int get_used_channels_mask(const Runtime &runtime) const;
+	// Hashes settings changing how blocks are generated, other than the program itself
+	uint64_t get_block_cache_settings_hash() const;
+
+	void generate_block_stack(
+			const Runtime &runtime_wrapper,
+			Cache &cache,
+			Span<VoxelGenerator::VoxelQueryData> queries,
+			Span<Result> out_results,
+			Span<const unsigned int> stack
+	);
+
+	void generate_sparse_sdf(
+			const Runtime &runtime_wrapper,
+			Cache &cache,
+			VoxelBuffer &out_buffer,
+			const Vector3i origin,
+			const uint32_t lod,
+			const Box3i box,
+			const int factor,
+			const float clip_threshold,
+			const bool profile
+	) const;
 };
 
 } // namespace zylann::voxel
@@ -0,0 +1,133 @@
+#include "voxel_graph_block_cache.h"
+#include "../../storage/voxel_buffer.h"
+#include "../../streams/voxel_block_serializer.h"
+#include "../../util/errors.h"
+#include "../../util/profiling.h"
+
+namespace zylann::voxel {
+
+namespace {
+
+StdVector<uint8_t> &get_tls_compressed_data() {
+	static thread_local StdVector<uint8_t> tls_data;
+	return tls_data;
+}
+
+// Buffer only holding channels to cache or to load
+VoxelBuffer &get_tls_voxels() {
+	static thread_local VoxelBuffer tls_voxels(VoxelBuffer::ALLOCATOR_DEFAULT);
+	return tls_voxels;
+}
+
+} // namespace
+
+GraphBlockCache::Key GraphBlockCache::make_key(
+		const VoxelBuffer &voxels,
+		Vector3i origin_in_voxels,
+		uint8_t lod_index,
+		uint8_t channels_mask,
+		uint64_t program_hash,
+		uint64_t settings_hash
+) {
+	Key key;
+	key.origin_in_voxels = origin_in_voxels;
+	key.size = voxels.get_size();
+	key.lod_index = lod_index;
+	key.channels_mask = channels_mask;
+	key.channel_depths = 0;
+	for (unsigned int channel_index = 0; channel_index < VoxelBuffer::MAX_CHANNELS; ++channel_index) {
+		key.channel_depths |= voxels.get_channel_depth(channel_index) << (channel_index * 2);
+	}
+	key.program_hash = program_hash;
+	key.settings_hash = settings_hash;
+	return key;
+}
+
+bool GraphBlockCache::try_load(const Key &key, VoxelBuffer &out_voxels, bool &out_max_lod_hint) {
+	ZN_PROFILE_SCOPE();
+	ZN_ASSERT_RETURN_V(out_voxels.get_size() == key.size, false);
+
+	// Data is copied so decompression doesn't lock other threads
+	StdVector<uint8_t> &compressed_data = get_tls_compressed_data();
+	{
+		MutexLock lock(_mutex);
+
+		const Entry *entry = _entries.get(key);
+		if (entry == nullptr) {
+			return false;
+		}
+		compressed_data = entry->data;
+		out_max_lod_hint = entry->max_lod_hint;
+	}
+
+	VoxelBuffer &voxels = get_tls_voxels();
+	ZN_ASSERT_RETURN_V(BlockSerializer::decompress_and_deserialize(to_span(compressed_data), voxels), false);
+	ZN_ASSERT_RETURN_V(voxels.get_size() == key.size, false);
+
+	for (unsigned int channel_index = 0; channel_index < VoxelBuffer::MAX_CHANNELS; ++channel_index) {
+		if ((key.channels_mask & (1 << channel_index)) != 0) {
+			out_voxels.copy_channel_from(voxels, channel_index);
+		}
+	}
+	return true;
+}
+
+void GraphBlockCache::store(const Key &key, const VoxelBuffer &voxels, bool max_lod_hint) {
+	ZN_PROFILE_SCOPE();
+	ZN_ASSERT_RETURN(voxels.get_size() == key.size);
+
+	{
+		MutexLock lock(_mutex);
+		if (_entries.get_capacity() == 0) {
+			return;
+		}
+	}
+
+	// Only channels produced by the generator are kept
+	VoxelBuffer &tmp_voxels = get_tls_voxels();
+	tmp_voxels.create(key.size);
+	for (unsigned int channel_index = 0; channel_index < VoxelBuffer::MAX_CHANNELS; ++channel_index) {
+		if ((key.channels_mask & (1 << channel_index)) != 0) {
+			tmp_voxels.set_channel_depth(channel_index, voxels.get_channel_depth(channel_index));
+			tmp_voxels.copy_channel_from(voxels, channel_index);
+		}
+	}
+
+	const BlockSerializer::SerializeResult result = BlockSerializer::serialize_and_compress(tmp_voxels);
+	ZN_ASSERT_RETURN(result.success);
+
+	Entry entry;
+	entry.data = result.data;
+	entry.max_lod_hint = max_lod_hint;
+	const size_t memory_usage = entry.data.capacity();
+
+	MutexLock lock(_mutex);
+	_entries.set(key, std::move(entry), memory_usage);
+}
+
+void GraphBlockCache::clear() {
+	MutexLock lock(_mutex);
+	_entries.clear();
+}
+
+void GraphBlockCache::set_capacity(size_t capacity_bytes) {
+	MutexLock lock(_mutex);
+	_entries.set_capacity(capacity_bytes);
+}
+
+size_t GraphBlockCache::get_capacity() const {
+	MutexLock lock(_mutex);
+	return _entries.get_capacity();
+}
+
+GraphBlockCache::Stats GraphBlockCache::get_stats() const {
+	MutexLock lock(_mutex);
+	return _entries.get_stats();
+}
+
+void GraphBlockCache::reset_stats() {
+	MutexLock lock(_mutex);
+	_entries.reset_stats();
+}
+
+} // namespace zylann::voxel
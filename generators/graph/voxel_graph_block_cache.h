@@ -0,0 +1,95 @@
+#ifndef VOXEL_GRAPH_BLOCK_CACHE_H
+#define VOXEL_GRAPH_BLOCK_CACHE_H
+
+#include "../../util/containers/lru_cache.h"
+#include "../../util/containers/std_vector.h"
+#include "../../util/hash_funcs.h"
+#include "../../util/math/vector3i.h"
+#include "../../util/thread/mutex.h"
+#include <cstdint>
+
+namespace zylann::voxel {
+
+class VoxelBuffer;
+
+// Keeps blocks recently generated by a generator graph, so generating them again only needs to decompress them. This
+// helps when viewers go back and forth across the same areas, or when several terrains share the same generator.
+// Blocks are stored compressed. When memory usage goes above capacity, the least recently used blocks are evicted.
+// This is thread-safe.
+class GraphBlockCache {
+public:
+	struct Key {
+		Vector3i origin_in_voxels;
+		Vector3i size;
+		uint8_t lod_index;
+		// Channels written by the generator
+		uint8_t channels_mask;
+		// Depth of each channel, 2 bits per channel
+		uint16_t channel_depths;
+		// Blocks depend on which program generated them, and with which settings
+		uint64_t program_hash;
+		uint64_t settings_hash;
+
+		inline bool operator==(const Key &other) const {
+			return origin_in_voxels == other.origin_in_voxels && size == other.size &&
+					lod_index == other.lod_index && channels_mask == other.channels_mask &&
+					channel_depths == other.channel_depths && program_hash == other.program_hash &&
+					settings_hash == other.settings_hash;
+		}
+	};
+
+	static const size_t DEFAULT_CAPACITY = 32 * 1024 * 1024;
+
+	// Makes a key for a block about to be generated into `voxels`
+	static Key make_key(
+			const VoxelBuffer &voxels,
+			Vector3i origin_in_voxels,
+			uint8_t lod_index,
+			uint8_t channels_mask,
+			uint64_t program_hash,
+			uint64_t settings_hash
+	);
+
+	// Copies channels of a cached block into `out_voxels`. Other channels are left untouched.
+	// Returns true if the block was found.
+	bool try_load(const Key &key, VoxelBuffer &out_voxels, bool &out_max_lod_hint);
+
+	// Caches channels of a generated block, replacing any previous version.
+	void store(const Key &key, const VoxelBuffer &voxels, bool max_lod_hint);
+
+	void clear();
+
+	// Maximum amount of memory used by cached blocks, in bytes
+	void set_capacity(size_t capacity_bytes);
+	size_t get_capacity() const;
+
+	typedef LRUCacheStats Stats;
+
+	Stats get_stats() const;
+	void reset_stats();
+
+private:
+	struct KeyHasher {
+		inline size_t operator()(const Key &key) const {
+			uint64_t h = hash_djb2_one_64(key.origin_in_voxels.x);
+			h = hash_djb2_one_64(key.origin_in_voxels.y, h);
+			h = hash_djb2_one_64(key.origin_in_voxels.z, h);
+			h = hash_djb2_one_64(key.lod_index | (key.channels_mask << 8) | (key.channel_depths << 16), h);
+			h = hash_djb2_one_64(key.program_hash, h);
+			return hash_djb2_one_64(key.settings_hash, h);
+		}
+	};
+
+	struct Entry {
+		// Voxels serialized and compressed with `BlockSerializer`
+		StdVector<uint8_t> data;
+		bool max_lod_hint = false;
+	};
+
+	LRUCache<Key, Entry, KeyHasher> _entries{ DEFAULT_CAPACITY };
+	Mutex _mutex;
+};
+
+} // namespace zylann::voxel
+
+#endif // VOXEL_GRAPH_BLOCK_CACHE_H
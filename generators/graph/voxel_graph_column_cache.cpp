@@ -0,0 +1,108 @@
+#include "voxel_graph_column_cache.h"
+#include "../../util/errors.h"
+#include "../../util/profiling.h"
+#include <algorithm>
+
+namespace zylann::voxel {
+
+namespace {
+
+bool is_same_signature(const StdVector<uint32_t> &a, Span<const uint32_t> b) {
+	if (a.size() != b.size()) {
+		return false;
+	}
+	for (unsigned int i = 0; i < b.size(); ++i) {
+		if (a[i] != b[i]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+} // namespace
+
+bool GraphColumnCache::try_load(
+		const Key &key,
+		Span<const uint32_t> signature,
+		Span<float *const> dst_buffers,
+		unsigned int values_per_buffer
+) {
+	ZN_PROFILE_SCOPE();
+	MutexLock lock(_mutex);
+
+	const Entry *entry = _entries.get_if(key, [signature, &dst_buffers, values_per_buffer](const Entry &cached) {
+		// Values computed differently are not usable
+		return cached.values.size() == dst_buffers.size() * values_per_buffer &&
+				is_same_signature(cached.signature, signature);
+	});
+	if (entry == nullptr) {
+		return false;
+	}
+
+	for (unsigned int buffer_index = 0; buffer_index < dst_buffers.size(); ++buffer_index) {
+		float *dst = dst_buffers[buffer_index];
+		ZN_ASSERT_CONTINUE(dst != nullptr);
+		const float *src = entry->values.data() + buffer_index * values_per_buffer;
+		std::copy(src, src + values_per_buffer, dst);
+	}
+
+	return true;
+}
+
+void GraphColumnCache::store(
+		const Key &key,
+		Span<const uint32_t> signature,
+		Span<const float *const> src_buffers,
+		unsigned int values_per_buffer
+) {
+	ZN_PROFILE_SCOPE();
+
+	{
+		MutexLock lock(_mutex);
+		if (_entries.get_capacity() == 0) {
+			return;
+		}
+	}
+
+	Entry entry;
+	entry.values.resize(src_buffers.size() * values_per_buffer);
+	for (unsigned int buffer_index = 0; buffer_index < src_buffers.size(); ++buffer_index) {
+		const float *src = src_buffers[buffer_index];
+		ZN_ASSERT_CONTINUE(src != nullptr);
+		std::copy(src, src + values_per_buffer, entry.values.data() + buffer_index * values_per_buffer);
+	}
+	entry.signature.assign(signature.data(), signature.data() + signature.size());
+
+	const size_t memory_usage =
+			entry.values.capacity() * sizeof(float) + entry.signature.capacity() * sizeof(uint32_t);
+
+	MutexLock lock(_mutex);
+	_entries.set(key, std::move(entry), memory_usage);
+}
+
+void GraphColumnCache::clear() {
+	MutexLock lock(_mutex);
+	_entries.clear();
+}
+
+void GraphColumnCache::set_capacity(size_t capacity_bytes) {
+	MutexLock lock(_mutex);
+	_entries.set_capacity(capacity_bytes);
+}
+
+size_t GraphColumnCache::get_capacity() const {
+	MutexLock lock(_mutex);
+	return _entries.get_capacity();
+}
+
+GraphColumnCache::Stats GraphColumnCache::get_stats() const {
+	MutexLock lock(_mutex);
+	return _entries.get_stats();
+}
+
+void GraphColumnCache::reset_stats() {
+	MutexLock lock(_mutex);
+	_entries.reset_stats();
+}
+
+} // namespace zylann::voxel
@@ -0,0 +1,89 @@
+#ifndef VOXEL_GRAPH_COLUMN_CACHE_H
+#define VOXEL_GRAPH_COLUMN_CACHE_H
+
+#include "../../util/containers/lru_cache.h"
+#include "../../util/containers/span.h"
+#include "../../util/containers/std_vector.h"
+#include "../../util/hash_funcs.h"
+#include "../../util/thread/mutex.h"
+#include <cstdint>
+
+namespace zylann::voxel {
+
+// Keeps values computed by the part of a generator graph that only depends on X and Z (the "outer group"), for
+// columns of voxels generated recently. Blocks generated later in the same column, such as those stacked along Y, can
+// then skip that part of the graph.
+// When memory usage goes above capacity, the least recently used columns are evicted.
+// This is thread-safe.
+class GraphColumnCache {
+public:
+	struct Key {
+		// Area of the column on the X and Z axes, in voxels of the LOD
+		int32_t origin_x;
+		int32_t origin_z;
+		uint16_t size_x;
+		uint16_t size_z;
+		uint8_t lod_index;
+		// Values depend on which program computed them
+		uint64_t program_hash;
+
+		inline bool operator==(const Key &other) const {
+			return origin_x == other.origin_x && origin_z == other.origin_z && size_x == other.size_x &&
+					size_z == other.size_z && lod_index == other.lod_index && program_hash == other.program_hash;
+		}
+	};
+
+	static const size_t DEFAULT_CAPACITY = 16 * 1024 * 1024;
+
+	// Copies values of a cached column into `dst_buffers`, each receiving `values_per_buffer` values.
+	// `signature` identifies how values were computed (for example, which operations ran). If the cached column was
+	// computed differently, it is not used. Returns true if values were found.
+	bool try_load(
+			const Key &key,
+			Span<const uint32_t> signature,
+			Span<float *const> dst_buffers,
+			unsigned int values_per_buffer
+	);
+
+	// Caches values of a column, replacing any previous values.
+	void store(
+			const Key &key,
+			Span<const uint32_t> signature,
+			Span<const float *const> src_buffers,
+			unsigned int values_per_buffer
+	);
+
+	void clear();
+
+	// Maximum amount of memory used by cached values, in bytes
+	void set_capacity(size_t capacity_bytes);
+	size_t get_capacity() const;
+
+	typedef LRUCacheStats Stats;
+
+	Stats get_stats() const;
+	void reset_stats();
+
+private:
+	struct KeyHasher {
+		inline size_t operator()(const Key &key) const {
+			uint64_t h = hash_djb2_one_64(key.origin_x);
+			h = hash_djb2_one_64(key.origin_z, h);
+			h = hash_djb2_one_64(key.size_x | (key.size_z << 16), h);
+			h = hash_djb2_one_64(key.lod_index, h);
+			return hash_djb2_one_64(key.program_hash, h);
+		}
+	};
+
+	struct Entry {
+		StdVector<float> values;
+		StdVector<uint32_t> signature;
+	};
+
+	LRUCache<Key, Entry, KeyHasher> _entries{ DEFAULT_CAPACITY };
+	Mutex _mutex;
+};
+
+} // namespace zylann::voxel
+
+#endif // VOXEL_GRAPH_COLUMN_CACHE_H
@@ -1544,6 +1544,88 @@ void compute_node_execution_order(
 
 } // namespace
 
+// Groups chains of fusable operations in the execution map, so they run together one tile at a time.
+// For example, `clamp(x * a + b, 0, 1)` would otherwise run as 3 operations each going through whole buffers, while
+// once fused, values written by an operation are read by the next one while they are still in cache.
+// Operations only join a group if they read the result of a previous operation of that group.
+void Runtime::fuse_operations(ExecutionMap &execution_map, const Program &program, FusionStats *stats) {
+	ZN_PROFILE_SCOPE();
+
+	const NodeTypeDB &type_db = NodeTypeDB::get_singleton();
+	const Span<const uint16_t> operations = to_span(program.operations);
+	const Span<const BufferSpec> buffer_specs = to_span(program.buffer_specs);
+	Span<ExecutionMap::OperationInfo> operation_infos = to_span(execution_map.operations);
+
+	// Addresses of buffers written by operations of the current group
+	static thread_local StdVector<uint16_t> tls_group_outputs;
+	StdVector<uint16_t> &group_outputs = tls_group_outputs;
+	group_outputs.clear();
+
+	unsigned int group_start_index = 0;
+	unsigned int group_size = 0;
+
+	for (unsigned int op_index = 0; op_index < operation_infos.size(); ++op_index) {
+		ExecutionMap::OperationInfo &op_info = operation_infos[op_index];
+		op_info.fused_count = 0;
+
+		unsigned int pc = op_info.address;
+		const NodeType &type = type_db.get_type(operations[pc++]);
+		const Span<const uint16_t> inputs = operations.sub(pc, type.inputs.size());
+		pc += inputs.size();
+		const Span<const uint16_t> outputs = operations.sub(pc, type.outputs.size());
+
+		bool fused = false;
+
+		if (type.is_fusable) {
+			// Groups must not straddle the outer group, because it can be skipped
+			if (group_size > 0 && group_size < MAX_FUSED_OPERATIONS &&
+				op_index != execution_map.inner_group_start_index) {
+				for (const uint16_t input_address : inputs) {
+					if (contains(to_span_const(group_outputs), input_address)) {
+						fused = true;
+						break;
+					}
+				}
+			}
+
+			if (fused) {
+				++operation_infos[group_start_index].fused_count;
+				++group_size;
+			} else {
+				group_start_index = op_index;
+				group_size = 1;
+				group_outputs.clear();
+			}
+
+		} else {
+			group_size = 0;
+			group_outputs.clear();
+		}
+
+		if (stats != nullptr) {
+			for (const uint16_t input_address : inputs) {
+				const BufferSpec &bs = buffer_specs[input_address];
+				if (bs.has_data || bs.is_binding) {
+					++stats->buffer_passes_count;
+					if (fused && contains(to_span_const(group_outputs), input_address)) {
+						++stats->fused_reads_count;
+					}
+				}
+			}
+			stats->buffer_passes_count += outputs.size();
+			if (fused) {
+				++stats->fused_operations_count;
+			}
+		}
+
+		if (group_size > 0) {
+			for (const uint16_t output_address : outputs) {
+				group_outputs.push_back(output_address);
+			}
+		}
+	}
+}
+
 CompilationResult Runtime::compile_preprocessed_graph(
 		Program &program,
 		const ProgramGraph &graph,
@@ -1898,6 +1980,9 @@ CompilationResult Runtime::compile_preprocessed_graph(
 				ZN_ASSERT(address_it != program.output_port_addresses.end());
 				BufferSpec &src_buffer_spec = buffer_specs[address_it->second];
 				src_buffer_spec.is_pinned = true;
+				if (!contains(to_span_const(program.outer_group_output_addresses), address_it->second)) {
+					program.outer_group_output_addresses.push_back(address_it->second);
+				}
 			}
 		}
 	}
@@ -2033,15 +2118,57 @@ CompilationResult Runtime::compile_preprocessed_graph(
 		program.buffer_data_count = data_helper.datas.size();
 	}
 
+	// Find out if the program can run one tile at a time, using tile-sized buffers.
+	// In debug, every port may be inspected after the program runs, so their buffers must hold all values.
+	program.tile_streaming = !debug;
+	for (const uint32_t node_id : order) {
+		const ProgramGraph::Node &node = graph.get_node(node_id);
+		const NodeType &type = type_db.get_type(node.type_id);
+		if (type.requires_whole_buffers) {
+			program.tile_streaming = false;
+			break;
+		}
+	}
+
+	if (program.tile_streaming) {
+		// Data must hold all values if any buffer using it is pinned (its values are re-used across runs or come from
+		// the compiler), or if it is read by the caller after the program runs
+		program.tile_sized_buffer_datas.resize(program.buffer_data_count, 1);
+		for (const BufferSpec &buffer_spec : program.buffer_specs) {
+			if (buffer_spec.has_data && buffer_spec.is_pinned) {
+				program.tile_sized_buffer_datas[buffer_spec.data_index] = 0;
+			}
+		}
+		for (unsigned int output_index = 0; output_index < program.outputs_count; ++output_index) {
+			const BufferSpec &buffer_spec = program.buffer_specs[program.outputs[output_index].buffer_address];
+			if (buffer_spec.has_data) {
+				program.tile_sized_buffer_datas[buffer_spec.data_index] = 0;
+			}
+		}
+		for (BufferSpec &buffer_spec : program.buffer_specs) {
+			buffer_spec.is_tile_sized =
+					buffer_spec.has_data && program.tile_sized_buffer_datas[buffer_spec.data_index] != 0;
+		}
+	}
+
+	CompilationResult result;
+	result.success = true;
+	result.tile_streaming = program.tile_streaming;
+
+	fuse_operations(program.default_execution_map, program, &result.fusion_stats);
+
 	ZN_PRINT_VERBOSE(
-			format("Compiled voxel graph. Program size: {}b, ports: {}, buffers: {}",
+			format("Compiled voxel graph. Program size: {}b, ports: {}, buffers: {}, tile-streamed: {}, fused "
+				   "operations: {}, buffer passes: {}, fused reads: {}",
 				   program.operations.size() * sizeof(uint16_t),
 				   program.buffer_count,
-				   program.buffer_data_count)
+				   program.buffer_data_count,
+				   program.tile_streaming,
+				   result.fusion_stats.fused_operations_count,
+				   result.fusion_stats.buffer_passes_count,
+				   result.fusion_stats.fused_reads_count)
 	);
 
-	CompilationResult result;
-	result.success = true;
 	return result;
 }
 
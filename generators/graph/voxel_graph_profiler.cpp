@@ -0,0 +1,61 @@
+#include "voxel_graph_profiler.h"
+#include "../../util/errors.h"
+#include <algorithm>
+
+namespace zylann::voxel {
+
+bool GraphProfiler::pick_sample() {
+	// Relaxed is enough, sampling doesn't need to be exact
+	const uint32_t i = _section_counter.fetch_add(1, std::memory_order_relaxed);
+	return (i % _sample_interval.load(std::memory_order_relaxed)) == 0;
+}
+
+void GraphProfiler::add_sample(Span<const NodeStats> nodes) {
+	MutexLock lock(_mutex);
+	for (const NodeStats &src : nodes) {
+		NodeStats &dst = _nodes[src.node_id];
+		dst.node_id = src.node_id;
+		dst.nanoseconds += src.nanoseconds;
+		dst.call_count += src.call_count;
+		dst.skip_count += src.skip_count;
+	}
+	++_sample_count;
+}
+
+void GraphProfiler::set_sample_interval(unsigned int interval) {
+	ZN_ASSERT_RETURN(interval > 0);
+	_sample_interval.store(interval, std::memory_order_relaxed);
+}
+
+unsigned int GraphProfiler::get_sample_interval() const {
+	return _sample_interval.load(std::memory_order_relaxed);
+}
+
+void GraphProfiler::get_results(StdVector<NodeStats> &out_nodes) const {
+	out_nodes.clear();
+	{
+		MutexLock lock(_mutex);
+		for (auto it = _nodes.begin(); it != _nodes.end(); ++it) {
+			out_nodes.push_back(it->second);
+		}
+	}
+	std::sort(out_nodes.begin(), out_nodes.end(), [](const NodeStats &a, const NodeStats &b) {
+		if (a.nanoseconds != b.nanoseconds) {
+			return a.nanoseconds > b.nanoseconds;
+		}
+		return a.node_id < b.node_id;
+	});
+}
+
+uint64_t GraphProfiler::get_sample_count() const {
+	MutexLock lock(_mutex);
+	return _sample_count;
+}
+
+void GraphProfiler::clear() {
+	MutexLock lock(_mutex);
+	_nodes.clear();
+	_sample_count = 0;
+}
+
+} // namespace zylann::voxel
@@ -0,0 +1,57 @@
+#ifndef VOXEL_GRAPH_PROFILER_H
+#define VOXEL_GRAPH_PROFILER_H
+
+#include "../../util/containers/span.h"
+#include "../../util/containers/std_unordered_map.h"
+#include "../../util/containers/std_vector.h"
+#include "../../util/thread/mutex.h"
+#include <atomic>
+#include <cstdint>
+
+namespace zylann::voxel {
+
+// Aggregates how much time nodes of a generator graph take while generating blocks. Only a sample of the sections
+// generated by worker threads is measured, so it can stay enabled while streaming. Unlike measurements done on a
+// synthetic block, this accounts for range analysis, which can skip nodes in many areas.
+// This is thread-safe.
+class GraphProfiler {
+public:
+	struct NodeStats {
+		uint32_t node_id = 0;
+		// Time spent running operations of the node
+		uint64_t nanoseconds = 0;
+		// How many times operations of the node ran. Generating a section usually runs them once per slice.
+		uint64_t call_count = 0;
+		// How many sampled sections didn't need to run the node, because range analysis found it doesn't affect
+		// outputs there
+		uint64_t skip_count = 0;
+	};
+
+	static const unsigned int DEFAULT_SAMPLE_INTERVAL = 16;
+
+	// Tells if the next section should be measured. One section out of every `sample_interval` is.
+	bool pick_sample();
+
+	// Adds measurements of one sampled section. The same node may appear multiple times.
+	void add_sample(Span<const NodeStats> nodes);
+
+	void set_sample_interval(unsigned int interval);
+	unsigned int get_sample_interval() const;
+
+	// Gets accumulated measurements, sorted from the most expensive node to the cheapest.
+	void get_results(StdVector<NodeStats> &out_nodes) const;
+	uint64_t get_sample_count() const;
+
+	void clear();
+
+private:
+	StdUnorderedMap<uint32_t, NodeStats> _nodes;
+	uint64_t _sample_count = 0;
+	std::atomic_uint32_t _sample_interval{ DEFAULT_SAMPLE_INTERVAL };
+	std::atomic_uint32_t _section_counter{ 0 };
+	Mutex _mutex;
+};
+
+} // namespace zylann::voxel
+
+#endif // VOXEL_GRAPH_PROFILER_H
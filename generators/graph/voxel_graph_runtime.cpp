@@ -1,13 +1,12 @@
 #include "voxel_graph_runtime.h"
 #include "../../util/containers/container_funcs.h"
 #include "../../util/godot/core/string.h"
+#include "../../util/hash_funcs.h"
 #include "../../util/io/log.h"
 #include "../../util/macros.h"
 #include "../../util/profiling.h"
-#include "../../util/string/format.h"
-#ifdef TOOLS_ENABLED
 #include "../../util/profiling_clock.h"
-#endif
+#include "../../util/string/format.h"
 #include "node_type_db.h"
 #include "voxel_generator_graph.h"
 
@@ -45,6 +44,24 @@ Span<const uint16_t> get_outputs_from_op_address(Span<const uint16_t> operations
 	return operations.sub(op_address + 1 + inputs_count, outputs_count);
 }
 
+inline void set_tile_view(
+		Runtime::Buffer &tile_buffer,
+		const Runtime::Buffer &buffer,
+		const unsigned int begin,
+		const unsigned int size
+) {
+	if (buffer.data == nullptr) {
+		// Constant without data
+		tile_buffer.data = nullptr;
+	} else if (buffer.is_tile_sized) {
+		// Only holds the current tile
+		tile_buffer.data = buffer.data;
+	} else {
+		tile_buffer.data = buffer.data + begin;
+	}
+	tile_buffer.size = size;
+}
+
 } // namespace
 
 bool Runtime::is_operation_constant(const State &state, uint16_t op_address) const {
@@ -226,7 +243,7 @@ void Runtime::generate_optimized_execution_map(
 						// The reason we do it is to avoid having to rewrite operations for every
 						// combination of constant arguments vs buffers.
 						ZN_ASSERT(buffer.data != nullptr);
-						tls_constant_fills.push_back(ExecutionMap::ConstantFill{ buffer.data, v });
+						tls_constant_fills.push_back(ExecutionMap::ConstantFill{ output_address, v });
 					}
 				}
 			} break;
@@ -262,6 +279,8 @@ void Runtime::generate_optimized_execution_map(
 				break;
 		}
 	}
+
+	fuse_operations(execution_map, program, nullptr);
 }
 
 void Runtime::generate_single(State &state, Span<const float> inputs, const ExecutionMap *execution_map) const {
@@ -276,6 +295,10 @@ void Runtime::generate_single(State &state, Span<const float> inputs, const Exec
 void Runtime::prepare_state(State &state, unsigned int buffer_size, bool with_profiling) const {
 	// Allocate memory
 
+	// When the program is tile-streamed, most buffers only need to hold one tile
+	const unsigned int tile_capacity = math::min(buffer_size, TILE_SIZE);
+	Span<const uint8_t> tile_sized_buffer_datas = to_span(_program.tile_sized_buffer_datas);
+
 	const unsigned int old_buffer_data_count = state.buffer_datas.size();
 	if (state.buffer_datas.size() < _program.buffer_data_count) {
 		// Create more buffer datas.
@@ -283,23 +306,29 @@ void Runtime::prepare_state(State &state, unsigned int buffer_size, bool with_pr
 		for (unsigned int i = old_buffer_data_count; i < state.buffer_datas.size(); ++i) {
 			BufferData &bd = state.buffer_datas[i];
 			ZN_ASSERT(bd.data == nullptr);
+			const unsigned int capacity =
+					i < tile_sized_buffer_datas.size() && tile_sized_buffer_datas[i] ? tile_capacity : buffer_size;
 			// These are new items, we always allocate.
-			bd.data = reinterpret_cast<float *>(ZN_ALLOC(buffer_size * sizeof(float)));
-			bd.capacity = buffer_size;
+			bd.data = reinterpret_cast<float *>(ZN_ALLOC(capacity * sizeof(float)));
+			bd.capacity = capacity;
 		}
 	}
 
-	if (state.buffer_size < buffer_size) {
-		// Make existing buffer datas larger.
-		for (unsigned int i = 0; i < old_buffer_data_count; ++i) {
-			BufferData &bd = state.buffer_datas[i];
-			ZN_ASSERT(bd.data != nullptr);
-			if (bd.capacity < buffer_size) {
-				// These are existing items, we always realloc.
-				bd.data = reinterpret_cast<float *>(ZN_REALLOC(bd.data, buffer_size * sizeof(float)));
-				bd.capacity = buffer_size;
-			}
+	// Make existing buffer datas larger if needed.
+	// Their capacity can vary depending on which graphs were prepared before, and whether they were tile-streamed.
+	for (unsigned int i = 0; i < old_buffer_data_count; ++i) {
+		BufferData &bd = state.buffer_datas[i];
+		ZN_ASSERT(bd.data != nullptr);
+		const unsigned int capacity =
+				i < tile_sized_buffer_datas.size() && tile_sized_buffer_datas[i] ? tile_capacity : buffer_size;
+		if (bd.capacity < capacity) {
+			// These are existing items, we always realloc.
+			bd.data = reinterpret_cast<float *>(ZN_REALLOC(bd.data, capacity * sizeof(float)));
+			bd.capacity = capacity;
 		}
+	}
+
+	if (state.buffer_capacity < buffer_size) {
 		// TODO Not sure if worth keeping capacity at state level. Buffer datas can have varying capacities depending on
 		// which multiple graphs were prepared before.
 		state.buffer_capacity = buffer_size;
@@ -332,7 +361,8 @@ void Runtime::prepare_state(State &state, unsigned int buffer_size, bool with_pr
 		if (buffer_spec.has_data) {
 			ZN_ASSERT(!buffer_spec.is_binding);
 			BufferData &bd = buffer_datas[buffer_spec.data_index];
-			ZN_ASSERT(bd.capacity >= buffer_size);
+			// Tile-sized buffers only hold one tile at a time
+			ZN_ASSERT(bd.capacity >= (buffer_spec.is_tile_sized ? tile_capacity : buffer_size));
 			buffer.data = bd.data;
 		} else {
 			ZN_ASSERT(buffer_spec.is_binding || buffer_spec.is_constant);
@@ -341,7 +371,8 @@ void Runtime::prepare_state(State &state, unsigned int buffer_size, bool with_pr
 
 		buffer.is_binding = buffer_spec.is_binding;
 		buffer.is_constant = buffer_spec.is_constant;
-		buffer.size = buffer_size;
+		buffer.is_tile_sized = buffer_spec.is_tile_sized;
+		buffer.size = buffer_spec.is_tile_sized ? tile_capacity : buffer_size;
 		buffer.buffer_data_index = buffer_spec.data_index;
 
 		// Always reset constants because we don't know if we'll run the same program as before...
@@ -349,7 +380,7 @@ void Runtime::prepare_state(State &state, unsigned int buffer_size, bool with_pr
 			buffer.constant_value = buffer_spec.constant_value;
 			// Data can be null if it was determined that the nodes using this port don't require a buffer.
 			if (buffer.data != nullptr) {
-				for (unsigned int i = 0; i < buffer_size; ++i) {
+				for (unsigned int i = 0; i < buffer.size; ++i) {
 					buffer.data[i] = buffer_spec.constant_value;
 				}
 			}
@@ -383,18 +414,166 @@ void Runtime::prepare_state(State &state, unsigned int buffer_size, bool with_pr
 		}
 	}*/
 
+	reset_profiling(state, with_profiling);
+}
+
+void Runtime::reset_profiling(State &state, bool enabled) const {
 	state.debug_profiler_times.clear();
-	if (with_profiling) {
+	if (enabled) {
 		// Give maximum size
 		state.debug_profiler_times.resize(_program.dependency_graph.nodes.size());
 	}
 }
 
+uint32_t Runtime::get_operation_node_id(uint16_t op_address) const {
+	for (const DependencyGraph::Node &node : _program.dependency_graph.nodes) {
+		// Constants are flagged as inputs, their address can be the same as the next operation
+		if (node.is_input || node.op_address != op_address) {
+			continue;
+		}
+		auto it = _program.expanded_node_id_to_user_node_id.find(node.debug_node_id);
+		if (it != _program.expanded_node_id_to_user_node_id.end()) {
+			return it->second;
+		}
+		return node.debug_node_id;
+	}
+	ZN_PRINT_ERROR(format("No operation found at address {}", op_address));
+	return ProgramGraph::NULL_ID;
+}
+
+bool Runtime::InputGrid::get_sub_grid(unsigned int begin, unsigned int count, InputGrid &out_grid) const {
+	const unsigned int row_size = size.x;
+	const unsigned int layer_size = size.x * size.z;
+	if (row_size == 0 || layer_size == 0 || begin % row_size != 0 || count % row_size != 0) {
+		return false;
+	}
+	out_grid = *this;
+	if (begin % layer_size == 0 && count % layer_size == 0) {
+		// Whole layers
+		out_grid.origin.y += begin / layer_size;
+		out_grid.size.y = count / layer_size;
+		return true;
+	}
+	// Rows within a single layer
+	const unsigned int begin_row = begin / row_size;
+	const unsigned int row_count = count / row_size;
+	const unsigned int begin_z = begin_row % size.z;
+	if (begin_z + row_count > static_cast<unsigned int>(size.z)) {
+		return false;
+	}
+	out_grid.origin.y += begin_row / size.z;
+	out_grid.origin.z += begin_z;
+	out_grid.size.y = 1;
+	out_grid.size.z = row_count;
+	return true;
+}
+
+// Runs operations one tile of values at a time, so values written by an operation are still in cache when the next one
+// reads them. This is used for fused operations, and for whole programs when they are tile-streamed. Operations must
+// only access values at the same index in their buffers, so each value goes through the same steps in the same order as
+// if operations ran one after the other over whole buffers.
+// Returns how many constant fills were done.
+unsigned int Runtime::run_operations_in_tiles(
+		State &state,
+		Span<const ExecutionMap::OperationInfo> operation_infos,
+		Span<const ExecutionMap::ConstantFill> constant_fills,
+		const unsigned int constant_fill_index,
+		const unsigned int first_execution_map_index,
+		const bool using_execution_map,
+		const bool profile,
+		const InputGrid *input_grid,
+		const FixedArray<int, 3> &input_grid_axis_addresses
+) const {
+	const Span<const uint16_t> operations = to_span(_program.operations);
+	const Span<const Buffer> buffers = to_span(state.buffers);
+
+	// Copies of buffers pointing at the current tile
+	state.tile_buffers.resize(buffers.size());
+	Span<Buffer> tile_buffers = to_span(state.tile_buffers);
+	for (unsigned int i = 0; i < buffers.size(); ++i) {
+		tile_buffers[i] = buffers[i];
+	}
+
+	const NodeTypeDB &type_db = NodeTypeDB::get_singleton();
+	const unsigned int buffer_size = state.buffer_size;
+	unsigned int cf_index = constant_fill_index;
+
+	PreciseProfilingClock profiling_clock;
+	if (profile) {
+		profiling_clock.restart();
+	}
+
+	for (unsigned int tile_begin = 0; tile_begin < buffer_size; tile_begin += TILE_SIZE) {
+		const unsigned int tile_size = math::min(TILE_SIZE, buffer_size - tile_begin);
+		cf_index = constant_fill_index;
+
+		// Positions of a tile may still form a grid, when it covers whole rows
+		InputGrid tile_grid;
+		const InputGrid *tile_grid_ptr = nullptr;
+		if (input_grid != nullptr && input_grid->get_sub_grid(tile_begin, tile_size, tile_grid)) {
+			tile_grid_ptr = &tile_grid;
+		}
+
+		for (unsigned int op_index = 0; op_index < operation_infos.size(); ++op_index) {
+			const ExecutionMap::OperationInfo &op_info = operation_infos[op_index];
+
+			// Constant fills also go tile by tile, so they keep happening right before the operation
+			for (unsigned int i = 0; i < op_info.constant_fill_count; ++i) {
+				const ExecutionMap::ConstantFill &cf = constant_fills[cf_index];
+				Buffer &tile_buffer = tile_buffers[cf.buffer_address];
+				set_tile_view(tile_buffer, buffers[cf.buffer_address], tile_begin, tile_size);
+				ZN_ASSERT(tile_buffer.data != nullptr);
+				for (unsigned int j = 0; j < tile_size; ++j) {
+					tile_buffer.data[j] = cf.value;
+				}
+				++cf_index;
+			}
+
+			unsigned int pc = op_info.address;
+
+			const uint16_t opid = operations[pc++];
+			const NodeType &node_type = type_db.get_type(opid);
+#ifdef DEBUG_ENABLED
+			ZN_ASSERT(!node_type.requires_whole_buffers);
+#endif
+
+			const uint32_t inputs_count = node_type.inputs.size();
+			const uint32_t outputs_count = node_type.outputs.size();
+
+			const Span<const uint16_t> op_inputs = operations.sub(pc, inputs_count);
+			pc += inputs_count;
+			const Span<const uint16_t> op_outputs = operations.sub(pc, outputs_count);
+			pc += outputs_count;
+
+			Span<const uint8_t> op_params = read_params(operations, pc);
+
+			for (const uint16_t address : op_inputs) {
+				set_tile_view(tile_buffers[address], buffers[address], tile_begin, tile_size);
+			}
+			for (const uint16_t address : op_outputs) {
+				set_tile_view(tile_buffers[address], buffers[address], tile_begin, tile_size);
+			}
+
+			ZN_ASSERT_RETURN_V(node_type.process_buffer_func != nullptr, cf_index - constant_fill_index);
+			ProcessBufferContext ctx(op_inputs, op_outputs, op_params, tile_buffers, using_execution_map);
+			ctx.set_input_grid(tile_grid_ptr, input_grid_axis_addresses);
+			node_type.process_buffer_func(ctx);
+
+			if (profile) {
+				state.add_execution_time(first_execution_map_index + op_index, profiling_clock.restart());
+			}
+		}
+	}
+
+	return cf_index - constant_fill_index;
+}
+
 void Runtime::generate_set(
 		State &state,
 		Span<const Span<const float>> p_inputs,
 		bool skip_outer_group,
-		const ExecutionMap *p_execution_map
+		const ExecutionMap *p_execution_map,
+		const InputGrid *input_grid
 ) const {
 	// I don't like putting private helper functions in headers.
 	struct L {
@@ -430,13 +609,17 @@ void Runtime::generate_set(
 	ZN_ASSERT_RETURN(state.buffers.size() != 0);
 	const unsigned int buffer_size = p_inputs.size() > 0 ? p_inputs[0].size() : state.buffer_size;
 	ZN_ASSERT_RETURN(state.buffer_size >= buffer_size);
-	ZN_ASSERT_RETURN(state.buffers[0].size >= buffer_size);
+	ZN_ASSERT_RETURN(state.buffers[0].size >= buffer_size || state.buffers[0].is_tile_sized);
 #ifdef DEBUG_ENABLED
 	for (size_t i = 0; i < state.buffers.size(); ++i) {
 		const Buffer &b = state.buffers[i];
-		ZN_ASSERT(b.size >= buffer_size);
-		ZN_ASSERT(b.size <= state.buffer_capacity);
-		ZN_ASSERT(b.size == state.buffer_size);
+		if (b.is_tile_sized) {
+			ZN_ASSERT(b.size == math::min(state.buffer_size, TILE_SIZE));
+		} else {
+			ZN_ASSERT(b.size >= buffer_size);
+			ZN_ASSERT(b.size <= state.buffer_capacity);
+			ZN_ASSERT(b.size == state.buffer_size);
+		}
 		if (b.data != nullptr && !b.is_binding) {
 			ZN_ASSERT(b.buffer_data_index < state.buffer_datas.size());
 			const BufferData &bd = state.buffer_datas[b.buffer_data_index];
@@ -453,63 +636,121 @@ void Runtime::generate_set(
 		L::bind_input_buffer(buffers, _program.inputs[i].buffer_address, p_inputs[i]);
 	}
 
+	FixedArray<int, 3> input_grid_axis_addresses;
+	fill(input_grid_axis_addresses, -1);
+	if (input_grid != nullptr &&
+		static_cast<unsigned int>(input_grid->size.x * input_grid->size.y * input_grid->size.z) != state.buffer_size) {
+		ZN_PRINT_ERROR("Input grid doesn't match the size of inputs, ignoring it");
+		input_grid = nullptr;
+	}
+	if (input_grid != nullptr) {
+		for (unsigned int axis = 0; axis < input_grid->axis_input_indices.size(); ++axis) {
+			const int input_index = input_grid->axis_input_indices[axis];
+			if (input_index >= 0 && input_index < static_cast<int>(_program.inputs.size())) {
+				input_grid_axis_addresses[axis] = _program.inputs[input_index].buffer_address;
+			}
+		}
+	}
+
 	const Span<const uint16_t> operations(_program.operations.data(), 0, _program.operations.size());
 
 	const ExecutionMap &execution_map = p_execution_map != nullptr ? *p_execution_map : _program.default_execution_map;
 	Span<const ExecutionMap::OperationInfo> operation_infos = to_span(execution_map.operations);
 	const Span<const ExecutionMap::ConstantFill> constant_fills = to_span(execution_map.constant_fills);
 
+	// Constant fills scheduled before operations of the outer group must be skipped with them
+	unsigned int first_constant_fill_index = 0;
+	// Measured times are stored at indices of the whole execution map
+	unsigned int first_execution_map_index = 0;
 	if (skip_outer_group && operation_infos.size() > 0) {
 		const unsigned int offset = execution_map.inner_group_start_index;
+		for (unsigned int i = 0; i < offset; ++i) {
+			first_constant_fill_index += operation_infos[i].constant_fill_count;
+		}
 		operation_infos = operation_infos.sub(offset);
+		first_execution_map_index = offset;
 	}
 
-#ifdef TOOLS_ENABLED
-	ProfilingClock profiling_clock;
 	const bool profile = state.debug_profiler_times.size() > 0;
-#endif
-
-	unsigned int constant_fill_index = 0;
-
-	for (unsigned int execution_map_index = 0; execution_map_index < operation_infos.size(); ++execution_map_index) {
-		const ExecutionMap::OperationInfo op_info = operation_infos[execution_map_index];
+	const bool using_execution_map = p_execution_map != nullptr;
+
+	if (_program.tile_streaming && state.buffer_size > TILE_SIZE) {
+		// Most buffers only have room for one tile of values, so the whole program runs one tile at a time
+		run_operations_in_tiles(
+				state,
+				operation_infos,
+				constant_fills,
+				first_constant_fill_index,
+				first_execution_map_index,
+				using_execution_map,
+				profile,
+				input_grid,
+				input_grid_axis_addresses
+		);
+
+	} else {
+		PreciseProfilingClock profiling_clock;
+		if (profile) {
+			profiling_clock.restart();
+		}
+		unsigned int constant_fill_index = first_constant_fill_index;
+
+		for (unsigned int execution_map_index = 0; execution_map_index < operation_infos.size();
+			 ++execution_map_index) {
+			const ExecutionMap::OperationInfo op_info = operation_infos[execution_map_index];
+
+			// When profiling, fused operations run separately so each of them can be measured
+			if (op_info.fused_count > 0 && !profile) {
+				constant_fill_index += run_operations_in_tiles(
+						state,
+						operation_infos.sub(execution_map_index, op_info.fused_count + 1),
+						constant_fills,
+						constant_fill_index,
+						first_execution_map_index + execution_map_index,
+						using_execution_map,
+						false,
+						input_grid,
+						input_grid_axis_addresses
+				);
+				execution_map_index += op_info.fused_count;
+				continue;
+			}
 
-		for (unsigned int i = 0; i < op_info.constant_fill_count; ++i) {
-			const ExecutionMap::ConstantFill &cf = constant_fills[constant_fill_index];
-			ZN_ASSERT(cf.data != nullptr);
-			for (unsigned int j = 0; j < state.buffer_size; ++j) {
-				cf.data[j] = cf.value;
+			for (unsigned int i = 0; i < op_info.constant_fill_count; ++i) {
+				const ExecutionMap::ConstantFill &cf = constant_fills[constant_fill_index];
+				float *data = buffers[cf.buffer_address].data;
+				ZN_ASSERT(data != nullptr);
+				for (unsigned int j = 0; j < state.buffer_size; ++j) {
+					data[j] = cf.value;
+				}
+				++constant_fill_index;
 			}
-			++constant_fill_index;
-		}
 
-		unsigned int pc = op_info.address;
+			unsigned int pc = op_info.address;
 
-		const uint16_t opid = operations[pc++];
-		const NodeType &node_type = NodeTypeDB::get_singleton().get_type(opid);
+			const uint16_t opid = operations[pc++];
+			const NodeType &node_type = NodeTypeDB::get_singleton().get_type(opid);
 
-		const uint32_t inputs_count = node_type.inputs.size();
-		const uint32_t outputs_count = node_type.outputs.size();
+			const uint32_t inputs_count = node_type.inputs.size();
+			const uint32_t outputs_count = node_type.outputs.size();
 
-		const Span<const uint16_t> op_inputs = operations.sub(pc, inputs_count);
-		pc += inputs_count;
-		const Span<const uint16_t> op_outputs = operations.sub(pc, outputs_count);
-		pc += outputs_count;
+			const Span<const uint16_t> op_inputs = operations.sub(pc, inputs_count);
+			pc += inputs_count;
+			const Span<const uint16_t> op_outputs = operations.sub(pc, outputs_count);
+			pc += outputs_count;
 
-		Span<const uint8_t> op_params = read_params(operations, pc);
+			Span<const uint8_t> op_params = read_params(operations, pc);
 
-		// TODO Buffers will stay bound if this error occurs!
-		ZN_ASSERT_RETURN(node_type.process_buffer_func != nullptr);
-		ProcessBufferContext ctx(op_inputs, op_outputs, op_params, buffers, p_execution_map != nullptr);
-		node_type.process_buffer_func(ctx);
+			// TODO Buffers will stay bound if this error occurs!
+			ZN_ASSERT_RETURN(node_type.process_buffer_func != nullptr);
+			ProcessBufferContext ctx(op_inputs, op_outputs, op_params, buffers, using_execution_map);
+			ctx.set_input_grid(input_grid, input_grid_axis_addresses);
+			node_type.process_buffer_func(ctx);
 
-#ifdef TOOLS_ENABLED
-		if (profile) {
-			const uint32_t elapsed_microseconds = profiling_clock.get_elapsed_microseconds();
-			state.add_execution_time(execution_map_index, elapsed_microseconds);
-			profiling_clock.restart();
+			if (profile) {
+				state.add_execution_time(first_execution_map_index + execution_map_index, profiling_clock.restart());
+			}
 		}
-#endif
 	}
 
 	// Unbind buffers
@@ -639,4 +880,19 @@ bool Runtime::try_get_output_port_address(ProgramGraph::PortLocation port, uint1
 	return true;
 }
 
+uint64_t Runtime::get_program_hash() const {
+	// Operations include their parameters, but not values of constant inputs
+	uint64_t h = hash_fnv1a_64(
+			reinterpret_cast<const uint8_t *>(_program.operations.data()),
+			_program.operations.size() * sizeof(uint16_t)
+	);
+	for (const BufferSpec &bs : _program.buffer_specs) {
+		if (bs.is_constant) {
+			h = hash_djb2_one_64(bs.address, h);
+			h = hash_djb2_one_64(math::get_float_bits(bs.constant_value), h);
+		}
+	}
+	return h;
+}
+
 } // namespace zylann::voxel::pg
@@ -16,10 +16,23 @@ namespace zylann::voxel::pg {
 class VoxelGraphFunction;
 class NodeTypeDB;
 
+// How much buffer traffic the default execution map of a program does, and how much operation fusion saves.
+struct FusionStats {
+	// Whole-buffer reads and writes done by operations
+	unsigned int buffer_passes_count = 0;
+	// Reads of values written by a previous operation of the same fused group. They happen one tile at a time while
+	// the data is still in cache, instead of going through a whole buffer.
+	unsigned int fused_reads_count = 0;
+	// Operations running as part of a group started by a previous operation
+	unsigned int fused_operations_count = 0;
+};
+
 struct CompilationResult {
 	bool success = false;
 	int node_id = -1;
 	int expanded_nodes_count = 0; // For testing and debugging
+	FusionStats fusion_stats; // For testing and debugging
+	bool tile_streaming = false; // For testing and debugging
 	String message;
 
 	static CompilationResult make_success() {
@@ -44,6 +57,10 @@ class Runtime {
 public:
 	static const unsigned int MAX_INPUTS = 8;
 	static const unsigned int MAX_OUTPUTS = 24;
+	// Fused operations and tile-streamed programs run on this many values at a time. With the amount of buffers
+	// operations usually touch, this keeps them in L1 cache.
+	static const unsigned int TILE_SIZE = 256;
+	static const unsigned int MAX_FUSED_OPERATIONS = 16;
 
 	struct BufferData {
 		// Owns the data.
@@ -68,6 +85,9 @@ public:
 		bool is_constant;
 		// Is the buffer a user input/output
 		bool is_binding = false;
+		// If true, the buffer only has room for one tile of values, because the program runs one tile at a time.
+		// `size` is then the size of a tile.
+		bool is_tile_sized = false;
 		// How many operations are using this buffer as input.
 		// This value is only relevant when using optimized execution mapping.
 		uint16_t local_users_count;
@@ -83,6 +103,8 @@ public:
 			uint16_t address = 0;
 			// How many constant fills to execute before this operation.
 			uint16_t constant_fill_count = 0;
+			// How many of the next operations are fused with this one. They run together one tile at a time.
+			uint16_t fused_count = 0;
 		};
 
 		StdVector<OperationInfo> operations;
@@ -98,7 +120,7 @@ public:
 		unsigned int inner_group_start_index = 0;
 
 		struct ConstantFill {
-			float *data = nullptr;
+			uint16_t buffer_address = 0;
 			float value = 0;
 		};
 
@@ -114,6 +136,30 @@ public:
 			inner_group_start_index = 0;
 			constant_fills.clear();
 		}
+
+		// Tells if running this map would execute the same operations as `other`, in the same state
+		bool has_same_operations(const ExecutionMap &other) const {
+			if (inner_group_start_index != other.inner_group_start_index ||
+				operations.size() != other.operations.size() || constant_fills.size() != other.constant_fills.size()) {
+				return false;
+			}
+			for (unsigned int i = 0; i < operations.size(); ++i) {
+				const OperationInfo &a = operations[i];
+				const OperationInfo &b = other.operations[i];
+				if (a.address != b.address || a.constant_fill_count != b.constant_fill_count ||
+					a.fused_count != b.fused_count) {
+					return false;
+				}
+			}
+			for (unsigned int i = 0; i < constant_fills.size(); ++i) {
+				const ConstantFill &a = constant_fills[i];
+				const ConstantFill &b = other.constant_fills[i];
+				if (a.buffer_address != b.buffer_address || a.value != b.value) {
+					return false;
+				}
+			}
+			return true;
+		}
 	};
 
 	// Contains the data the program will modify while it runs.
@@ -155,20 +201,30 @@ public:
 			}
 			buffer_datas.clear();
 			buffers.clear();
+			tile_buffers.clear();
 			ranges.clear();
 			debug_profiler_times.clear();
 		}
 
-		inline void add_execution_time(uint32_t execution_map_index, uint32_t time) {
+		inline void add_execution_time(uint32_t execution_map_index, uint64_t nanoseconds) {
 #if DEBUG_ENABLED
 			CRASH_COND(execution_map_index >= debug_profiler_times.size());
 #endif
-			debug_profiler_times[execution_map_index] += time;
+			debug_profiler_times[execution_map_index] += nanoseconds;
 		}
 
+		// Gets accumulated time in microseconds. Operations can run in less than a microsecond, so they are measured
+		// in nanoseconds and only converted here, after being summed.
 		inline uint32_t get_execution_time(uint32_t execution_map_index) const {
 #if DEBUG_ENABLED
 			CRASH_COND(execution_map_index >= debug_profiler_times.size());
+#endif
+			return debug_profiler_times[execution_map_index] / 1000;
+		}
+
+		inline uint64_t get_execution_time_nanoseconds(uint32_t execution_map_index) const {
+#if DEBUG_ENABLED
+			CRASH_COND(execution_map_index >= debug_profiler_times.size());
 #endif
 			return debug_profiler_times[execution_map_index];
 		}
@@ -178,9 +234,11 @@ public:
 
 		StdVector<math::Interval> ranges;
 		StdVector<Buffer> buffers;
+		// Copy of `buffers` pointing at one tile of their data, used to run fused operations
+		StdVector<Buffer> tile_buffers;
 		StdVector<BufferData> buffer_datas;
-		// [execution_map_index] => microseconds
-		StdVector<uint32_t> debug_profiler_times;
+		// [execution_map_index] => nanoseconds
+		StdVector<uint64_t> debug_profiler_times;
 
 		unsigned int buffer_size = 0;
 		unsigned int buffer_capacity = 0;
@@ -194,6 +252,22 @@ public:
 		unsigned int buffer_address = 0;
 	};
 
+	// Describes positions given as inputs when they form a regular grid, so some nodes can use faster paths than
+	// reading positions one by one. Values are ordered with X first, then Z, then Y, like slices of blocks generated by
+	// `VoxelGeneratorGraph`.
+	struct InputGrid {
+		// Coordinates of the first position, in multiples of `step`
+		Vector3i origin;
+		Vector3i size;
+		// Distance between consecutive positions along each axis
+		int step = 1;
+		// Index of the inputs receiving coordinates along X, Y and Z. -1 if there is no such input.
+		FixedArray<int, 3> axis_input_indices;
+
+		// Gets the grid covered by a range of values, if they form a box. Returns false otherwise.
+		bool get_sub_grid(unsigned int begin, unsigned int count, InputGrid &out_grid) const;
+	};
+
 	// Info about a terminal node of the graph
 	struct OutputInfo {
 		unsigned int buffer_address;
@@ -212,15 +286,21 @@ public:
 	// If none of these change, you can keep re-using it.
 	void prepare_state(State &state, unsigned int buffer_size, bool with_profiling) const;
 
+	// Enables or disables measuring time spent in each operation by the next queries. Measurements are reset to zero.
+	// Unlike `prepare_state`, this doesn't touch buffers.
+	void reset_profiling(State &state, bool enabled) const;
+
 	// Convenience for set generation with only one value
 	// TODO Evaluate needs for double-precision in pg::Runtime
 	void generate_single(State &state, Span<const float> inputs, const ExecutionMap *execution_map) const;
 
+	// If `input_grid` is provided, input positions must be those of the grid.
 	void generate_set(
 			State &state,
 			Span<const Span<const float>> p_inputs,
 			bool skip_outer_group,
-			const ExecutionMap *p_execution_map
+			const ExecutionMap *p_execution_map,
+			const InputGrid *input_grid = nullptr
 	) const;
 
 #ifdef DEBUG_ENABLED
@@ -261,11 +341,21 @@ public:
 
 	const ExecutionMap &get_default_execution_map() const;
 
+	// Gets the ID of the user-facing node an operation was compiled from. Unlike `ExecutionMap::debug_nodes`, this
+	// also works when the program was not compiled in debug mode.
+	uint32_t get_operation_node_id(uint16_t op_address) const;
+
 	// Gets the buffer address of a specific output port
 	bool try_get_output_port_address(ProgramGraph::PortLocation port, uint16_t &out_address) const;
 
+	// Identifies the compiled program. Programs compiled separately may have different hashes even if they come from
+	// the same graph.
 	uint64_t get_program_hash() const;
 
+	inline Span<const uint16_t> get_outer_group_output_addresses() const {
+		return to_span(_program.outer_group_output_addresses);
+	}
+
 	static inline Span<const uint8_t> read_params(Span<const uint16_t> operations, unsigned int &pc) {
 		const uint16_t params_size_in_words = operations[pc];
 		++pc;
@@ -368,9 +458,37 @@ public:
 			return b;
 		}
 
+		// `axis_addresses` are the addresses of buffers holding X, Y and Z coordinates of the grid, or -1
+		inline void set_input_grid(const InputGrid *grid, const FixedArray<int, 3> &axis_addresses) {
+			_input_grid = grid;
+			_input_grid_axis_addresses = axis_addresses;
+		}
+
+		// If input positions of the values being processed form a regular grid, returns it. Returns null otherwise.
+		inline const InputGrid *get_input_grid() const {
+			return _input_grid;
+		}
+
+		// Returns which axis of the input grid input `i` directly receives coordinates of (0 for X, 1 for Y, 2 for Z).
+		// Returns -1 if the input receives something else, or if there is no input grid.
+		inline int get_input_grid_axis(uint32_t i) const {
+			if (_input_grid == nullptr) {
+				return -1;
+			}
+			const int address = get_input_address(i);
+			for (unsigned int axis = 0; axis < _input_grid_axis_addresses.size(); ++axis) {
+				if (_input_grid_axis_addresses[axis] == address) {
+					return axis;
+				}
+			}
+			return -1;
+		}
+
 	private:
 		Span<Buffer> _buffers;
 		bool _using_execution_map;
+		const InputGrid *_input_grid = nullptr;
+		FixedArray<int, 3> _input_grid_axis_addresses;
 	};
 
 	// Functions usable by node implementations during range analysis
@@ -423,6 +541,20 @@ private:
 
 	bool is_operation_constant(const State &state, uint16_t op_address) const;
 
+	static void fuse_operations(ExecutionMap &execution_map, const Program &program, FusionStats *stats);
+
+	unsigned int run_operations_in_tiles(
+			State &state,
+			Span<const ExecutionMap::OperationInfo> operation_infos,
+			Span<const ExecutionMap::ConstantFill> constant_fills,
+			unsigned int constant_fill_index,
+			unsigned int first_execution_map_index,
+			bool using_execution_map,
+			bool profile,
+			const InputGrid *input_grid,
+			const FixedArray<int, 3> &input_grid_axis_addresses
+	) const;
+
 	struct BufferSpec {
 		// Index the buffer should be stored at
 		uint16_t address = 0;
@@ -444,6 +576,8 @@ private:
 		// If false, the port might share the same buffer data with other ports.
 		// TODO Rename `has_unique_data`?
 		bool is_pinned = false;
+		// If true, the data only needs to hold one tile of values. Only used when the program is tile-streamed.
+		bool is_tile_sized = false;
 	};
 
 	// Pre-processed, read-only graph used for runtime optimizations.
@@ -512,6 +646,10 @@ private:
 		// cases.
 		uint32_t inner_group_start_op_index;
 
+		// Addresses of buffers written by the outer group and read by the inner group. They hold everything the inner
+		// group needs from the outer group, so their values can be cached to skip the outer group entirely.
+		StdVector<uint16_t> outer_group_output_addresses;
+
 		StdVector<InputInfo> inputs;
 
 		FixedArray<OutputInfo, MAX_OUTPUTS> outputs;
@@ -523,6 +661,13 @@ private:
 		// Maximum amount of buffer datas this program will need to do a full run.
 		unsigned int buffer_data_count = 0;
 
+		// If true, the program runs one tile of values at a time, so most of its buffers only need to hold one tile
+		// instead of the whole query. This is possible when every operation only works with values at the same index.
+		// Bindings, pinned buffers and outputs still span the whole query.
+		bool tile_streaming = false;
+		// [buffer_data_index] => 1 if the data only needs to hold one tile. Empty if the program isn't tile-streamed.
+		StdVector<uint8_t> tile_sized_buffer_datas;
+
 		// Associates a port from the expanded graph to its corresponding address within the compiled program.
 		// This is used for debugging intermediate values.
 		StdUnorderedMap<ProgramGraph::PortLocation, uint16_t> output_port_addresses;
@@ -541,6 +686,7 @@ private:
 			operations.clear();
 			buffer_specs.clear();
 			inner_group_start_op_index = 0;
+			outer_group_output_addresses.clear();
 			default_execution_map.clear();
 			output_port_addresses.clear();
 			user_port_to_expanded_port.clear();
@@ -556,6 +702,8 @@ private:
 			ref_resources.clear();
 			buffer_count = 0;
 			buffer_data_count = 0;
+			tile_streaming = false;
+			tile_sized_buffer_datas.clear();
 		}
 	};
 
@@ -2,6 +2,7 @@
 #include "../../engine/buffered_task_scheduler.h"
 #include "../../engine/voxel_engine.h"
 #include "../../storage/voxel_data.h"
+#include "../../util/containers/container_funcs.h"
 #include "../../util/containers/std_vector.h"
 #include "../../util/dstack.h"
 #include "../../util/godot/classes/time.h"
@@ -83,6 +84,17 @@ void GenerateColumnMultipassTask::run(ThreadedTaskContext &ctx) {
 	Map &map = _generator_internal->map;
 	BufferedTaskScheduler &task_scheduler = BufferedTaskScheduler::get_for_current_thread();
 
+	if (_wait_begin_time_usec != 0) {
+		const uint64_t wait_usec = Time::get_singleton()->get_ticks_usec() - _wait_begin_time_usec;
+		Stats &stats = _generator_internal->stats;
+		if (_waiting_for_dependencies) {
+			stats.dependency_wait_usec += wait_usec;
+		} else {
+			stats.postpone_wait_usec += wait_usec;
+		}
+		_wait_begin_time_usec = 0;
+	}
+
 	const int final_subpass_index =
 			VoxelGeneratorMultipassCB::get_subpass_count_from_pass_count(_generator_internal->passes.size()) - 1;
 
@@ -93,6 +105,7 @@ void GenerateColumnMultipassTask::run(ThreadedTaskContext &ctx) {
 		{
 			if (!map.spatial_lock.try_lock_write(BoxBounds2i::from_position(_column_position))) {
 				// Try later (funny situation, but that's the pattern)
+				begin_wait(false);
 				ctx.status = ThreadedTaskContext::STATUS_POSTPONED;
 				return;
 			}
@@ -106,6 +119,7 @@ void GenerateColumnMultipassTask::run(ThreadedTaskContext &ctx) {
 				// Unregister task from the column
 				Column &column = column_it->second;
 				column.pending_subpass_tasks_mask &= ~(1 << _subpass_index);
+				schedule_waiting_tasks(column, true, task_scheduler);
 
 				if (_subpass_index == final_subpass_index) {
 					// Schedule pending block requests to make them handle cancellation
@@ -150,6 +164,7 @@ void GenerateColumnMultipassTask::run(ThreadedTaskContext &ctx) {
 		// SpatialLock3D::Write swlock(map->spatial_lock, neighbors_box);
 		if (!map.spatial_lock.try_lock_write(neighbors_box)) {
 			// Try later
+			begin_wait(false);
 			ctx.status = ThreadedTaskContext::STATUS_POSTPONED;
 			return;
 		}
@@ -180,6 +195,7 @@ void GenerateColumnMultipassTask::run(ThreadedTaskContext &ctx) {
 		Column *main_column = columns[central_block_index];
 
 		bool spawned_subtasks = false;
+		bool subscribed = false;
 		bool postpone = false;
 
 		// Check loading levels
@@ -199,6 +215,7 @@ void GenerateColumnMultipassTask::run(ThreadedTaskContext &ctx) {
 
 					if (main_column != nullptr) {
 						main_column->pending_subpass_tasks_mask &= ~(1 << _subpass_index);
+						schedule_waiting_tasks(*main_column, true, task_scheduler);
 
 						if (_subpass_index == final_subpass_index) {
 							// Schedule pending block requests to make them handle cancellation
@@ -233,12 +250,21 @@ void GenerateColumnMultipassTask::run(ThreadedTaskContext &ctx) {
 							postpone = true;
 
 						} else if ((column->pending_subpass_tasks_mask & (1 << prev_subpass_index)) != 0) {
-							// A task is pending to work on the dependency, so we wait.
-							// TODO Ideally we should subscribe to the completion of that task.
-							// We can do that
+							// A task is pending to work on the dependency. Subscribe to its completion, so we get
+							// scheduled again as soon as it's done, instead of polling until it is.
 							// println(format("O {} {} {} {} {}", int(_subpass_index), _column_position.x, 0,
 							// 		_column_position.y, Time::get_singleton()->get_ticks_usec()));
-							postpone = true;
+
+							if (dependency_counter == nullptr) {
+								dependency_counter = make_shared_instance<std::atomic_int>();
+							}
+							++(*dependency_counter);
+
+							column->waiting_tasks.push_back(
+									SubpassWaiter{ this, dependency_counter, static_cast<int8_t>(prev_subpass_index) }
+							);
+
+							subscribed = true;
 
 						} else {
 							// No task is pending to work on the dependency, spawn one.
@@ -280,10 +306,13 @@ void GenerateColumnMultipassTask::run(ThreadedTaskContext &ctx) {
 			}
 		}
 
-		if (spawned_subtasks) {
+		if (spawned_subtasks || subscribed) {
+			// Measuring from here, because tasks we depend on may start completing once we release the region
+			begin_wait(true);
 			ctx.status = ThreadedTaskContext::STATUS_TAKEN_OUT;
 
 		} else if (postpone) {
+			begin_wait(false);
 			ctx.status = ThreadedTaskContext::STATUS_POSTPONED;
 			return;
 
@@ -355,6 +384,7 @@ void GenerateColumnMultipassTask::run(ThreadedTaskContext &ctx) {
 			}
 
 			main_column->pending_subpass_tasks_mask &= ~(1 << _subpass_index);
+			schedule_waiting_tasks(*main_column, false, task_scheduler);
 
 			if (main_column->subpass_index == final_subpass_index) {
 				// All tasks that were waiting for this column to be complete (and did not spawn column subtasks
@@ -381,6 +411,42 @@ void GenerateColumnMultipassTask::schedule_final_block_tasks(Column &column, Buf
 	}
 }
 
+void GenerateColumnMultipassTask::schedule_waiting_tasks(
+		Column &column,
+		bool all,
+		BufferedTaskScheduler &task_scheduler
+) {
+	unsigned int i = 0;
+	while (i < column.waiting_tasks.size()) {
+		SubpassWaiter &waiter = column.waiting_tasks[i];
+
+		if (!all && waiter.subpass_index > column.subpass_index) {
+			++i;
+			continue;
+		}
+
+		const int counter = --(*waiter.dependency_counter);
+		ZN_ASSERT(counter >= 0);
+		if (counter == 0) {
+			// No other dependency left, the task can run again. It will check if it can run its subpass now.
+			task_scheduler.push_main_task(waiter.task);
+		}
+
+		unordered_remove(column.waiting_tasks, i);
+	}
+}
+
+void GenerateColumnMultipassTask::begin_wait(bool for_dependencies) {
+	_wait_begin_time_usec = Time::get_singleton()->get_ticks_usec();
+	_waiting_for_dependencies = for_dependencies;
+	Stats &stats = _generator_internal->stats;
+	if (for_dependencies) {
+		++stats.dependency_wait_count;
+	} else {
+		++stats.postpone_count;
+	}
+}
+
 void GenerateColumnMultipassTask::return_to_caller(bool success) {
 	ZN_ASSERT(_caller_task != nullptr);
 	ZN_ASSERT(_caller_task_dependency_counter != nullptr);
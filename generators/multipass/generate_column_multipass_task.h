@@ -13,9 +13,11 @@ class BufferedTaskScheduler;
 // If at least one column isn't found in the map, the task is cancelled, and so should be all its callers.
 // Otherwise:
 // If a column doesn't fulfills dependency requirements:
-//     - If another task is working on that column, the current task is postponed to run later.
+//     - If another task is working on that column, the current task subscribes to it, and will be scheduled again
+//       when that task is done.
 //     - Otherwise, a subtask is spawned to work on the dependency.
-//       The current task is queued after every subtask spawned this way.
+//       The current task is queued after every subtask spawned or subscribed to this way.
+// This way, passes can start as soon as their dependencies are met, without tasks repeatedly polling the map.
 // Otherwise, the task runs the pass, re-schedules its caller, and returns.
 //
 // One reason to use this pattern instead of "pyramid diffs", is that it can be invoked without assumptions. It will
@@ -53,7 +55,18 @@ public:
 	// order to re-schedule its caller. Eventually we may find a way to integrate this pattern into the framework.
 	// bool is_cancelled() {}
 
+	// Schedules tasks that were waiting for the column to reach their subpass. If `all` is true, they are all
+	// scheduled regardless, which is needed when pending tasks are cancelled or the column is removed.
+	// The column must be locked.
+	static void schedule_waiting_tasks(
+			VoxelGeneratorMultipassCBStructs::Column &column,
+			bool all,
+			BufferedTaskScheduler &task_scheduler
+	);
+
 private:
+	// Must be called before the task leaves the runner (postponed or taken out), to measure how long it waits
+	void begin_wait(bool for_dependencies);
 	void schedule_final_block_tasks(
 			VoxelGeneratorMultipassCBStructs::Column &column,
 			BufferedTaskScheduler &task_scheduler
@@ -75,6 +88,9 @@ private:
 	// processed".
 	std::shared_ptr<std::atomic_int> _caller_task_dependency_counter;
 	GenerateColumnMultipassTask *_caller_mp_task = nullptr;
+	// Time at which the task started waiting, or 0 if it is not waiting
+	uint64_t _wait_begin_time_usec = 0;
+	bool _waiting_for_dependencies = false;
 };
 
 } // namespace zylann::voxel
@@ -8,6 +8,8 @@
 #include "../../util/profiling.h"
 #include "../../util/string/format.h"
 #include "generate_block_multipass_cb_task.h"
+#include "generate_column_multipass_task.h"
+#include <algorithm>
 
 namespace zylann::voxel {
 
@@ -156,6 +158,17 @@ void VoxelGeneratorMultipassCB::set_pass_extent_blocks(int pass_index, int new_e
 	re_initialize_column_refcounts();
 }
 
+int VoxelGeneratorMultipassCB::get_column_cache_capacity() const {
+	return get_internal()->column_cache_capacity;
+}
+
+void VoxelGeneratorMultipassCB::set_column_cache_capacity(int capacity_bytes) {
+	ZN_ASSERT_RETURN(capacity_bytes >= 0);
+	std::shared_ptr<Internal> internal = get_internal();
+	internal->column_cache_capacity = capacity_bytes;
+	evict_cached_columns(*internal);
+}
+
 // Internal
 
 std::shared_ptr<Internal> VoxelGeneratorMultipassCB::get_internal() const {
@@ -190,6 +203,23 @@ Box2i to_box2i_in_height_range(Box3i box3, int min_y, int height) {
 	return Box2i(to_vec2i_xz(box3.position), to_vec2i_xz(box3.size));
 }
 
+// Approximation of the memory used by voxels of a column, not counting metadata
+size_t get_column_memory_usage(const Column &column) {
+	size_t usage = sizeof(Column);
+	for (const Block &block : column.blocks) {
+		usage += sizeof(Block);
+		const VoxelBuffer &voxels = block.voxels;
+		for (unsigned int channel_index = 0; channel_index < VoxelBuffer::MAX_CHANNELS; ++channel_index) {
+			if (voxels.get_channel_compression(channel_index) == VoxelBuffer::COMPRESSION_NONE) {
+				usage += VoxelBuffer::get_size_in_bytes_for_volume(
+						voxels.get_size(), voxels.get_channel_depth(channel_index)
+				);
+			}
+		}
+	}
+	return usage;
+}
+
 } // namespace
 
 void VoxelGeneratorMultipassCB::generate_pass(PassInput input) {
@@ -219,6 +249,56 @@ void VoxelGeneratorMultipassCB::generate_pass(PassInput input) {
 	}
 }
 
+// Frees the least recently cached columns until they use no more memory than the capacity. Columns locked by tasks are
+// skipped, they will be evicted another time.
+void VoxelGeneratorMultipassCB::evict_cached_columns(Internal &internal) {
+	ZN_PROFILE_SCOPE();
+
+	Map &map = internal.map;
+	const size_t capacity = internal.column_cache_capacity;
+
+	MutexLock mlock(map.mutex);
+
+	if (map.cached_columns_memory_usage <= capacity) {
+		return;
+	}
+
+	// Oldest first
+	StdVector<std::pair<uint64_t, Vector2i>> candidates;
+	candidates.reserve(map.cached_column_count);
+	for (auto it = map.columns.begin(); it != map.columns.end(); ++it) {
+		const Column &column = it->second;
+		if (column.cached) {
+			candidates.push_back({ column.cached_time, it->first });
+		}
+	}
+	std::sort(candidates.begin(), candidates.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+
+	for (const std::pair<uint64_t, Vector2i> &candidate : candidates) {
+		if (map.cached_columns_memory_usage <= capacity) {
+			break;
+		}
+
+		// Not blocking here, because tasks lock regions before locking the map
+		const BoxBounds2i bounds = BoxBounds2i::from_position(candidate.second);
+		if (!map.spatial_lock.try_lock_write(bounds)) {
+			continue;
+		}
+		SpatialLock2D::UnlockWriteOnScopeExit swlock(map.spatial_lock, bounds);
+
+		auto it = map.columns.find(candidate.second);
+		ZN_ASSERT_CONTINUE(it != map.columns.end());
+		Column &column = it->second;
+		// Only fully generated columns are cached, no task can be waiting on them
+		ZN_ASSERT(column.waiting_tasks.size() == 0);
+
+		map.cached_columns_memory_usage -= column.cached_memory_usage;
+		--map.cached_column_count;
+		map.columns.erase(it);
+		++internal.stats.cache_evictions;
+	}
+}
+
 void VoxelGeneratorMultipassCB::re_initialize_column_refcounts() {
 	// This should only be called following a map reset
 	ZN_ASSERT_RETURN_MSG(get_internal()->map.columns.size() == 0, "Bug!");
@@ -283,20 +363,29 @@ void VoxelGeneratorMultipassCB::process_viewer_diff_internal(Box3i p_requested_b
 
 	BufferedTaskScheduler &task_scheduler = BufferedTaskScheduler::get_for_current_thread();
 
+	VoxelGeneratorMultipassCBStructs::Stats &stats = internal->stats;
+
 	// Blocks to view
 	const int column_height = internal->column_height_blocks;
-	load_requested_box.difference(prev_load_requested_box, [&map, column_height](Box2i new_box) {
+	load_requested_box.difference(prev_load_requested_box, [&map, &stats, column_height](Box2i new_box) {
 		{
 			ZN_PROFILE_SCOPE_NAMED("Enter box");
 
 			SpatialLock2D::Write swlock(map.spatial_lock, new_box);
 			MutexLock mlock(map.mutex);
 
-			new_box.for_each_cell_yx([&map, column_height](Vector2i bpos) {
+			new_box.for_each_cell_yx([&map, &stats, column_height](Vector2i bpos) {
 				Column &column = map.columns[bpos];
 				if (column.blocks.size() == 0) {
 					column.blocks.resize(column_height);
 				}
+				if (column.cached) {
+					// A viewer came back before the column got evicted, it doesn't need to generate again
+					column.cached = false;
+					map.cached_columns_memory_usage -= column.cached_memory_usage;
+					--map.cached_column_count;
+					++stats.cache_hits;
+				}
 				// if (block == nullptr) {
 				// 	block = make_unique_instance<Block>();
 				// 	// block->loading = true;
@@ -308,8 +397,11 @@ void VoxelGeneratorMultipassCB::process_viewer_diff_internal(Box3i p_requested_b
 		}
 	});
 
+	const int final_subpass_index = get_subpass_count_from_pass_count(internal->passes.size()) - 1;
+	const bool use_column_cache = internal->column_cache_capacity > 0;
+
 	// Blocks to unview
-	prev_load_requested_box.difference(load_requested_box, [&map, &task_scheduler](Box2i old_box) {
+	prev_load_requested_box.difference(load_requested_box, [&](Box2i old_box) {
 		ZN_PROFILE_SCOPE_NAMED("Leave box (locking)");
 
 		// TODO This can be a bottleneck if the generator is slow and a player teleports far away while columns are
@@ -323,7 +415,7 @@ void VoxelGeneratorMultipassCB::process_viewer_diff_internal(Box3i p_requested_b
 		{
 			ZN_PROFILE_SCOPE_NAMED("Leave box");
 
-			old_box.for_each_cell_yx([&map, &task_scheduler](Vector2i cpos) {
+			old_box.for_each_cell_yx([&](Vector2i cpos) {
 				auto it = map.columns.find(cpos);
 
 				// The block must be found because last time the block was in the loading area of the viewer.
@@ -342,16 +434,34 @@ void VoxelGeneratorMultipassCB::process_viewer_diff_internal(Box3i p_requested_b
 						}
 					}
 
-					// TODO Implement saving tasks
-					// We remove immediately for now
-					map.columns.erase(it);
-					// println(format("U {} {} {} {} {}", 0, cpos.x, 0, cpos.y,
-					// Time::get_singleton()->get_ticks_usec()));
+					// Tasks waiting for this column will find it's gone and cancel
+					GenerateColumnMultipassTask::schedule_waiting_tasks(column, true, task_scheduler);
+
+					if (use_column_cache && column.subpass_index == final_subpass_index &&
+						column.pending_subpass_tasks_mask == 0) {
+						// Keep it in case viewers come back. Its neighbors may be removed and generated again in the
+						// meantime, so their passes can run on it again. That also happens to columns at the edge of
+						// the area viewers keep loaded.
+						column.cached = true;
+						column.cached_memory_usage = get_column_memory_usage(column);
+						column.cached_time = ++map.cache_time;
+						map.cached_columns_memory_usage += column.cached_memory_usage;
+						++map.cached_column_count;
+
+					} else {
+						// TODO Implement saving tasks
+						// We remove immediately for now
+						map.columns.erase(it);
+						// println(format("U {} {} {} {} {}", 0, cpos.x, 0, cpos.y,
+						// Time::get_singleton()->get_ticks_usec()));
+					}
 				}
 			});
 		}
 	});
 
+	evict_cached_columns(*internal);
+
 	task_scheduler.flush();
 }
 
@@ -385,6 +495,26 @@ void VoxelGeneratorMultipassCB::clear_cache() {
 	*/
 }
 
+VoxelGeneratorMultipassCB::Stats VoxelGeneratorMultipassCB::get_stats() const {
+	std::shared_ptr<Internal> internal = get_internal();
+	const VoxelGeneratorMultipassCBStructs::Stats &src = internal->stats;
+	Stats stats;
+	{
+		Map &map = internal->map;
+		MutexLock mlock(map.mutex);
+		stats.column_count = map.columns.size();
+		stats.cached_column_count = map.cached_column_count;
+		stats.cached_columns_memory_usage = map.cached_columns_memory_usage;
+	}
+	stats.cache_hits = src.cache_hits;
+	stats.cache_evictions = src.cache_evictions;
+	stats.dependency_wait_count = src.dependency_wait_count;
+	stats.dependency_wait_usec = src.dependency_wait_usec;
+	stats.postpone_count = src.postpone_count;
+	stats.postpone_wait_usec = src.postpone_wait_usec;
+	return stats;
+}
+
 bool VoxelGeneratorMultipassCB::debug_try_get_column_states(StdVector<DebugColumnState> &out_states) {
 	ZN_PROFILE_SCOPE();
 
@@ -566,6 +696,21 @@ TypedArray<godot::VoxelBuffer> VoxelGeneratorMultipassCB::debug_generate_test_co
 
 // BINDING LAND
 
+Dictionary VoxelGeneratorMultipassCB::_b_get_stats() const {
+	const Stats stats = get_stats();
+	Dictionary d;
+	d["columns"] = static_cast<int64_t>(stats.column_count);
+	d["cached_columns"] = static_cast<int64_t>(stats.cached_column_count);
+	d["cached_columns_memory_usage"] = static_cast<int64_t>(stats.cached_columns_memory_usage);
+	d["cache_hits"] = static_cast<int64_t>(stats.cache_hits);
+	d["cache_evictions"] = static_cast<int64_t>(stats.cache_evictions);
+	d["dependency_waits"] = static_cast<int64_t>(stats.dependency_wait_count);
+	d["dependency_wait_usec"] = static_cast<int64_t>(stats.dependency_wait_usec);
+	d["postpones"] = static_cast<int64_t>(stats.postpone_count);
+	d["postpone_wait_usec"] = static_cast<int64_t>(stats.postpone_wait_usec);
+	return d;
+}
+
 bool VoxelGeneratorMultipassCB::_set(const StringName &p_name, const Variant &p_value) {
 	const String property_name = p_name;
 
@@ -641,6 +786,16 @@ void VoxelGeneratorMultipassCB::_bind_methods() {
 			D_METHOD("set_column_height_blocks", "y"), &VoxelGeneratorMultipassCB::set_column_height_blocks
 	);
 
+	ClassDB::bind_method(
+			D_METHOD("get_column_cache_capacity"), &VoxelGeneratorMultipassCB::get_column_cache_capacity
+	);
+	ClassDB::bind_method(
+			D_METHOD("set_column_cache_capacity", "capacity_bytes"),
+			&VoxelGeneratorMultipassCB::set_column_cache_capacity
+	);
+
+	ClassDB::bind_method(D_METHOD("get_stats"), &VoxelGeneratorMultipassCB::_b_get_stats);
+
 	ClassDB::bind_method(
 			D_METHOD("debug_generate_test_column", "column_position_blocks"),
 			&VoxelGeneratorMultipassCB::debug_generate_test_column
@@ -669,6 +824,12 @@ void VoxelGeneratorMultipassCB::_bind_methods() {
 			"get_pass_count"
 	);
 
+	ADD_PROPERTY(
+			PropertyInfo(Variant::INT, "column_cache_capacity"),
+			"set_column_cache_capacity",
+			"get_column_cache_capacity"
+	);
+
 	BIND_CONSTANT(MAX_PASSES);
 	BIND_CONSTANT(MAX_PASS_EXTENT);
 }
@@ -4,6 +4,7 @@
 #include "../../engine/ids.h"
 #include "../../storage/voxel_buffer_gd.h"
 #include "../../util/containers/std_vector.h"
+#include "../../util/godot/core/dictionary.h"
 #include "../../util/godot/core/gdvirtual.h"
 #include "../../util/math/box3i.h"
 #include "../../util/math/vector2i.h"
@@ -54,11 +55,21 @@ public:
 		return false;
 	}
 
+	bool supports_fused_generation() const override {
+		// Blocks can only be obtained from columns, which are generated by our own tasks
+		return false;
+	}
+
 	Result generate_block(VoxelQueryData input) override;
 	int get_used_channels_mask() const override;
 
 	IThreadedTask *create_block_task(const VoxelGenerator::BlockTaskParams &params) const override;
 
+	IThreadedTask *create_block_batch_task(Span<const VoxelGenerator::BlockTaskParams> params) const override {
+		// Blocks depend on passes of their neighbors, which have their own scheduling
+		return nullptr;
+	}
+
 	// Executes a pass on a grid of blocks.
 	// The grid contains a central column of blocks, where the main processing must happen.
 	// It is surrounded by neighbors, which are accessible in case main processing affects them partially (structures
@@ -84,6 +95,29 @@ public:
 	int get_pass_extent_blocks(int pass_index) const;
 	void set_pass_extent_blocks(int pass_index, int new_extent);
 
+	// Maximum memory that columns which are fully generated but no longer in range of any viewer can use. They are kept
+	// so they don't have to be generated again if a viewer comes back. 0 disables it.
+	int get_column_cache_capacity() const;
+	void set_column_cache_capacity(int capacity_bytes);
+
+	struct Stats {
+		// Columns in the map, including cached ones
+		size_t column_count = 0;
+		size_t cached_column_count = 0;
+		size_t cached_columns_memory_usage = 0;
+		uint64_t cache_hits = 0;
+		uint64_t cache_evictions = 0;
+		// How many times column tasks had to wait for neighbor passes to complete, and how long in total
+		uint64_t dependency_wait_count = 0;
+		uint64_t dependency_wait_usec = 0;
+		// How many times column tasks had to retry because neighbors were locked, and how long in total
+		uint64_t postpone_count = 0;
+		uint64_t postpone_wait_usec = 0;
+	};
+
+	// Statistics are reset when the cache is cleared, or when the structure of passes changes.
+	Stats get_stats() const;
+
 	// Run the generator to get a particular column from scratch, using a single thread for better script debugging
 	// (since Godot 4 still doesn't support debugging scripts in different threads, at time of writing). This doesn't
 	// use the internal cache and can be extremely slow.
@@ -130,6 +164,7 @@ protected:
 private:
 	void process_viewer_diff_internal(Box3i p_requested_box, Box3i p_prev_requested_box);
 	void re_initialize_column_refcounts();
+	static void evict_cached_columns(VoxelGeneratorMultipassCBStructs::Internal &internal);
 	void generate_block_fallback_script(VoxelQueryData &input);
 
 	// This must be called each time the structure of passes changes (number of passes, extents)
@@ -163,6 +198,8 @@ private:
 		// it is totally unsafe to modify the script while it executes in threads in the editor...
 	}
 
+	Dictionary _b_get_stats() const;
+
 	static void _bind_methods();
 
 	struct PairedViewer {
@@ -12,6 +12,8 @@
 #include "../../util/thread/mutex.h"
 #include "../../util/thread/spatial_lock_2d.h"
 
+#include <atomic>
+#include <memory>
 #include <utility>
 
 // Data structures used internally in multipass generation.
@@ -66,6 +68,15 @@ struct Block {
 	}
 };
 
+// Task suspended until a column reaches a given subpass
+struct SubpassWaiter {
+	// Task to schedule when `dependency_counter` reaches zero. Like `Block::final_pending_task`, it is owned by the
+	// column while it is here.
+	IThreadedTask *task = nullptr;
+	std::shared_ptr<std::atomic_int> dependency_counter;
+	int8_t subpass_index = 0;
+};
+
 struct Column {
 	RefCount viewers;
 	// Index of the last subpass that was executed directly on this chunk.
@@ -73,10 +84,21 @@ struct Column {
 	int8_t subpass_index = -1;
 	bool saving = false;
 	bool loading = false;
+	// True if the column is fully generated but no viewer needs it anymore. It is kept in case viewers come back,
+	// until cached columns use more memory than allowed.
+	bool cached = false;
 
 	// Each bit is set to 1 when a task is pending to process this block at a given subpass.
 	uint8_t pending_subpass_tasks_mask = 0;
 
+	// Tasks waiting for one of the pending tasks of this column to complete, so they can run their own subpass.
+	// They are scheduled when that happens, or when the pending task is cancelled, or when the column is removed.
+	StdVector<SubpassWaiter> waiting_tasks;
+
+	// Memory used by blocks of the column when it got cached, and when that happened
+	size_t cached_memory_usage = 0;
+	uint64_t cached_time = 0;
+
 	// Currently unused, because if chunks get removed from the cache or don't get saved for any reason,
 	// it can become out of sync and we wouldn't know. It would be a nice optimization tho...
 	//
@@ -97,8 +119,13 @@ struct Column {
 
 struct Map {
 	StdUnorderedMap<Vector2i, Column> columns;
-	// Protects the hashmap itself
+	// Protects the hashmap itself, and the following fields
 	Mutex mutex;
+	// Total memory used by columns flagged as `cached`
+	size_t cached_columns_memory_usage = 0;
+	unsigned int cached_column_count = 0;
+	// Incremented every time a column gets cached, used to find the oldest ones
+	uint64_t cache_time = 0;
 	// Protects columns
 	mutable SpatialLock2D spatial_lock;
 
@@ -124,6 +151,23 @@ struct Pass {
 	int8_t dependency_extents = 0;
 };
 
+struct Stats {
+	// How many times viewers came back to a cached column
+	std::atomic_uint64_t cache_hits{ 0 };
+	// How many cached columns were freed to stay below capacity
+	std::atomic_uint64_t cache_evictions{ 0 };
+	// How many times column tasks were suspended until neighbor columns reached the subpass they need, and for how
+	// long in total
+	std::atomic_uint64_t dependency_wait_count{ 0 };
+	std::atomic_uint64_t dependency_wait_usec{ 0 };
+	// How many times column tasks were postponed because their area was locked by other tasks, and for how long in
+	// total. This is time spent in the task runner's queue without doing work.
+	std::atomic_uint64_t postpone_count{ 0 };
+	std::atomic_uint64_t postpone_wait_usec{ 0 };
+};
+
+static constexpr size_t DEFAULT_COLUMN_CACHE_CAPACITY = 32 * 1024 * 1024;
+
 // Internal state of the generator.
 struct Internal {
 	// Map used solely for generation purposes. It acts like a cache so we don't recompute the same passes many
@@ -138,6 +182,12 @@ struct Internal {
 	int column_base_y_blocks = -4;
 	int column_height_blocks = 8;
 
+	// Maximum amount of memory used by columns no viewer needs anymore, in bytes. Unlike other params, it can change
+	// without making a new instance, since it doesn't invalidate the map.
+	std::atomic_size_t column_cache_capacity{ DEFAULT_COLUMN_CACHE_CAPACITY };
+
+	Stats stats;
+
 	// Set to `true` if the generator's configuration changed. Means a new instance of Internal has been made.
 	// Existing tasks may still finish their work using the old instance, but results will be thrown away. Such
 	// tasks can end faster if they check this boolean.
@@ -152,6 +202,7 @@ struct Internal {
 		passes = other.passes;
 		column_base_y_blocks = other.column_base_y_blocks;
 		column_height_blocks = other.column_height_blocks;
+		column_cache_capacity = other.column_cache_capacity.load();
 	}
 };
 
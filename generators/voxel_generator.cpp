@@ -4,6 +4,7 @@
 #include "../storage/voxel_buffer_gd.h"
 #include "../util/godot/core/array.h" // for `varray` in GDExtension builds
 #include "../util/profiling.h"
+#include "generate_block_batch_task.h"
 #include "generate_block_task.h"
 
 #ifdef VOXEL_ENABLE_GPU
@@ -19,11 +20,22 @@ VoxelGenerator::Result VoxelGenerator::generate_block(VoxelQueryData input) {
 	return Result();
 }
 
+void VoxelGenerator::generate_blocks(Span<VoxelQueryData> queries, Span<Result> out_results) {
+	ZN_ASSERT_RETURN(queries.size() == out_results.size());
+	for (unsigned int i = 0; i < queries.size(); ++i) {
+		out_results[i] = generate_block(queries[i]);
+	}
+}
+
 IThreadedTask *VoxelGenerator::create_block_task(const BlockTaskParams &params) const {
 	// Default generic task
 	return ZN_NEW(GenerateBlockTask(params));
 }
 
+IThreadedTask *VoxelGenerator::create_block_batch_task(Span<const BlockTaskParams> params) const {
+	return ZN_NEW(GenerateBlockBatchTask(params));
+}
+
 int VoxelGenerator::get_used_channels_mask() const {
 	return 0;
 }
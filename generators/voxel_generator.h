@@ -68,6 +68,11 @@ public:
 
 	virtual Result generate_block(VoxelQueryData input);
 
+	// Generates multiple blocks at once. `out_results` must have the same size as `queries`. Blocks are often
+	// neighbors (like columns of blocks requested by a terrain), so generators may override this to share work
+	// between them. The default implementation calls `generate_block` for each block.
+	virtual void generate_blocks(Span<VoxelQueryData> queries, Span<Result> out_results);
+
 	struct BlockTaskParams {
 		Vector3i block_position;
 		VoxelFormat format;
@@ -90,6 +95,12 @@ public:
 	// the requesting volume.
 	virtual IThreadedTask *create_block_task(const BlockTaskParams &params) const;
 
+	// Creates a threaded task that will generate multiple blocks at once using `generate_blocks`, and return each of
+	// them to the requesting volume. All parameters must have the same volume, LOD, block size, format and
+	// dependencies. Returns null if the generator doesn't support it, in which case `create_block_task` should be used
+	// for each block.
+	virtual IThreadedTask *create_block_batch_task(Span<const BlockTaskParams> params) const;
+
 	virtual bool supports_single_generation() const {
 		return false;
 	}
@@ -102,6 +113,12 @@ public:
 		return true;
 	}
 
+	// Tells if blocks can be generated by calling `generate_block` from other tasks, for example to generate and mesh
+	// a chunk in a single task. Generators that need their own block tasks must return false.
+	virtual bool supports_fused_generation() const {
+		return true;
+	}
+
 	// TODO Not sure if it's a good API regarding performance
 	virtual VoxelSingleValue generate_single(Vector3i pos, unsigned int channel);
 
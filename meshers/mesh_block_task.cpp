@@ -204,6 +204,18 @@ void copy_block_and_neighbors(
 		const VoxelModifierStack &modifiers = voxel_data.get_modifiers();
 #endif
 
+		if (boxes_to_generate.size() == 1 && boxes_to_generate[0] == Box3i(Vector3i(), dst.get_size())) {
+			// No neighbor was available, generate directly in the destination buffer instead of copying
+			VoxelGenerator::VoxelQueryData q{ dst, origin_in_voxels_lod0, lod_index };
+			if (generator.is_valid()) {
+				generator->generate_block(q);
+			}
+#ifdef VOXEL_ENABLE_MODIFIERS
+			modifiers.apply(q.voxel_buffer, AABB(q.origin_in_voxels, q.voxel_buffer.get_size() << lod_index));
+#endif
+			return;
+		}
+
 		for (const Box3i &box : boxes_to_generate) {
 			ZN_PROFILE_SCOPE_NAMED("Box");
 			// print_line(String("size={0}").format(varray(box.size.to_vec3())));
@@ -350,6 +362,7 @@ void MeshBlockTask::run(zylann::ThreadedTaskContext &ctx) {
 
 #ifdef VOXEL_ENABLE_GPU
 	if (block_generation_use_gpu) {
+		ZN_ASSERT_RETURN_MSG(generated_blocks_dependency == nullptr, "Returning generated blocks requires the CPU");
 		if (_stage == 0) {
 			gather_voxels_gpu(ctx);
 		}
@@ -455,7 +468,8 @@ void MeshBlockTask::gather_voxels_cpu() {
 			_voxels,
 			min_padding,
 			max_padding,
-			mesher->get_used_channels_mask(),
+			// Generated blocks will be extracted from the meshing buffer, so it must contain all channels
+			generated_blocks_dependency != nullptr ? VoxelBuffer::ALL_CHANNELS_MASK : mesher->get_used_channels_mask(),
 			meshing_dependency->generator,
 			*data,
 			lod_index,
@@ -464,38 +478,44 @@ void MeshBlockTask::gather_voxels_cpu() {
 			nullptr
 	);
 
-	// Could cache generator data from here if it was safe to write into the map
-	/*if (data != nullptr && cache_generated_blocks) {
-		const CubicAreaInfo area_info = get_cubic_area_info_from_size(blocks.size());
-		ERR_FAIL_COND(!area_info.is_valid());
+	if (generated_blocks_dependency != nullptr) {
+		extract_generated_blocks();
+	}
+}
+
+void MeshBlockTask::extract_generated_blocks() {
+	ZN_PROFILE_SCOPE();
+
+	const CubicAreaInfo area_info = get_cubic_area_info_from_size(blocks_count);
+	ERR_FAIL_COND(!area_info.is_valid());
 
-		VoxelDataLodMap::Lod &lod = data->lods[lod_index];
-
-		// Note, this box does not include neighbors!
-		const Vector3i min_bpos = position * area_info.mesh_block_size_factor;
-		const Vector3i max_bpos = min_bpos + Vector3iUtil::create(area_info.edge_size - 2);
-
-		Vector3i bpos;
-		for (bpos.z = min_bpos.z; bpos.z < max_bpos.z; ++bpos.z) {
-			for (bpos.x = min_bpos.x; bpos.x < max_bpos.x; ++bpos.x) {
-				for (bpos.y = min_bpos.y; bpos.y < max_bpos.y; ++bpos.y) {
-					// {
-					// 	RWLockRead rlock(lod.map_lock);
-					// 	VoxelDataBlock *block = lod.map.get_block(bpos);
-					// 	if (block != nullptr && (block->is_edited() || block->is_modified())) {
-					// 		continue;
-					// 	}
-					// }
-					std::shared_ptr<VoxelBuffer> &cache_buffer = make_shared_instance<VoxelBuffer>();
-					cache_buffer->copy_format(voxels);
-					const Vector3i min_src_pos =
-							(bpos - min_bpos) * data_block_size + Vector3iUtil::create(min_padding);
-					cache_buffer->copy_from(voxels, min_src_pos, min_src_pos + cache_buffer->get_size(), Vector3i());
-					// TODO Where to put voxels? Can't safely write to data at the moment.
+	const int data_block_size = data->get_block_size();
+	const VoxelFormat format = data->get_format();
+	const Vector3i min_padding = Vector3iUtil::create(meshing_dependency->mesher->get_minimum_padding());
+	const Vector3i data_block_pos0 = mesh_block_position * area_info.mesh_block_size_factor;
+
+	_generated_blocks.clear();
+
+	// Central blocks were generated into the meshing buffer, so we can return them without generating them again.
+	// Using ZXY order like `blocks`.
+	Vector3i rpos;
+	for (rpos.z = 0; rpos.z < area_info.mesh_block_size_factor; ++rpos.z) {
+		for (rpos.x = 0; rpos.x < area_info.mesh_block_size_factor; ++rpos.x) {
+			for (rpos.y = 0; rpos.y < area_info.mesh_block_size_factor; ++rpos.y) {
+				std::shared_ptr<VoxelBuffer> buffer = make_shared_instance<VoxelBuffer>(VoxelBuffer::ALLOCATOR_POOL);
+				buffer->create(Vector3iUtil::create(data_block_size), &format);
+
+				const Vector3i src_min = min_padding + rpos * data_block_size;
+				const Vector3i src_max = src_min + buffer->get_size();
+				for (unsigned int channel_index = 0; channel_index < VoxelBuffer::MAX_CHANNELS; ++channel_index) {
+					buffer->copy_channel_from(_voxels, src_min, src_max, Vector3i(), channel_index);
 				}
+				buffer->compress_uniform_channels();
+
+				_generated_blocks.push_back(GeneratedBlock{ buffer, data_block_pos0 + rpos });
 			}
 		}
-	}*/
+	}
 }
 
 void MeshBlockTask::build_mesh() {
@@ -617,6 +637,11 @@ bool MeshBlockTask::is_cancelled() {
 
 void MeshBlockTask::apply_result() {
 	if (VoxelEngine::get_singleton().is_volume_valid(volume_id)) {
+		// Send data first, so the volume has it by the time it receives the mesh
+		if (generated_blocks_dependency != nullptr && generated_blocks_dependency->valid) {
+			apply_generated_blocks();
+		}
+
 		// The request response must match the dependency it would have been requested with.
 		// If it doesn't match, we are no longer interested in the result.
 		// It is assumed that if a dependency is changed, a new copy of it is made and the old one is marked
@@ -655,4 +680,43 @@ void MeshBlockTask::apply_result() {
 	}
 }
 
+void MeshBlockTask::apply_generated_blocks() {
+	VoxelEngine::VolumeCallbacks callbacks = VoxelEngine::get_singleton().get_volume_callbacks(volume_id);
+	ERR_FAIL_COND(callbacks.data_output_callback == nullptr);
+
+	if (!_has_run || _generated_blocks.size() == 0) {
+		// Notify the volume, which may request these blocks again
+		const CubicAreaInfo area_info = get_cubic_area_info_from_size(blocks_count);
+		ERR_FAIL_COND(!area_info.is_valid());
+		const Vector3i data_block_pos0 = mesh_block_position * area_info.mesh_block_size_factor;
+
+		Vector3i rpos;
+		for (rpos.z = 0; rpos.z < area_info.mesh_block_size_factor; ++rpos.z) {
+			for (rpos.x = 0; rpos.x < area_info.mesh_block_size_factor; ++rpos.x) {
+				for (rpos.y = 0; rpos.y < area_info.mesh_block_size_factor; ++rpos.y) {
+					VoxelEngine::BlockDataOutput o{};
+					o.type = VoxelEngine::BlockDataOutput::TYPE_GENERATED;
+					o.position = data_block_pos0 + rpos;
+					o.lod_index = lod_index;
+					o.dropped = true;
+					callbacks.data_output_callback(callbacks.data, o);
+				}
+			}
+		}
+		return;
+	}
+
+	for (GeneratedBlock &block : _generated_blocks) {
+		VoxelEngine::BlockDataOutput o{};
+		o.type = VoxelEngine::BlockDataOutput::TYPE_GENERATED;
+		o.voxels = std::move(block.voxels);
+		o.position = block.position;
+		o.lod_index = lod_index;
+		o.dropped = false;
+		o.had_voxels = true;
+		callbacks.data_output_callback(callbacks.data, o);
+	}
+	_generated_blocks.clear();
+}
+
 } // namespace zylann::voxel
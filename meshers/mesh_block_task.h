@@ -5,6 +5,7 @@
 #include "../engine/ids.h"
 #include "../engine/meshing_dependency.h"
 #include "../engine/priority_dependency.h"
+#include "../engine/streaming_dependency.h"
 #include "../storage/voxel_buffer.h"
 #include "../util/containers/std_vector.h"
 #include "../util/godot/classes/array_mesh.h"
@@ -79,13 +80,19 @@ public:
 #endif
 	Ref<VoxelGenerator> detail_texture_generator_override;
 	TaskCancellationToken cancellation_token;
+	// If not null, central blocks (those covered by the mesh block) must be null in `blocks`. They will be generated
+	// into the meshing buffer, and sent back to the volume as generated data blocks along with the mesh. This fuses
+	// generation and meshing of areas that have no saved data. Not supported with GPU generation.
+	std::shared_ptr<StreamingDependency> generated_blocks_dependency;
 
 private:
 #ifdef VOXEL_ENABLE_GPU
 	void gather_voxels_gpu(zylann::ThreadedTaskContext &ctx);
 #endif
 	void gather_voxels_cpu();
+	void extract_generated_blocks();
 	void build_mesh();
+	void apply_generated_blocks();
 
 	bool _has_run = false;
 	bool _too_far = false;
@@ -98,6 +105,12 @@ private:
 	Ref<Mesh> _mesh;
 	Ref<Mesh> _shadow_occluder_mesh;
 	StdVector<uint16_t> _mesh_material_indices; // Indexed by mesh surface
+	struct GeneratedBlock {
+		std::shared_ptr<VoxelBuffer> voxels;
+		Vector3i position; // In data blocks
+	};
+	// Only used if `generated_blocks_dependency` is set
+	StdVector<GeneratedBlock> _generated_blocks;
 #ifdef VOXEL_ENABLE_SMOOTH_MESHING
 	std::shared_ptr<DetailTextureOutput> _detail_textures;
 #endif
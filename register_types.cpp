@@ -42,6 +42,8 @@
 #include "terrain/voxel_a_star_grid_3d.h"
 #include "terrain/voxel_mesh_block.h"
 #include "terrain/voxel_save_completion_tracker.h"
+#include "terrain/voxel_session_recorder.h"
+#include "terrain/voxel_session_replayer.h"
 #include "terrain/voxel_viewer.h"
 #include "util/godot/check_ref_ownership.h"
 #include "util/macros.h"
@@ -185,6 +187,11 @@
 
 #ifdef VOXEL_TESTS
 #include "tests/tests.h"
+#include "util/godot/classes/file_access.h"
+#include "util/godot/core/string.h"
+#include "util/io/log.h"
+#include "util/string/format.h"
+#include "util/testing/benchmark.h"
 #include "util/testing/test_options.h"
 #endif
 
@@ -276,6 +283,8 @@ void initialize_voxel_module(ModuleInitializationLevel p_level) {
 		ClassDB::register_class<VoxelColorPalette>();
 		ClassDB::register_class<VoxelDataBlockEnterInfo>();
 		ClassDB::register_class<VoxelSaveCompletionTracker>();
+		ClassDB::register_class<VoxelSessionRecorder>();
+		ClassDB::register_class<VoxelSessionReplayer>();
 		ClassDB::register_class<pg::VoxelGraphFunction>();
 
 		// Storage
@@ -427,12 +436,32 @@ void initialize_voxel_module(ModuleInitializationLevel p_level) {
 #ifdef VOXEL_TESTS
 		const PackedStringArray command_line_arguments = zylann::godot::get_command_line_arguments();
 		const String tests_cmd = "--run_voxel_tests";
+		const String benchmarks_cmd = "--run_voxel_benchmarks";
 
 		for (int i = 0; i < command_line_arguments.size(); ++i) {
 			const String arg = command_line_arguments[i];
 			if (arg == tests_cmd) {
 				zylann::voxel::tests::run_voxel_tests(zylann::testing::TestOptions());
 				break;
+			} else if (arg == benchmarks_cmd || arg.begins_with(benchmarks_cmd + "=")) {
+				// Benchmarks needing the scene tree are skipped at this point. Godot and benchmarks also print to the
+				// standard output, so JSON results are written to a file, which can be specified after `=`.
+				String json_path = "voxel_benchmarks.json";
+				if (arg != benchmarks_cmd) {
+					json_path = arg.substr(benchmarks_cmd.length() + 1);
+				}
+				StdString json;
+				zylann::voxel::tests::run_voxel_benchmarks(
+						zylann::testing::TestOptions(), zylann::testing::BenchmarkRunner::DEFAULT_ITERATIONS, json
+				);
+				Ref<FileAccess> f = FileAccess::open(json_path, FileAccess::WRITE);
+				if (f.is_valid()) {
+					f->store_string(zylann::godot::to_godot(json));
+					zylann::print_line(zylann::format("Voxel benchmark results written to {}", json_path));
+				} else {
+					ZN_PRINT_ERROR(zylann::format("Failed to write voxel benchmark results to {}", json_path));
+				}
+				break;
 			}
 		}
 #endif
@@ -62,4 +62,8 @@ void LoadAllBlocksDataTask::apply_result() {
 	}
 }
 
+const void *LoadAllBlocksDataTask::get_serial_key() const {
+	return get_io_serial_key(stream_dependency->stream.ptr());
+}
+
 } // namespace zylann::voxel
\ No newline at end of file
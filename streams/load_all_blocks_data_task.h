@@ -20,6 +20,7 @@ public:
 	TaskPriority get_priority() override;
 	bool is_cancelled() override;
 	void apply_result() override;
+	const void *get_serial_key() const override;
 
 	VolumeID volume_id;
 	std::shared_ptr<StreamingDependency> stream_dependency;
@@ -184,4 +184,8 @@ void LoadBlockDataTask::apply_result() {
 	}
 }
 
+const void *LoadBlockDataTask::get_serial_key() const {
+	return get_io_serial_key(_stream_dependency->stream.ptr());
+}
+
 } // namespace zylann::voxel
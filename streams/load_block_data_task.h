@@ -37,6 +37,7 @@ public:
 	TaskPriority get_priority() override;
 	bool is_cancelled() override;
 	void apply_result() override;
+	const void *get_serial_key() const override;
 
 	static int debug_get_running_count();
 
@@ -2,16 +2,21 @@
 #include "../../streams/voxel_block_serializer.h"
 #include "../../util/godot/core/array.h"
 #include "../../util/godot/core/string.h"
+#include "../../util/hash_funcs.h"
 #include "../../util/io/log.h"
 #include "../../util/profiling.h"
 #include "../../util/string/format.h"
 #include "file_utils.h"
 #include <algorithm>
+#include <cstring>
 
 namespace zylann::voxel {
 
 namespace {
 const uint8_t FORMAT_VERSION = 3;
+// Version 4 is like 3, but several blocks may share the same sectors. It is only used by files containing such blocks,
+// so that builds not supporting it don't modify sectors other blocks still reference.
+const uint8_t FORMAT_VERSION_SHARED_SECTORS = 4;
 
 // Version 2 is like 3, but does not include any format information
 const uint8_t FORMAT_VERSION_LEGACY_2 = 2;
@@ -134,8 +139,13 @@ bool load_header(
 	ERR_FAIL_COND_V(strcmp(magic.data(), FORMAT_REGION_MAGIC) != 0, false);
 
 	const uint8_t version = f.get_8();
+	ERR_FAIL_COND_V_MSG(
+			version > FORMAT_VERSION_SHARED_SECTORS,
+			false,
+			String("Region file version {0} is not supported").format(varray(version))
+	);
 
-	if (version == FORMAT_VERSION) {
+	if (version >= FORMAT_VERSION) {
 		out_format.block_size_po2 = f.get_8();
 
 		out_format.region_size.x = f.get_8();
@@ -271,14 +281,26 @@ Error RegionFile::open(const String &fpath, bool create_if_not_found) {
 	);
 
 	CRASH_COND(_sectors.size() != 0);
+	_has_shared_sectors = false;
 	for (unsigned int i = 0; i < blocks_sorted_by_offset.size(); ++i) {
 		const BlockInfoAndIndex b = blocks_sorted_by_offset[i];
+		if (i > 0 && blocks_sorted_by_offset[i - 1].b.get_sector_index() == b.b.get_sector_index()) {
+			// Deduplicated block, its sectors were already listed
+			_has_shared_sectors = true;
+			continue;
+		}
 		Vector3i bpos = get_block_position_from_index(b.i);
 		for (unsigned int j = 0; j < b.b.get_sector_count(); ++j) {
 			_sectors.push_back(bpos);
 		}
 	}
 
+	if (_has_shared_sectors && _header.version == FORMAT_VERSION) {
+		// Make sure builds that don't support shared sectors won't modify this file
+		_header.version = FORMAT_VERSION_SHARED_SECTORS;
+		_header_modified = true;
+	}
+
 #ifdef DEBUG_ENABLED
 	debug_check();
 #endif
@@ -300,6 +322,9 @@ Error RegionFile::close() {
 		_file_access.unref();
 	}
 	_sectors.clear();
+	_has_shared_sectors = false;
+	_content_index.clear();
+	_content_index_built = false;
 	return err;
 }
 
@@ -385,7 +410,7 @@ Error RegionFile::save_block(Vector3i position, VoxelBuffer &block) {
 	FileAccess &f = **_file_access;
 
 	// We should be allowed to migrate before write operations
-	if (_header.version != FORMAT_VERSION) {
+	if (_header.version < FORMAT_VERSION) {
 		ERR_FAIL_COND_V(migrate_to_latest(f) == false, ERR_UNAVAILABLE);
 	}
 
@@ -393,6 +418,46 @@ Error RegionFile::save_block(Vector3i position, VoxelBuffer &block) {
 	ERR_FAIL_COND_V(lut_index >= _header.blocks.size(), ERR_INVALID_PARAMETER);
 	RegionBlockInfo &block_info = _header.blocks[lut_index];
 
+	BlockSerializer::SerializeResult res = BlockSerializer::serialize_and_compress(block);
+	ERR_FAIL_COND_V(!res.success, ERR_INVALID_PARAMETER);
+	const StdVector<uint8_t> &data = res.data;
+	const size_t written_size = sizeof(uint32_t) + data.size();
+
+	uint64_t data_hash = 0;
+	if (_deduplication_enabled) {
+		data_hash = hash_fnv1a_64(data.data(), data.size());
+		const int other_index = find_block_with_same_data(data_hash, to_span(data));
+
+		if (other_index != -1) {
+			if (_header.blocks[other_index].data == block_info.data) {
+				// Already pointing at identical data
+				return OK;
+			}
+
+			// Release sectors the block was using
+			if (block_info.data != 0) {
+				if (get_sector_reference_count(block_info) > 1) {
+					block_info.data = 0;
+				} else {
+					// Note, this can move sectors of the other block, so its info must be read after this
+					remove_sectors_from_block(position, block_info.get_sector_count());
+				}
+			}
+
+			block_info = _header.blocks[other_index];
+			_has_shared_sectors = true;
+			_header.version = FORMAT_VERSION_SHARED_SECTORS;
+			_header_modified = true;
+			return OK;
+		}
+	}
+
+	if (block_info.data != 0 && get_sector_reference_count(block_info) > 1) {
+		// Sectors are shared with other blocks so they must be left untouched. New data will be appended instead.
+		block_info.data = 0;
+		_header_modified = true;
+	}
+
 	if (block_info.data == 0) {
 		// The block isn't in the file yet, append at the end
 
@@ -402,17 +467,14 @@ Error RegionFile::save_block(Vector3i position, VoxelBuffer &block) {
 		// Check position matches the sectors rule
 		CRASH_COND((block_offset - _blocks_begin_offset) % _header.format.sector_size != 0);
 
-		BlockSerializer::SerializeResult res = BlockSerializer::serialize_and_compress(block);
-		ERR_FAIL_COND_V(!res.success, ERR_INVALID_PARAMETER);
-		f.store_32(res.data.size());
-		const unsigned int written_size = sizeof(uint32_t) + res.data.size();
-		zylann::godot::store_buffer(f, to_span(res.data));
+		f.store_32(data.size());
+		zylann::godot::store_buffer(f, to_span(data));
 
 		const unsigned int end_pos = f.get_position();
 		CRASH_COND_MSG(
 				written_size != (end_pos - block_offset),
 				String("written_size: {0}, block_offset: {1}, end_pos: {2}")
-						.format(varray(written_size, block_offset, end_pos))
+						.format(varray(static_cast<int64_t>(written_size), block_offset, end_pos))
 		);
 		pad_to_sector_size(f);
 
@@ -434,11 +496,6 @@ Error RegionFile::save_block(Vector3i position, VoxelBuffer &block) {
 		const int old_sector_count = block_info.get_sector_count();
 		CRASH_COND(old_sector_count < 1);
 
-		BlockSerializer::SerializeResult res = BlockSerializer::serialize_and_compress(block);
-		ERR_FAIL_COND_V(!res.success, ERR_INVALID_PARAMETER);
-		const StdVector<uint8_t> &data = res.data;
-		const size_t written_size = sizeof(uint32_t) + data.size();
-
 		const int new_sector_count = get_sector_count_from_bytes(written_size);
 		CRASH_COND(new_sector_count < 1);
 
@@ -491,9 +548,129 @@ Error RegionFile::save_block(Vector3i position, VoxelBuffer &block) {
 		block_info.set_sector_count(new_sector_count);
 	}
 
+	if (_deduplication_enabled) {
+		_content_index[data_hash] = lut_index;
+	}
+
 	return OK;
 }
 
+void RegionFile::set_deduplication_enabled(bool enabled) {
+	_deduplication_enabled = enabled;
+	if (!enabled) {
+		_content_index.clear();
+		_content_index_built = false;
+	}
+}
+
+unsigned int RegionFile::get_sector_reference_count(const RegionBlockInfo block_info) const {
+	if (!_has_shared_sectors) {
+		return block_info.data != 0 ? 1 : 0;
+	}
+	unsigned int count = 0;
+	for (const RegionBlockInfo &b : _header.blocks) {
+		if (b.data != 0 && b.get_sector_index() == block_info.get_sector_index()) {
+			++count;
+		}
+	}
+	return count;
+}
+
+bool RegionFile::read_stored_block_data(const RegionBlockInfo block_info, StdVector<uint8_t> &out_data) {
+	ZN_ASSERT_RETURN_V(_file_access.is_valid(), false);
+	ZN_ASSERT_RETURN_V(block_info.data != 0, false);
+	FileAccess &f = **_file_access;
+
+	f.seek(_blocks_begin_offset + block_info.get_sector_index() * _header.format.sector_size);
+	const uint32_t size = f.get_32();
+	ZN_ASSERT_RETURN_V(size <= block_info.get_sector_count() * _header.format.sector_size, false);
+
+	out_data.resize(size);
+	return zylann::godot::get_buffer(f, to_span(out_data)) == size;
+}
+
+bool RegionFile::stored_block_data_equals(const RegionBlockInfo block_info, Span<const uint8_t> data) {
+	if (block_info.data == 0) {
+		return false;
+	}
+	// Only the size of the block is needed to rule out most mismatches
+	FileAccess &f = **_file_access;
+	f.seek(_blocks_begin_offset + block_info.get_sector_index() * _header.format.sector_size);
+	if (f.get_32() != data.size()) {
+		return false;
+	}
+
+	static thread_local StdVector<uint8_t> tls_stored_data;
+	if (!read_stored_block_data(block_info, tls_stored_data)) {
+		return false;
+	}
+	return memcmp(tls_stored_data.data(), data.data(), data.size()) == 0;
+}
+
+void RegionFile::build_content_index() {
+	ZN_PROFILE_SCOPE();
+
+	_content_index.clear();
+
+	StdVector<uint8_t> stored_data;
+
+	for (unsigned int lut_index = 0; lut_index < _header.blocks.size(); ++lut_index) {
+		const RegionBlockInfo block_info = _header.blocks[lut_index];
+		if (block_info.data == 0) {
+			continue;
+		}
+		if (!read_stored_block_data(block_info, stored_data)) {
+			ZN_PRINT_ERROR(format("Could not read block {} in {}", lut_index, _file_path));
+			continue;
+		}
+		const uint64_t hash = hash_fnv1a_64(stored_data.data(), stored_data.size());
+		// Blocks sharing the same sectors have the same hash, one of them is enough
+		_content_index.insert({ hash, lut_index });
+	}
+
+	_content_index_built = true;
+}
+
+// Returns the index of a block in the header storing exactly the given data, or -1 if not found.
+int RegionFile::find_block_with_same_data(uint64_t hash, Span<const uint8_t> data) {
+	if (!_content_index_built) {
+		build_content_index();
+	}
+
+	auto it = _content_index.find(hash);
+	if (it == _content_index.end()) {
+		return -1;
+	}
+
+	const uint32_t other_lut_index = it->second;
+	ZN_ASSERT_RETURN_V(other_lut_index < _header.blocks.size(), -1);
+
+	// The index may be outdated if that block was modified or removed since
+	if (!stored_block_data_equals(_header.blocks[other_lut_index], data)) {
+		_content_index.erase(it);
+		return -1;
+	}
+
+	return other_lut_index;
+}
+
+RegionFile::DeduplicationStats RegionFile::get_deduplication_stats() const {
+	DeduplicationStats stats;
+
+	StdVector<uint32_t> sector_indices;
+	for (const RegionBlockInfo &b : _header.blocks) {
+		if (b.data != 0) {
+			sector_indices.push_back(b.get_sector_index());
+		}
+	}
+	stats.block_count = sector_indices.size();
+
+	std::sort(sector_indices.begin(), sector_indices.end());
+	stats.stored_block_count = std::unique(sector_indices.begin(), sector_indices.end()) - sector_indices.begin();
+
+	return stats;
+}
+
 void RegionFile::pad_to_sector_size(FileAccess &f) {
 	const int64_t rpos = f.get_position() - _blocks_begin_offset;
 	if (rpos == 0) {
@@ -586,7 +763,7 @@ void RegionFile::remove_sectors_from_block(Vector3i block_pos, unsigned int p_se
 
 bool RegionFile::save_header(FileAccess &f) {
 	// We should be allowed to migrate before write operations.
-	if (_header.version != FORMAT_VERSION) {
+	if (_header.version < FORMAT_VERSION) {
 		ERR_FAIL_COND_V(migrate_to_latest(f) == false, false);
 	}
 	ERR_FAIL_COND_V(!zylann::voxel::save_header(f, _header.version, _header.format, _header.blocks), false);
@@ -636,7 +813,7 @@ bool RegionFile::migrate_to_latest(FileAccess &f) {
 		version = FORMAT_VERSION;
 	}
 
-	if (version != FORMAT_VERSION) {
+	if (version != FORMAT_VERSION && version != FORMAT_VERSION_SHARED_SECTORS) {
 		ERR_PRINT(String("Invalid file version: {0}").format(varray(version)));
 		return false;
 	}
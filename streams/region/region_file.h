@@ -3,6 +3,7 @@
 
 #include "../../storage/voxel_buffer.h"
 #include "../../util/containers/fixed_array.h"
+#include "../../util/containers/std_unordered_map.h"
 #include "../../util/containers/std_vector.h"
 #include "../../util/godot/classes/file_access.h"
 #include "../../util/math/color8.h"
@@ -70,6 +71,9 @@ static_assert(sizeof(RegionBlockInfo) == 4, "Data in this struct must have a con
 // of data in memory.
 // It isn't thread-safe.
 //
+// Several blocks of the header may point to the same sectors, if they were saved with deduplication enabled and had
+// byte-identical data. Such sectors are only moved or removed once no block references them anymore.
+//
 class RegionFile {
 public:
 	RegionFile();
@@ -95,6 +99,21 @@ public:
 
 	bool is_valid_block_position(const Vector3 position) const;
 
+	// When enabled, saving a block whose serialized data is identical to another block of the region will make both
+	// point to the same sectors instead of writing a copy.
+	void set_deduplication_enabled(bool enabled);
+	bool is_deduplication_enabled() const {
+		return _deduplication_enabled;
+	}
+
+	struct DeduplicationStats {
+		unsigned int block_count = 0;
+		// Number of distinct sector ranges holding block data
+		unsigned int stored_block_count = 0;
+	};
+
+	DeduplicationStats get_deduplication_stats() const;
+
 private:
 	bool save_header(FileAccess &f);
 	Error load_header(FileAccess &f);
@@ -105,6 +124,12 @@ private:
 	void pad_to_sector_size(FileAccess &f);
 	void remove_sectors_from_block(Vector3i block_pos, unsigned int p_sector_count);
 
+	unsigned int get_sector_reference_count(const RegionBlockInfo block_info) const;
+	bool stored_block_data_equals(const RegionBlockInfo block_info, Span<const uint8_t> data);
+	bool read_stored_block_data(const RegionBlockInfo block_info, StdVector<uint8_t> &out_data);
+	void build_content_index();
+	int find_block_with_same_data(uint64_t hash, Span<const uint8_t> data);
+
 	bool migrate_to_latest(FileAccess &f);
 	bool migrate_from_v2_to_v3(FileAccess &f, RegionFormat &format);
 
@@ -137,6 +162,14 @@ private:
 	StdVector<Vector3u16> _sectors;
 	uint32_t _blocks_begin_offset;
 	String _file_path;
+
+	// True if at least two blocks of the header point to the same sectors
+	bool _has_shared_sectors = false;
+	bool _deduplication_enabled = false;
+	// Hash of stored block data => index of a block in the header having that data.
+	// Built lazily. Entries may be outdated, so contents are checked when a match is found.
+	StdUnorderedMap<uint64_t, uint32_t> _content_index;
+	bool _content_index_built = false;
 };
 
 } // namespace zylann::voxel
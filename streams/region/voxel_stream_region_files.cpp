@@ -443,6 +443,53 @@ String VoxelStreamRegionFiles::get_region_file_path(const Vector3i &region_pos,
 	return _directory_path.path_join(String("regions/lod{0}/r.{1}.{2}.{3}.{4}").format(a));
 }
 
+bool VoxelStreamRegionFiles::get_region_file_list(
+		const String &directory_path,
+		unsigned int lod_count,
+		StdVector<PositionAndLod> &out_regions
+) {
+	using namespace zylann::godot;
+
+	for (unsigned int lod_index = 0; lod_index < lod_count; ++lod_index) {
+		const String lod_folder = directory_path.path_join("regions").path_join("lod") + String::num_int64(lod_index);
+		const String ext = String(".") + RegionFormat::FILE_EXTENSION;
+
+		Ref<DirAccess> da = open_directory(lod_folder, nullptr);
+		if (da.is_null()) {
+			continue;
+		}
+
+		da->list_dir_begin();
+
+		while (true) {
+			String fname = da->get_next();
+			if (fname == "") {
+				break;
+			}
+			if (da->current_is_dir()) {
+				continue;
+			}
+			if (fname.ends_with(ext)) {
+				PackedStringArray parts = fname.split(".");
+				// r.x.y.z.ext
+				ERR_FAIL_COND_V_MSG(
+						parts.size() < 4, false, String("Found invalid region file: '{0}'").format(varray(fname))
+				);
+				PositionAndLod p;
+				p.position.x = parts[1].to_int();
+				p.position.y = parts[2].to_int();
+				p.position.z = parts[3].to_int();
+				p.lod_index = lod_index;
+				out_regions.push_back(p);
+			}
+		}
+
+		da->list_dir_end();
+	}
+
+	return true;
+}
+
 VoxelStreamRegionFiles::CachedRegion *VoxelStreamRegionFiles::get_region_from_cache(const Vector3i pos, int lod) const {
 	// A linear search might be better than a Map data structure,
 	// because it's unlikely to have more than about 10 regions cached at a time
@@ -489,6 +536,7 @@ VoxelStreamRegionFiles::CachedRegion *VoxelStreamRegionFiles::open_region(
 		format.sector_size = _meta.sector_size;
 
 		cached_region->region.set_format(format);
+		cached_region->region.set_deduplication_enabled(_deduplication_enabled);
 		cached_region->position = region_pos;
 		cached_region->lod = lod;
 	}
@@ -633,56 +681,13 @@ void VoxelStreamRegionFiles::_convert_files(Meta new_meta) {
 		ZN_PRINT_VERBOSE(format("Data backed up as {}", old_dir));
 	}
 
-	struct PositionAndLod {
-		Vector3i position;
-		uint8_t lod_index;
-	};
-
 	ERR_FAIL_COND(old_stream->load_meta() != FILE_OK);
 
 	StdVector<PositionAndLod> old_region_list;
 	Meta old_meta = old_stream->_meta;
 
 	// Get list of all regions from the old stream
-	{
-		for (unsigned int lod_index = 0; lod_index < old_meta.lod_count; ++lod_index) {
-			const String lod_folder =
-					old_stream->_directory_path.path_join("regions").path_join("lod") + String::num_int64(lod_index);
-			const String ext = String(".") + RegionFormat::FILE_EXTENSION;
-
-			Ref<DirAccess> da = open_directory(lod_folder, nullptr);
-			if (da.is_null()) {
-				continue;
-			}
-
-			da->list_dir_begin();
-
-			while (true) {
-				String fname = da->get_next();
-				if (fname == "") {
-					break;
-				}
-				if (da->current_is_dir()) {
-					continue;
-				}
-				if (fname.ends_with(ext)) {
-					PackedStringArray parts = fname.split(".");
-					// r.x.y.z.ext
-					ERR_FAIL_COND_MSG(
-							parts.size() < 4, String("Found invalid region file: '{0}'").format(varray(fname))
-					);
-					PositionAndLod p;
-					p.position.x = parts[1].to_int();
-					p.position.y = parts[2].to_int();
-					p.position.z = parts[3].to_int();
-					p.lod_index = lod_index;
-					old_region_list.push_back(p);
-				}
-			}
-
-			da->list_dir_end();
-		}
-	}
+	ERR_FAIL_COND(!get_region_file_list(old_stream->_directory_path, old_meta.lod_count, old_region_list));
 
 	_meta = new_meta;
 	ERR_FAIL_COND(save_meta() != FILE_OK);
@@ -936,6 +941,55 @@ void VoxelStreamRegionFiles::flush() {
 	}
 }
 
+void VoxelStreamRegionFiles::set_deduplication_enabled(bool enabled) {
+	MutexLock lock(_mutex);
+	_deduplication_enabled = enabled;
+	for (CachedRegion *cr : _region_cache) {
+		cr->region.set_deduplication_enabled(enabled);
+	}
+}
+
+bool VoxelStreamRegionFiles::is_deduplication_enabled() const {
+	MutexLock lock(_mutex);
+	return _deduplication_enabled;
+}
+
+Dictionary VoxelStreamRegionFiles::get_deduplication_stats() {
+	ZN_PROFILE_SCOPE();
+	MutexLock lock(_mutex);
+
+	Dictionary d;
+
+	if (_directory_path.is_empty() || !_meta_loaded) {
+		return d;
+	}
+
+	StdVector<PositionAndLod> region_list;
+	ZN_ASSERT_RETURN_V(get_region_file_list(_directory_path, _meta.lod_count, region_list), d);
+
+	unsigned int block_count = 0;
+	unsigned int stored_block_count = 0;
+
+	for (const PositionAndLod &region_info : region_list) {
+		// Reuse the cache so headers of open regions are up to date
+		const CachedRegion *cached_region = open_region(region_info.position, region_info.lod_index, false);
+		if (cached_region == nullptr) {
+			continue;
+		}
+		const RegionFile::DeduplicationStats stats = cached_region->region.get_deduplication_stats();
+		block_count += stats.block_count;
+		stored_block_count += stats.stored_block_count;
+	}
+
+	d["region_count"] = static_cast<int64_t>(region_list.size());
+	d["block_count"] = block_count;
+	d["stored_block_count"] = stored_block_count;
+	// How many blocks share each stored copy on average. 1 means no deduplication happened.
+	d["ratio"] = stored_block_count > 0 ? static_cast<double>(block_count) / stored_block_count : 1.0;
+
+	return d;
+}
+
 void VoxelStreamRegionFiles::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("set_directory", "directory"), &VoxelStreamRegionFiles::set_directory);
 	ClassDB::bind_method(D_METHOD("get_directory"), &VoxelStreamRegionFiles::get_directory);
@@ -953,7 +1007,19 @@ void VoxelStreamRegionFiles::_bind_methods() {
 
 	ClassDB::bind_method(D_METHOD("convert_files", "new_settings"), &VoxelStreamRegionFiles::convert_files);
 
+	ClassDB::bind_method(
+			D_METHOD("set_deduplication_enabled", "enabled"), &VoxelStreamRegionFiles::set_deduplication_enabled
+	);
+	ClassDB::bind_method(D_METHOD("is_deduplication_enabled"), &VoxelStreamRegionFiles::is_deduplication_enabled);
+
+	ClassDB::bind_method(D_METHOD("get_deduplication_stats"), &VoxelStreamRegionFiles::get_deduplication_stats);
+
 	ADD_PROPERTY(PropertyInfo(Variant::STRING, "directory", PROPERTY_HINT_DIR), "set_directory", "get_directory");
+	ADD_PROPERTY(
+			PropertyInfo(Variant::BOOL, "deduplication_enabled"),
+			"set_deduplication_enabled",
+			"is_deduplication_enabled"
+	);
 
 	ADD_GROUP("Dimensions", "");
 	ADD_PROPERTY(PropertyInfo(Variant::INT, "lod_count"), "set_lod_count", "get_lod_count");
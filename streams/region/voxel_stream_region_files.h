@@ -54,6 +54,13 @@ public:
 
 	void flush() override;
 
+	// When enabled, blocks with byte-identical data within the same region file are stored only once.
+	void set_deduplication_enabled(bool enabled);
+	bool is_deduplication_enabled() const;
+
+	// Flushes open regions, then reports how much voxel data is shared across all region files of the directory.
+	Dictionary get_deduplication_stats();
+
 protected:
 	static void _bind_methods();
 
@@ -93,6 +100,17 @@ private:
 	static bool check_meta(const Meta &meta);
 	void _convert_files(Meta new_meta);
 
+	struct PositionAndLod {
+		Vector3i position;
+		uint8_t lod_index;
+	};
+
+	static bool get_region_file_list(
+			const String &directory_path,
+			unsigned int lod_count,
+			StdVector<PositionAndLod> &out_regions
+	);
+
 	// Orders block requests so those querying the same regions get grouped together
 	struct BlockQueryComparator {
 		VoxelStreamRegionFiles *self = nullptr;
@@ -135,6 +153,7 @@ private:
 	StdVector<CachedRegion *> _region_cache;
 	// TODO Add memory caches to increase capacity.
 	unsigned int _max_open_regions = MIN(8, FOPEN_MAX);
+	bool _deduplication_enabled = false;
 
 	Mutex _mutex;
 };
@@ -169,4 +169,8 @@ void SaveBlockDataTask::apply_result() {
 	}
 }
 
+const void *SaveBlockDataTask::get_serial_key() const {
+	return get_io_serial_key(_stream_dependency->stream.ptr());
+}
+
 } // namespace zylann::voxel
@@ -1,5 +1,6 @@
 #include "connection.h"
 #include "../../thirdparty/sqlite/sqlite3.h"
+#include "../../util/hash_funcs.h"
 #include "../../util/profiling.h"
 #include "../../util/string/format.h"
 
@@ -172,6 +173,30 @@ static void finalize(sqlite3_stmt *&s) {
 	}
 }
 
+// Runs a one-off query expected to return a single row of integers.
+// NULL columns are returned as 0.
+bool exec_single_row_int64(sqlite3 *db, const char *sql, Span<int64_t> out_values) {
+	sqlite3_stmt *statement = nullptr;
+	if (!prepare(db, &statement, sql)) {
+		return false;
+	}
+	bool success = false;
+	const int rc = sqlite3_step(statement);
+	if (rc == SQLITE_ROW) {
+		for (unsigned int i = 0; i < out_values.size(); ++i) {
+			out_values[i] = sqlite3_column_int64(statement, i);
+		}
+		success = true;
+	} else {
+		ZN_PRINT_ERROR(sqlite3_errmsg(db));
+	}
+	finalize(statement);
+	return success;
+}
+
+const char *CREATE_VOXEL_BLOBS_TABLE_SQL =
+		"CREATE TABLE IF NOT EXISTS voxel_blobs (hash INTEGER PRIMARY KEY, refs INTEGER, vb BLOB)";
+
 } // namespace
 
 Connection::Connection() {}
@@ -200,6 +225,8 @@ bool Connection::open(const char *fpath, const BlockLocation::CoordinateFormat p
 	const CoordinateColumnType block_key_column_type = get_coordinate_column_type(preferred_coordinate_format);
 
 	// Create tables if they don't exist.
+	// New databases use the version V1 schema, so they remain readable by older builds. Later versions are only needed
+	// by some features, which migrate the database when they get used (see `VERSION_NEW_DATABASE`).
 	const char *tables[3] = {
 		"CREATE TABLE IF NOT EXISTS meta (version INTEGER, block_size_po2 INTEGER, coordinate_format INTEGER)",
 		"",
@@ -238,22 +265,76 @@ bool Connection::open(const char *fpath, const BlockLocation::CoordinateFormat p
 		return false;
 	}
 
-	// Prepare statements
-	if (!prepare(
-				db,
-				&_update_voxel_block_statement,
-				"INSERT INTO blocks VALUES (:loc, :vb, null) "
-				"ON CONFLICT(loc) DO UPDATE SET vb=excluded.vb"
-		)) {
-		return false;
+	if (version >= VERSION_V2) {
+		rc = sqlite3_exec(db, CREATE_VOXEL_BLOBS_TABLE_SQL, nullptr, nullptr, &error_message);
+		if (rc != SQLITE_OK) {
+			ZN_PRINT_ERROR(format("Failed to create table: {}", error_message));
+			sqlite3_free(error_message);
+			close();
+			return false;
+		}
 	}
-	if (!prepare(db, &_get_voxel_block_statement, "SELECT vb FROM blocks WHERE loc=:loc")) {
-		return false;
+
+	// Prepare statements
+	if (version >= VERSION_V2) {
+		if (!prepare(
+					db,
+					&_update_voxel_block_statement,
+					"INSERT INTO blocks (loc, vb, vb_hash) VALUES (:loc, :vb, :vb_hash) "
+					"ON CONFLICT(loc) DO UPDATE SET vb=excluded.vb, vb_hash=excluded.vb_hash"
+			)) {
+			return false;
+		}
+		// Voxel data is either stored in the block, or referenced by hash
+		if (!prepare(
+					db,
+					&_get_voxel_block_statement,
+					"SELECT COALESCE(blocks.vb, voxel_blobs.vb) FROM blocks "
+					"LEFT JOIN voxel_blobs ON blocks.vb_hash=voxel_blobs.hash WHERE blocks.loc=:loc"
+			)) {
+			return false;
+		}
+		if (!prepare(db, &_get_voxel_block_hash_statement, "SELECT vb_hash FROM blocks WHERE loc=:loc")) {
+			return false;
+		}
+		if (!prepare(db, &_get_voxel_blob_statement, "SELECT vb FROM voxel_blobs WHERE hash=:hash")) {
+			return false;
+		}
+		if (!prepare(db, &_insert_voxel_blob_statement, "INSERT INTO voxel_blobs VALUES (:hash, 1, :vb)")) {
+			return false;
+		}
+		if (!prepare(db, &_add_voxel_blob_ref_statement, "UPDATE voxel_blobs SET refs=refs+1 WHERE hash=:hash")) {
+			return false;
+		}
+		if (!prepare(
+					db, &_remove_voxel_blob_ref_statement, "UPDATE voxel_blobs SET refs=refs-1 WHERE hash=:hash"
+			)) {
+			return false;
+		}
+		if (!prepare(
+					db,
+					&_delete_unreferenced_voxel_blob_statement,
+					"DELETE FROM voxel_blobs WHERE hash=:hash AND refs<=0"
+			)) {
+			return false;
+		}
+	} else {
+		if (!prepare(
+					db,
+					&_update_voxel_block_statement,
+					"INSERT INTO blocks (loc, vb) VALUES (:loc, :vb) "
+					"ON CONFLICT(loc) DO UPDATE SET vb=excluded.vb"
+			)) {
+			return false;
+		}
+		if (!prepare(db, &_get_voxel_block_statement, "SELECT vb FROM blocks WHERE loc=:loc")) {
+			return false;
+		}
 	}
 	if (!prepare(
 				db,
 				&_update_instance_block_statement,
-				"INSERT INTO blocks VALUES (:loc, null, :instances) "
+				"INSERT INTO blocks (loc, instances) VALUES (:loc, :instances) "
 				"ON CONFLICT(loc) DO UPDATE SET instances=excluded.instances"
 		)) {
 		return false;
@@ -275,7 +356,7 @@ bool Connection::open(const char *fpath, const BlockLocation::CoordinateFormat p
 		if (!prepare(db, &_save_meta_statement, "INSERT INTO meta VALUES (:version, :block_size_po2)")) {
 			return false;
 		}
-	} else if (version == VERSION_LATEST) {
+	} else if (version >= VERSION_V1 && version <= VERSION_LATEST) {
 		if (!prepare(
 					db, &_save_meta_statement, "INSERT INTO meta VALUES (:version, :block_size_po2, :coordinate_format)"
 			)) {
@@ -297,8 +378,19 @@ bool Connection::open(const char *fpath, const BlockLocation::CoordinateFormat p
 		)) {
 		return false;
 	}
-	if (!prepare(db, &_load_all_blocks_statement, "SELECT * FROM blocks")) {
-		return false;
+	if (version >= VERSION_V2) {
+		if (!prepare(
+					db,
+					&_load_all_blocks_statement,
+					"SELECT blocks.loc, COALESCE(blocks.vb, voxel_blobs.vb), blocks.instances FROM blocks "
+					"LEFT JOIN voxel_blobs ON blocks.vb_hash=voxel_blobs.hash"
+			)) {
+			return false;
+		}
+	} else {
+		if (!prepare(db, &_load_all_blocks_statement, "SELECT loc, vb, instances FROM blocks")) {
+			return false;
+		}
 	}
 	if (!prepare(db, &_load_all_block_keys_statement, "SELECT loc FROM blocks")) {
 		return false;
@@ -308,7 +400,7 @@ bool Connection::open(const char *fpath, const BlockLocation::CoordinateFormat p
 	Meta meta = load_meta();
 	if (meta.version == -1) {
 		// Setup database
-		meta.version = VERSION_LATEST;
+		meta.version = VERSION_NEW_DATABASE;
 		// Defaults
 		meta.block_size_po2 = constants::DEFAULT_BLOCK_SIZE_PO2;
 		meta.coordinate_format = preferred_coordinate_format;
@@ -363,6 +455,12 @@ void Connection::close() {
 	finalize(_save_channel_statement);
 	finalize(_load_all_blocks_statement);
 	finalize(_load_all_block_keys_statement);
+	finalize(_get_voxel_block_hash_statement);
+	finalize(_get_voxel_blob_statement);
+	finalize(_insert_voxel_blob_statement);
+	finalize(_add_voxel_blob_ref_statement);
+	finalize(_remove_voxel_blob_ref_statement);
+	finalize(_delete_unreferenced_voxel_blob_statement);
 	sqlite3_close(_db);
 	_db = nullptr;
 	_opened_path.clear();
@@ -406,6 +504,22 @@ bool Connection::end_transaction() {
 bool Connection::save_block(const BlockLocation loc, const Span<const uint8_t> block_data, const BlockType type) {
 	ZN_PROFILE_SCOPE();
 
+	if (type == VOXELS && supports_deduplication()) {
+		// The block might have been referencing deduplicated data, which has to be released
+		bool had_hash;
+		uint64_t old_hash;
+		if (!load_voxel_block_hash(loc, had_hash, old_hash)) {
+			return false;
+		}
+		if (!update_voxel_block_row(loc, block_data, nullptr)) {
+			return false;
+		}
+		if (had_hash) {
+			return release_voxel_blob(old_hash);
+		}
+		return true;
+	}
+
 	sqlite3 *db = _db;
 
 	sqlite3_stmt *update_block_statement;
@@ -456,6 +570,262 @@ bool Connection::save_block(const BlockLocation loc, const Span<const uint8_t> b
 	return true;
 }
 
+bool Connection::save_voxel_block_deduplicated(const BlockLocation loc, const Span<const uint8_t> block_data) {
+	ZN_PROFILE_SCOPE();
+	ZN_ASSERT_RETURN_V(supports_deduplication(), false);
+
+	if (block_data.size() == 0) {
+		return save_block(loc, block_data, VOXELS);
+	}
+
+	sqlite3 *db = _db;
+	const uint64_t hash = hash_fnv1a_64(block_data.data(), block_data.size());
+
+	bool had_hash;
+	uint64_t old_hash;
+	if (!load_voxel_block_hash(loc, had_hash, old_hash)) {
+		return false;
+	}
+
+	// Look for existing data with the same hash
+	sqlite3_stmt *get_blob_statement = _get_voxel_blob_statement;
+	int rc = sqlite3_reset(get_blob_statement);
+	if (rc != SQLITE_OK) {
+		ZN_PRINT_ERROR(sqlite3_errmsg(db));
+		return false;
+	}
+	rc = sqlite3_bind_int64(get_blob_statement, 1, static_cast<int64_t>(hash));
+	if (rc != SQLITE_OK) {
+		ZN_PRINT_ERROR(sqlite3_errmsg(db));
+		return false;
+	}
+
+	bool found = false;
+	bool same_contents = false;
+	while (true) {
+		rc = sqlite3_step(get_blob_statement);
+		if (rc == SQLITE_ROW) {
+			found = true;
+			const void *blob = sqlite3_column_blob(get_blob_statement, 0);
+			const size_t blob_size = sqlite3_column_bytes(get_blob_statement, 0);
+			same_contents = blob_size == block_data.size() && memcmp(blob, block_data.data(), blob_size) == 0;
+			continue;
+		}
+		if (rc != SQLITE_DONE) {
+			ZN_PRINT_ERROR(sqlite3_errmsg(db));
+			return false;
+		}
+		break;
+	}
+
+	if (found && !same_contents) {
+		// Hash collision. Extremely unlikely, but we can't share that data, so store it inline instead.
+		ZN_PRINT_VERBOSE(format(
+				"Hash collision when deduplicating block {} lod {}", loc.position, static_cast<int>(loc.lod)
+		));
+		return save_block(loc, block_data, VOXELS);
+	}
+
+	// Acquire the new reference before releasing the old one, in case they are the same
+	sqlite3_stmt *acquire_statement = found ? _add_voxel_blob_ref_statement : _insert_voxel_blob_statement;
+	rc = sqlite3_reset(acquire_statement);
+	if (rc != SQLITE_OK) {
+		ZN_PRINT_ERROR(sqlite3_errmsg(db));
+		return false;
+	}
+	rc = sqlite3_bind_int64(acquire_statement, 1, static_cast<int64_t>(hash));
+	if (rc != SQLITE_OK) {
+		ZN_PRINT_ERROR(sqlite3_errmsg(db));
+		return false;
+	}
+	if (!found) {
+		// We use SQLITE_TRANSIENT so SQLite will make its own copy of the data
+		rc = sqlite3_bind_blob(acquire_statement, 2, block_data.data(), block_data.size(), SQLITE_TRANSIENT);
+		if (rc != SQLITE_OK) {
+			ZN_PRINT_ERROR(sqlite3_errmsg(db));
+			return false;
+		}
+	}
+	rc = sqlite3_step(acquire_statement);
+	if (rc != SQLITE_DONE) {
+		ZN_PRINT_ERROR(sqlite3_errmsg(db));
+		return false;
+	}
+
+	if (!update_voxel_block_row(loc, Span<const uint8_t>(), &hash)) {
+		return false;
+	}
+
+	if (had_hash) {
+		return release_voxel_blob(old_hash);
+	}
+	return true;
+}
+
+bool Connection::load_voxel_block_hash(const BlockLocation loc, bool &out_has_hash, uint64_t &out_hash) {
+	sqlite3 *db = _db;
+	sqlite3_stmt *statement = _get_voxel_block_hash_statement;
+
+	int rc = sqlite3_reset(statement);
+	if (rc != SQLITE_OK) {
+		ZN_PRINT_ERROR(sqlite3_errmsg(db));
+		return false;
+	}
+
+	BindBlockCoordinates block_coordinates_binding;
+	if (!block_coordinates_binding.bind(db, statement, 1, _meta.coordinate_format, loc)) {
+		return false;
+	}
+
+	out_has_hash = false;
+	out_hash = 0;
+
+	while (true) {
+		rc = sqlite3_step(statement);
+		if (rc == SQLITE_ROW) {
+			if (sqlite3_column_type(statement, 0) != SQLITE_NULL) {
+				out_has_hash = true;
+				out_hash = static_cast<uint64_t>(sqlite3_column_int64(statement, 0));
+			}
+			continue;
+		}
+		if (rc != SQLITE_DONE) {
+			ZN_PRINT_ERROR(sqlite3_errmsg(db));
+			return false;
+		}
+		break;
+	}
+
+	return block_coordinates_binding.unbind(db, statement, 1);
+}
+
+bool Connection::release_voxel_blob(const uint64_t hash) {
+	sqlite3 *db = _db;
+
+	// Decrement references, then delete the data if nothing uses it anymore
+	FixedArray<sqlite3_stmt *, 2> statements;
+	statements[0] = _remove_voxel_blob_ref_statement;
+	statements[1] = _delete_unreferenced_voxel_blob_statement;
+
+	for (sqlite3_stmt *statement : statements) {
+		int rc = sqlite3_reset(statement);
+		if (rc != SQLITE_OK) {
+			ZN_PRINT_ERROR(sqlite3_errmsg(db));
+			return false;
+		}
+		rc = sqlite3_bind_int64(statement, 1, static_cast<int64_t>(hash));
+		if (rc != SQLITE_OK) {
+			ZN_PRINT_ERROR(sqlite3_errmsg(db));
+			return false;
+		}
+		rc = sqlite3_step(statement);
+		if (rc != SQLITE_DONE) {
+			ZN_PRINT_ERROR(sqlite3_errmsg(db));
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Writes the voxel columns of a block row (V2+). Either `block_data` is stored inline, or `hash` is not null and
+// references deduplicated data.
+bool Connection::update_voxel_block_row(
+		const BlockLocation loc,
+		Span<const uint8_t> block_data,
+		const uint64_t *hash
+) {
+	sqlite3 *db = _db;
+	sqlite3_stmt *statement = _update_voxel_block_statement;
+
+	int rc = sqlite3_reset(statement);
+	if (rc != SQLITE_OK) {
+		ZN_PRINT_ERROR(sqlite3_errmsg(db));
+		return false;
+	}
+
+	BindBlockCoordinates block_coordinates_binding;
+	if (!block_coordinates_binding.bind(db, statement, 1, _meta.coordinate_format, loc)) {
+		return false;
+	}
+
+	if (block_data.size() == 0) {
+		rc = sqlite3_bind_null(statement, 2);
+	} else {
+		// We use SQLITE_TRANSIENT so SQLite will make its own copy of the data
+		rc = sqlite3_bind_blob(statement, 2, block_data.data(), block_data.size(), SQLITE_TRANSIENT);
+	}
+	if (rc != SQLITE_OK) {
+		ZN_PRINT_ERROR(sqlite3_errmsg(db));
+		return false;
+	}
+
+	if (hash == nullptr) {
+		rc = sqlite3_bind_null(statement, 3);
+	} else {
+		rc = sqlite3_bind_int64(statement, 3, static_cast<int64_t>(*hash));
+	}
+	if (rc != SQLITE_OK) {
+		ZN_PRINT_ERROR(sqlite3_errmsg(db));
+		return false;
+	}
+
+	rc = sqlite3_step(statement);
+	if (rc != SQLITE_DONE) {
+		ZN_PRINT_ERROR(sqlite3_errmsg(db));
+		return false;
+	}
+
+	return block_coordinates_binding.unbind(db, statement, 1);
+}
+
+bool Connection::get_deduplication_stats(DeduplicationStats &out_stats) {
+	ZN_PROFILE_SCOPE();
+	ZN_ASSERT_RETURN_V(is_open(), false);
+
+	FixedArray<int64_t, 3> inline_row;
+	fill(inline_row, int64_t(0));
+	ZN_ASSERT_RETURN_V(
+			exec_single_row_int64(
+					_db, "SELECT COUNT(*), SUM(LENGTH(vb)) FROM blocks WHERE vb IS NOT NULL", to_span(inline_row)
+			),
+			false
+	);
+
+	out_stats = DeduplicationStats();
+	out_stats.inline_block_count = inline_row[0];
+	out_stats.voxel_block_count = inline_row[0];
+	out_stats.logical_bytes = inline_row[1];
+	out_stats.stored_bytes = inline_row[1];
+
+	if (!supports_deduplication()) {
+		return true;
+	}
+
+	FixedArray<int64_t, 1> referencing_row;
+	ZN_ASSERT_RETURN_V(
+			exec_single_row_int64(
+					_db, "SELECT COUNT(*) FROM blocks WHERE vb_hash IS NOT NULL", to_span(referencing_row)
+			),
+			false
+	);
+
+	FixedArray<int64_t, 3> blobs_row;
+	ZN_ASSERT_RETURN_V(
+			exec_single_row_int64(
+					_db, "SELECT COUNT(*), SUM(LENGTH(vb)), SUM(LENGTH(vb) * refs) FROM voxel_blobs", to_span(blobs_row)
+			),
+			false
+	);
+
+	out_stats.voxel_block_count += referencing_row[0];
+	out_stats.unique_blob_count = blobs_row[0];
+	out_stats.stored_bytes += blobs_row[1];
+	out_stats.logical_bytes += blobs_row[2];
+
+	return true;
+}
+
 VoxelStream::ResultCode Connection::load_block(
 		const BlockLocation loc,
 		StdVector<uint8_t> &out_block_data,
@@ -646,7 +1016,7 @@ int Connection::load_version() {
 		rc = sqlite3_step(load_version_statement);
 	} else {
 		// There was no row. This database is probably not setup.
-		return VERSION_LATEST;
+		return VERSION_NEW_DATABASE;
 	}
 
 	if (rc != SQLITE_DONE) {
@@ -680,7 +1050,7 @@ Connection::Meta Connection::load_meta() {
 
 		if (meta.version == VERSION_V0) {
 			meta.coordinate_format = BlockLocation::FORMAT_INT64_X16_Y16_Z16_L16;
-		} else if (meta.version == VERSION_LATEST) {
+		} else if (meta.version >= VERSION_V1 && meta.version <= VERSION_LATEST) {
 			meta.coordinate_format =
 					static_cast<BlockLocation::CoordinateFormat>(sqlite3_column_int(load_meta_statement, 2));
 		} else {
@@ -764,7 +1134,7 @@ void Connection::save_meta(Meta meta) {
 		ERR_PRINT(sqlite3_errmsg(db));
 		return;
 	}
-	if (meta.version == VERSION_LATEST) {
+	if (meta.version >= VERSION_V1) {
 		rc = sqlite3_bind_int(save_meta_statement, 3, meta.coordinate_format);
 		if (rc != SQLITE_OK) {
 			ZN_PRINT_ERROR(sqlite3_errmsg(db));
@@ -865,11 +1235,78 @@ bool Connection::migrate_from_v0_to_v1() {
 	return true;
 }
 
+bool Connection::migrate_from_v1_to_v2() {
+	if (_meta.version == VERSION_V2) {
+		ZN_PRINT_WARNING("Version already matching");
+		return true;
+	}
+	ZN_ASSERT_RETURN_V(_meta.version == VERSION_V1, false);
+
+	// Prepare statements
+	struct Statements {
+		Connection &db;
+		sqlite3_stmt *alter_table = nullptr;
+		sqlite3_stmt *create_table = nullptr;
+		sqlite3_stmt *update_table = nullptr;
+
+		Statements(Connection &p_db) : db(p_db) {}
+
+		~Statements() {
+			finalize(alter_table);
+			finalize(create_table);
+			finalize(update_table);
+		}
+	};
+
+	Statements statements(*this);
+
+	ZN_ASSERT_RETURN_V(prepare(_db, &statements.alter_table, "ALTER TABLE blocks ADD COLUMN vb_hash INTEGER"), false);
+	ZN_ASSERT_RETURN_V(prepare(_db, &statements.update_table, "UPDATE meta SET version = :version"), false);
+
+	// Run
+	{
+		TransactionScope scope(*this);
+
+		int rc = sqlite3_step(statements.alter_table);
+		if (rc != SQLITE_DONE) {
+			ZN_PRINT_ERROR(sqlite3_errmsg(_db));
+			return false;
+		}
+
+		// Preparing after altering the schema, otherwise the statement would be invalidated
+		ZN_ASSERT_RETURN_V(prepare(_db, &statements.create_table, CREATE_VOXEL_BLOBS_TABLE_SQL), false);
+
+		rc = sqlite3_step(statements.create_table);
+		if (rc != SQLITE_DONE) {
+			ZN_PRINT_ERROR(sqlite3_errmsg(_db));
+			return false;
+		}
+
+		rc = sqlite3_bind_int(statements.update_table, 1, VERSION_V2);
+		if (rc != SQLITE_OK) {
+			ZN_PRINT_ERROR(sqlite3_errmsg(_db));
+			return false;
+		}
+
+		rc = sqlite3_step(statements.update_table);
+		if (rc != SQLITE_DONE) {
+			ZN_PRINT_ERROR(sqlite3_errmsg(_db));
+			return false;
+		}
+	}
+
+	_meta.version = VERSION_V2;
+	return true;
+}
+
 bool Connection::migrate_to_next_version() {
 	switch (_meta.version) {
 		case VERSION_V0:
 			return migrate_from_v0_to_v1();
 
+		case VERSION_V1:
+			return migrate_from_v1_to_v2();
+
 		case VERSION_LATEST:
 			ZN_PRINT_WARNING("Version is already latest");
 			break;
@@ -885,11 +1322,20 @@ bool Connection::migrate_to_next_version() {
 void Connection::migrate_to_latest_version() {
 	ZN_ASSERT_RETURN(is_open());
 
+	if (_meta.version == VERSION_LATEST) {
+		return;
+	}
+
 	while (_meta.version != VERSION_LATEST) {
 		const int prev = _meta.version;
 		ZN_ASSERT_RETURN(migrate_to_next_version());
 		ZN_ASSERT_RETURN(prev != _meta.version);
 	}
+
+	// Statements were prepared for the previous version, so reopen to get those of the latest
+	const StdString path = _opened_path;
+	const BlockLocation::CoordinateFormat coordinate_format = _meta.coordinate_format;
+	open(path.c_str(), coordinate_format);
 }
 
 } // namespace zylann::voxel::sqlite
@@ -16,7 +16,11 @@ class Connection {
 public:
 	static constexpr int VERSION_V0 = 0;
 	static constexpr int VERSION_V1 = 1;
-	static constexpr int VERSION_LATEST = VERSION_V1;
+	// Adds content-addressed storage of voxel blocks (`voxel_blobs` table, `vb_hash` column in `blocks`)
+	static constexpr int VERSION_V2 = 2;
+	static constexpr int VERSION_LATEST = VERSION_V2;
+	// Deduplication requires V2, databases are migrated to it only when it gets enabled
+	static constexpr int VERSION_NEW_DATABASE = VERSION_V1;
 
 	struct Meta {
 		int version = -1;
@@ -62,6 +66,29 @@ public:
 
 	bool save_block(const BlockLocation loc, const Span<const uint8_t> block_data, const BlockType type);
 
+	// Saves voxel data by storing it once in a table indexed by a hash of its contents, which the block then
+	// references. Blocks with byte-identical data share the same storage. Requires version V2 or later.
+	bool save_voxel_block_deduplicated(const BlockLocation loc, const Span<const uint8_t> block_data);
+
+	bool supports_deduplication() const {
+		return _meta.version >= VERSION_V2;
+	}
+
+	struct DeduplicationStats {
+		// Blocks having voxel data, whether it is stored inline or referenced
+		uint64_t voxel_block_count = 0;
+		// Blocks storing their voxel data inline (not deduplicated)
+		uint64_t inline_block_count = 0;
+		// Number of distinct pieces of data stored in the content-addressed table
+		uint64_t unique_blob_count = 0;
+		// Total size of voxel data as if every block stored its own copy
+		uint64_t logical_bytes = 0;
+		// Total size of voxel data actually stored
+		uint64_t stored_bytes = 0;
+	};
+
+	bool get_deduplication_stats(DeduplicationStats &out_stats);
+
 	VoxelStream::ResultCode load_block(
 			const BlockLocation loc,
 			StdVector<uint8_t> &out_block_data,
@@ -95,6 +122,11 @@ private:
 	void save_meta(Meta meta);
 	bool migrate_to_next_version();
 	bool migrate_from_v0_to_v1();
+	bool migrate_from_v1_to_v2();
+
+	bool load_voxel_block_hash(const BlockLocation loc, bool &out_has_hash, uint64_t &out_hash);
+	bool release_voxel_blob(const uint64_t hash);
+	bool update_voxel_block_row(const BlockLocation loc, Span<const uint8_t> block_data, const uint64_t *hash);
 
 	StdString _opened_path;
 	Meta _meta;
@@ -112,6 +144,13 @@ private:
 	sqlite3_stmt *_save_channel_statement = nullptr;
 	sqlite3_stmt *_load_all_blocks_statement = nullptr;
 	sqlite3_stmt *_load_all_block_keys_statement = nullptr;
+	// V2+
+	sqlite3_stmt *_get_voxel_block_hash_statement = nullptr;
+	sqlite3_stmt *_get_voxel_blob_statement = nullptr;
+	sqlite3_stmt *_insert_voxel_blob_statement = nullptr;
+	sqlite3_stmt *_add_voxel_blob_ref_statement = nullptr;
+	sqlite3_stmt *_remove_voxel_blob_ref_statement = nullptr;
+	sqlite3_stmt *_delete_unreferenced_voxel_blob_statement = nullptr;
 };
 
 } // namespace zylann::voxel::sqlite
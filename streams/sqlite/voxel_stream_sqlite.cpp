@@ -1,4 +1,5 @@
 #include "voxel_stream_sqlite.h"
+#include "../../util/containers/container_funcs.h"
 #include "../../util/godot/classes/project_settings.h"
 #include "../../util/godot/core/string.h"
 #include "../../util/profiling.h"
@@ -83,6 +84,7 @@ void VoxelStreamSQLite::set_database_path(String path) {
 	}
 	_block_keys_cache.clear();
 	_connection_pool.clear();
+	_database_version = -1;
 
 	_user_specified_connection_path = path;
 	// To support Godot shortcuts like `user://` and `res://` (though the latter won't work on exported builds)
@@ -469,6 +471,8 @@ void VoxelStreamSQLite::flush_cache_to_connection(sqlite::Connection *p_connecti
 	const Box3i coordinate_range = BlockLocation::get_coordinate_range(coordinate_format);
 	const unsigned int lod_count = BlockLocation::get_lod_count(coordinate_format);
 
+	const bool deduplicate = _deduplication_enabled && p_connection->supports_deduplication();
+
 	// TODO Needs better error rollback handling
 	_cache.flush([p_connection,
 #ifdef VOXEL_ENABLE_INSTANCER
@@ -476,7 +480,8 @@ void VoxelStreamSQLite::flush_cache_to_connection(sqlite::Connection *p_connecti
 #endif
 				  &temp_compressed_data,
 				  coordinate_range,
-				  lod_count](VoxelStreamCache::Block &block) {
+				  lod_count,
+				  deduplicate](VoxelStreamCache::Block &block) {
 		ZN_ASSERT_RETURN(validate_range(block.position, block.lod, coordinate_range, lod_count));
 
 		BlockLocation loc;
@@ -490,7 +495,11 @@ void VoxelStreamSQLite::flush_cache_to_connection(sqlite::Connection *p_connecti
 			} else {
 				BlockSerializer::SerializeResult res = BlockSerializer::serialize_and_compress(block.voxels);
 				ERR_FAIL_COND(!res.success);
-				p_connection->save_block(loc, to_span(res.data), sqlite::Connection::VOXELS);
+				if (deduplicate) {
+					p_connection->save_voxel_block_deduplicated(loc, to_span(res.data));
+				} else {
+					p_connection->save_block(loc, to_span(res.data), sqlite::Connection::VOXELS);
+				}
 			}
 		}
 
@@ -525,9 +534,16 @@ VoxelStreamSQLite::ConnectionResult VoxelStreamSQLite::get_connection() {
 			ZN_PRINT_WARNING_ONCE("The database path hasn't been set.")
 			return { nullptr, ConnectionResult::NOT_CONFIGURED };
 		}
-		if (_connection_pool.size() != 0) {
+		while (_connection_pool.size() != 0) {
 			sqlite::Connection *existing_connection = _connection_pool.back();
 			_connection_pool.pop_back();
+			if (existing_connection->get_meta().version < _database_version ||
+				(_deduplication_enabled && !existing_connection->supports_deduplication())) {
+				// The database was migrated after this connection was opened, so its statements are outdated. Or it
+				// has to be migrated, which happens when opening a new connection.
+				delete existing_connection;
+				continue;
+			}
 			return { existing_connection, ConnectionResult::SUCCESS };
 		}
 		// First connection we get since we set the database path
@@ -544,6 +560,43 @@ VoxelStreamSQLite::ConnectionResult VoxelStreamSQLite::get_connection() {
 		delete con;
 		return { nullptr, ConnectionResult::ERROR };
 	}
+	if (_deduplication_enabled && !con->supports_deduplication()) {
+		// Only one connection may migrate the database
+		MutexLock migration_lock(_migration_mutex);
+		// Another connection might have migrated it since this one was opened
+		if (!con->open(fpath.data(), to_internal_coordinate_format(preferred_coordinate_format))) {
+			delete con;
+			return { nullptr, ConnectionResult::ERROR };
+		}
+		if (!con->supports_deduplication()) {
+			ZN_PRINT_VERBOSE(format(
+					"Migrating database {} from version {} to {} in order to support deduplication",
+					fpath,
+					con->get_meta().version,
+					sqlite::Connection::VERSION_LATEST
+			));
+			con->migrate_to_latest_version();
+			if (!con->is_open()) {
+				delete con;
+				return { nullptr, ConnectionResult::ERROR };
+			}
+		}
+	}
+	{
+		MutexLock mlock(_connection_mutex);
+		if (con->get_meta().version > _database_version) {
+			_database_version = con->get_meta().version;
+			// Connections opened before a migration must not be used anymore
+			const int database_version = _database_version;
+			unordered_remove_if(_connection_pool, [database_version](sqlite::Connection *pooled_connection) {
+				if (pooled_connection->get_meta().version < database_version) {
+					delete pooled_connection;
+					return true;
+				}
+				return false;
+			});
+		}
+	}
 	if (_block_keys_cache_enabled) {
 		RWLockWrite wlock(_block_keys_cache.rw_lock);
 		con->load_all_block_keys(&_block_keys_cache, [](void *ctx, BlockLocation loc) {
@@ -559,7 +612,7 @@ void VoxelStreamSQLite::recycle_connection(sqlite::Connection *con) {
 	// Put back in the pool if the connection path didn't change
 	{
 		MutexLock mlock(_connection_mutex);
-		if (_globalized_connection_path == con_path) {
+		if (_globalized_connection_path == con_path && con->get_meta().version >= _database_version) {
 			_connection_pool.push_back(con);
 			return;
 		}
@@ -575,6 +628,45 @@ bool VoxelStreamSQLite::is_key_cache_enabled() const {
 	return _block_keys_cache_enabled;
 }
 
+void VoxelStreamSQLite::set_deduplication_enabled(bool enabled) {
+	_deduplication_enabled = enabled;
+}
+
+bool VoxelStreamSQLite::is_deduplication_enabled() const {
+	return _deduplication_enabled;
+}
+
+Dictionary VoxelStreamSQLite::get_deduplication_stats() {
+	ZN_PROFILE_SCOPE();
+
+	Dictionary d;
+
+	const ConnectionResult con_res = get_connection();
+	if (con_res.code != ConnectionResult::SUCCESS) {
+		return d;
+	}
+	sqlite::Connection *con = con_res.connection;
+	const ScopeRecycle con_scope(this, con);
+
+	// Stats are computed from the database, so pending saves must be written first
+	flush_cache_to_connection(con);
+
+	sqlite::Connection::DeduplicationStats stats;
+	ZN_ASSERT_RETURN_V(con->get_deduplication_stats(stats), d);
+
+	const uint64_t stored_block_count = stats.inline_block_count + stats.unique_blob_count;
+
+	d["voxel_block_count"] = static_cast<int64_t>(stats.voxel_block_count);
+	d["inline_block_count"] = static_cast<int64_t>(stats.inline_block_count);
+	d["unique_blob_count"] = static_cast<int64_t>(stats.unique_blob_count);
+	d["logical_bytes"] = static_cast<int64_t>(stats.logical_bytes);
+	d["stored_bytes"] = static_cast<int64_t>(stats.stored_bytes);
+	// How many blocks share each stored copy on average. 1 means no deduplication happened.
+	d["ratio"] = stored_block_count > 0 ? static_cast<double>(stats.voxel_block_count) / stored_block_count : 1.0;
+
+	return d;
+}
+
 Box3i VoxelStreamSQLite::get_supported_block_range() const {
 	// const Connection *con = get_connection();
 	// const CoordinateFormat format = con != nullptr ? con->get_meta().coordinate_format :
@@ -665,6 +757,13 @@ void VoxelStreamSQLite::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("set_key_cache_enabled", "enabled"), &VoxelStreamSQLite::set_key_cache_enabled);
 	ClassDB::bind_method(D_METHOD("is_key_cache_enabled"), &VoxelStreamSQLite::is_key_cache_enabled);
 
+	ClassDB::bind_method(
+			D_METHOD("set_deduplication_enabled", "enabled"), &VoxelStreamSQLite::set_deduplication_enabled
+	);
+	ClassDB::bind_method(D_METHOD("is_deduplication_enabled"), &VoxelStreamSQLite::is_deduplication_enabled);
+
+	ClassDB::bind_method(D_METHOD("get_deduplication_stats"), &VoxelStreamSQLite::get_deduplication_stats);
+
 	ClassDB::bind_method(
 			D_METHOD("set_preferred_coordinate_format", "format"), &VoxelStreamSQLite::set_preferred_coordinate_format
 	);
@@ -692,6 +791,12 @@ void VoxelStreamSQLite::_bind_methods() {
 			"set_preferred_coordinate_format",
 			"get_preferred_coordinate_format"
 	);
+
+	ADD_PROPERTY(
+			PropertyInfo(Variant::BOOL, "deduplication_enabled"),
+			"set_deduplication_enabled",
+			"is_deduplication_enabled"
+	);
 }
 
 } // namespace zylann::voxel
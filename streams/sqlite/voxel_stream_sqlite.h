@@ -3,6 +3,7 @@
 
 #include "../../util/containers/std_unordered_set.h"
 #include "../../util/containers/std_vector.h"
+#include "../../util/godot/core/dictionary.h"
 #include "../../util/string/std_string.h"
 #include "../../util/thread/mutex.h"
 #include "../voxel_block_serializer.h"
@@ -75,6 +76,16 @@ public:
 
 	bool copy_blocks_to_other_sqlite_stream(Ref<VoxelStreamSQLite> dst_stream);
 
+	// When enabled, voxel blocks are stored once per distinct content, keyed by a hash of their serialized bytes,
+	// and referenced by their location. Worlds saving generator output contain many identical blocks (all air, all
+	// stone...), so this can shrink databases considerably.
+	// Databases created with older versions are migrated when opened with this option enabled.
+	void set_deduplication_enabled(bool enabled);
+	bool is_deduplication_enabled() const;
+
+	// Flushes pending saves, then reports how much voxel data is shared in the database.
+	Dictionary get_deduplication_stats();
+
 private:
 	void rebuild_key_cache();
 
@@ -163,6 +174,11 @@ private:
 	StdString _globalized_connection_path;
 	StdVector<sqlite::Connection *> _connection_pool;
 	Mutex _connection_mutex;
+	// Latest schema version a connection opened the database with. Connections with an older version were opened
+	// before a migration and get discarded. Protected by `_connection_mutex`.
+	int _database_version = -1;
+	// Held while migrating the database to a newer version
+	Mutex _migration_mutex;
 	// This cache stores blocks in memory, and gets flushed to the database when big enough.
 	// This is because save queries are more expensive.
 	// It also speeds up queries of blocks that were recently saved.
@@ -175,6 +191,7 @@ private:
 	// such a cache can become quite large. In this case we could either allow turning it off, or use an octree.
 	BlockKeysCache _block_keys_cache;
 	bool _block_keys_cache_enabled = false;
+	bool _deduplication_enabled = false;
 	// Format that will be used when creating new databases. May not necessarily match the format actually used by
 	// existing databases.
 	CoordinateFormat _preferred_coordinate_format = COORDINATE_FORMAT_STRING_CSD;
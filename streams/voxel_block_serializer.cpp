@@ -696,6 +696,307 @@ bool deserialize(Span<const uint8_t> p_data, VoxelBuffer &out_voxel_buffer) {
 	return true;
 }
 
+// Delta encoding
+
+namespace {
+
+// Each run of changed voxels starts with its first index and its length
+const unsigned int DELTA_RUN_HEADER_SIZE = 2 * sizeof(uint32_t);
+
+enum DeltaMetadataFlags { //
+	DELTA_BLOCK_METADATA_CHANGED = 1
+};
+
+template <typename T>
+void fill_uniform_channel_bytes(StdVector<uint8_t> &dst, size_t volume, uint64_t value) {
+	dst.resize(volume * sizeof(T));
+	const T v = static_cast<T>(value);
+	T *ptr = reinterpret_cast<T *>(dst.data());
+	for (size_t i = 0; i < volume; ++i) {
+		ptr[i] = v;
+	}
+}
+
+// Gets the raw bytes of a channel. Uniform channels are expanded into `tmp`, so the result can be compared byte-wise
+// regardless of compression.
+Span<const uint8_t> get_channel_bytes_expanded(
+		const VoxelBuffer &buffer,
+		unsigned int channel_index,
+		StdVector<uint8_t> &tmp
+) {
+	Span<const uint8_t> bytes;
+	if (buffer.get_channel_as_bytes_read_only(channel_index, bytes)) {
+		return bytes;
+	}
+	const size_t volume = Vector3iUtil::get_volume_u64(buffer.get_size());
+	const uint64_t value = buffer.get_voxel(Vector3i(), channel_index);
+	switch (buffer.get_channel_depth(channel_index)) {
+		case VoxelBuffer::DEPTH_8_BIT:
+			fill_uniform_channel_bytes<uint8_t>(tmp, volume, value);
+			break;
+		case VoxelBuffer::DEPTH_16_BIT:
+			fill_uniform_channel_bytes<uint16_t>(tmp, volume, value);
+			break;
+		case VoxelBuffer::DEPTH_32_BIT:
+			fill_uniform_channel_bytes<uint32_t>(tmp, volume, value);
+			break;
+		case VoxelBuffer::DEPTH_64_BIT:
+			fill_uniform_channel_bytes<uint64_t>(tmp, volume, value);
+			break;
+		default:
+			ZN_PRINT_ERROR("Unhandled depth");
+			tmp.clear();
+			break;
+	}
+	return to_span_const(tmp);
+}
+
+bool append_metadata(const VoxelMetadata &meta, StdVector<uint8_t> &dst) {
+	const size_t size = get_metadata_size_in_bytes(meta);
+	ZN_ASSERT_RETURN_V(size > 0, false);
+	const size_t pos = dst.size();
+	dst.resize(pos + size);
+	ByteSpanWithPosition bs(to_span(dst), pos);
+	MemoryWriterExistingBuffer mw(bs, ENDIANNESS_LITTLE_ENDIAN);
+	serialize_metadata(meta, mw);
+	return true;
+}
+
+struct DeltaRun {
+	uint32_t begin;
+	uint32_t count;
+};
+
+// Finds runs of voxels that differ between two channels. Runs separated by a small number of unchanged voxels are
+// merged, since storing these voxels is cheaper than starting a new run.
+void find_changed_runs(
+		Span<const uint8_t> previous,
+		Span<const uint8_t> current,
+		const unsigned int voxel_size,
+		StdVector<DeltaRun> &out_runs
+) {
+	const uint32_t volume = current.size() / voxel_size;
+	const uint32_t max_gap = math::max(DELTA_RUN_HEADER_SIZE / voxel_size, 1u);
+
+	uint32_t i = 0;
+	while (i < volume) {
+		if (memcmp(&previous[i * voxel_size], &current[i * voxel_size], voxel_size) == 0) {
+			++i;
+			continue;
+		}
+		DeltaRun run;
+		run.begin = i;
+		uint32_t end = i + 1;
+		uint32_t gap = 0;
+		for (i = i + 1; i < volume; ++i) {
+			if (memcmp(&previous[i * voxel_size], &current[i * voxel_size], voxel_size) != 0) {
+				end = i + 1;
+				gap = 0;
+			} else {
+				++gap;
+				if (gap > max_gap) {
+					break;
+				}
+			}
+		}
+		run.count = end - run.begin;
+		out_runs.push_back(run);
+	}
+}
+
+} // namespace
+
+bool serialize_delta(const VoxelBuffer &previous, const VoxelBuffer &current, StdVector<uint8_t> &out_data) {
+	ZN_PROFILE_SCOPE();
+
+	if (previous.get_size() != current.get_size()) {
+		return false;
+	}
+	for (unsigned int channel_index = 0; channel_index < VoxelBuffer::MAX_CHANNELS; ++channel_index) {
+		if (previous.get_channel_depth(channel_index) != current.get_channel_depth(channel_index)) {
+			return false;
+		}
+	}
+
+	out_data.clear();
+	MemoryWriter mw(out_data, ENDIANNESS_LITTLE_ENDIAN);
+
+	// Changed channels mask, written once we know it
+	mw.store_8(0);
+	uint8_t changed_channels_mask = 0;
+
+	static thread_local StdVector<uint8_t> tls_previous_tmp;
+	static thread_local StdVector<uint8_t> tls_current_tmp;
+	static thread_local StdVector<DeltaRun> tls_runs;
+
+	for (unsigned int channel_index = 0; channel_index < VoxelBuffer::MAX_CHANNELS; ++channel_index) {
+		if (previous.get_channel_compression(channel_index) == VoxelBuffer::COMPRESSION_UNIFORM &&
+			current.get_channel_compression(channel_index) == VoxelBuffer::COMPRESSION_UNIFORM &&
+			previous.get_voxel(Vector3i(), channel_index) == current.get_voxel(Vector3i(), channel_index)) {
+			continue;
+		}
+
+		const Span<const uint8_t> previous_bytes =
+				get_channel_bytes_expanded(previous, channel_index, tls_previous_tmp);
+		const Span<const uint8_t> current_bytes = get_channel_bytes_expanded(current, channel_index, tls_current_tmp);
+		ZN_ASSERT_RETURN_V(previous_bytes.size() == current_bytes.size(), false);
+
+		if (memcmp(previous_bytes.data(), current_bytes.data(), current_bytes.size()) == 0) {
+			continue;
+		}
+
+		const unsigned int voxel_size =
+				VoxelBuffer::get_depth_byte_count(current.get_channel_depth(channel_index));
+
+		tls_runs.clear();
+		find_changed_runs(previous_bytes, current_bytes, voxel_size, tls_runs);
+
+		changed_channels_mask |= (1 << channel_index);
+		mw.store_32(tls_runs.size());
+		for (const DeltaRun &run : tls_runs) {
+			mw.store_32(run.begin);
+			mw.store_32(run.count);
+			mw.store_buffer(current_bytes.sub(run.begin * voxel_size, run.count * voxel_size));
+		}
+	}
+
+	out_data[0] = changed_channels_mask;
+
+	// Metadata
+
+	uint8_t metadata_flags = 0;
+	if (!previous.get_block_metadata().equals(current.get_block_metadata())) {
+		metadata_flags |= DELTA_BLOCK_METADATA_CHANGED;
+	}
+	mw.store_8(metadata_flags);
+	if (metadata_flags & DELTA_BLOCK_METADATA_CHANGED) {
+		ZN_ASSERT_RETURN_V(append_metadata(current.get_block_metadata(), out_data), false);
+	}
+
+	const FlatMapMoveOnly<Vector3i, VoxelMetadata> &previous_voxel_metadata = previous.get_voxel_metadata();
+	const FlatMapMoveOnly<Vector3i, VoxelMetadata> &current_voxel_metadata = current.get_voxel_metadata();
+
+	// Removed metadata
+	{
+		const size_t count_pos = out_data.size();
+		mw.store_32(0);
+		uint32_t removed_count = 0;
+		for (FlatMapMoveOnly<Vector3i, VoxelMetadata>::ConstIterator it = previous_voxel_metadata.begin();
+			 it != previous_voxel_metadata.end();
+			 ++it) {
+			if (current_voxel_metadata.find(it->key) == nullptr) {
+				mw.store_16(it->key.x);
+				mw.store_16(it->key.y);
+				mw.store_16(it->key.z);
+				++removed_count;
+			}
+		}
+		ByteSpanWithPosition bs(to_span(out_data), count_pos);
+		MemoryWriterExistingBuffer count_writer(bs, ENDIANNESS_LITTLE_ENDIAN);
+		count_writer.store_32(removed_count);
+	}
+
+	// Added or modified metadata
+	{
+		const size_t count_pos = out_data.size();
+		mw.store_32(0);
+		uint32_t changed_count = 0;
+		for (FlatMapMoveOnly<Vector3i, VoxelMetadata>::ConstIterator it = current_voxel_metadata.begin();
+			 it != current_voxel_metadata.end();
+			 ++it) {
+			const VoxelMetadata *previous_meta = previous_voxel_metadata.find(it->key);
+			if (previous_meta == nullptr || !previous_meta->equals(it->value)) {
+				mw.store_16(it->key.x);
+				mw.store_16(it->key.y);
+				mw.store_16(it->key.z);
+				ZN_ASSERT_RETURN_V(append_metadata(it->value, out_data), false);
+				++changed_count;
+			}
+		}
+		ByteSpanWithPosition bs(to_span(out_data), count_pos);
+		MemoryWriterExistingBuffer count_writer(bs, ENDIANNESS_LITTLE_ENDIAN);
+		count_writer.store_32(changed_count);
+	}
+
+	return true;
+}
+
+bool apply_delta(Span<const uint8_t> p_data, VoxelBuffer &inout_voxel_buffer) {
+	ZN_PROFILE_SCOPE();
+	ZN_ASSERT_RETURN_V(p_data.size() >= 1, false);
+
+	MemoryReader mr(p_data, ENDIANNESS_LITTLE_ENDIAN);
+
+	const uint8_t changed_channels_mask = mr.get_8();
+
+	for (unsigned int channel_index = 0; channel_index < VoxelBuffer::MAX_CHANNELS; ++channel_index) {
+		if ((changed_channels_mask & (1 << channel_index)) == 0) {
+			continue;
+		}
+
+		const unsigned int voxel_size =
+				VoxelBuffer::get_depth_byte_count(inout_voxel_buffer.get_channel_depth(channel_index));
+
+		inout_voxel_buffer.decompress_channel(channel_index);
+		Span<uint8_t> dst_bytes;
+		ZN_ASSERT_RETURN_V(inout_voxel_buffer.get_channel_as_bytes(channel_index, dst_bytes), false);
+
+		ZN_ASSERT_RETURN_V(mr.pos + sizeof(uint32_t) <= mr.data.size(), false);
+		const uint32_t run_count = mr.get_32();
+
+		for (uint32_t run_index = 0; run_index < run_count; ++run_index) {
+			ZN_ASSERT_RETURN_V(mr.pos + DELTA_RUN_HEADER_SIZE <= mr.data.size(), false);
+			const size_t begin = static_cast<size_t>(mr.get_32()) * voxel_size;
+			const size_t size = static_cast<size_t>(mr.get_32()) * voxel_size;
+			ZN_ASSERT_RETURN_V_MSG(begin + size <= dst_bytes.size(), false, "Delta run out of bounds");
+			ZN_ASSERT_RETURN_V(mr.pos + size <= mr.data.size(), false);
+			memcpy(&dst_bytes[begin], &mr.data[mr.pos], size);
+			mr.pos += size;
+		}
+	}
+
+	ZN_ASSERT_RETURN_V(mr.pos < mr.data.size(), false);
+	const uint8_t metadata_flags = mr.get_8();
+
+	if (metadata_flags & DELTA_BLOCK_METADATA_CHANGED) {
+		ZN_ASSERT_RETURN_V(deserialize_metadata(inout_voxel_buffer.get_block_metadata(), mr), false);
+	}
+
+	ZN_ASSERT_RETURN_V(mr.pos + sizeof(uint32_t) <= mr.data.size(), false);
+	const uint32_t removed_count = mr.get_32();
+	for (uint32_t i = 0; i < removed_count; ++i) {
+		ZN_ASSERT_RETURN_V(mr.pos + 3 * sizeof(uint16_t) <= mr.data.size(), false);
+		Vector3i pos;
+		pos.x = mr.get_16();
+		pos.y = mr.get_16();
+		pos.z = mr.get_16();
+		inout_voxel_buffer.erase_voxel_metadata(pos);
+	}
+
+	ZN_ASSERT_RETURN_V(mr.pos + sizeof(uint32_t) <= mr.data.size(), false);
+	const uint32_t changed_count = mr.get_32();
+	for (uint32_t i = 0; i < changed_count; ++i) {
+		ZN_ASSERT_RETURN_V(mr.pos + 3 * sizeof(uint16_t) <= mr.data.size(), false);
+		Vector3i pos;
+		pos.x = mr.get_16();
+		pos.y = mr.get_16();
+		pos.z = mr.get_16();
+		ZN_ASSERT_RETURN_V_MSG(
+				inout_voxel_buffer.is_position_valid(pos),
+				false,
+				format("Invalid voxel metadata position {} for buffer of size {}", pos, inout_voxel_buffer.get_size())
+		);
+		VoxelMetadata meta;
+		ZN_ASSERT_RETURN_V(deserialize_metadata(meta, mr), false);
+		VoxelMetadata *dst_meta = inout_voxel_buffer.get_or_create_voxel_metadata(pos);
+		ZN_ASSERT_RETURN_V(dst_meta != nullptr, false);
+		*dst_meta = std::move(meta);
+	}
+
+	ZN_ASSERT_RETURN_V(mr.pos == mr.data.size(), false);
+	return true;
+}
+
 SerializeResult serialize_and_compress(const VoxelBuffer &voxel_buffer) {
 	ZN_PROFILE_SCOPE();
 
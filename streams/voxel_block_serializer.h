@@ -38,6 +38,14 @@ SerializeResult serialize_and_compress(const VoxelBuffer &voxel_buffer);
 bool decompress_and_deserialize(Span<const uint8_t> p_data, VoxelBuffer &out_voxel_buffer);
 bool decompress_and_deserialize(FileAccess &f, unsigned int size_to_read, VoxelBuffer &out_voxel_buffer);
 
+// Produces the changes needed to turn `previous` into `current`, as runs of modified voxels and metadata changes.
+// This is meant to send small edits to a receiver that already has `previous`. The result is not compressed.
+// Returns false if the buffers can't be compared (different size or channel depths), in which case the whole block
+// has to be serialized instead.
+bool serialize_delta(const VoxelBuffer &previous, const VoxelBuffer &current, StdVector<uint8_t> &out_data);
+// Applies changes produced by `serialize_delta`. The buffer must be equal to the `previous` buffer that was used.
+bool apply_delta(Span<const uint8_t> p_data, VoxelBuffer &inout_voxel_buffer);
+
 // Temporary thread-local buffers for internal use
 StdVector<uint8_t> &get_tls_data();
 StdVector<uint8_t> &get_tls_compressed_data();
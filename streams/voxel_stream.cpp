@@ -55,6 +55,11 @@ void VoxelStream::load_all_blocks(FullLoadingResult &result) {
 	ZN_PRINT_ERROR(format("{} does not support `load_all_blocks`", get_class()));
 }
 
+bool VoxelStream::is_thread_safe() const {
+	// Can be implemented in subclasses
+	return false;
+}
+
 int VoxelStream::get_used_channels_mask() const {
 	return 0;
 }
@@ -25,8 +25,9 @@ class VoxelBuffer;
 }
 
 // Provides access to a source of paged voxel data, which may load and save.
-// This is intended for files, so it may run in a single background thread and gets requests in batches.
-// Must be implemented in a thread-safe way.
+// This is intended for files, so it runs in background I/O threads and gets requests in batches.
+// Must be implemented in a thread-safe way. Unless `is_thread_safe` returns true, the engine won't call loading and
+// saving functions of the same stream from multiple threads at the same time.
 //
 // If you are looking for a more specialized API to generate voxels with more threads, use VoxelGenerator.
 //
@@ -128,6 +129,11 @@ public:
 
 	virtual Box3i get_supported_block_range() const;
 
+	// Tells if loading and saving functions can run efficiently in multiple threads at the same time. If not, I/O
+	// tasks using the stream will run one at a time, while tasks using other streams can still run in parallel.
+	// Streams locking a single file or connection for every request should return false.
+	virtual bool is_thread_safe() const;
+
 	// Should generated blocks be saved immediately? If not, they will be saved only when modified.
 	// If this is enabled, generated blocks will immediately be considered edited and will be saved to the stream.
 	// Warning: this is incompatible with non-destructive workflows such as modifiers.
@@ -158,6 +164,14 @@ private:
 	RWLock _parameters_lock;
 };
 
+// Gets which key I/O tasks using the given stream must be serialized with (see `IThreadedTask::get_serial_key`).
+inline const void *get_io_serial_key(const VoxelStream *stream) {
+	if (stream == nullptr || stream->is_thread_safe()) {
+		return nullptr;
+	}
+	return stream;
+}
+
 } // namespace zylann::voxel
 
 VARIANT_ENUM_CAST(zylann::voxel::VoxelStream::ResultCode);
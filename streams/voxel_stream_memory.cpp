@@ -145,6 +145,11 @@ int VoxelStreamMemory::get_lod_count() const {
 	return _lods.size();
 }
 
+bool VoxelStreamMemory::is_thread_safe() const {
+	// Each LOD has its own lock, which is only held while copying blocks
+	return true;
+}
+
 void VoxelStreamMemory::set_artificial_save_latency_usec(int usec) {
 	ZN_ASSERT_RETURN(usec >= 0);
 	_artificial_save_latency_usec = usec;
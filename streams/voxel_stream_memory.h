@@ -37,6 +37,8 @@ public:
 
 	int get_lod_count() const override;
 
+	bool is_thread_safe() const override;
+
 	void set_artificial_save_latency_usec(int usec);
 	int get_artificial_save_latency_usec() const;
 
@@ -31,6 +31,11 @@ public:
 	// collision, it may be a better idea to use `is_area_editable` and not use mesh blocks
 	bool is_loaded = false;
 
+	// True if the block's mesh is being built or was built from generated voxels only, with a task that also generated
+	// its data blocks. The result doesn't depend on neighbor blocks, so they don't need to trigger an update when they
+	// get generated afterward. Any other update request resets this.
+	bool is_meshed_from_generator = false;
+
 	VoxelMeshBlockVT(const Vector3i bpos, unsigned int size) : VoxelMeshBlock(bpos) {
 		_position_in_voxels = bpos * size;
 	}
@@ -61,6 +66,7 @@ public:
 			GeometryInstance3D::GIMode gi_mode,
 			RenderingServer::ShadowCastingSetting shadow_setting,
 			int render_layers_mask,
+			zylann::godot::DirectMeshInstancePool *mesh_instance_pool,
 			Ref<Mesh> shadow_occluder_mesh
 #ifdef TOOLS_ENABLED
 			,
@@ -87,7 +93,7 @@ public:
 			shadow_occluder.set_mesh(shadow_occluder_mesh);
 		}
 
-		VoxelMeshBlock::set_mesh(mesh, gi_mode, shadow_setting, render_layers_mask);
+		VoxelMeshBlock::set_mesh(mesh, gi_mode, shadow_setting, render_layers_mask, mesh_instance_pool);
 	}
 
 	void drop_mesh() {
@@ -97,6 +103,17 @@ public:
 		VoxelMeshBlock::drop_mesh();
 	}
 
+	void recycle_server_objects(
+			zylann::godot::DirectMeshInstancePool &mesh_instance_pool,
+			zylann::godot::DirectStaticBodyPool &static_body_pool
+	) {
+		// Shadow occluders are rare and use different settings, they are not worth pooling
+		if (shadow_occluder.is_valid()) {
+			shadow_occluder.destroy();
+		}
+		VoxelMeshBlock::recycle_server_objects(mesh_instance_pool, static_body_pool);
+	}
+
 	void set_render_layers_mask(int mask) {
 		if (shadow_occluder.is_valid()) {
 			shadow_occluder.set_render_layers_mask(mask);
@@ -13,6 +13,7 @@
 #include "../../streams/load_block_data_task.h"
 #include "../../streams/save_block_data_task.h"
 #include "../../util/containers/container_funcs.h"
+#include "../../util/containers/std_unordered_set.h"
 #include "../../util/godot/classes/base_material_3d.h" // For property hint in release mode in GDExtension...
 #include "../../util/godot/classes/concave_polygon_shape_3d.h"
 #include "../../util/godot/classes/engine.h"
@@ -32,6 +33,9 @@
 #include "../voxel_data_block_enter_info.h"
 #include "../voxel_save_completion_tracker.h"
 #include "voxel_terrain_multiplayer_synchronizer.h"
+#include <algorithm>
+#include <limits>
+#include <tuple>
 
 #ifdef TOOLS_ENABLED
 #include "../../meshers/transvoxel/voxel_mesher_transvoxel.h"
@@ -59,32 +63,41 @@ VoxelTerrain::VoxelTerrain() {
 	_streaming_dependency = make_shared_instance<StreamingDependency>();
 	_meshing_dependency = make_shared_instance<MeshingDependency>();
 
-	struct ApplyMeshUpdateTask : public ITimeSpreadTask {
+	struct ApplyMeshUpdatesTask : public ITimeSpreadTask {
 		void run(TimeSpreadTaskContext &ctx) override {
 			if (!VoxelEngine::get_singleton().is_volume_valid(volume_id)) {
 				// The node can have been destroyed while this task was still pending
-				ZN_PRINT_VERBOSE("Cancelling ApplyMeshUpdateTask, volume_id is invalid");
+				ZN_PRINT_VERBOSE("Cancelling ApplyMeshUpdatesTask, volume_id is invalid");
 				return;
 			}
-			self->apply_mesh_update(data);
+			if (self->apply_pending_mesh_updates()) {
+				self->_mesh_updates_task_scheduled = false;
+			} else {
+				// Budget exhausted, continue next frame
+				ctx.postpone = true;
+				ctx.stop = true;
+			}
 		}
 		VolumeID volume_id;
 		VoxelTerrain *self = nullptr;
-		VoxelEngine::BlockMeshOutput data;
 	};
 
 	// Mesh updates are spread over frames by scheduling them in a task runner of VoxelEngine,
 	// but instead of using a reception buffer we use a callback,
-	// because this kind of task scheduling would otherwise delay the update by 1 frame
+	// because this kind of task scheduling would otherwise delay the update by 1 frame.
+	// Results are gathered so they can all be applied in one pass, in order of priority.
 	VoxelEngine::VolumeCallbacks callbacks;
 	callbacks.data = this;
 	callbacks.mesh_output_callback = [](void *cb_data, VoxelEngine::BlockMeshOutput &ob) {
 		VoxelTerrain *self = reinterpret_cast<VoxelTerrain *>(cb_data);
-		ApplyMeshUpdateTask *task = ZN_NEW(ApplyMeshUpdateTask);
-		task->volume_id = self->_volume_id;
-		task->self = self;
-		task->data = std::move(ob);
-		VoxelEngine::get_singleton().push_main_thread_time_spread_task(task);
+		self->_pending_mesh_outputs.push_back(std::move(ob));
+		if (!self->_mesh_updates_task_scheduled) {
+			ApplyMeshUpdatesTask *task = ZN_NEW(ApplyMeshUpdatesTask);
+			task->volume_id = self->_volume_id;
+			task->self = self;
+			VoxelEngine::get_singleton().push_main_thread_time_spread_task(task);
+			self->_mesh_updates_task_scheduled = true;
+		}
 	};
 	callbacks.data_output_callback = [](void *cb_data, VoxelEngine::BlockDataOutput &ob) {
 		VoxelTerrain *self = reinterpret_cast<VoxelTerrain *>(cb_data);
@@ -420,6 +433,9 @@ bool VoxelTerrain::is_automatic_loading_enabled() const {
 
 void VoxelTerrain::try_schedule_mesh_update(VoxelMeshBlockVT &mesh_block) {
 	ZN_PROFILE_SCOPE();
+	// Something else than generation wants the mesh to be updated
+	mesh_block.is_meshed_from_generator = false;
+
 	if (mesh_block.is_in_update_list) {
 		// Already in the list
 		return;
@@ -514,6 +530,12 @@ void VoxelTerrain::unview_mesh_block(Vector3i bpos, bool mesh_flag, bool collisi
 void VoxelTerrain::unload_mesh_block(Vector3i bpos) {
 	StdVector<Vector3i> &blocks_pending_update = _blocks_pending_update;
 
+	VoxelMeshBlockVT *block = _mesh_map.get_block(bpos);
+	if (block != nullptr) {
+		// The block will be freed later, give its objects back now while we know the pools are still alive
+		block->recycle_server_objects(_mesh_instance_pool, _static_body_pool);
+	}
+
 	bool was_loaded = false;
 	_mesh_map.remove_block(bpos, [&blocks_pending_update, &was_loaded](const VoxelMeshBlockVT &block) {
 		if (block.is_in_update_list) {
@@ -767,7 +789,7 @@ void VoxelTerrain::post_edit_voxel(Vector3i pos) {
 	post_edit_area(Box3i(pos, Vector3i(1, 1, 1)), true);
 }
 
-void VoxelTerrain::try_schedule_mesh_update_from_data(const Box3i &box_in_voxels) {
+void VoxelTerrain::try_schedule_mesh_update_from_data(const Box3i &box_in_voxels, bool generated) {
 	ZN_PROFILE_SCOPE();
 	if (_mesher.is_null()) {
 		// No mesher, can't do updates
@@ -775,11 +797,15 @@ void VoxelTerrain::try_schedule_mesh_update_from_data(const Box3i &box_in_voxels
 	}
 	// We pad by 1 because neighbor blocks might be affected visually (for example, baked ambient occlusion)
 	const Box3i mesh_box = box_in_voxels.padded(1).downscaled(get_mesh_block_size());
-	mesh_box.for_each_cell([this](Vector3i pos) {
+	mesh_box.for_each_cell([this, generated](Vector3i pos) {
 		VoxelMeshBlockVT *block = _mesh_map.get_block(pos);
 		// There isn't necessarily a mesh block, if the edit happens in a boundary,
 		// or if it is done next to a viewer that doesn't need meshes
 		if (block != nullptr) {
+			if (generated && block->is_meshed_from_generator) {
+				// Voxels from the generator were already used as neighbors
+				return;
+			}
 			try_schedule_mesh_update(*block);
 		}
 	});
@@ -889,6 +915,9 @@ void VoxelTerrain::_notification(int p_what) {
 		case NOTIFICATION_TRANSFORM_CHANGED: {
 			const Transform3D transform = get_global_transform();
 			// VoxelEngine::get_singleton().set_volume_transform(_volume_id, transform);
+			VoxelEngine::get_singleton().get_session_recorder().set_world_to_local_transform(
+					_volume_id, to_transform3f(transform.affine_inverse())
+			);
 
 			if (!is_inside_tree()) {
 				// The transform and other properties can be set by the scene loader,
@@ -934,6 +963,31 @@ void init_sparse_grid_priority_dependency(
 			math::squared(shared_viewers_data->highest_view_distance + 2.f * transformed_block_radius);
 }
 
+VoxelGenerator::BlockTaskParams make_generate_block_task_params(
+		VolumeID volume_id,
+		const std::shared_ptr<StreamingDependency> &stream_dependency,
+		Vector3i block_pos,
+		std::shared_ptr<PriorityDependency::ViewersData> &shared_viewers_data,
+		const Transform3D &volume_transform,
+		const std::shared_ptr<VoxelData> &voxel_data
+) {
+	const unsigned int data_block_size = voxel_data->get_block_size();
+
+	VoxelGenerator::BlockTaskParams params;
+	params.format = voxel_data->get_format();
+	params.volume_id = volume_id;
+	params.block_position = block_pos;
+	params.block_size = data_block_size;
+	params.stream_dependency = stream_dependency;
+	params.data = voxel_data;
+
+	init_sparse_grid_priority_dependency(
+			params.priority_dependency, block_pos, data_block_size, shared_viewers_data, volume_transform
+	);
+
+	return params;
+}
+
 void request_block_load(
 		VolumeID volume_id,
 		std::shared_ptr<StreamingDependency> stream_dependency,
@@ -981,20 +1035,12 @@ void request_block_load(
 		// Directly generate the block without checking the stream
 		ERR_FAIL_COND(stream_dependency->generator.is_null());
 
-		VoxelGenerator::BlockTaskParams params;
-		params.format = voxel_data->get_format();
-		params.volume_id = volume_id;
-		params.block_position = block_pos;
-		params.block_size = data_block_size;
-		params.stream_dependency = stream_dependency;
+		VoxelGenerator::BlockTaskParams params = make_generate_block_task_params(
+				volume_id, stream_dependency, block_pos, shared_viewers_data, volume_transform, voxel_data
+		);
 #ifdef VOXEL_ENABLE_GPU
 		params.use_gpu = use_gpu;
 #endif
-		params.data = voxel_data;
-
-		init_sparse_grid_priority_dependency(
-				params.priority_dependency, block_pos, data_block_size, shared_viewers_data, volume_transform
-		);
 
 		IThreadedTask *task = stream_dependency->generator->create_block_task(params);
 
@@ -1002,18 +1048,210 @@ void request_block_load(
 	}
 }
 
+// Maximum number of blocks stacked along Y that can be generated by a single task
+const unsigned int MAX_GENERATE_BATCH_SIZE = 4;
+
+// Requests generation of blocks directly, without checking the stream. Blocks stacked on top of each other are
+// generated in batches, so the generator can share work between them.
+void request_blocks_generation(
+		VolumeID volume_id,
+		std::shared_ptr<StreamingDependency> stream_dependency,
+		Span<Vector3i> block_positions,
+		std::shared_ptr<PriorityDependency::ViewersData> &shared_viewers_data,
+		const Transform3D volume_transform,
+		BufferedTaskScheduler &scheduler,
+		const std::shared_ptr<VoxelData> &voxel_data
+) {
+	ZN_PROFILE_SCOPE();
+	ZN_ASSERT(stream_dependency != nullptr);
+	Ref<VoxelGenerator> generator = stream_dependency->generator;
+	ERR_FAIL_COND(generator.is_null());
+
+	// Sort so that blocks of the same column end up next to each other, bottom first
+	Vector3i *positions_begin = block_positions.data();
+	std::sort(positions_begin, positions_begin + block_positions.size(), [](const Vector3i &a, const Vector3i &b) {
+		return std::tie(a.x, a.z, a.y) < std::tie(b.x, b.z, b.y);
+	});
+
+	static thread_local StdVector<VoxelGenerator::BlockTaskParams> tls_params;
+
+	unsigned int begin = 0;
+	while (begin < block_positions.size()) {
+		unsigned int end = begin + 1;
+		while (end < block_positions.size() && end - begin < MAX_GENERATE_BATCH_SIZE) {
+			const Vector3i prev = block_positions[end - 1];
+			const Vector3i next = block_positions[end];
+			if (next != prev + Vector3i(0, 1, 0)) {
+				break;
+			}
+			++end;
+		}
+
+		tls_params.clear();
+		for (unsigned int i = begin; i < end; ++i) {
+			tls_params.push_back(make_generate_block_task_params(
+					volume_id, stream_dependency, block_positions[i], shared_viewers_data, volume_transform, voxel_data
+			));
+		}
+
+		IThreadedTask *batch_task = nullptr;
+		if (tls_params.size() > 1) {
+			batch_task = generator->create_block_batch_task(to_span_const(tls_params));
+		}
+
+		if (batch_task != nullptr) {
+			scheduler.push_main_task(batch_task);
+		} else {
+			// Batching not supported
+			for (const VoxelGenerator::BlockTaskParams &params : tls_params) {
+				scheduler.push_main_task(generator->create_block_task(params));
+			}
+		}
+
+		begin = end;
+	}
+
+	// Don't hold on to shared pointers
+	tls_params.clear();
+}
+
 } // namespace
 
+bool VoxelTerrain::can_generate_and_mesh_in_single_task(
+		const VoxelStream *stream,
+		const VoxelGenerator *generator,
+		const VoxelMesher *mesher
+) {
+	// With a stream, blocks have to be loaded first, and only missing ones get generated
+	return stream == nullptr && generator != nullptr && mesher != nullptr && generator->supports_fused_generation();
+}
+
+// When there is no stream, mesh blocks whose data blocks all have to be generated can be generated and meshed by a
+// single task, which also returns the generated data blocks. This saves a round-trip through the main thread and a
+// copy of the voxels, which is significant when a lot of terrain gets streamed in. Blocks handled this way are removed
+// from the list of blocks pending load.
+void VoxelTerrain::send_generate_and_mesh_requests(BufferedTaskScheduler &scheduler) {
+	ZN_PROFILE_SCOPE();
+
+	if (!can_generate_and_mesh_in_single_task(
+				_streaming_dependency->stream.ptr(), _streaming_dependency->generator.ptr(), _mesher.ptr()
+		)) {
+		return;
+	}
+#ifdef VOXEL_ENABLE_GPU
+	if (_generator_use_gpu && _streaming_dependency->generator->supports_shaders()) {
+		return;
+	}
+#endif
+
+	const int mesh_to_data_factor = get_mesh_block_size() / get_data_block_size();
+
+	static thread_local StdUnorderedSet<Vector3i> tls_pending_blocks;
+	// Whether each mesh block was scheduled for generation and meshing
+	static thread_local StdUnorderedMap<Vector3i, bool> tls_mesh_blocks;
+	tls_pending_blocks.clear();
+	tls_mesh_blocks.clear();
+
+	for (const Vector3i bpos : _blocks_pending_load) {
+		tls_pending_blocks.insert(bpos);
+	}
+
+	std::shared_ptr<PriorityDependency::ViewersData> shared_viewers_data =
+			VoxelEngine::get_singleton().get_shared_viewers_data_from_default_world();
+	const Transform3D volume_transform = get_global_transform();
+
+	const auto try_send_request = [this, mesh_to_data_factor, &shared_viewers_data, &volume_transform, &scheduler](
+										  const Vector3i mesh_block_pos
+								  ) {
+		VoxelMeshBlockVT *mesh_block = _mesh_map.get_block(mesh_block_pos);
+		if (mesh_block == nullptr || mesh_block->is_in_update_list) {
+			return false;
+		}
+		if (mesh_block->mesh_viewers.get() == 0 && mesh_block->collision_viewers.get() == 0) {
+			return false;
+		}
+
+		const Box3i central_box(mesh_block_pos * mesh_to_data_factor, Vector3iUtil::create(mesh_to_data_factor));
+		bool all_pending = true;
+		central_box.for_each_cell([this, &all_pending](const Vector3i bpos) {
+			if (tls_pending_blocks.find(bpos) == tls_pending_blocks.end() || _data->has_block(bpos, 0)) {
+				all_pending = false;
+			}
+		});
+		if (!all_pending) {
+			// Some of the voxels already exist, so they could differ from the generator
+			return false;
+		}
+
+		MeshBlockTask *task = ZN_NEW(MeshBlockTask);
+		task->volume_id = _volume_id;
+		task->mesh_block_position = mesh_block_pos;
+		task->lod_index = 0;
+		task->meshing_dependency = _meshing_dependency;
+		task->require_visual = mesh_block->mesh_viewers.get() > 0;
+		task->collision_hint = _generate_collisions && mesh_block->collision_viewers.get() > 0;
+		task->data = _data;
+		task->generated_blocks_dependency = _streaming_dependency;
+
+		// Neighbors that are already loaded are used as they are, missing ones are generated by the task.
+		const Box3i data_box = central_box.padded(1);
+		_data->get_blocks_with_voxel_data(data_box, 0, to_span(task->blocks));
+		task->blocks_count = Vector3iUtil::get_volume_u64(data_box.size);
+
+		init_sparse_grid_priority_dependency(
+				task->priority_dependency,
+				task->mesh_block_position,
+				get_mesh_block_size(),
+				shared_viewers_data,
+				volume_transform
+		);
+
+		scheduler.push_main_task(task);
+
+		mesh_block->is_meshed_from_generator = true;
+		return true;
+	};
+
+	for (size_t i = 0; i < _blocks_pending_load.size();) {
+		const Vector3i mesh_block_pos = math::floordiv(_blocks_pending_load[i], mesh_to_data_factor);
+
+		auto it = tls_mesh_blocks.find(mesh_block_pos);
+		if (it == tls_mesh_blocks.end()) {
+			it = tls_mesh_blocks.insert({ mesh_block_pos, try_send_request(mesh_block_pos) }).first;
+		}
+
+		if (it->second) {
+			// The block will be generated along with its mesh.
+			// It remains in the list of loading blocks, so it can still be cancelled.
+			unordered_remove(_blocks_pending_load, i);
+		} else {
+			++i;
+		}
+	}
+}
+
 void VoxelTerrain::send_data_load_requests() {
 	ZN_PROFILE_SCOPE();
 
 	if (_blocks_pending_load.size() > 0) {
+		BufferedTaskScheduler &scheduler = BufferedTaskScheduler::get_for_current_thread();
+
+		send_generate_and_mesh_requests(scheduler);
+
 		std::shared_ptr<PriorityDependency::ViewersData> shared_viewers_data =
 				VoxelEngine::get_singleton().get_shared_viewers_data_from_default_world();
 
 		const Transform3D volume_transform = get_global_transform();
 
-		BufferedTaskScheduler &scheduler = BufferedTaskScheduler::get_for_current_thread();
+		// Without stream, blocks can be generated in batches
+		bool batch_generation = _streaming_dependency->stream.is_null() && _streaming_dependency->generator.is_valid();
+#ifdef VOXEL_ENABLE_GPU
+		if (_generator_use_gpu && batch_generation && _streaming_dependency->generator->supports_shaders()) {
+			batch_generation = false;
+		}
+#endif
+		static thread_local StdVector<Vector3i> tls_blocks_to_generate;
+		tls_blocks_to_generate.clear();
 
 		// Blocks to load
 		for (size_t i = 0; i < _blocks_pending_load.size(); ++i) {
@@ -1046,6 +1284,9 @@ void VoxelTerrain::send_data_load_requests() {
 				// task would lock the saved regions for reading (which is currently a problem already, because no
 				// locking actually occurs!).
 
+			} else if (batch_generation) {
+				tls_blocks_to_generate.push_back(block_pos);
+
 			} else {
 				request_block_load(
 						_volume_id,
@@ -1059,6 +1300,17 @@ void VoxelTerrain::send_data_load_requests() {
 				);
 			}
 		}
+		if (tls_blocks_to_generate.size() > 0) {
+			request_blocks_generation(
+					_volume_id,
+					_streaming_dependency,
+					to_span(tls_blocks_to_generate),
+					shared_viewers_data,
+					volume_transform,
+					scheduler,
+					_data
+			);
+		}
 		scheduler.flush();
 		_blocks_pending_load.clear();
 	}
@@ -1160,7 +1412,7 @@ void VoxelTerrain::notify_data_block_enter(const VoxelDataBlock &block, Vector3i
 
 	if (_multiplayer_synchronizer != nullptr && !Engine::get_singleton()->is_editor_hint() &&
 		network_peer_id != MultiplayerPeer::TARGET_PEER_SERVER && _multiplayer_synchronizer->is_server()) {
-		_multiplayer_synchronizer->send_block(network_peer_id, block, bpos);
+		_multiplayer_synchronizer->send_block(network_peer_id, bpos);
 	}
 }
 
@@ -1509,6 +1761,17 @@ void VoxelTerrain::process_viewer_data_box_change(
 			);
 		});
 
+		if (_multiplayer_synchronizer != nullptr && _multiplayer_synchronizer->is_server() &&
+			VoxelEngine::get_singleton().viewer_exists(viewer_id)) {
+			// The peer will unload these blocks too, so the server no longer needs to remember what it sent
+			const int network_peer_id = VoxelEngine::get_singleton().get_viewer_network_peer_id(viewer_id);
+			if (network_peer_id != -1 && network_peer_id != MultiplayerPeer::TARGET_PEER_SERVER) {
+				prev_data_box.difference(new_data_box, [this, network_peer_id](Box3i out_of_range_box) {
+					_multiplayer_synchronizer->forget_sent_blocks(network_peer_id, out_of_range_box);
+				});
+			}
+		}
+
 		// Temporarily store unloaded blocks in a map until saving completes
 		for (unsigned int i = to_save_index0; i < _blocks_to_save.size(); ++i) {
 			const VoxelData::BlockToSave &bts = _blocks_to_save[i];
@@ -1741,7 +2004,8 @@ void VoxelTerrain::apply_data_block_response(VoxelEngine::BlockDataOutput &ob) {
 	// TODO Optimize: initial loading can hang for a while here.
 	// Because lots of blocks are loaded at once, which leads to many block queries.
 	try_schedule_mesh_update_from_data(
-			Box3i(_data->block_to_voxel(block_pos), Vector3iUtil::create(get_data_block_size()))
+			Box3i(_data->block_to_voxel(block_pos), Vector3iUtil::create(get_data_block_size())),
+			ob.type == VoxelEngine::BlockDataOutput::TYPE_GENERATED
 	);
 
 	// We might have requested some blocks again (if we got a dropped one while we still need them)
@@ -1924,6 +2188,8 @@ void VoxelTerrain::apply_mesh_update(const VoxelEngine::BlockMeshOutput &ob) {
 		// TODO Not sure what to do in this case, the code sending update queries has to be tweaked
 		ZN_PRINT_VERBOSE("Received a block mesh drop while we were still expecting it");
 		++_stats.dropped_block_meshs;
+		// If it was also generating voxels, they will be requested again separately
+		block->is_meshed_from_generator = false;
 		return;
 	}
 
@@ -2000,6 +2266,7 @@ void VoxelTerrain::apply_mesh_update(const VoxelEngine::BlockMeshOutput &ob) {
 			get_gi_mode(),
 			static_cast<RenderingServer::ShadowCastingSetting>(get_shadow_casting()),
 			get_render_layers_mask(),
+			&_mesh_instance_pool,
 			shadow_occluder_mesh
 #ifdef TOOLS_ENABLED
 			,
@@ -2013,6 +2280,9 @@ void VoxelTerrain::apply_mesh_update(const VoxelEngine::BlockMeshOutput &ob) {
 
 	const bool gen_collisions = _generate_collisions && block->collision_viewers.get() > 0;
 	if (gen_collisions) {
+		MainThreadTimeBudgetScope budget_scope(
+				VoxelEngine::get_singleton().get_main_thread_time_budget(), VoxelEngine::MAIN_THREAD_CATEGORY_COLLISION
+		);
 		Ref<Shape3D> collision_shape = make_collision_shape_from_mesher_output(ob.surfaces, **_mesher);
 
 		bool debug_collisions = false;
@@ -2027,7 +2297,7 @@ void VoxelTerrain::apply_mesh_update(const VoxelEngine::BlockMeshOutput &ob) {
 			debug_collisions = scene_tree->is_debugging_collisions_hint();
 		}
 
-		block->set_collision_shape(collision_shape, debug_collisions, this, _collision_margin);
+		block->set_collision_shape(collision_shape, debug_collisions, this, _collision_margin, &_static_body_pool);
 
 		block->set_collision_layer(_collision_layer);
 		block->set_collision_mask(_collision_mask);
@@ -2047,6 +2317,71 @@ void VoxelTerrain::apply_mesh_update(const VoxelEngine::BlockMeshOutput &ob) {
 	}
 }
 
+// Returns true if all pending updates were applied, false if some remain because the time budget was exhausted
+bool VoxelTerrain::apply_pending_mesh_updates() {
+	ZN_PROFILE_SCOPE();
+
+	StdVector<VoxelEngine::BlockMeshOutput> &outputs = _pending_mesh_outputs;
+	if (outputs.size() == 0) {
+		return true;
+	}
+
+	if (outputs.size() > 1 && _paired_viewers.size() > 0) {
+		// Apply blocks closest to viewers first
+		struct OutputPriority {
+			int64_t distance_squared;
+			uint32_t index;
+
+			inline bool operator<(const OutputPriority &other) const {
+				return distance_squared < other.distance_squared;
+			}
+		};
+
+		StdVector<OutputPriority> priorities;
+		priorities.reserve(outputs.size());
+
+		const int block_size = get_mesh_block_size();
+		const Vector3i half_block_size = Vector3iUtil::create(block_size / 2);
+
+		for (unsigned int i = 0; i < outputs.size(); ++i) {
+			const Vector3i center = outputs[i].position * block_size + half_block_size;
+			int64_t min_distance_squared = std::numeric_limits<int64_t>::max();
+			for (const PairedViewer &viewer : _paired_viewers) {
+				const Vector3i d = center - viewer.state.local_position_voxels;
+				const int64_t distance_squared = int64_t(d.x) * d.x + int64_t(d.y) * d.y + int64_t(d.z) * d.z;
+				min_distance_squared = math::min(min_distance_squared, distance_squared);
+			}
+			priorities.push_back(OutputPriority{ min_distance_squared, i });
+		}
+
+		// Stable, so successive updates of the same block remain in the order they were received
+		std::stable_sort(priorities.begin(), priorities.end());
+
+		StdVector<VoxelEngine::BlockMeshOutput> sorted_outputs;
+		sorted_outputs.reserve(outputs.size());
+		for (const OutputPriority &p : priorities) {
+			sorted_outputs.push_back(std::move(outputs[p.index]));
+		}
+		outputs = std::move(sorted_outputs);
+	}
+
+	const MainThreadTimeBudget &budget = VoxelEngine::get_singleton().get_main_thread_time_budget();
+
+	unsigned int applied_count = 0;
+	for (; applied_count < outputs.size(); ++applied_count) {
+		// Always apply at least one, so updates still progress if the budget is very low
+		if (applied_count > 0 &&
+			(budget.is_category_exhausted(VoxelEngine::MAIN_THREAD_CATEGORY_MESH) ||
+			 budget.is_category_exhausted(VoxelEngine::MAIN_THREAD_CATEGORY_COLLISION))) {
+			break;
+		}
+		apply_mesh_update(outputs[applied_count]);
+	}
+
+	outputs.erase(outputs.begin(), outputs.begin() + applied_count);
+	return outputs.size() == 0;
+}
+
 Ref<VoxelTool> VoxelTerrain::get_voxel_tool() {
 	Ref<VoxelTool> vt = memnew(VoxelToolTerrain(this));
 	const int used_channels_mask = get_used_channels_mask();
@@ -101,6 +101,14 @@ public:
 #ifdef VOXEL_ENABLE_GPU
 	void set_generator_use_gpu(bool enabled);
 	bool get_generator_use_gpu() const;
+
+	// Tells if new chunks can be generated and meshed by the same task, instead of generating their blocks first. GPU
+	// generation is not accounted for.
+	static bool can_generate_and_mesh_in_single_task(
+			const VoxelStream *stream,
+			const VoxelGenerator *generator,
+			const VoxelMesher *mesher
+	);
 #endif
 
 	VoxelData &get_storage() const {
@@ -216,6 +224,7 @@ private:
 	// void process_received_data_blocks();
 	void process_meshing();
 	void apply_mesh_update(const VoxelEngine::BlockMeshOutput &ob);
+	bool apply_pending_mesh_updates();
 	void apply_data_block_response(VoxelEngine::BlockDataOutput &ob);
 
 	void _on_stream_params_changed();
@@ -236,11 +245,12 @@ private:
 	void unload_mesh_block(Vector3i bpos);
 	// void make_data_block_dirty(Vector3i bpos);
 	void try_schedule_mesh_update(VoxelMeshBlockVT &block);
-	void try_schedule_mesh_update_from_data(const Box3i &box_in_voxels);
+	void try_schedule_mesh_update_from_data(const Box3i &box_in_voxels, bool generated = false);
 
 	void save_all_modified_blocks(bool with_copy, std::shared_ptr<AsyncDependencyTracker> tracker);
 	void get_viewer_pos_and_direction(Vector3 &out_pos, Vector3 &out_direction) const;
 	void send_data_load_requests();
+	void send_generate_and_mesh_requests(BufferedTaskScheduler &scheduler);
 	void consume_block_data_save_requests(
 			BufferedTaskScheduler &task_scheduler,
 			std::shared_ptr<AsyncDependencyTracker> saving_tracker,
@@ -347,6 +357,16 @@ private:
 		Vector3i position;
 	};
 	StdVector<QuickReloadingBlock> _quick_reloading_blocks;
+	// Meshing results received from VoxelEngine, applied in one pass per frame by a single time-spread task, closest to
+	// viewers first.
+	StdVector<VoxelEngine::BlockMeshOutput> _pending_mesh_outputs;
+	// True if the task applying `_pending_mesh_outputs` is scheduled
+	bool _mesh_updates_task_scheduled = false;
+
+	// Rendering and physics objects of unloaded blocks, reused by new blocks so we don't free and create them all the
+	// time as viewers move
+	zylann::godot::DirectMeshInstancePool _mesh_instance_pool;
+	zylann::godot::DirectStaticBodyPool _static_body_pool;
 
 	Ref<VoxelMesher> _mesher;
 
@@ -1,6 +1,8 @@
 #include "voxel_terrain_multiplayer_synchronizer.h"
 #include "../../constants/voxel_string_names.h"
 #include "../../storage/voxel_buffer.h"
+#include "../../storage/voxel_data.h"
+#include "../../streams/compressed_data.h"
 #include "../../streams/voxel_block_serializer.h"
 #include "../../util/containers/container_funcs.h"
 #include "../../util/godot/classes/multiplayer_api.h"
@@ -8,10 +10,14 @@
 #include "../../util/godot/classes/scene_tree.h"
 #include "../../util/godot/core/array.h"
 #include "../../util/io/serialization.h"
+#include "../../util/math/funcs.h"
 #include "../../util/profiling.h"
 #include "../../util/string/format.h"
+#include "../../util/thread/spatial_lock_3d.h"
 #include "voxel_terrain.h"
 
+#include <algorithm>
+
 #ifdef TOOLS_ENABLED
 #include "../../util/godot/core/packed_arrays.h"
 #include "../../util/godot/core/string.h"
@@ -45,35 +51,26 @@ bool VoxelTerrainMultiplayerSynchronizer::is_server() const {
 	return mp->is_server();
 }
 
-void VoxelTerrainMultiplayerSynchronizer::send_block(
-		int viewer_peer_id,
-		const VoxelDataBlock &data_block,
-		Vector3i bpos
-) {
-	ZN_PROFILE_SCOPE();
-
-	BlockSerializer::SerializeResult result = BlockSerializer::serialize_and_compress(data_block.get_voxels_const());
-	ZN_ASSERT_RETURN(result.success);
+namespace {
 
-	PackedByteArray message_data;
-	message_data.resize(4 * sizeof(int16_t) + result.data.size());
+enum BlockMessageType : uint8_t {
+	// Full serialized and compressed block
+	BLOCK_MESSAGE_FULL = 0,
+	// Compressed changes to apply to the block the receiver already has
+	BLOCK_MESSAGE_DELTA = 1
+};
 
-	ByteSpanWithPosition mw_span(Span<uint8_t>(message_data.ptrw(), message_data.size()), 0);
-	MemoryWriterExistingBuffer mw(mw_span, ENDIANNESS_LITTLE_ENDIAN);
+const unsigned int BLOCK_MESSAGE_HEADER_SIZE = 3 * sizeof(int16_t) + sizeof(uint8_t) + sizeof(uint32_t);
 
-	mw.store_16(bpos.x);
-	mw.store_16(bpos.y);
-	mw.store_16(bpos.z);
-	ZN_ASSERT_RETURN(result.data.size() <= 65535);
-	mw.store_16(result.data.size());
-	mw.store_buffer(to_span(result.data));
+} // namespace
 
+void VoxelTerrainMultiplayerSynchronizer::send_block(int viewer_peer_id, Vector3i bpos) {
 	// print_line(String("Server: send block {0}").format(varray(bpos)));
 
-	// rpc_id(viewer_peer_id, VoxelStringNames::get_singleton().receive_block, data);
-	// Instead of sending it right away, defer it until the terrain finished processing. Sending individual blocks with
-	// the RPC system is too slow.
-	_deferred_block_messages_per_peer[viewer_peer_id].push_back(DeferredBlockMessage{ message_data });
+	PeerState &peer = _peers[viewer_peer_id];
+	// The peer doesn't have this block (anymore), so whatever we remember about it is outdated
+	peer.sent_blocks.erase(bpos);
+	peer.pending_blocks[bpos] = true;
 }
 
 // TODO Have a way to implement ghost edits?
@@ -83,6 +80,43 @@ void VoxelTerrainMultiplayerSynchronizer::send_block(
 // isn't acknowledging it for some time.
 
 void VoxelTerrainMultiplayerSynchronizer::send_area(Box3i voxel_box) {
+	// Full areas are sent immediately, so when bandwidth is limited, edits go through the per-peer block queue instead
+	// (sent in full if delta sync is off)
+	if (_delta_sync_enabled || _bandwidth_limit_per_peer > 0) {
+		send_area_as_blocks(voxel_box);
+	} else {
+		send_area_full(voxel_box);
+	}
+}
+
+// Queues every block touched by the edit for peers that have them. If delta sync is enabled, they will be sent as
+// differences from the version each peer last received.
+void VoxelTerrainMultiplayerSynchronizer::send_area_as_blocks(Box3i voxel_box) {
+	ZN_PROFILE_SCOPE();
+	ZN_ASSERT_RETURN(_terrain != nullptr);
+
+	const int block_size = _terrain->get_data_block_size();
+	const Box3i blocks_box = voxel_box.downscaled(block_size);
+
+	StdVector<ViewerID> viewers;
+
+	blocks_box.for_each_cell_zxy([&](Vector3i bpos) {
+		viewers.clear();
+		_terrain->get_viewers_in_area(viewers, Box3i(bpos * block_size, Vector3iUtil::create(block_size)));
+
+		for (const ViewerID viewer_id : viewers) {
+			const int peer_id = VoxelEngine::get_singleton().get_viewer_network_peer_id(viewer_id);
+			if (peer_id == -1 || peer_id == MultiplayerPeer::TARGET_PEER_SERVER) {
+				continue;
+			}
+			// If the block is already pending, it will be sent only once with its latest state.
+			// If it was pending a full send, it remains so.
+			_peers[peer_id].pending_blocks.insert({ bpos, false });
+		}
+	});
+}
+
+void VoxelTerrainMultiplayerSynchronizer::send_area_full(Box3i voxel_box) {
 	ZN_PROFILE_SCOPE();
 	ZN_ASSERT_RETURN(_terrain != nullptr);
 
@@ -117,6 +151,58 @@ void VoxelTerrainMultiplayerSynchronizer::send_area(Box3i voxel_box) {
 	}
 }
 
+namespace {
+
+template <typename T>
+void erase_positions_in_box(StdUnorderedMap<Vector3i, T> &map, const Box3i box) {
+	if (Vector3iUtil::get_volume_u64(box.size) < map.size()) {
+		box.for_each_cell_zxy([&map](Vector3i bpos) { //
+			map.erase(bpos);
+		});
+	} else {
+		for (auto it = map.begin(); it != map.end();) {
+			if (box.contains(it->first)) {
+				it = map.erase(it);
+			} else {
+				++it;
+			}
+		}
+	}
+}
+
+} // namespace
+
+void VoxelTerrainMultiplayerSynchronizer::forget_sent_blocks(int peer_id, Box3i block_box) {
+	auto peer_it = _peers.find(peer_id);
+	if (peer_it == _peers.end()) {
+		return;
+	}
+	PeerState &peer = peer_it->second;
+	erase_positions_in_box(peer.sent_blocks, block_box);
+	erase_positions_in_box(peer.pending_blocks, block_box);
+}
+
+void VoxelTerrainMultiplayerSynchronizer::set_delta_sync_enabled(bool enabled) {
+	_delta_sync_enabled = enabled;
+	if (!enabled) {
+		for (auto it = _peers.begin(); it != _peers.end(); ++it) {
+			it->second.sent_blocks.clear();
+		}
+	}
+}
+
+bool VoxelTerrainMultiplayerSynchronizer::is_delta_sync_enabled() const {
+	return _delta_sync_enabled;
+}
+
+void VoxelTerrainMultiplayerSynchronizer::set_bandwidth_limit_per_peer(int bytes_per_second) {
+	_bandwidth_limit_per_peer = math::max(bytes_per_second, 0);
+}
+
+int VoxelTerrainMultiplayerSynchronizer::get_bandwidth_limit_per_peer() const {
+	return _bandwidth_limit_per_peer;
+}
+
 void VoxelTerrainMultiplayerSynchronizer::_notification(int p_what) {
 	if (p_what == NOTIFICATION_PARENTED) {
 		VoxelTerrain *terrain = Object::cast_to<VoxelTerrain>(get_parent());
@@ -130,6 +216,7 @@ void VoxelTerrainMultiplayerSynchronizer::_notification(int p_what) {
 			_terrain->set_multiplayer_synchronizer(nullptr);
 		}
 		_terrain = nullptr;
+		_peers.clear();
 
 	} else if (p_what == NOTIFICATION_PROCESS) {
 		process();
@@ -143,46 +230,265 @@ void VoxelTerrainMultiplayerSynchronizer::_notification(int p_what) {
 // 	}
 // }
 
+VoxelTerrainMultiplayerSynchronizer::FrameBlock *VoxelTerrainMultiplayerSynchronizer::get_frame_block(Vector3i bpos) {
+	auto it = _frame_blocks.find(bpos);
+	if (it != _frame_blocks.end()) {
+		return it->second.full_data.size() != 0 ? &it->second : nullptr;
+	}
+
+	FrameBlock &fb = _frame_blocks[bpos];
+
+	VoxelData &data = _terrain->get_storage();
+	std::shared_ptr<VoxelBuffer> snapshot;
+	{
+		SpatialLock3D::Read srlock(data.get_spatial_lock(0), BoxBounds3i::from_position(bpos));
+		std::shared_ptr<VoxelBuffer> voxels = data.try_get_block_voxels(bpos);
+		if (voxels == nullptr) {
+			// The block got unloaded before we could send it
+			return nullptr;
+		}
+		if (!_delta_sync_enabled) {
+			// No need to remember what peers received, serialize directly
+			BlockSerializer::SerializeResult result = BlockSerializer::serialize_and_compress(*voxels);
+			ZN_ASSERT_RETURN_V(result.success, nullptr);
+			fb.full_data = result.data;
+			return &fb;
+		}
+		// Take a copy, because voxels of the terrain can change after we send them, and we have to remember what
+		// peers received
+		snapshot = make_shared_instance<VoxelBuffer>(VoxelBuffer::ALLOCATOR_POOL);
+		voxels->copy_to(*snapshot, true);
+	}
+
+	BlockSerializer::SerializeResult result = BlockSerializer::serialize_and_compress(*snapshot);
+	ZN_ASSERT_RETURN_V(result.success, nullptr);
+	fb.full_data = result.data;
+	fb.voxels = snapshot;
+	return &fb;
+}
+
+// Picks the data to send for a block: a difference from what the peer has if possible and smaller, or the full block.
+// Peers that received the same previous version get the same difference.
+Span<const uint8_t> VoxelTerrainMultiplayerSynchronizer::get_block_message_data(
+		FrameBlock &fb,
+		const VoxelBuffer *previous,
+		uint8_t &out_type
+) {
+	if (previous != nullptr && fb.voxels != nullptr) {
+		if (previous != fb.delta_base) {
+			fb.delta_base = previous;
+			fb.delta_data.clear();
+
+			static thread_local StdVector<uint8_t> tls_delta;
+			if (BlockSerializer::serialize_delta(*previous, *fb.voxels, tls_delta)) {
+				if (!CompressedData::compress(
+							to_span_const(tls_delta), fb.delta_data, CompressedData::COMPRESSION_LZ4
+					)) {
+					fb.delta_data.clear();
+				}
+			}
+		}
+		if (fb.delta_data.size() > 0 && fb.delta_data.size() < fb.full_data.size()) {
+			out_type = BLOCK_MESSAGE_DELTA;
+			return to_span_const(fb.delta_data);
+		}
+	}
+	out_type = BLOCK_MESSAGE_FULL;
+	return to_span_const(fb.full_data);
+}
+
 void VoxelTerrainMultiplayerSynchronizer::process() {
 	ZN_PROFILE_SCOPE();
 
-	for (auto it = _deferred_block_messages_per_peer.begin(); it != _deferred_block_messages_per_peer.end(); ++it) {
-		StdVector<DeferredBlockMessage> &messages = it->second;
+	if (_peers.size() == 0 || _terrain == nullptr) {
+		return;
+	}
+
+	// Find where each peer is, so blocks closest to them are sent first
+	StdUnorderedMap<int, Vector3> peer_positions;
+	{
+		const Transform3D world_to_local = _terrain->get_global_transform().affine_inverse();
+		VoxelEngine::get_singleton().for_each_viewer(
+				[&peer_positions, &world_to_local](ViewerID id, const VoxelEngine::Viewer &viewer) {
+					if (viewer.network_peer_id != -1) {
+						peer_positions.insert({ viewer.network_peer_id, world_to_local.xform(viewer.world_position) });
+					}
+				}
+		);
+	}
+
+	const float delta_time = get_process_delta_time();
 
-		if (messages.size() == 0) {
+	for (auto it = _peers.begin(); it != _peers.end();) {
+		const int peer_id = it->first;
+		auto position_it = peer_positions.find(peer_id);
+
+		if (position_it == peer_positions.end()) {
+			// Peers that no longer have any viewer can't receive block updates anymore
+			it = _peers.erase(it);
 			continue;
 		}
 
-		PackedByteArray pba;
-		// Make one big fat message per frame per peer, because sending many is super-slow with Godot's ENet multiplayer
-		// integration. It calls flush() on every RPC and that takes a lot of time, and there is overhead caused by
-		// the high-level features...
+		process_peer(peer_id, it->second, position_it->second, delta_time);
+		++it;
+	}
+
+	_frame_blocks.clear();
+}
+
+void VoxelTerrainMultiplayerSynchronizer::get_pending_blocks_by_distance(
+		const StdUnorderedMap<Vector3i, bool> &pending_blocks,
+		Vector3 viewer_position,
+		int block_size,
+		StdVector<PendingBlock> &out_blocks
+) {
+	const Vector3 half_block_size = Vector3(block_size, block_size, block_size) * 0.5f;
+
+	for (auto it = pending_blocks.begin(); it != pending_blocks.end(); ++it) {
+		const Vector3 block_center = Vector3(it->first * block_size) + half_block_size;
+		out_blocks.push_back(PendingBlock{ it->first, block_center.distance_squared_to(viewer_position), it->second });
+	}
+
+	std::sort(out_blocks.begin(), out_blocks.end(), [](const PendingBlock &a, const PendingBlock &b) {
+		return a.distance_squared < b.distance_squared;
+	});
+}
+
+float VoxelTerrainMultiplayerSynchronizer::replenish_send_budget(float budget, int bytes_per_second, float delta_time) {
+	const float max_budget = static_cast<float>(bytes_per_second);
+	return math::min(budget + max_budget * delta_time, max_budget);
+}
+
+void VoxelTerrainMultiplayerSynchronizer::process_peer(
+		int peer_id,
+		PeerState &peer,
+		Vector3 viewer_position,
+		float delta_time
+) {
+	ZN_PROFILE_SCOPE();
+
+	const bool limited = _bandwidth_limit_per_peer > 0;
+	if (limited) {
+		peer.send_budget = replenish_send_budget(peer.send_budget, _bandwidth_limit_per_peer, delta_time);
+		if (peer.send_budget <= 0.f) {
+			return;
+		}
+	}
+
+	if (peer.pending_blocks.size() == 0) {
+		return;
+	}
+
+	static thread_local StdVector<PendingBlock> tls_pending_blocks;
+	StdVector<PendingBlock> &pending_blocks = tls_pending_blocks;
+	pending_blocks.clear();
+
+	get_pending_blocks_by_distance(
+			peer.pending_blocks, viewer_position, _terrain->get_data_block_size(), pending_blocks
+	);
+
+	// Make one big fat message per frame per peer, because sending many is super-slow with Godot's ENet multiplayer
+	// integration. It calls flush() on every RPC and that takes a lot of time, and there is overhead caused by
+	// the high-level features...
+	StdVector<uint8_t> &batch = _batch_data;
+	batch.clear();
+	MemoryWriter mw(batch, ENDIANNESS_LITTLE_ENDIAN);
+	// Block count, written at the end
+	mw.store_32(0);
+	uint32_t block_count = 0;
+
+	for (const PendingBlock &pb : pending_blocks) {
+		if (limited && peer.send_budget <= 0.f) {
+			break;
+		}
+
+		peer.pending_blocks.erase(pb.position);
+
+		FrameBlock *fb = get_frame_block(pb.position);
+		if (fb == nullptr) {
+			continue;
+		}
 
-		unsigned int size = 0;
-		for (const DeferredBlockMessage &message : messages) {
-			size += message.data.size();
+		const VoxelBuffer *previous = nullptr;
+		if (_delta_sync_enabled && !pb.full) {
+			auto sent_it = peer.sent_blocks.find(pb.position);
+			if (sent_it != peer.sent_blocks.end()) {
+				previous = sent_it->second.get();
+			}
 		}
 
-		pba.resize(1 * sizeof(uint32_t) + size);
+		uint8_t type;
+		const Span<const uint8_t> data = get_block_message_data(*fb, previous, type);
+
+		mw.store_16(pb.position.x);
+		mw.store_16(pb.position.y);
+		mw.store_16(pb.position.z);
+		mw.store_8(type);
+		// Compressed blocks with many channels can be larger than 64 Kb
+		mw.store_32(data.size());
+		mw.store_buffer(data);
+		++block_count;
 
-		ByteSpanWithPosition mw_span(Span<uint8_t>(pba.ptrw(), pba.size()), 0);
-		MemoryWriterExistingBuffer mw(mw_span, ENDIANNESS_LITTLE_ENDIAN);
-		mw.store_32(messages.size());
+		peer.send_budget -= static_cast<float>(BLOCK_MESSAGE_HEADER_SIZE + data.size());
 
-		for (const DeferredBlockMessage &message : messages) {
-			mw.store_buffer(Span<const uint8_t>(message.data.ptr(), message.data.size()));
+		if (_delta_sync_enabled) {
+			// Keep a copy of what the peer received, so later edits can be sent as differences
+			peer.sent_blocks[pb.position] = fb->voxels;
 		}
-		ZN_ASSERT(mw.data.size() == mw.data.pos);
+	}
 
-		messages.clear();
+	if (block_count == 0) {
+		return;
+	}
 
-		const int peer_id = it->first;
-		ZN_PRINT_VERBOSE(format("Sending {} bytes of block data to peer {}", pba.size(), peer_id));
-		// print_data_hex(Span<const uint8_t>(pba.ptr(), pba.size()));
-		rpc_id(peer_id, VoxelStringNames::get_singleton()._rpc_receive_blocks, pba);
+	{
+		ByteSpanWithPosition bs(to_span(batch), 0);
+		MemoryWriterExistingBuffer count_writer(bs, ENDIANNESS_LITTLE_ENDIAN);
+		count_writer.store_32(block_count);
+	}
+
+	PackedByteArray pba;
+	pba.resize(batch.size());
+	memcpy(pba.ptrw(), batch.data(), batch.size());
+
+	ZN_PRINT_VERBOSE(format(
+			"Sending {} blocks ({} bytes) to peer {}, {} remaining",
+			block_count,
+			pba.size(),
+			peer_id,
+			peer.pending_blocks.size()
+	));
+	// print_data_hex(Span<const uint8_t>(pba.ptr(), pba.size()));
+	rpc_id(peer_id, VoxelStringNames::get_singleton()._rpc_receive_blocks, pba);
+}
+
+namespace {
+
+void receive_block_delta(VoxelTerrain &terrain, Vector3i bpos, Span<const uint8_t> compressed_delta) {
+	ZN_PROFILE_SCOPE();
+
+	static thread_local StdVector<uint8_t> tls_delta;
+	ZN_ASSERT_RETURN(CompressedData::decompress(compressed_delta, tls_delta));
+
+	VoxelData &data = terrain.get_storage();
+	{
+		SpatialLock3D::Write swlock(data.get_spatial_lock(0), BoxBounds3i::from_position(bpos));
+		std::shared_ptr<VoxelBuffer> voxels = data.try_get_block_voxels(bpos);
+		if (voxels == nullptr) {
+			// The block went out of range before the update arrived. The server will send it in full when it comes
+			// back in range.
+			ZN_PRINT_VERBOSE(format("Received delta for block {} which is not loaded, ignoring", bpos));
+			return;
+		}
+		ZN_ASSERT_RETURN(BlockSerializer::apply_delta(to_span_const(tls_delta), *voxels));
 	}
+
+	const int block_size = data.get_block_size();
+	terrain.post_edit_area(Box3i(bpos * block_size, Vector3iUtil::create(block_size)), true);
 }
 
+} // namespace
+
 void VoxelTerrainMultiplayerSynchronizer::_b_receive_blocks(PackedByteArray message_data) {
 	ZN_PROFILE_SCOPE();
 	ZN_ASSERT_RETURN(_terrain != nullptr);
@@ -201,18 +507,28 @@ void VoxelTerrainMultiplayerSynchronizer::_b_receive_blocks(PackedByteArray mess
 		bpos.x = int16_t(mr.get_16());
 		bpos.y = int16_t(mr.get_16());
 		bpos.z = int16_t(mr.get_16());
-		const int voxel_data_size = mr.get_16();
+		const uint8_t type = mr.get_8();
+		const uint32_t voxel_data_size = mr.get_32();
 		// print_line(String("Client: receive block {0} data {1}").format(varray(bpos, voxel_data_size)));
 
-		VoxelBuffer voxels(VoxelBuffer::ALLOCATOR_POOL);
-		ZN_ASSERT_RETURN(BlockSerializer::decompress_and_deserialize(mr.data.sub(mr.pos, voxel_data_size), voxels));
-
+		ZN_ASSERT_RETURN(mr.pos + voxel_data_size <= mr.data.size());
+		const Span<const uint8_t> voxel_data = mr.data.sub(mr.pos, voxel_data_size);
 		mr.pos += voxel_data_size;
 
+		ZN_ASSERT_RETURN(_terrain != nullptr);
+
+		if (type == BLOCK_MESSAGE_DELTA) {
+			receive_block_delta(*_terrain, bpos, voxel_data);
+			continue;
+		}
+		ZN_ASSERT_CONTINUE_MSG(type == BLOCK_MESSAGE_FULL, format("Unknown block message type {}", type));
+
+		VoxelBuffer voxels(VoxelBuffer::ALLOCATOR_POOL);
+		ZN_ASSERT_RETURN(BlockSerializer::decompress_and_deserialize(voxel_data, voxels));
+
 		std::shared_ptr<VoxelBuffer> voxels_p = make_shared_instance<VoxelBuffer>(VoxelBuffer::ALLOCATOR_POOL);
 		*voxels_p = std::move(voxels);
 
-		ZN_ASSERT_RETURN(_terrain != nullptr);
 		_terrain->try_set_block_data(bpos, voxels_p);
 	}
 }
@@ -287,6 +603,28 @@ void VoxelTerrainMultiplayerSynchronizer::_bind_methods() {
 			D_METHOD("_rpc_receive_blocks", "data"), &VoxelTerrainMultiplayerSynchronizer::_b_receive_blocks
 	);
 	ClassDB::bind_method(D_METHOD("_rpc_receive_area", "data"), &VoxelTerrainMultiplayerSynchronizer::_b_receive_area);
+
+	ClassDB::bind_method(
+			D_METHOD("set_delta_sync_enabled", "enabled"), &VoxelTerrainMultiplayerSynchronizer::set_delta_sync_enabled
+	);
+	ClassDB::bind_method(
+			D_METHOD("is_delta_sync_enabled"), &VoxelTerrainMultiplayerSynchronizer::is_delta_sync_enabled
+	);
+
+	ClassDB::bind_method(
+			D_METHOD("set_bandwidth_limit_per_peer", "bytes_per_second"),
+			&VoxelTerrainMultiplayerSynchronizer::set_bandwidth_limit_per_peer
+	);
+	ClassDB::bind_method(
+			D_METHOD("get_bandwidth_limit_per_peer"), &VoxelTerrainMultiplayerSynchronizer::get_bandwidth_limit_per_peer
+	);
+
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "delta_sync_enabled"), "set_delta_sync_enabled", "is_delta_sync_enabled");
+	ADD_PROPERTY(
+			PropertyInfo(Variant::INT, "bandwidth_limit_per_peer", PROPERTY_HINT_RANGE, "0,100000000,1,or_greater"),
+			"set_bandwidth_limit_per_peer",
+			"get_bandwidth_limit_per_peer"
+	);
 }
 
 } // namespace zylann::voxel
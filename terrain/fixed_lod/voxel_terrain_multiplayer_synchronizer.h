@@ -1,11 +1,13 @@
 #ifndef VOXEL_NETWORK_TERRAIN_SYNC_H
 #define VOXEL_NETWORK_TERRAIN_SYNC_H
 
-#include "../../storage/voxel_data_block.h"
+#include "../../util/containers/span.h"
 #include "../../util/containers/std_unordered_map.h"
 #include "../../util/containers/std_vector.h"
 #include "../../util/godot/classes/node.h"
 #include "../../util/math/box3i.h"
+#include "../../util/math/vector3.h"
+#include <memory>
 
 #ifdef TOOLS_ENABLED
 #include "../../util/godot/core/version.h"
@@ -14,6 +16,7 @@
 namespace zylann::voxel {
 
 class VoxelTerrain;
+class VoxelBuffer;
 
 // Implements multiplayer replication for `VoxelTerrain`
 class VoxelTerrainMultiplayerSynchronizer : public Node {
@@ -23,9 +26,41 @@ public:
 
 	bool is_server() const;
 
-	void send_block(int viewer_peer_id, const VoxelDataBlock &data_block, Vector3i bpos);
+	// Queues a block to be sent in full to a peer, which will be done in the next frames
+	void send_block(int viewer_peer_id, Vector3i bpos);
 	void send_area(Box3i voxel_box);
 
+	// When enabled, the server remembers which version of each block was sent to each peer, so that later changes
+	// can be sent as differences instead of full blocks. This costs memory on the server: a copy of the last version of
+	// every block each peer received is kept until it goes out of range. Off by default.
+	void set_delta_sync_enabled(bool enabled);
+	bool is_delta_sync_enabled() const;
+
+	// Maximum amount of block data sent to each peer per second. 0 means no limit.
+	void set_bandwidth_limit_per_peer(int bytes_per_second);
+	int get_bandwidth_limit_per_peer() const;
+
+	// Called when blocks are no longer in range of a peer, so they no longer need to be sent or remembered
+	void forget_sent_blocks(int peer_id, Box3i block_box);
+
+	struct PendingBlock {
+		Vector3i position;
+		float distance_squared;
+		bool full;
+	};
+
+	// Lists blocks waiting to be sent to a peer, closest to its viewer first. Exposed for testing.
+	static void get_pending_blocks_by_distance(
+			const StdUnorderedMap<Vector3i, bool> &pending_blocks,
+			Vector3 viewer_position,
+			int block_size,
+			StdVector<PendingBlock> &out_blocks
+	);
+
+	// Adds to the amount of bytes a peer can be sent after some time passed. Allows bursts of up to one second worth
+	// of data. Exposed for testing.
+	static float replenish_send_budget(float budget, int bytes_per_second, float delta_time);
+
 #ifdef TOOLS_ENABLED
 #if defined(ZN_GODOT)
 	PackedStringArray get_configuration_warnings() const override;
@@ -40,6 +75,16 @@ private:
 
 	void process();
 
+	void send_area_as_blocks(Box3i voxel_box);
+	void send_area_full(Box3i voxel_box);
+
+	struct PeerState;
+	struct FrameBlock;
+
+	void process_peer(int peer_id, PeerState &peer, Vector3 viewer_position, float delta_time);
+	FrameBlock *get_frame_block(Vector3i bpos);
+	Span<const uint8_t> get_block_message_data(FrameBlock &fb, const VoxelBuffer *previous, uint8_t &out_type);
+
 	void _b_receive_blocks(PackedByteArray message_data);
 	void _b_receive_area(PackedByteArray message_data);
 
@@ -48,11 +93,36 @@ private:
 	VoxelTerrain *_terrain = nullptr;
 	int _rpc_channel = 0;
 
-	struct DeferredBlockMessage {
-		PackedByteArray data;
+	bool _delta_sync_enabled = false;
+	int _bandwidth_limit_per_peer = 0;
+
+	typedef StdUnorderedMap<Vector3i, std::shared_ptr<const VoxelBuffer>> SentBlockMap;
+
+	struct PeerState {
+		// Blocks waiting to be sent, closest to the peer's viewer first. The value tells if the whole block has to be
+		// sent. A block changing again before it is sent only gets sent once, with its latest contents.
+		StdUnorderedMap<Vector3i, bool> pending_blocks;
+		// Last version of each block sent to the peer. Snapshots are immutable, and shared between peers that
+		// received the same version.
+		SentBlockMap sent_blocks;
+		// Bytes that can be sent, replenished over time when a bandwidth limit is set
+		float send_budget = 0.f;
+	};
+
+	StdUnorderedMap<int, PeerState> _peers;
+
+	// Blocks read from the terrain during the current frame, so they are copied and serialized only once even if
+	// they are sent to multiple peers
+	struct FrameBlock {
+		// Copy of the block as it was sent, only taken when delta sync is enabled
+		std::shared_ptr<const VoxelBuffer> voxels;
+		StdVector<uint8_t> full_data;
+		const VoxelBuffer *delta_base = nullptr;
+		StdVector<uint8_t> delta_data;
 	};
 
-	StdUnorderedMap<int, StdVector<DeferredBlockMessage>> _deferred_block_messages_per_peer;
+	StdUnorderedMap<Vector3i, FrameBlock> _frame_blocks;
+	StdVector<uint8_t> _batch_data;
 };
 
 } // namespace zylann::voxel
@@ -24,6 +24,18 @@ public:
 		mi.destroy();
 	}
 
+	// Same as `try_add_and_destroy`, but the instance is kept in a pool for reuse instead of being destroyed
+	static inline void try_add_and_recycle(
+			zylann::godot::DirectMeshInstance &mi,
+			zylann::godot::DirectMeshInstancePool &pool
+	) {
+		const Mesh *mesh = mi.get_mesh_ptr();
+		if (mesh != nullptr && mesh->get_reference_count() == 1) {
+			add(mi.get_mesh());
+		}
+		pool.recycle(mi);
+	}
+
 	void run() override {
 		ZN_PROFILE_SCOPE();
 		if (_mesh->get_reference_count() > 1) {
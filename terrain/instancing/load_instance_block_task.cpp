@@ -276,4 +276,8 @@ void LoadInstanceChunkTask::run(ThreadedTaskContext &ctx) {
 	}
 }
 
+const void *LoadInstanceChunkTask::get_serial_key() const {
+	return get_io_serial_key(_stream.ptr());
+}
+
 } // namespace zylann::voxel
@@ -40,6 +40,7 @@ public:
 	}
 
 	void run(ThreadedTaskContext &ctx) override;
+	const void *get_serial_key() const override;
 
 private:
 	std::shared_ptr<InstancerTaskOutputQueue> _output_queue;
@@ -510,7 +510,11 @@ void VoxelInstancer::process_mesh_lods() {
 
 	const float hysteresis = 1.05;
 
-	const uint64_t time_up_time = Time::get_singleton()->get_ticks_usec() + _mesh_lod_update_budget_microseconds;
+	MainThreadTimeBudget &budget = VoxelEngine::get_singleton().get_main_thread_time_budget();
+	MainThreadTimeBudgetScope budget_scope(budget, VoxelEngine::MAIN_THREAD_CATEGORY_INSTANCER);
+	const uint64_t time_up_time = Time::get_singleton()->get_ticks_usec() +
+			math::min(_mesh_lod_update_budget_microseconds,
+					  budget.get_category_remaining_usec(VoxelEngine::MAIN_THREAD_CATEGORY_INSTANCER));
 
 	const bool instancer_is_visible = is_visible_in_tree();
 
@@ -638,8 +642,11 @@ void VoxelInstancer::process_collision_distances() {
 
 	const float hysteresis = 1.05;
 
-	const uint64_t time_up_time =
-			Time::get_singleton()->get_ticks_usec() + _collision_distance_update_budget_microseconds;
+	MainThreadTimeBudget &budget = VoxelEngine::get_singleton().get_main_thread_time_budget();
+	MainThreadTimeBudgetScope budget_scope(budget, VoxelEngine::MAIN_THREAD_CATEGORY_INSTANCER);
+	const uint64_t time_up_time = Time::get_singleton()->get_ticks_usec() +
+			math::min(_collision_distance_update_budget_microseconds,
+					  budget.get_category_remaining_usec(VoxelEngine::MAIN_THREAD_CATEGORY_INSTANCER));
 
 	// TODO Candidate for temp allocator
 	StdVector<Transform3f> transforms;
@@ -109,6 +109,12 @@ void VoxelLodTerrain::ApplyMeshUpdateTask::run(TimeSpreadTaskContext &ctx) {
 	}
 
 	self->apply_mesh_update(data);
+
+	const MainThreadTimeBudget &budget = VoxelEngine::get_singleton().get_main_thread_time_budget();
+	if (budget.is_category_exhausted(VoxelEngine::MAIN_THREAD_CATEGORY_MESH) ||
+		budget.is_category_exhausted(VoxelEngine::MAIN_THREAD_CATEGORY_COLLISION)) {
+		ctx.stop = true;
+	}
 }
 
 VoxelLodTerrain::VoxelLodTerrain() {
@@ -1157,6 +1163,9 @@ void VoxelLodTerrain::_notification(int p_what) {
 
 			const Transform3D transform = get_global_transform();
 			// VoxelEngine::get_singleton().set_volume_transform(_volume_id, transform);
+			VoxelEngine::get_singleton().get_session_recorder().set_world_to_local_transform(
+					_volume_id, to_transform3f(transform.affine_inverse())
+			);
 
 			if (!is_inside_tree()) {
 				// The transform and other properties can be set by the scene loader,
@@ -1251,7 +1260,7 @@ void VoxelLodTerrain::process(float delta) {
 	// process_block_loading_responses();
 
 	// TODO This could go into time spread tasks too
-	process_deferred_collision_updates(VoxelEngine::get_singleton().get_main_thread_time_budget_usec());
+	process_deferred_collision_updates();
 
 #ifdef TOOLS_ENABLED
 	if (debug_is_draw_enabled() && is_visible_in_tree()) {
@@ -2119,6 +2128,10 @@ void VoxelLodTerrain::apply_mesh_update(VoxelEngine::BlockMeshOutput &ob) {
 		if (_collision_update_delay == 0 ||
 			static_cast<int>(now - block->last_collider_update_time) > _collision_update_delay) {
 			ZN_ASSERT(_mesher.is_valid());
+			MainThreadTimeBudgetScope budget_scope(
+					VoxelEngine::get_singleton().get_main_thread_time_budget(),
+					VoxelEngine::MAIN_THREAD_CATEGORY_COLLISION
+			);
 			Ref<Shape3D> collision_shape = make_collision_shape_from_mesher_output(ob.surfaces, **_mesher);
 			set_block_collision_shape(*this, *block, collision_shape, now);
 			block->set_collision_enabled(collision_active);
@@ -2342,12 +2355,13 @@ void VoxelLodTerrain::apply_detail_texture_update_to_block(
 
 #endif
 
-void VoxelLodTerrain::process_deferred_collision_updates(uint32_t timeout_msec) {
+void VoxelLodTerrain::process_deferred_collision_updates() {
 	ZN_PROFILE_SCOPE();
 
 	const unsigned int lod_count = get_lod_count();
-	// TODO We may move this in a time spread task somehow, the timeout does not account for them so could take longer
-	const uint64_t then = get_ticks_msec();
+	// TODO We may move this in a time spread task somehow
+	MainThreadTimeBudget &budget = VoxelEngine::get_singleton().get_main_thread_time_budget();
+	MainThreadTimeBudgetScope budget_scope(budget, VoxelEngine::MAIN_THREAD_CATEGORY_COLLISION);
 
 	for (unsigned int lod_index = 0; lod_index < lod_count; ++lod_index) {
 		VoxelMeshMap<VoxelMeshBlockVLT> &mesh_map = _mesh_maps_per_lod[lod_index];
@@ -2379,8 +2393,8 @@ void VoxelLodTerrain::process_deferred_collision_updates(uint32_t timeout_msec)
 				--i;
 			}
 
-			// We always process at least one, then we check the timeout
-			if (get_ticks_msec() - then >= timeout_msec) {
+			// We always process at least one, then we check the budget
+			if (budget.is_category_exhausted(VoxelEngine::MAIN_THREAD_CATEGORY_COLLISION)) {
 				return;
 			}
 		}
@@ -337,7 +337,7 @@ private:
 
 	void save_all_modified_blocks(bool with_copy, std::shared_ptr<AsyncDependencyTracker> tracker);
 
-	void process_deferred_collision_updates(uint32_t timeout_msec);
+	void process_deferred_collision_updates();
 	void process_fading_blocks(float delta);
 
 	struct LocalCameraInfo {
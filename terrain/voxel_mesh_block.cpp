@@ -52,7 +52,8 @@ void VoxelMeshBlock::set_mesh(
 		Ref<Mesh> mesh,
 		GeometryInstance3D::GIMode gi_mode,
 		RenderingServer::ShadowCastingSetting shadow_setting,
-		int render_layers_mask
+		int render_layers_mask,
+		zylann::godot::DirectMeshInstancePool *mesh_instance_pool
 ) {
 	// TODO Don't add mesh instance to the world if it's not visible.
 	// I suspect Godot is trying to include invisible mesh instances into the culling process,
@@ -62,7 +63,11 @@ void VoxelMeshBlock::set_mesh(
 	if (mesh.is_valid()) {
 		if (!_mesh_instance.is_valid()) {
 			// Create instance if it doesn't exist
-			_mesh_instance.create();
+			if (mesh_instance_pool != nullptr) {
+				mesh_instance_pool->create(_mesh_instance);
+			} else {
+				_mesh_instance.create();
+			}
 			_mesh_instance.set_interpolated(false);
 			_mesh_instance.set_gi_mode(gi_mode);
 			_mesh_instance.set_cast_shadows_setting(shadow_setting);
@@ -79,7 +84,11 @@ void VoxelMeshBlock::set_mesh(
 	} else {
 		if (_mesh_instance.is_valid()) {
 			// Delete instance if it exists
-			_mesh_instance.destroy();
+			if (mesh_instance_pool != nullptr) {
+				mesh_instance_pool->recycle(_mesh_instance);
+			} else {
+				_mesh_instance.destroy();
+			}
 		}
 	}
 }
@@ -144,7 +153,13 @@ void VoxelMeshBlock::set_parent_transform(const Transform3D &parent_transform) {
 	}
 }
 
-void VoxelMeshBlock::set_collision_shape(Ref<Shape3D> shape, bool debug_collision, const Node3D *node, float margin) {
+void VoxelMeshBlock::set_collision_shape(
+		Ref<Shape3D> shape,
+		bool debug_collision,
+		const Node3D *node,
+		float margin,
+		zylann::godot::DirectStaticBodyPool *static_body_pool
+) {
 	ERR_FAIL_COND(node == nullptr);
 	ERR_FAIL_COND_MSG(node->get_world_3d() != _world, "Physics body and attached node must be from the same world");
 
@@ -154,7 +169,11 @@ void VoxelMeshBlock::set_collision_shape(Ref<Shape3D> shape, bool debug_collisio
 	}
 
 	if (!_static_body.is_valid()) {
-		_static_body.create();
+		if (static_body_pool != nullptr) {
+			static_body_pool->create(_static_body);
+		} else {
+			_static_body.create();
+		}
 		_static_body.set_world(*_world);
 		// This allows collision signals to provide the terrain node in the `collider` field
 		_static_body.set_attached_object(node);
@@ -215,6 +234,14 @@ bool VoxelMeshBlock::is_collision_enabled() const {
 	return _collision_enabled;
 }
 
+void VoxelMeshBlock::recycle_server_objects(
+		zylann::godot::DirectMeshInstancePool &mesh_instance_pool,
+		zylann::godot::DirectStaticBodyPool &static_body_pool
+) {
+	FreeMeshTask::try_add_and_recycle(_mesh_instance, mesh_instance_pool);
+	static_body_pool.recycle(_static_body);
+}
+
 Ref<ConcavePolygonShape3D> make_collision_shape_from_mesher_output(
 		const VoxelMesher::Output &mesher_output,
 		const VoxelMesher &mesher
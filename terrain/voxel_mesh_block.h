@@ -35,11 +35,14 @@ public:
 
 	// Visuals
 
+	// If a pool is provided, the mesh instance is taken from it if it has to be created, and given back to it if it
+	// has to be removed.
 	void set_mesh(
 			Ref<Mesh> mesh,
 			GeometryInstance3D::GIMode gi_mode,
 			RenderingServer::ShadowCastingSetting shadow_setting,
-			int render_layers_mask
+			int render_layers_mask,
+			zylann::godot::DirectMeshInstancePool *mesh_instance_pool = nullptr
 	);
 	Ref<Mesh> get_mesh() const;
 	bool has_mesh() const;
@@ -65,7 +68,14 @@ public:
 
 	// Collisions
 
-	void set_collision_shape(Ref<Shape3D> shape, bool debug_collision, const Node3D *node, float margin);
+	// If a pool is provided, the static body is taken from it if it has to be created.
+	void set_collision_shape(
+			Ref<Shape3D> shape,
+			bool debug_collision,
+			const Node3D *node,
+			float margin,
+			zylann::godot::DirectStaticBodyPool *static_body_pool = nullptr
+	);
 	bool has_collision_shape() const;
 	void set_collision_layer(int layer);
 	void set_collision_mask(int mask);
@@ -76,6 +86,13 @@ public:
 	void set_collision_enabled(bool enable);
 	bool is_collision_enabled() const;
 
+	// Gives the mesh instance and static body of the block to pools, so they can be reused by other blocks instead of
+	// being freed. Must be done before the block gets destroyed.
+	void recycle_server_objects(
+			zylann::godot::DirectMeshInstancePool &mesh_instance_pool,
+			zylann::godot::DirectStaticBodyPool &static_body_pool
+	);
+
 protected:
 	void _set_visible(bool visible);
 
@@ -0,0 +1,96 @@
+#include "voxel_session_recorder.h"
+#include "../engine/voxel_engine.h"
+#include "../util/godot/core/packed_arrays.h"
+#include "../util/math/conv.h"
+#include "fixed_lod/voxel_terrain.h"
+#include "variable_lod/voxel_lod_terrain.h"
+#include "voxel_node.h"
+
+namespace zylann::voxel {
+
+namespace {
+
+// Tells which resource was used, so the terrain can be set up the same way for replay
+String get_resource_info(const Ref<Resource> &resource) {
+	if (resource.is_null()) {
+		return String();
+	}
+	const String path = resource->get_path();
+	if (!path.is_empty()) {
+		return path;
+	}
+	return resource->get_class();
+}
+
+Dictionary get_terrain_config(const VoxelNode &terrain) {
+	Dictionary config;
+	config["terrain_class"] = terrain.get_class();
+	config["generator"] = get_resource_info(terrain.get_generator());
+	config["stream"] = get_resource_info(terrain.get_stream());
+	config["mesher"] = get_resource_info(terrain.get_mesher());
+
+	const VoxelTerrain *vt = Object::cast_to<VoxelTerrain>(&terrain);
+	if (vt != nullptr) {
+		config["max_view_distance"] = vt->get_max_view_distance();
+		config["mesh_block_size"] = vt->get_mesh_block_size();
+		config["data_block_size"] = vt->get_data_block_size();
+	}
+
+	const VoxelLodTerrain *vlt = Object::cast_to<VoxelLodTerrain>(&terrain);
+	if (vlt != nullptr) {
+		config["view_distance"] = vlt->get_view_distance();
+		config["lod_count"] = vlt->get_lod_count();
+		config["lod_distance"] = vlt->get_lod_distance();
+		config["mesh_block_size"] = vlt->get_mesh_block_size();
+		config["data_block_size"] = vlt->get_data_block_size();
+	}
+
+	return config;
+}
+
+} // namespace
+
+VoxelSessionRecorder::~VoxelSessionRecorder() {
+	if (_recording) {
+		// Nobody can get the trace anymore
+		SessionTrace trace;
+		VoxelEngine::get_singleton().get_session_recorder().stop(trace);
+	}
+}
+
+void VoxelSessionRecorder::start(VoxelNode *terrain) {
+	ZN_ASSERT_RETURN(terrain != nullptr);
+	SessionRecorder &recorder = VoxelEngine::get_singleton().get_session_recorder();
+	ZN_ASSERT_RETURN_MSG(!recorder.is_recording(), "Another session is already being recorded");
+
+	const Transform3f world_to_local = to_transform3f(terrain->get_global_transform().affine_inverse());
+	recorder.start(terrain->get_volume_id(), world_to_local, get_terrain_config(*terrain));
+	_recording = true;
+}
+
+PackedByteArray VoxelSessionRecorder::stop() {
+	ZN_ASSERT_RETURN_V_MSG(_recording, PackedByteArray(), "This recorder was not started");
+	_recording = false;
+
+	SessionTrace trace;
+	VoxelEngine::get_singleton().get_session_recorder().stop(trace);
+
+	StdVector<uint8_t> data;
+	trace.serialize(data);
+
+	PackedByteArray bytes;
+	zylann::godot::copy_to(bytes, to_span_const(data));
+	return bytes;
+}
+
+bool VoxelSessionRecorder::is_recording() const {
+	return _recording;
+}
+
+void VoxelSessionRecorder::_bind_methods() {
+	ClassDB::bind_method(D_METHOD("start", "terrain"), &VoxelSessionRecorder::start);
+	ClassDB::bind_method(D_METHOD("stop"), &VoxelSessionRecorder::stop);
+	ClassDB::bind_method(D_METHOD("is_recording"), &VoxelSessionRecorder::is_recording);
+}
+
+} // namespace zylann::voxel
@@ -0,0 +1,30 @@
+#ifndef VOXEL_SESSION_RECORDER_GD_H
+#define VOXEL_SESSION_RECORDER_GD_H
+
+#include "../util/godot/classes/ref_counted.h"
+#include "../util/godot/core/packed_byte_array.h"
+
+namespace zylann::voxel {
+
+class VoxelNode;
+
+// Records viewers and edits done on a terrain every frame, so the session can be replayed later with
+// `VoxelSessionReplayer`. Only one session can be recorded at a time.
+class VoxelSessionRecorder : public RefCounted {
+	GDCLASS(VoxelSessionRecorder, RefCounted)
+public:
+	~VoxelSessionRecorder();
+
+	void start(VoxelNode *terrain);
+	PackedByteArray stop();
+	bool is_recording() const;
+
+private:
+	static void _bind_methods();
+
+	bool _recording = false;
+};
+
+} // namespace zylann::voxel
+
+#endif // VOXEL_SESSION_RECORDER_GD_H
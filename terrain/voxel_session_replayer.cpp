@@ -0,0 +1,251 @@
+#include "voxel_session_replayer.h"
+#include "../edition/voxel_tool.h"
+#include "../engine/session_trace.h"
+#include "../engine/voxel_engine.h"
+#include "../util/containers/std_unordered_map.h"
+#include "../util/godot/classes/os.h"
+#include "../util/godot/core/packed_arrays.h"
+#include "../util/math/conv.h"
+#include "../util/profiling_clock.h"
+#include "../util/thread/thread.h"
+#include "voxel_node.h"
+#include <algorithm>
+
+namespace zylann::voxel {
+
+namespace {
+
+struct ReplayStats {
+	StdVector<uint32_t> frame_times_usec;
+	int max_generation_tasks = 0;
+	int max_meshing_tasks = 0;
+	int max_streaming_tasks = 0;
+	int max_main_thread_tasks = 0;
+	unsigned int max_general_pool_tasks = 0;
+	unsigned int max_io_pool_tasks = 0;
+	uint64_t peak_static_memory = 0;
+
+	void update_peaks(const VoxelEngine::Stats &stats) {
+		max_generation_tasks = math::max(max_generation_tasks, stats.generation_tasks);
+		max_meshing_tasks = math::max(max_meshing_tasks, stats.meshing_tasks);
+		max_streaming_tasks = math::max(max_streaming_tasks, stats.streaming_tasks);
+		max_main_thread_tasks = math::max(max_main_thread_tasks, stats.main_thread_tasks);
+		max_general_pool_tasks = math::max(max_general_pool_tasks, stats.general.tasks);
+		max_io_pool_tasks = math::max(max_io_pool_tasks, stats.io.tasks);
+		peak_static_memory = math::max(peak_static_memory, OS::get_singleton()->get_static_memory_usage());
+	}
+};
+
+inline bool is_idle(const VoxelEngine::Stats &stats) {
+	return stats.generation_tasks == 0 && stats.meshing_tasks == 0 && stats.streaming_tasks == 0 &&
+			stats.main_thread_tasks == 0;
+}
+
+// Viewer positions are recorded in the local space of the terrain, `local_to_world` places them around the terrain
+// being replayed on.
+void apply_viewers(
+		VoxelEngine &engine,
+		Span<const SessionTrace::ViewerState> viewers,
+		const Transform3D &local_to_world,
+		StdUnorderedMap<uint32_t, ViewerID> &viewer_ids
+) {
+	// Remove viewers that are gone
+	for (auto it = viewer_ids.begin(); it != viewer_ids.end();) {
+		bool found = false;
+		for (const SessionTrace::ViewerState &state : viewers) {
+			if (state.id == it->first) {
+				found = true;
+				break;
+			}
+		}
+		if (found) {
+			++it;
+		} else {
+			engine.remove_viewer(it->second);
+			it = viewer_ids.erase(it);
+		}
+	}
+
+	for (const SessionTrace::ViewerState &state : viewers) {
+		ViewerID viewer_id;
+		auto it = viewer_ids.find(state.id);
+		if (it == viewer_ids.end()) {
+			viewer_id = engine.add_viewer();
+			viewer_ids.insert({ state.id, viewer_id });
+		} else {
+			viewer_id = it->second;
+		}
+		engine.set_viewer_position(viewer_id, local_to_world.xform(to_vec3(state.position)));
+		VoxelEngine::Viewer::Distances distances;
+		distances.horizontal = state.horizontal_distance;
+		distances.vertical = state.vertical_distance;
+		engine.set_viewer_distances(viewer_id, distances);
+		engine.set_viewer_requires_visuals(viewer_id, state.requires_visuals);
+		engine.set_viewer_requires_collisions(viewer_id, state.requires_collisions);
+	}
+}
+
+void apply_edit(VoxelTool &tool, const SessionTrace::Edit &edit) {
+	tool.set_mode(static_cast<VoxelTool::Mode>(edit.mode));
+	tool.set_channel(static_cast<VoxelBuffer::ChannelId>(edit.channel));
+	tool.set_value(edit.value);
+	tool.set_eraser_value(edit.eraser_value);
+	tool.set_sdf_scale(edit.sdf_scale);
+	tool.set_sdf_strength(edit.sdf_strength);
+
+	const Vector3i voxel_pos = to_vec3i(math::floor(edit.position));
+
+	switch (edit.type) {
+		case SessionTrace::EDIT_SET_VOXEL:
+			tool.set_voxel(voxel_pos, edit.value);
+			break;
+		case SessionTrace::EDIT_SET_VOXEL_F:
+			tool.set_voxel_f(voxel_pos, edit.param);
+			break;
+		case SessionTrace::EDIT_POINT:
+			tool.do_point(voxel_pos);
+			break;
+		case SessionTrace::EDIT_SPHERE:
+			tool.do_sphere(to_vec3(edit.position), edit.param);
+			break;
+		case SessionTrace::EDIT_BOX:
+			tool.do_box(voxel_pos, edit.end);
+			break;
+		default:
+			ZN_PRINT_ERROR("Unhandled edit type");
+			break;
+	}
+}
+
+uint32_t get_percentile(Span<const uint32_t> sorted_values, float p) {
+	if (sorted_values.size() == 0) {
+		return 0;
+	}
+	const size_t i = math::min(static_cast<size_t>(p * sorted_values.size()), sorted_values.size() - 1);
+	return sorted_values[i];
+}
+
+} // namespace
+
+Dictionary VoxelSessionReplayer::replay(VoxelNode *terrain, PackedByteArray trace_data, Dictionary options) {
+	ZN_ASSERT_RETURN_V(terrain != nullptr, Dictionary());
+	ZN_ASSERT_RETURN_V_MSG(terrain->is_inside_tree(), Dictionary(), "The terrain must be in the scene tree");
+
+	SessionTrace trace;
+	ZN_ASSERT_RETURN_V(trace.deserialize(zylann::godot::to_span(trace_data)), Dictionary());
+
+	// By default frames run back to back. In realtime, they are spaced like they were recorded.
+	const bool realtime = options.get("realtime", false);
+	const bool drain = options.get("drain", true);
+	const float drain_timeout_seconds = options.get("drain_timeout_seconds", 60.f);
+
+	VoxelEngine &engine = VoxelEngine::get_singleton();
+	// So task latencies obtained from `VoxelEngine.get_stats()` afterwards only cover the replay
+	engine.clear_task_latency_stats();
+
+	Ref<VoxelTool> tool = terrain->get_voxel_tool();
+
+	StdUnorderedMap<uint32_t, ViewerID> viewer_ids;
+	ReplayStats stats;
+	stats.frame_times_usec.reserve(trace.frames.size());
+	const uint64_t static_memory_start = OS::get_singleton()->get_static_memory_usage();
+
+	ProfilingClock total_clock;
+
+	for (const SessionTrace::Frame &frame : trace.frames) {
+		ProfilingClock frame_clock;
+
+		if (frame.viewers_changed) {
+			apply_viewers(engine, to_span(frame.viewers), terrain->get_global_transform(), viewer_ids);
+		}
+
+		if (tool.is_valid()) {
+			for (const SessionTrace::Edit &edit : frame.edits) {
+				apply_edit(**tool, edit);
+			}
+		}
+
+		engine.process();
+		terrain->notification(Node::NOTIFICATION_PROCESS);
+
+		const uint64_t frame_time_usec = frame_clock.get_elapsed_microseconds();
+		stats.frame_times_usec.push_back(math::min(frame_time_usec, uint64_t(0xffffffff)));
+		stats.update_peaks(engine.get_stats());
+
+		if (realtime && frame_time_usec < frame.delta_usec) {
+			Thread::sleep_usec(frame.delta_usec - frame_time_usec);
+		}
+	}
+
+	const uint64_t replay_time_usec = total_clock.get_elapsed_microseconds();
+
+	// Let the engine finish work the session caused, to know how far behind it was
+	bool drained = false;
+	ProfilingClock drain_clock;
+	if (drain) {
+		const uint64_t timeout_usec = static_cast<uint64_t>(drain_timeout_seconds * 1'000'000.0);
+		// The terrain may schedule more work after tasks complete, so we wait a few frames in a row without any
+		const unsigned int idle_frames_needed = 10;
+		unsigned int idle_frames = 0;
+		while (idle_frames < idle_frames_needed && drain_clock.get_elapsed_microseconds() < timeout_usec) {
+			engine.process();
+			terrain->notification(Node::NOTIFICATION_PROCESS);
+			const VoxelEngine::Stats engine_stats = engine.get_stats();
+			stats.update_peaks(engine_stats);
+			idle_frames = is_idle(engine_stats) ? idle_frames + 1 : 0;
+			Thread::sleep_usec(1000);
+		}
+		drained = idle_frames >= idle_frames_needed;
+	}
+	const uint64_t drain_time_usec = drain ? drain_clock.get_elapsed_microseconds() : 0;
+
+	for (auto it = viewer_ids.begin(); it != viewer_ids.end(); ++it) {
+		engine.remove_viewer(it->second);
+	}
+
+	StdVector<uint32_t> &sorted_times = stats.frame_times_usec;
+	std::sort(sorted_times.begin(), sorted_times.end());
+	uint64_t frame_time_sum = 0;
+	for (const uint32_t t : sorted_times) {
+		frame_time_sum += t;
+	}
+
+	Dictionary frame_times;
+	frame_times["average"] = sorted_times.size() > 0 ? int64_t(frame_time_sum / sorted_times.size()) : 0;
+	frame_times["p50"] = get_percentile(to_span_const(sorted_times), 0.5f);
+	frame_times["p90"] = get_percentile(to_span_const(sorted_times), 0.9f);
+	frame_times["p99"] = get_percentile(to_span_const(sorted_times), 0.99f);
+	frame_times["max"] = sorted_times.size() > 0 ? int64_t(sorted_times.back()) : 0;
+
+	Dictionary max_tasks;
+	max_tasks["generation"] = stats.max_generation_tasks;
+	max_tasks["meshing"] = stats.max_meshing_tasks;
+	max_tasks["streaming"] = stats.max_streaming_tasks;
+	max_tasks["main_thread"] = stats.max_main_thread_tasks;
+	max_tasks["general_pool"] = int64_t(stats.max_general_pool_tasks);
+	max_tasks["io_pool"] = int64_t(stats.max_io_pool_tasks);
+
+	Dictionary memory;
+	memory["static_start"] = int64_t(static_memory_start);
+	memory["static_end"] = int64_t(OS::get_singleton()->get_static_memory_usage());
+	memory["static_peak"] = int64_t(stats.peak_static_memory);
+
+	Dictionary d;
+	d["config"] = trace.config;
+	d["frame_count"] = static_cast<int64_t>(trace.frames.size());
+	d["replay_time_usec"] = int64_t(replay_time_usec);
+	d["frame_time_usec"] = frame_times;
+	d["max_tasks"] = max_tasks;
+	d["memory"] = memory;
+	d["drained"] = drained;
+	d["drain_time_usec"] = int64_t(drain_time_usec);
+	return d;
+}
+
+void VoxelSessionReplayer::_bind_methods() {
+	ClassDB::bind_method(
+			D_METHOD("replay", "terrain", "trace_data", "options"), &VoxelSessionReplayer::replay, DEFVAL(Dictionary())
+	);
+}
+
+} // namespace zylann::voxel
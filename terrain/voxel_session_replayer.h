@@ -0,0 +1,24 @@
+#ifndef VOXEL_SESSION_REPLAYER_H
+#define VOXEL_SESSION_REPLAYER_H
+
+#include "../util/godot/classes/ref_counted.h"
+#include "../util/godot/core/packed_byte_array.h"
+
+namespace zylann::voxel {
+
+class VoxelNode;
+
+// Replays a session recorded with `VoxelSessionRecorder` on a terrain, and measures how the engine coped with it.
+// This blocks until the whole session was replayed, driving the engine and the terrain manually.
+class VoxelSessionReplayer : public RefCounted {
+	GDCLASS(VoxelSessionReplayer, RefCounted)
+public:
+	Dictionary replay(VoxelNode *terrain, PackedByteArray trace_data, Dictionary options);
+
+private:
+	static void _bind_methods();
+};
+
+} // namespace zylann::voxel
+
+#endif // VOXEL_SESSION_REPLAYER_H
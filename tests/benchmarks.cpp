@@ -0,0 +1,567 @@
+#include "../engine/voxel_engine.h"
+#include "../generators/graph/voxel_generator_graph.h"
+#include "../meshers/blocky/voxel_blocky_library.h"
+#include "../meshers/blocky/voxel_blocky_model_cube.h"
+#include "../meshers/blocky/voxel_blocky_model_empty.h"
+#include "../meshers/blocky/voxel_mesher_blocky.h"
+#include "../meshers/cubes/voxel_mesher_cubes.h"
+#include "../storage/voxel_buffer.h"
+#include "../streams/region/voxel_stream_region_files.h"
+#include "../streams/voxel_block_serializer.h"
+#include "../util/containers/std_vector.h"
+#include "../util/godot/classes/engine.h"
+#include "../util/godot/classes/fast_noise_lite.h"
+#include "../util/godot/classes/scene_tree.h"
+#include "../util/godot/classes/window.h"
+#include "../util/io/log.h"
+#include "../util/math/color8.h"
+#include "../util/noise/fast_noise_lite/fast_noise_lite.h"
+#include "../util/profiling_clock.h"
+#include "../util/string/format.h"
+#include "../util/testing/benchmark.h"
+#include "../util/testing/test_directory.h"
+#include "../util/thread/thread.h"
+#include "tests.h"
+#include <cstring>
+
+#ifdef VOXEL_ENABLE_BASIC_GENERATORS
+#include "../generators/simple/voxel_generator_noise.h"
+#include "../generators/simple/voxel_generator_noise_2d.h"
+#endif
+
+#ifdef VOXEL_ENABLE_SMOOTH_MESHING
+#include "../meshers/transvoxel/voxel_mesher_transvoxel.h"
+#include "../terrain/variable_lod/voxel_lod_terrain.h"
+#endif
+
+#ifdef VOXEL_ENABLE_SQLITE
+#include "../streams/sqlite/voxel_stream_sqlite.h"
+#endif
+
+#ifdef VOXEL_ENABLE_FAST_NOISE_2
+#include "../util/noise/fast_noise_2.h"
+#endif
+
+namespace zylann::voxel::tests {
+
+using namespace zylann::testing;
+
+namespace {
+
+// Every benchmark works on the same fixed area, so results can be compared between runs
+const int BLOCK_SIZE_PO2 = 4;
+const int BLOCK_SIZE = 1 << BLOCK_SIZE_PO2;
+// Blocks around the surface of generated terrain, 4x4x4
+const int AREA_SIZE_IN_BLOCKS = 4;
+const int SEED = 131183;
+
+void get_area_block_positions(StdVector<Vector3i> &out_positions) {
+	Vector3i bpos;
+	const int half_size = AREA_SIZE_IN_BLOCKS / 2;
+	for (bpos.z = -half_size; bpos.z < half_size; ++bpos.z) {
+		for (bpos.x = -half_size; bpos.x < half_size; ++bpos.x) {
+			for (bpos.y = -half_size; bpos.y < half_size; ++bpos.y) {
+				out_positions.push_back(bpos);
+			}
+		}
+	}
+}
+
+Ref<VoxelGeneratorGraph> create_graph_generator() {
+	//     X --- FastNoise2D
+	//      \/              \
+	//      /\               \
+	//     Z ---------------- y + 20 * n --- OutputSDF
+	//                       /
+	//     Y ----------------
+
+	Ref<VoxelGeneratorGraph> generator;
+	generator.instantiate();
+	pg::VoxelGraphFunction &g = **generator->get_main_function();
+
+	const uint32_t in_x = g.create_node(pg::VoxelGraphFunction::NODE_INPUT_X, Vector2());
+	const uint32_t in_y = g.create_node(pg::VoxelGraphFunction::NODE_INPUT_Y, Vector2());
+	const uint32_t in_z = g.create_node(pg::VoxelGraphFunction::NODE_INPUT_Z, Vector2());
+	const uint32_t out_sdf = g.create_node(pg::VoxelGraphFunction::NODE_OUTPUT_SDF, Vector2());
+	const uint32_t n_noise = g.create_node(pg::VoxelGraphFunction::NODE_FAST_NOISE_2D, Vector2());
+	const uint32_t n_expr = g.create_node(pg::VoxelGraphFunction::NODE_EXPRESSION, Vector2());
+
+	Ref<ZN_FastNoiseLite> noise;
+	noise.instantiate();
+	noise->set_seed(SEED);
+	noise->set_period(128);
+	g.set_node_param(n_noise, 0, noise);
+
+	g.set_node_param(n_expr, 0, "y + 20 * n");
+	PackedStringArray var_names;
+	var_names.push_back("y");
+	var_names.push_back("n");
+	g.set_expression_node_inputs(n_expr, var_names);
+
+	g.add_connection(in_x, 0, n_noise, 0);
+	g.add_connection(in_z, 0, n_noise, 1);
+	g.add_connection(in_y, 0, n_expr, 0);
+	g.add_connection(n_noise, 0, n_expr, 1);
+	g.add_connection(n_expr, 0, out_sdf, 0);
+
+	const pg::CompilationResult result = generator->compile(false);
+	ZN_ASSERT_MSG(result.success, "Failed to compile benchmark graph");
+
+	return generator;
+}
+
+#ifdef VOXEL_ENABLE_FAST_NOISE_2
+
+Ref<VoxelGeneratorGraph> create_fast_noise_2_graph_generator(const bool use_grid_queries) {
+	//     X --- FastNoise2_3D
+	//     Y -/             |
+	//     Z -/             |
+	//                      y + 20 * n --- OutputSDF
+	//                     /
+	//     Y --------------
+
+	Ref<VoxelGeneratorGraph> generator;
+	generator.instantiate();
+	pg::VoxelGraphFunction &g = **generator->get_main_function();
+
+	const uint32_t in_x = g.create_node(pg::VoxelGraphFunction::NODE_INPUT_X, Vector2());
+	const uint32_t in_y = g.create_node(pg::VoxelGraphFunction::NODE_INPUT_Y, Vector2());
+	const uint32_t in_z = g.create_node(pg::VoxelGraphFunction::NODE_INPUT_Z, Vector2());
+	const uint32_t out_sdf = g.create_node(pg::VoxelGraphFunction::NODE_OUTPUT_SDF, Vector2());
+	const uint32_t n_noise = g.create_node(pg::VoxelGraphFunction::NODE_FAST_NOISE_2_3D, Vector2());
+	const uint32_t n_expr = g.create_node(pg::VoxelGraphFunction::NODE_EXPRESSION, Vector2());
+
+	Ref<FastNoise2> noise;
+	noise.instantiate();
+	noise->set_seed(SEED);
+	noise->set_period(128);
+	g.set_node_param(n_noise, 0, noise);
+
+	g.set_node_param(n_expr, 0, "y + 20 * n");
+	PackedStringArray var_names;
+	var_names.push_back("y");
+	var_names.push_back("n");
+	g.set_expression_node_inputs(n_expr, var_names);
+
+	g.add_connection(in_x, 0, n_noise, 0);
+	g.add_connection(in_y, 0, n_noise, 1);
+	g.add_connection(in_z, 0, n_noise, 2);
+	g.add_connection(in_y, 0, n_expr, 0);
+	g.add_connection(n_noise, 0, n_expr, 1);
+	g.add_connection(n_expr, 0, out_sdf, 0);
+
+	generator->set_use_grid_queries(use_grid_queries);
+
+	const pg::CompilationResult result = generator->compile(false);
+	ZN_ASSERT_MSG(result.success, "Failed to compile benchmark graph");
+
+	return generator;
+}
+
+#endif
+
+// Generates voxels of every block of the benchmark area. Padding is added around each block, as meshers need it.
+void generate_area_blocks(
+		VoxelGenerator &generator,
+		const int min_padding,
+		const int max_padding,
+		StdVector<VoxelBuffer> &out_buffers
+) {
+	StdVector<Vector3i> positions;
+	get_area_block_positions(positions);
+
+	out_buffers.reserve(positions.size());
+	for (const Vector3i bpos : positions) {
+		out_buffers.emplace_back(VoxelBuffer::ALLOCATOR_DEFAULT);
+		VoxelBuffer &vb = out_buffers.back();
+		vb.create(Vector3iUtil::create(min_padding + BLOCK_SIZE + max_padding));
+		const Vector3i origin = bpos * BLOCK_SIZE - Vector3iUtil::create(min_padding);
+		generator.generate_block(VoxelGenerator::VoxelQueryData{ vb, origin, 0 });
+	}
+}
+
+// Turns SDF into solid/empty voxels in the given channel
+void convert_sdf_to_solid(VoxelBuffer &vb, const VoxelBuffer::ChannelId channel, const uint64_t solid_value) {
+	Vector3i pos;
+	const Vector3i size = vb.get_size();
+	for (pos.z = 0; pos.z < size.z; ++pos.z) {
+		for (pos.x = 0; pos.x < size.x; ++pos.x) {
+			for (pos.y = 0; pos.y < size.y; ++pos.y) {
+				const float sd = vb.get_voxel_f(pos, VoxelBuffer::CHANNEL_SDF);
+				vb.set_voxel(sd < 0.f ? solid_value : 0, pos, channel);
+			}
+		}
+	}
+}
+
+void benchmark_generate(BenchmarkRunner &runner, const char *name, VoxelGenerator &generator) {
+	StdVector<Vector3i> positions;
+	get_area_block_positions(positions);
+
+	VoxelBuffer vb(VoxelBuffer::ALLOCATOR_DEFAULT);
+	vb.create(Vector3iUtil::create(BLOCK_SIZE));
+
+	runner.run(name, "blocks", positions.size(), [&generator, &positions, &vb]() {
+		for (const Vector3i bpos : positions) {
+			generator.generate_block(VoxelGenerator::VoxelQueryData{ vb, bpos * BLOCK_SIZE, 0 });
+		}
+	});
+}
+
+void benchmark_generation(BenchmarkRunner &runner) {
+	{
+		Ref<VoxelGeneratorGraph> generator = create_graph_generator();
+		benchmark_generate(runner, "generate_graph", **generator);
+	}
+#ifdef VOXEL_ENABLE_FAST_NOISE_2
+	// Same graph, with noise computed on a uniform grid or from arrays of positions
+	{
+		Ref<VoxelGeneratorGraph> generator = create_fast_noise_2_graph_generator(true);
+		benchmark_generate(runner, "generate_graph_fast_noise_2_grid", **generator);
+	}
+	{
+		Ref<VoxelGeneratorGraph> generator = create_fast_noise_2_graph_generator(false);
+		benchmark_generate(runner, "generate_graph_fast_noise_2_positions", **generator);
+	}
+#else
+	runner.add_skipped("generate_graph_fast_noise_2_grid", "built without FastNoise2");
+	runner.add_skipped("generate_graph_fast_noise_2_positions", "built without FastNoise2");
+#endif
+#ifdef VOXEL_ENABLE_BASIC_GENERATORS
+	{
+		Ref<FastNoiseLite> noise;
+		noise.instantiate();
+		noise->set_seed(SEED);
+
+		Ref<VoxelGeneratorNoise> generator;
+		generator.instantiate();
+		generator->set_channel(VoxelBuffer::CHANNEL_SDF);
+		generator->set_noise(noise);
+		generator->set_height_start(-32);
+		generator->set_height_range(64);
+		benchmark_generate(runner, "generate_noise", **generator);
+	}
+	{
+		Ref<FastNoiseLite> noise;
+		noise.instantiate();
+		noise->set_seed(SEED);
+
+		Ref<VoxelGeneratorNoise2D> generator;
+		generator.instantiate();
+		generator->set_channel(VoxelBuffer::CHANNEL_SDF);
+		generator->set_noise(noise);
+		generator->set_height_start(-32);
+		generator->set_height_range(64);
+		benchmark_generate(runner, "generate_heightmap", **generator);
+	}
+#else
+	runner.add_skipped("generate_noise", "built without basic generators");
+	runner.add_skipped("generate_heightmap", "built without basic generators");
+#endif
+}
+
+void benchmark_mesh(
+		BenchmarkRunner &runner,
+		const char *name,
+		VoxelMesher &mesher,
+		const StdVector<VoxelBuffer> &buffers
+) {
+	runner.run(name, "blocks", buffers.size(), [&mesher, &buffers]() {
+		for (const VoxelBuffer &vb : buffers) {
+			VoxelMesher::Output output;
+			mesher.build(output, VoxelMesher::Input{ vb, nullptr, Vector3i(), 0, false });
+		}
+	});
+}
+
+void benchmark_meshing(BenchmarkRunner &runner) {
+	Ref<VoxelGeneratorGraph> generator = create_graph_generator();
+
+#ifdef VOXEL_ENABLE_SMOOTH_MESHING
+	{
+		Ref<VoxelMesherTransvoxel> mesher;
+		mesher.instantiate();
+
+		StdVector<VoxelBuffer> buffers;
+		generate_area_blocks(**generator, mesher->get_minimum_padding(), mesher->get_maximum_padding(), buffers);
+		benchmark_mesh(runner, "mesh_transvoxel", **mesher, buffers);
+	}
+#else
+	runner.add_skipped("mesh_transvoxel", "built without smooth meshing");
+#endif
+	{
+		Ref<VoxelBlockyLibrary> library;
+		library.instantiate();
+		{
+			Ref<VoxelBlockyModelEmpty> air;
+			air.instantiate();
+			library->add_model(air);
+		}
+		{
+			Ref<VoxelBlockyModelCube> cube;
+			cube.instantiate();
+			library->add_model(cube);
+		}
+		library->bake();
+
+		Ref<VoxelMesherBlocky> mesher;
+		mesher.instantiate();
+		mesher->set_library(library);
+
+		StdVector<VoxelBuffer> buffers;
+		generate_area_blocks(**generator, mesher->get_minimum_padding(), mesher->get_maximum_padding(), buffers);
+		for (VoxelBuffer &vb : buffers) {
+			convert_sdf_to_solid(vb, VoxelBuffer::CHANNEL_TYPE, 1);
+		}
+		benchmark_mesh(runner, "mesh_blocky", **mesher, buffers);
+	}
+	{
+		Ref<VoxelMesherCubes> mesher;
+		mesher.instantiate();
+		mesher->set_color_mode(VoxelMesherCubes::COLOR_RAW);
+
+		StdVector<VoxelBuffer> buffers;
+		generate_area_blocks(**generator, mesher->get_minimum_padding(), mesher->get_maximum_padding(), buffers);
+		for (VoxelBuffer &vb : buffers) {
+			vb.set_channel_depth(VoxelBuffer::CHANNEL_COLOR, VoxelBuffer::DEPTH_16_BIT);
+			convert_sdf_to_solid(vb, VoxelBuffer::CHANNEL_COLOR, Color8(100, 200, 50, 255).to_u16());
+		}
+		benchmark_mesh(runner, "mesh_cubes", **mesher, buffers);
+	}
+}
+
+void benchmark_serialization(BenchmarkRunner &runner) {
+	Ref<VoxelGeneratorGraph> generator = create_graph_generator();
+	StdVector<VoxelBuffer> buffers;
+	generate_area_blocks(**generator, 0, 0, buffers);
+
+	StdVector<StdVector<uint8_t>> serialized;
+	StdVector<StdVector<uint8_t>> compressed;
+	for (const VoxelBuffer &vb : buffers) {
+		serialized.push_back(BlockSerializer::serialize(vb).data);
+		compressed.push_back(BlockSerializer::serialize_and_compress(vb).data);
+	}
+
+	VoxelBuffer temp(VoxelBuffer::ALLOCATOR_DEFAULT);
+
+	runner.run("serialize", "blocks", buffers.size(), [&buffers]() {
+		for (const VoxelBuffer &vb : buffers) {
+			BlockSerializer::serialize(vb);
+		}
+	});
+	runner.run("deserialize", "blocks", serialized.size(), [&serialized, &temp]() {
+		for (const StdVector<uint8_t> &data : serialized) {
+			BlockSerializer::deserialize(to_span_const(data), temp);
+		}
+	});
+	runner.run("serialize_and_compress", "blocks", buffers.size(), [&buffers]() {
+		for (const VoxelBuffer &vb : buffers) {
+			BlockSerializer::serialize_and_compress(vb);
+		}
+	});
+	runner.run("decompress_and_deserialize", "blocks", compressed.size(), [&compressed, &temp]() {
+		for (const StdVector<uint8_t> &data : compressed) {
+			BlockSerializer::decompress_and_deserialize(to_span_const(data), temp);
+		}
+	});
+}
+
+void benchmark_stream(BenchmarkRunner &runner, const char *save_name, const char *load_name, VoxelStream &stream) {
+	Ref<VoxelGeneratorGraph> generator = create_graph_generator();
+	StdVector<VoxelBuffer> buffers;
+	generate_area_blocks(**generator, 0, 0, buffers);
+
+	StdVector<Vector3i> positions;
+	get_area_block_positions(positions);
+
+	StdVector<VoxelBuffer> loaded_buffers;
+	loaded_buffers.reserve(buffers.size());
+	StdVector<VoxelStream::VoxelQueryData> save_queries;
+	StdVector<VoxelStream::VoxelQueryData> load_queries;
+	for (unsigned int i = 0; i < buffers.size(); ++i) {
+		loaded_buffers.emplace_back(VoxelBuffer::ALLOCATOR_DEFAULT);
+		loaded_buffers.back().create(Vector3iUtil::create(BLOCK_SIZE));
+		save_queries.push_back(VoxelStream::VoxelQueryData{ buffers[i], positions[i], 0, VoxelStream::RESULT_ERROR });
+		load_queries.push_back(
+				VoxelStream::VoxelQueryData{ loaded_buffers[i], positions[i], 0, VoxelStream::RESULT_ERROR }
+		);
+	}
+
+	// Saving the same blocks again overwrites them, so every iteration does the same work
+	runner.run(save_name, "blocks", save_queries.size(), [&stream, &save_queries]() {
+		stream.save_voxel_blocks(to_span(save_queries));
+		stream.flush();
+	});
+	runner.run(load_name, "blocks", load_queries.size(), [&stream, &load_queries]() {
+		stream.load_voxel_blocks(to_span(load_queries));
+	});
+}
+
+void benchmark_streams(BenchmarkRunner &runner) {
+	{
+		TestDirectory test_dir;
+		ZN_ASSERT_RETURN(test_dir.is_valid());
+
+		Ref<VoxelStreamRegionFiles> stream;
+		stream.instantiate();
+		stream->set_block_size_po2(BLOCK_SIZE_PO2);
+		stream->set_directory(test_dir.get_path());
+		benchmark_stream(runner, "region_save", "region_load", **stream);
+	}
+#ifdef VOXEL_ENABLE_SQLITE
+	{
+		TestDirectory test_dir;
+		ZN_ASSERT_RETURN(test_dir.is_valid());
+
+		Ref<VoxelStreamSQLite> stream;
+		stream.instantiate();
+		stream->set_database_path(test_dir.get_path().path_join("database.sqlite"));
+		benchmark_stream(runner, "sqlite_save", "sqlite_load", **stream);
+	}
+#else
+	runner.add_skipped("sqlite_save", "built without SQLite");
+	runner.add_skipped("sqlite_load", "built without SQLite");
+#endif
+}
+
+#ifdef VOXEL_ENABLE_SMOOTH_MESHING
+
+uint64_t get_task_run_count(const VoxelEngine::Stats &stats, const char *task_name) {
+	for (const TaskLatencyStats::TaskTypeStats &task_stats : stats.task_latencies) {
+		if (strcmp(task_stats.name, task_name) == 0) {
+			return task_stats.counts[TaskLatencyStats::METRIC_RUN];
+		}
+	}
+	return 0;
+}
+
+// Processes the engine and the terrain the same way frames would, until there is no more work to do.
+// Frames run back to back while there is work, so `out_busy_usec` measures how long the work took. Once there seems to
+// be none left, frames are spaced out to check if the terrain schedules more, and are not counted.
+// Returns false if it took too long.
+bool process_until_idle(VoxelEngine &engine, VoxelLodTerrain &terrain, uint64_t &out_busy_usec) {
+	// The terrain may schedule more work after tasks complete, so we wait a few frames in a row without any
+	const unsigned int idle_frames_needed = 10;
+	const uint64_t timeout_usec = 120'000'000;
+	const uint32_t idle_frame_time_usec = 1000;
+
+	ProfilingClock timeout_clock;
+	ProfilingClock frame_clock;
+	unsigned int idle_frames = 0;
+	out_busy_usec = 0;
+
+	while (idle_frames < idle_frames_needed) {
+		frame_clock.restart();
+
+		engine.process();
+		terrain.notification(Node::NOTIFICATION_PROCESS);
+
+		const VoxelEngine::Stats stats = engine.get_stats();
+		const bool idle = stats.generation_tasks == 0 && stats.meshing_tasks == 0 && stats.streaming_tasks == 0 &&
+				stats.main_thread_tasks == 0;
+
+		if (timeout_clock.get_elapsed_microseconds() > timeout_usec) {
+			return false;
+		}
+
+		if (idle) {
+			++idle_frames;
+			Thread::sleep_usec(idle_frame_time_usec);
+		} else {
+			idle_frames = 0;
+			out_busy_usec += frame_clock.get_elapsed_microseconds();
+		}
+	}
+	return true;
+}
+
+void benchmark_lod_terrain_streaming(BenchmarkRunner &runner) {
+	const char *name = "lod_terrain_streaming";
+	if (!runner.can_run(name)) {
+		return;
+	}
+
+	// The terrain has to be in the scene tree to process, which isn't the case when benchmarks run on startup
+	SceneTree *tree = Object::cast_to<SceneTree>(Engine::get_singleton()->get_main_loop());
+	if (tree == nullptr || tree->get_root() == nullptr) {
+		runner.add_skipped(name, "requires a SceneTree");
+		return;
+	}
+
+	VoxelEngine &engine = VoxelEngine::get_singleton();
+
+	Ref<VoxelMesherTransvoxel> mesher;
+	mesher.instantiate();
+
+	VoxelLodTerrain *terrain = memnew(VoxelLodTerrain);
+	terrain->set_generator(create_graph_generator());
+	terrain->set_mesher(mesher);
+	terrain->set_lod_count(4);
+	terrain->set_view_distance(256);
+	terrain->set_generate_collisions(false);
+	tree->get_root()->add_child(terrain);
+
+	const ViewerID viewer_id = engine.add_viewer();
+	engine.set_viewer_distances(viewer_id, VoxelEngine::Viewer::Distances{ 256, 256 });
+	engine.set_viewer_requires_visuals(viewer_id, true);
+	engine.set_viewer_requires_collisions(viewer_id, false);
+
+	engine.clear_task_latency_stats();
+
+	// Fixed path, moving in a straight line and stopping at regular intervals until the area around is loaded
+	const unsigned int waypoint_count = 8;
+	const float waypoint_spacing = 64.f;
+
+	uint64_t duration_usec = 0;
+	bool timed_out = false;
+	for (unsigned int i = 0; i < waypoint_count && !timed_out; ++i) {
+		engine.set_viewer_position(viewer_id, Vector3(i * waypoint_spacing, 0, 0));
+		uint64_t busy_usec = 0;
+		timed_out = !process_until_idle(engine, *terrain, busy_usec);
+		duration_usec += busy_usec;
+	}
+
+	const VoxelEngine::Stats stats = engine.get_stats();
+	const uint64_t meshed_block_count = get_task_run_count(stats, "MeshBlock");
+
+	engine.remove_viewer(viewer_id);
+	tree->get_root()->remove_child(terrain);
+	memdelete(terrain);
+
+	if (timed_out) {
+		ZN_PRINT_ERROR(format("Benchmark `{}` timed out", name));
+		runner.add_skipped(name, "timed out");
+		return;
+	}
+
+	// Streaming happens only once, so there is a single sample
+	const uint64_t durations_usec[] = { duration_usec };
+	runner.add_result(name, "meshed blocks", meshed_block_count, Span<const uint64_t>(durations_usec, 1));
+}
+
+#endif // VOXEL_ENABLE_SMOOTH_MESHING
+
+} // namespace
+
+void run_voxel_benchmarks(const TestOptions &options, unsigned int iterations, FwdMutableStdString out_json) {
+	print_line("------------ Voxel benchmarks begin -------------");
+
+	BenchmarkRunner runner(options, iterations);
+
+	benchmark_generation(runner);
+	benchmark_meshing(runner);
+	benchmark_serialization(runner);
+	benchmark_streams(runner);
+#ifdef VOXEL_ENABLE_SMOOTH_MESHING
+	benchmark_lod_terrain_streaming(runner);
+#else
+	runner.add_skipped("lod_terrain_streaming", "built without smooth meshing");
+#endif
+
+	runner.print_results();
+	runner.get_json(out_json);
+
+	print_line("------------ Voxel benchmarks end -------------");
+}
+
+} // namespace zylann::voxel::tests
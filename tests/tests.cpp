@@ -7,12 +7,17 @@
 #include "util/test_expression_parser.h"
 #include "util/test_flat_map.h"
 #include "util/test_island_finder.h"
+#include "util/test_lru_cache.h"
+#include "util/test_main_thread_time_budget.h"
 #include "util/test_math_funcs.h"
 #include "util/test_noise.h"
 #include "util/test_slot_map.h"
 #include "util/test_spatial_lock.h"
 #include "util/test_string_funcs.h"
+#include "util/test_task_latency_stats.h"
+#include "util/test_task_priority_queue.h"
 #include "util/test_threaded_task_runner.h"
+#include "util/test_trace_recorder.h"
 
 #include "voxel/test_block_serializer.h"
 #include "voxel/test_curve_range.h"
@@ -20,12 +25,15 @@
 #include "voxel/test_octree.h"
 #include "voxel/test_raycast.h"
 #include "voxel/test_region_file.h"
+#include "voxel/test_session_trace.h"
 #include "voxel/test_storage_funcs.h"
 #include "voxel/test_voxel_buffer.h"
 #include "voxel/test_voxel_data_map.h"
 #include "voxel/test_voxel_graph.h"
 #include "voxel/test_voxel_instancer.h"
 #include "voxel/test_voxel_mesher_cubes.h"
+#include "voxel/test_voxel_terrain.h"
+#include "voxel/test_voxel_terrain_multiplayer_synchronizer.h"
 
 #ifdef VOXEL_ENABLE_SMOOTH_MESHING
 #include "voxel/test_transvoxel.h"
@@ -60,6 +68,7 @@ void run_voxel_tests(const testing::TestOptions &options) {
 	using namespace zylann::tests;
 
 	VOXEL_TEST(test_wrap);
+	VOXEL_TEST(test_float4);
 	VOXEL_TEST(test_int32_to_string_base10);
 	VOXEL_TEST(test_string_base10_to_int32);
 	VOXEL_TEST(test_voxel_buffer_metadata);
@@ -123,7 +132,11 @@ void run_voxel_tests(const testing::TestOptions &options) {
 	VOXEL_TEST(test_voxel_buffer_create);
 	VOXEL_TEST(test_block_serializer);
 	VOXEL_TEST(test_block_serializer_stream_peer);
+	VOXEL_TEST(test_block_serializer_delta);
 	VOXEL_TEST(test_region_file);
+	VOXEL_TEST(test_region_file_deduplication);
+	VOXEL_TEST(test_session_trace_serialization);
+	VOXEL_TEST(test_session_recorder);
 	VOXEL_TEST(test_voxel_stream_region_files);
 #ifdef VOXEL_ENABLE_FAST_NOISE_2
 	VOXEL_TEST(test_fast_noise_2_basic);
@@ -131,11 +144,28 @@ void run_voxel_tests(const testing::TestOptions &options) {
 #endif
 	VOXEL_TEST(test_run_blocky_random_tick);
 	VOXEL_TEST(test_flat_map);
+	VOXEL_TEST(test_lru_cache);
 	VOXEL_TEST(test_expression_parser);
 	VOXEL_TEST(test_voxel_mesher_cubes);
+	VOXEL_TEST(test_voxel_terrain_generate_and_mesh_support);
+	VOXEL_TEST(test_voxel_generator_multipass_cb_cache_hit);
+	VOXEL_TEST(test_voxel_generator_multipass_cb_cache_eviction);
+	VOXEL_TEST(test_voxel_generator_multipass_cb_dependency_wait);
+	VOXEL_TEST(test_voxel_terrain_multiplayer_synchronizer_send_order);
+	VOXEL_TEST(test_voxel_terrain_multiplayer_synchronizer_send_budget);
 	VOXEL_TEST(test_threaded_task_runner_misc);
+	VOXEL_TEST(test_threaded_task_runner_serial_keys);
 	VOXEL_TEST(test_threaded_task_runner_debug_names);
 	VOXEL_TEST(test_task_priority_values);
+	VOXEL_TEST(test_threaded_task_runner_priority_order);
+	VOXEL_TEST(test_threaded_task_runner_serial_not_starved);
+	VOXEL_TEST(test_threaded_task_runner_contention);
+	VOXEL_TEST(test_task_priority_queue);
+	VOXEL_TEST(test_latency_histogram);
+	VOXEL_TEST(test_task_latency_stats);
+	VOXEL_TEST(test_trace_recorder);
+	VOXEL_TEST(test_trace_recorder_thread_buffer_reuse);
+	VOXEL_TEST(test_main_thread_time_budget);
 #ifdef VOXEL_ENABLE_MESH_SDF
 	VOXEL_TEST(test_voxel_mesh_sdf_issue463);
 #endif
@@ -156,15 +186,30 @@ void run_voxel_tests(const testing::TestOptions &options) {
 	VOXEL_TEST(test_voxel_stream_sqlite_key_blob80_encoding);
 	VOXEL_TEST(test_voxel_stream_sqlite_basic);
 	VOXEL_TEST(test_voxel_stream_sqlite_coordinate_format);
+	VOXEL_TEST(test_voxel_stream_sqlite_deduplication);
+	VOXEL_TEST(test_voxel_stream_sqlite_new_database_version);
+	VOXEL_TEST(test_voxel_stream_sqlite_migration_with_pooled_connections);
 #endif
 	VOXEL_TEST(test_sdf_hemisphere);
 	VOXEL_TEST(test_fnl_range);
+	VOXEL_TEST(test_fnl_series);
 	VOXEL_TEST(test_voxel_buffer_set_channel_bytes);
 	VOXEL_TEST(test_voxel_buffer_issue769);
 	VOXEL_TEST(test_raycast_sdf);
 	VOXEL_TEST(test_raycast_blocky);
 	VOXEL_TEST(test_raycast_blocky_no_cache_graph);
 	VOXEL_TEST(test_voxel_graph_constant_reduction);
+	VOXEL_TEST(test_voxel_graph_operation_fusion);
+	VOXEL_TEST(test_voxel_graph_tile_streaming);
+	VOXEL_TEST(test_voxel_graph_generate_blocks_stacked);
+	VOXEL_TEST(test_voxel_graph_adaptive_subdivision);
+	VOXEL_TEST(test_voxel_graph_column_cache);
+	VOXEL_TEST(test_voxel_graph_block_cache);
+	VOXEL_TEST(test_voxel_graph_sparse_sampling);
+	VOXEL_TEST(test_voxel_graph_profiling);
+#ifdef VOXEL_ENABLE_FAST_NOISE_2
+	VOXEL_TEST(test_voxel_graph_fast_noise_2_grid);
+#endif
 #ifdef VOXEL_ENABLE_SMOOTH_MESHING
 	VOXEL_TEST(test_transvoxel_issue772);
 #endif
@@ -2,6 +2,7 @@
 #define VOXEL_TESTS_H
 
 #include "../util/godot/macros.h"
+#include "../util/string/fwd_std_string.h"
 
 namespace zylann {
 
@@ -13,6 +14,8 @@ namespace voxel {
 
 namespace tests {
 void run_voxel_tests(const testing::TestOptions &options);
+// Runs performance benchmarks and writes their results as JSON
+void run_voxel_benchmarks(const testing::TestOptions &options, unsigned int iterations, FwdMutableStdString out_json);
 }
 
 namespace noise_tests {
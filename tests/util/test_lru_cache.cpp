@@ -0,0 +1,59 @@
+#include "test_lru_cache.h"
+#include "../../util/containers/lru_cache.h"
+#include "../../util/testing/test_macros.h"
+
+namespace zylann::tests {
+
+void test_lru_cache() {
+	struct Hasher {
+		inline size_t operator()(int key) const {
+			return key;
+		}
+	};
+
+	const size_t value_usage = 1000;
+	LRUCache<int, int, Hasher> cache(10 * value_usage);
+
+	for (int i = 0; i < 5; ++i) {
+		cache.set(i, 100 * i, value_usage);
+	}
+	ZN_TEST_ASSERT(cache.get_stats().entry_count == 5);
+
+	const int *value = cache.get(3);
+	ZN_TEST_ASSERT(value != nullptr && *value == 300);
+	ZN_TEST_ASSERT(cache.get(42) == nullptr);
+	// Unusable values count as misses
+	ZN_TEST_ASSERT(cache.get_if(2, [](const int v) { return v != 200; }) == nullptr);
+
+	LRUCacheStats stats = cache.get_stats();
+	ZN_TEST_ASSERT(stats.hit_count == 1);
+	ZN_TEST_ASSERT(stats.miss_count == 2);
+
+	// Replacing a value doesn't count it twice
+	const size_t memory_usage = stats.memory_usage;
+	cache.set(4, 4, value_usage);
+	ZN_TEST_ASSERT(cache.get_stats().memory_usage == memory_usage);
+
+	// Use 0 so it becomes more recent than the others
+	ZN_TEST_ASSERT(cache.get(0) != nullptr);
+
+	// Exceeding capacity evicts least recently used entries first
+	for (int i = 5; i < 10; ++i) {
+		cache.set(i, 100 * i, value_usage);
+	}
+	stats = cache.get_stats();
+	ZN_TEST_ASSERT(stats.memory_usage <= cache.get_capacity());
+	ZN_TEST_ASSERT(cache.get(1) == nullptr);
+	ZN_TEST_ASSERT(cache.get(0) != nullptr);
+	ZN_TEST_ASSERT(cache.get(9) != nullptr);
+
+	cache.set_capacity(0);
+	ZN_TEST_ASSERT(cache.get_stats().entry_count == 0);
+	cache.set(1, 1, value_usage);
+	ZN_TEST_ASSERT(cache.get_stats().entry_count == 0);
+
+	cache.reset_stats();
+	ZN_TEST_ASSERT(cache.get_stats().hit_count == 0);
+}
+
+} // namespace zylann::tests
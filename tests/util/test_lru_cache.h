@@ -0,0 +1,10 @@
+#ifndef ZN_TESTS_LRU_CACHE_H
+#define ZN_TESTS_LRU_CACHE_H
+
+namespace zylann::tests {
+
+void test_lru_cache();
+
+} // namespace zylann::tests
+
+#endif // ZN_TESTS_LRU_CACHE_H
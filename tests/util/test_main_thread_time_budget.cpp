@@ -0,0 +1,73 @@
+#include "test_main_thread_time_budget.h"
+#include "../../util/tasks/main_thread_time_budget.h"
+#include "../../util/testing/test_macros.h"
+
+namespace zylann::tests {
+
+void test_main_thread_time_budget() {
+	const uint32_t target_frame_time_usec = 16'666;
+
+	// Simulates frames where the rest of the game takes `other_work_usec`, and where there is always more main thread
+	// work than the budget allows. Returns the frame time once it settled.
+	struct L {
+		static uint32_t simulate(MainThreadTimeBudget &budget, const uint32_t other_work_usec) {
+			uint32_t frame_time_usec = 0;
+			for (unsigned int i = 0; i < 300; ++i) {
+				budget.begin_frame(frame_time_usec, true);
+				frame_time_usec = other_work_usec + budget.get_budget_usec();
+			}
+			return frame_time_usec;
+		}
+	};
+
+	{
+		MainThreadTimeBudget budget;
+		budget.set_fixed_budget_usec(8000);
+		budget.set_target_frame_time_usec(target_frame_time_usec);
+		// Not adaptive, the budget must not change
+		L::simulate(budget, 15'000);
+		ZN_TEST_ASSERT(budget.get_budget_usec() == 8000);
+	}
+	{
+		MainThreadTimeBudget budget;
+		budget.set_fixed_budget_usec(8000);
+		budget.set_target_frame_time_usec(target_frame_time_usec);
+		budget.set_adaptive_enabled(true);
+
+		// The rest of the game is heavy, the budget must shrink so frames get close to the target
+		const uint32_t frame_time_usec = L::simulate(budget, 12'000);
+		ZN_TEST_ASSERT(budget.get_budget_usec() < 8000);
+		ZN_TEST_ASSERT(frame_time_usec >= target_frame_time_usec * 0.9f);
+		ZN_TEST_ASSERT(frame_time_usec <= target_frame_time_usec * 1.1f);
+
+		// The rest of the game got light, the budget must grow, but not beyond half of the frame
+		L::simulate(budget, 2'000);
+		ZN_TEST_ASSERT(budget.get_budget_usec() == target_frame_time_usec / 2);
+
+		// The game is too slow anyways, the budget must stay at its minimum so work can still progress
+		L::simulate(budget, 30'000);
+		ZN_TEST_ASSERT(budget.get_budget_usec() == MainThreadTimeBudget::MIN_ADAPTIVE_BUDGET_USEC);
+	}
+	{
+		MainThreadTimeBudget budget;
+		budget.set_fixed_budget_usec(8000);
+		budget.set_category_ratio(1, 0.25f);
+
+		ZN_TEST_ASSERT(budget.get_category_budget_usec(0) == 8000);
+		ZN_TEST_ASSERT(budget.get_category_budget_usec(1) == 2000);
+
+		budget.add_category_time_usec(1, 1500);
+		ZN_TEST_ASSERT(budget.get_category_remaining_usec(1) == 500);
+		ZN_TEST_ASSERT(!budget.is_category_exhausted(1));
+		budget.add_category_time_usec(1, 1000);
+		ZN_TEST_ASSERT(budget.is_category_exhausted(1));
+		ZN_TEST_ASSERT(!budget.is_category_exhausted(0));
+
+		// Spent time is reset every frame
+		budget.begin_frame(16'000, false);
+		ZN_TEST_ASSERT(!budget.is_category_exhausted(1));
+		ZN_TEST_ASSERT(budget.get_category_stats(1).spent_usec == 2500);
+	}
+}
+
+} // namespace zylann::tests
@@ -0,0 +1,10 @@
+#ifndef ZN_TEST_MAIN_THREAD_TIME_BUDGET_H
+#define ZN_TEST_MAIN_THREAD_TIME_BUDGET_H
+
+namespace zylann::tests {
+
+void test_main_thread_time_budget();
+
+} // namespace zylann::tests
+
+#endif // ZN_TEST_MAIN_THREAD_TIME_BUDGET_H
@@ -1,4 +1,5 @@
 #include "test_math_funcs.h"
+#include "../../util/math/float4.h"
 #include "../../util/math/funcs.h"
 #include "../../util/testing/test_macros.h"
 
@@ -30,4 +31,89 @@ void test_wrap() {
 	}
 }
 
+void test_float4() {
+	// Values chosen to cover signs, zeros, fractions and floats too large to fit in 32-bit integers
+	const float values[] = { -1e10f, -8388609.f, -3.5f, -1.f, -0.25f, 0.f, 0.25f, 1.f, 2.75f, 8388609.f, 1e10f, 7.f };
+	const unsigned int count = sizeof(values) / sizeof(values[0]);
+	static_assert(count % math::Float4::SIZE == 0);
+
+	struct L {
+		static void check(const math::Float4 v, const float *expected) {
+			float results[math::Float4::SIZE];
+			v.store(results);
+			for (unsigned int i = 0; i < math::Float4::SIZE; ++i) {
+				ZN_TEST_ASSERT(results[i] == expected[i]);
+			}
+		}
+	};
+
+	for (unsigned int i = 0; i < count; i += math::Float4::SIZE) {
+		const float *a = values + i;
+		// Another lane order so binary operations see different pairs
+		const float *b = values + (count - math::Float4::SIZE - i);
+		const math::Float4 va = math::Float4::load(a);
+		const math::Float4 vb = math::Float4::load(b);
+		float expected[math::Float4::SIZE];
+
+		for (unsigned int j = 0; j < math::Float4::SIZE; ++j) {
+			expected[j] = a[j] + b[j];
+		}
+		L::check(va + vb, expected);
+
+		for (unsigned int j = 0; j < math::Float4::SIZE; ++j) {
+			expected[j] = a[j] - b[j];
+		}
+		L::check(va - vb, expected);
+
+		for (unsigned int j = 0; j < math::Float4::SIZE; ++j) {
+			expected[j] = a[j] * b[j];
+		}
+		L::check(va * vb, expected);
+
+		for (unsigned int j = 0; j < math::Float4::SIZE; ++j) {
+			expected[j] = math::min(a[j], b[j]);
+		}
+		L::check(math::min(va, vb), expected);
+
+		for (unsigned int j = 0; j < math::Float4::SIZE; ++j) {
+			expected[j] = math::max(a[j], b[j]);
+		}
+		L::check(math::max(va, vb), expected);
+
+		for (unsigned int j = 0; j < math::Float4::SIZE; ++j) {
+			expected[j] = math::clamp(a[j], -1.f, 1.f);
+		}
+		L::check(math::clamp(va, math::Float4(-1.f), math::Float4(1.f)), expected);
+
+		for (unsigned int j = 0; j < math::Float4::SIZE; ++j) {
+			expected[j] = Math::abs(-a[j]);
+		}
+		L::check(math::abs(-va), expected);
+
+		for (unsigned int j = 0; j < math::Float4::SIZE; ++j) {
+			expected[j] = Math::floor(a[j]);
+		}
+		L::check(math::floor(va), expected);
+
+		for (unsigned int j = 0; j < math::Float4::SIZE; ++j) {
+			expected[j] = Math::sqrt(Math::abs(a[j]));
+		}
+		L::check(math::sqrt(math::abs(va)), expected);
+
+		for (unsigned int j = 0; j < math::Float4::SIZE; ++j) {
+			expected[j] = math::div_or_zero(a[j], values[5 + j % 2]);
+		}
+		const float divisors[] = { values[5], values[6], values[5], values[6] };
+		L::check(math::div_or_zero(va, math::Float4::load(divisors)), expected);
+
+		// Compilers may fuse multiply-adds differently in scalar code, so this one is approximate
+		float lerp_results[math::Float4::SIZE];
+		math::lerp(va, vb, math::Float4(0.25f)).store(lerp_results);
+		for (unsigned int j = 0; j < math::Float4::SIZE; ++j) {
+			const float e = Math::lerp(a[j], b[j], 0.25f);
+			ZN_TEST_ASSERT(Math::abs(lerp_results[j] - e) <= 1e-6f * math::max(Math::abs(e), 1.f));
+		}
+	}
+}
+
 } // namespace zylann::tests
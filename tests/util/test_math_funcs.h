@@ -4,6 +4,7 @@
 namespace zylann::tests {
 
 void test_wrap();
+void test_float4();
 
 } // namespace zylann::tests
 
@@ -1,6 +1,7 @@
 #include "test_noise.h"
 #include "../../util/noise/fast_noise_lite/fast_noise_lite.h"
 #include "../../util/noise/fast_noise_lite/fast_noise_lite_range.h"
+#include "../../util/containers/std_vector.h"
 #include "../../util/testing/test_macros.h"
 
 namespace zylann::tests {
@@ -48,4 +49,63 @@ void test_fnl_range() {
 	ZN_TEST_ASSERT(analytic_range.contains(empiric_range));
 }
 
+void test_fnl_series() {
+	// Series must give the same results as querying noise one value at a time, including noise types which have no
+	// vectorized implementation. The count is not a multiple of 4, so remaining values are tested too.
+	const unsigned int count = 67;
+
+	StdVector<float> x;
+	StdVector<float> y;
+	StdVector<float> z;
+	for (unsigned int i = 0; i < count; ++i) {
+		// Some integer coordinates, including negative ones, as they are edge cases of flooring
+		x.push_back(i < 8 ? static_cast<float>(i) - 4.f : i * 7.31f - 250.f);
+		y.push_back(i < 8 ? 3.f - static_cast<float>(i) : 180.f - i * 5.17f);
+		z.push_back(i * 2.93f - 90.f);
+	}
+
+	const ZN_FastNoiseLite::NoiseType noise_types[] = {
+		ZN_FastNoiseLite::TYPE_OPEN_SIMPLEX_2, //
+		ZN_FastNoiseLite::TYPE_OPEN_SIMPLEX_2S, //
+		ZN_FastNoiseLite::TYPE_CELLULAR, //
+		ZN_FastNoiseLite::TYPE_PERLIN, //
+		ZN_FastNoiseLite::TYPE_VALUE_CUBIC, //
+		ZN_FastNoiseLite::TYPE_VALUE //
+	};
+	const ZN_FastNoiseLite::FractalType fractal_types[] = {
+		ZN_FastNoiseLite::FRACTAL_NONE, //
+		ZN_FastNoiseLite::FRACTAL_FBM, //
+		ZN_FastNoiseLite::FRACTAL_RIDGED, //
+		ZN_FastNoiseLite::FRACTAL_PING_PONG //
+	};
+
+	StdVector<float> series;
+	series.resize(count);
+
+	for (const ZN_FastNoiseLite::NoiseType noise_type : noise_types) {
+		for (const ZN_FastNoiseLite::FractalType fractal_type : fractal_types) {
+			Ref<ZN_FastNoiseLite> noise;
+			noise.instantiate();
+			noise->set_noise_type(noise_type);
+			noise->set_fractal_type(fractal_type);
+			noise->set_fractal_octaves(3);
+			noise->set_fractal_weighted_strength(0.4);
+			noise->set_period(37.0);
+			noise->set_seed(131);
+			noise->set_cellular_return_type(ZN_FastNoiseLite::CELLULAR_RETURN_DISTANCE_2_SUB);
+			noise->set_rotation_type_3d(ZN_FastNoiseLite::ROTATION_3D_IMPROVE_XZ_PLANES);
+
+			noise->get_noise_2d_series(to_span(x), to_span(y), to_span(series));
+			for (unsigned int i = 0; i < count; ++i) {
+				ZN_TEST_ASSERT(series[i] == noise->get_noise_2d(x[i], y[i]));
+			}
+
+			noise->get_noise_3d_series(to_span(x), to_span(y), to_span(z), to_span(series));
+			for (unsigned int i = 0; i < count; ++i) {
+				ZN_TEST_ASSERT(series[i] == noise->get_noise_3d(x[i], y[i], z[i]));
+			}
+		}
+	}
+}
+
 } // namespace zylann::tests
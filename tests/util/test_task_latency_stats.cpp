@@ -0,0 +1,91 @@
+#include "test_task_latency_stats.h"
+#include "../../util/containers/std_vector.h"
+#include "../../util/tasks/task_latency_stats.h"
+#include "../../util/testing/test_macros.h"
+#include <cstring>
+
+namespace zylann::tests {
+
+namespace {
+
+bool is_within_error(const uint64_t value, const uint64_t expected) {
+	// Buckets have 16 sub-buckets per power of two
+	const uint64_t max_error = expected / 16 + 1;
+	return value + max_error >= expected && value <= expected + max_error;
+}
+
+} // namespace
+
+void test_latency_histogram() {
+	// Bucket indices must be contiguous and increasing with values
+	unsigned int prev_index = 0;
+	for (uint64_t v = 0; v < 100'000; ++v) {
+		const unsigned int index = LatencyHistogram::get_bucket_index(v);
+		ZN_TEST_ASSERT(index == prev_index || index == prev_index + 1);
+		ZN_TEST_ASSERT(is_within_error(LatencyHistogram::get_bucket_value(index), v));
+		prev_index = index;
+	}
+	ZN_TEST_ASSERT(LatencyHistogram::get_bucket_index(0xffffffffffff) == LatencyHistogram::BUCKET_COUNT - 1);
+
+	LatencyHistogram histogram;
+	for (uint64_t v = 1; v <= 1000; ++v) {
+		histogram.add(v * 10);
+	}
+
+	LatencyHistogram::Snapshot snapshot;
+	snapshot.add(histogram);
+	ZN_TEST_ASSERT(snapshot.total_count == 1000);
+	ZN_TEST_ASSERT(is_within_error(snapshot.get_percentile(0.5f), 5000));
+	ZN_TEST_ASSERT(is_within_error(snapshot.get_percentile(0.9f), 9000));
+	ZN_TEST_ASSERT(is_within_error(snapshot.get_percentile(0.99f), 9900));
+
+	histogram.clear();
+	LatencyHistogram::Snapshot empty_snapshot;
+	empty_snapshot.add(histogram);
+	ZN_TEST_ASSERT(empty_snapshot.total_count == 0);
+	ZN_TEST_ASSERT(empty_snapshot.get_percentile(0.5f) == 0);
+}
+
+void test_task_latency_stats() {
+	TaskLatencyStats stats(4);
+
+	// Same name from different pointers must be merged
+	static const char name_a[] = "TaskA";
+	static const char name_a_copy[] = "TaskA";
+	static const char *name_b = "TaskB";
+
+	for (uint64_t i = 0; i < 100; ++i) {
+		stats.record(0, name_a, TaskLatencyStats::METRIC_RUN, 100);
+		stats.record(1, name_a_copy, TaskLatencyStats::METRIC_RUN, 100);
+		stats.record(2, name_b, TaskLatencyStats::METRIC_WAIT, 2000);
+	}
+	stats.record(3, name_b, TaskLatencyStats::METRIC_WAIT, 1'000'000);
+
+	StdVector<TaskLatencyStats::TaskTypeStats> results;
+	stats.get_stats(results);
+	ZN_TEST_ASSERT(results.size() == 2);
+
+	for (const TaskLatencyStats::TaskTypeStats &r : results) {
+		if (std::strcmp(r.name, "TaskA") == 0) {
+			ZN_TEST_ASSERT(r.counts[TaskLatencyStats::METRIC_RUN] == 200);
+			ZN_TEST_ASSERT(r.counts[TaskLatencyStats::METRIC_WAIT] == 0);
+			ZN_TEST_ASSERT(is_within_error(r.percentiles_usec[TaskLatencyStats::METRIC_RUN].p99, 100));
+
+		} else {
+			ZN_TEST_ASSERT(std::strcmp(r.name, "TaskB") == 0);
+			ZN_TEST_ASSERT(r.counts[TaskLatencyStats::METRIC_WAIT] == 101);
+			ZN_TEST_ASSERT(is_within_error(r.percentiles_usec[TaskLatencyStats::METRIC_WAIT].p50, 2000));
+			ZN_TEST_ASSERT(is_within_error(r.percentiles_usec[TaskLatencyStats::METRIC_WAIT].p99, 2000));
+		}
+	}
+
+	stats.clear();
+	stats.get_stats(results);
+	for (const TaskLatencyStats::TaskTypeStats &r : results) {
+		for (unsigned int metric = 0; metric < TaskLatencyStats::METRIC_COUNT; ++metric) {
+			ZN_TEST_ASSERT(r.counts[metric] == 0);
+		}
+	}
+}
+
+} // namespace zylann::tests
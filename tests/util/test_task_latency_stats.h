@@ -0,0 +1,11 @@
+#ifndef ZN_TEST_TASK_LATENCY_STATS_H
+#define ZN_TEST_TASK_LATENCY_STATS_H
+
+namespace zylann::tests {
+
+void test_latency_histogram();
+void test_task_latency_stats();
+
+} // namespace zylann::tests
+
+#endif // ZN_TEST_TASK_LATENCY_STATS_H
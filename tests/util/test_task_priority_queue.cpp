@@ -0,0 +1,113 @@
+#include "test_task_priority_queue.h"
+#include "../../util/containers/std_vector.h"
+#include "../../util/godot/core/random_pcg.h"
+#include "../../util/tasks/task_priority_queue.h"
+#include "../../util/testing/test_macros.h"
+#include <algorithm>
+
+namespace zylann::tests {
+
+void test_task_priority_queue() {
+	struct Item {
+		uint32_t id;
+		uint32_t priority;
+	};
+
+	TaskPriorityQueue<Item> queue;
+	ZN_TEST_ASSERT(queue.is_empty());
+	ZN_TEST_ASSERT(queue.get_top_priority() == TaskPriority::min());
+
+	StdVector<Item> expected_items;
+
+	RandomPCG rng;
+	rng.seed(131183);
+
+	for (uint32_t i = 0; i < 2000; ++i) {
+		// Use a few values only in upper bands, like tasks usually do
+		const TaskPriority priority(rng.rand() % 256, rng.rand() % 8, rng.rand() % 3, 255 - rng.rand() % 2);
+		const Item item{ i, priority.whole };
+		queue.push(priority, item);
+		expected_items.push_back(item);
+	}
+
+	ZN_TEST_ASSERT(queue.size() == expected_items.size());
+
+	// Lower priority of items with even IDs, and remove items multiple of 3
+	queue.update([](Item &item, TaskPriority &inout_priority) {
+		ZN_TEST_ASSERT(item.priority == inout_priority.whole);
+		if ((item.id % 3) == 0) {
+			return false;
+		}
+		if ((item.id % 2) == 0) {
+			inout_priority.band2 = 0;
+			inout_priority.band3 = 0;
+			item.priority = inout_priority.whole;
+		}
+		return true;
+	});
+
+	StdVector<Item> updated_items;
+	for (Item item : expected_items) {
+		if ((item.id % 3) == 0) {
+			continue;
+		}
+		if ((item.id % 2) == 0) {
+			item.priority &= 0x0000ffff;
+		}
+		updated_items.push_back(item);
+	}
+
+	ZN_TEST_ASSERT(queue.size() == updated_items.size());
+
+	size_t visited_count = 0;
+	queue.for_each([&visited_count](const Item &item, const TaskPriority priority) {
+		ZN_TEST_ASSERT(item.priority == priority.whole);
+		++visited_count;
+	});
+	ZN_TEST_ASSERT(visited_count == updated_items.size());
+
+	std::sort(updated_items.begin(), updated_items.end(), [](const Item &a, const Item &b) {
+		return a.priority > b.priority;
+	});
+
+	for (const Item &expected_item : updated_items) {
+		ZN_TEST_ASSERT(queue.get_top_priority().whole == expected_item.priority);
+		Item item;
+		TaskPriority priority;
+		ZN_TEST_ASSERT(queue.pop(item, &priority));
+		// Items with equal priority can come in any order
+		ZN_TEST_ASSERT(priority.whole == expected_item.priority);
+		ZN_TEST_ASSERT(item.priority == expected_item.priority);
+	}
+
+	ZN_TEST_ASSERT(queue.is_empty());
+	Item item;
+	ZN_TEST_ASSERT(queue.pop(item) == false);
+
+	// Nodes remain allocated after being emptied, check they can be reused
+	queue.push(TaskPriority(1, 2, 3, 4), Item{ 0, 0 });
+	queue.push(TaskPriority(5, 2, 3, 4), Item{ 1, 0 });
+	ZN_TEST_ASSERT(queue.get_top_priority() == TaskPriority(5, 2, 3, 4));
+	queue.clear();
+	ZN_TEST_ASSERT(queue.is_empty());
+	ZN_TEST_ASSERT(queue.get_top_priority() == TaskPriority::min());
+
+	// Popping with a filter skips items with higher priority
+	queue.push(TaskPriority(1, 0, 0, 0), Item{ 0, 0 });
+	queue.push(TaskPriority(2, 0, 0, 0), Item{ 1, 0 });
+	queue.push(TaskPriority(3, 0, 0, 1), Item{ 2, 0 });
+	TaskPriority priority;
+	ZN_TEST_ASSERT(queue.pop_first_if([](const Item &item) { return item.id != 2; }, item, &priority));
+	ZN_TEST_ASSERT(item.id == 1);
+	ZN_TEST_ASSERT(priority == TaskPriority(2, 0, 0, 0));
+	ZN_TEST_ASSERT(queue.pop_first_if([](const Item &item) { return item.id == 5; }, item) == false);
+	ZN_TEST_ASSERT(queue.size() == 2);
+	ZN_TEST_ASSERT(queue.pop_first_if([](const Item &item) { return item.id != 2; }, item));
+	ZN_TEST_ASSERT(item.id == 0);
+	ZN_TEST_ASSERT(queue.get_top_priority() == TaskPriority(3, 0, 0, 1));
+	ZN_TEST_ASSERT(queue.pop(item));
+	ZN_TEST_ASSERT(item.id == 2);
+	ZN_TEST_ASSERT(queue.is_empty());
+}
+
+} // namespace zylann::tests
@@ -0,0 +1,10 @@
+#ifndef ZN_TEST_TASK_PRIORITY_QUEUE_H
+#define ZN_TEST_TASK_PRIORITY_QUEUE_H
+
+namespace zylann::tests {
+
+void test_task_priority_queue();
+
+} // namespace zylann::tests
+
+#endif // ZN_TEST_TASK_PRIORITY_QUEUE_H
@@ -5,6 +5,7 @@
 #include "../../util/godot/classes/time.h"
 #include "../../util/godot/core/random_pcg.h"
 #include "../../util/io/log.h"
+#include "../../util/math/funcs.h"
 #include "../../util/math/vector3i.h"
 #include "../../util/memory/memory.h"
 #include "../../util/profiling.h"
@@ -144,6 +145,81 @@ void test_threaded_task_runner_misc() {
 	ZN_TEST_ASSERT(serial_counter->current_count == 0);
 }
 
+void test_threaded_task_runner_serial_keys() {
+	static const uint32_t task_duration_usec = 20'000;
+
+	struct TaskCounter {
+		std::atomic_uint32_t max_count = { 0 };
+		std::atomic_uint32_t current_count = { 0 };
+		std::atomic_uint32_t completed_count = { 0 };
+
+		void begin() {
+			const uint32_t count = ++current_count;
+			uint32_t prev_max = max_count;
+			while (prev_max < count && !max_count.compare_exchange_weak(prev_max, count)) {
+			}
+		}
+
+		void end() {
+			--current_count;
+			++completed_count;
+		}
+	};
+
+	// Simulates tasks using one of several resources, which can't be used by multiple threads at once
+	class TestTask : public IThreadedTask {
+	public:
+		TaskCounter &key_counter;
+		TaskCounter &total_counter;
+
+		TestTask(TaskCounter &p_key_counter, TaskCounter &p_total_counter) :
+				key_counter(p_key_counter), total_counter(p_total_counter) {}
+
+		void run(ThreadedTaskContext &ctx) override {
+			key_counter.begin();
+			total_counter.begin();
+			Thread::sleep_usec(task_duration_usec);
+			total_counter.end();
+			key_counter.end();
+		}
+
+		const void *get_serial_key() const override {
+			return &key_counter;
+		}
+	};
+
+	const unsigned int test_thread_count = 4;
+	const unsigned int key_count = 2;
+	const unsigned int tasks_per_key = 8;
+
+	FixedArray<TaskCounter, key_count> key_counters;
+	TaskCounter total_counter;
+
+	ThreadedTaskRunner runner;
+	runner.set_thread_count(test_thread_count);
+	runner.set_name("Test");
+
+	StdVector<IThreadedTask *> tasks;
+	for (unsigned int i = 0; i < tasks_per_key; ++i) {
+		for (unsigned int key_index = 0; key_index < key_count; ++key_index) {
+			tasks.push_back(ZN_NEW(TestTask(key_counters[key_index], total_counter)));
+		}
+	}
+	// Not scheduled as serial, but they have a key so they must run as such
+	runner.enqueue(to_span(tasks), false);
+
+	runner.wait_for_all_tasks();
+	runner.dequeue_completed_tasks([](IThreadedTask *task) { ZN_DELETE(task); });
+
+	for (const TaskCounter &counter : key_counters) {
+		ZN_TEST_ASSERT(counter.completed_count == tasks_per_key);
+		ZN_TEST_ASSERT(counter.max_count == 1);
+	}
+	ZN_TEST_ASSERT(total_counter.completed_count == key_count * tasks_per_key);
+	// Tasks with different keys are allowed to run in parallel
+	ZN_TEST_ASSERT(total_counter.max_count == key_count);
+}
+
 void test_threaded_task_runner_debug_names() {
 	class NamedTestTask1 : public IThreadedTask {
 	public:
@@ -276,6 +352,191 @@ void test_task_priority_values() {
 	ZN_TEST_ASSERT(TaskPriority(10, 10, 0, 0) < TaskPriority(10, 10, 10, 0));
 }
 
+void test_threaded_task_runner_priority_order() {
+	struct OrderLog {
+		StdVector<uint32_t> priorities;
+		Mutex mutex;
+	};
+
+	class PriorityTestTask : public IThreadedTask {
+	public:
+		TaskPriority priority;
+		OrderLog &log;
+
+		PriorityTestTask(TaskPriority p_priority, OrderLog &p_log) : priority(p_priority), log(p_log) {}
+
+		void run(ThreadedTaskContext &ctx) override {
+			MutexLock mlock(log.mutex);
+			log.priorities.push_back(priority.whole);
+		}
+
+		TaskPriority get_priority() override {
+			return priority;
+		}
+	};
+
+	OrderLog log;
+	RandomPCG rng;
+
+	StdVector<IThreadedTask *> tasks;
+	for (unsigned int i = 0; i < 1000; ++i) {
+		tasks.push_back(ZN_NEW(PriorityTestTask(TaskPriority(rng.rand(256), rng.rand(4), rng.rand(4), 0), log)));
+	}
+
+	// With a single thread, tasks scheduled at once must run from highest to lowest priority
+	ThreadedTaskRunner runner;
+	runner.set_thread_count(1);
+	runner.set_name("Test");
+	runner.enqueue(to_span(tasks), false);
+	runner.wait_for_all_tasks();
+
+	unsigned int completed_count = 0;
+	runner.dequeue_completed_tasks([&completed_count](IThreadedTask *task) {
+		ZN_DELETE(task);
+		++completed_count;
+	});
+
+	ZN_TEST_ASSERT(completed_count == tasks.size());
+	ZN_TEST_ASSERT(log.priorities.size() == tasks.size());
+	for (unsigned int i = 1; i < log.priorities.size(); ++i) {
+		ZN_TEST_ASSERT(log.priorities[i - 1] >= log.priorities[i]);
+	}
+}
+
+// Serial tasks must not wait for parallel tasks of the same priority to be all done
+void test_threaded_task_runner_serial_not_starved() {
+	struct OrderLog {
+		StdVector<bool> serial;
+		Mutex mutex;
+	};
+
+	class OrderTestTask : public IThreadedTask {
+	public:
+		OrderLog &log;
+		bool serial;
+
+		OrderTestTask(OrderLog &p_log, bool p_serial) : log(p_log), serial(p_serial) {}
+
+		void run(ThreadedTaskContext &ctx) override {
+			if (!serial) {
+				// Slow enough so the queue remains saturated while serial tasks are scheduled
+				Thread::sleep_usec(100);
+			}
+			MutexLock mlock(log.mutex);
+			log.serial.push_back(serial);
+		}
+
+		TaskPriority get_priority() override {
+			return TaskPriority(1, 1, 1, 0);
+		}
+	};
+
+	OrderLog log;
+
+	ThreadedTaskRunner runner;
+	runner.set_thread_count(1);
+	runner.set_name("Test");
+
+	const unsigned int parallel_task_count = 1000;
+	StdVector<IThreadedTask *> tasks;
+	for (unsigned int i = 0; i < parallel_task_count; ++i) {
+		tasks.push_back(ZN_NEW(OrderTestTask(log, false)));
+	}
+	runner.enqueue(to_span(tasks), false);
+
+	// More than one, because the first might be picked only because it was just scheduled
+	const unsigned int serial_task_count = 4;
+	tasks.clear();
+	for (unsigned int i = 0; i < serial_task_count; ++i) {
+		tasks.push_back(ZN_NEW(OrderTestTask(log, true)));
+	}
+	runner.enqueue(to_span(tasks), true);
+
+	runner.wait_for_all_tasks();
+
+	unsigned int completed_count = 0;
+	runner.dequeue_completed_tasks([&completed_count](IThreadedTask *task) {
+		ZN_DELETE(task);
+		++completed_count;
+	});
+
+	ZN_TEST_ASSERT(completed_count == parallel_task_count + serial_task_count);
+	ZN_TEST_ASSERT(log.serial.size() == completed_count);
+
+	unsigned int serial_run_count = 0;
+	for (unsigned int i = 0; i < log.serial.size() / 2; ++i) {
+		if (log.serial[i]) {
+			++serial_run_count;
+		}
+	}
+	ZN_TEST_ASSERT(serial_run_count == serial_task_count);
+}
+
+// Schedules a lot of very short tasks on all available threads, which mostly measures the overhead of picking tasks.
+// This is more of a benchmark, the only check is that all tasks ran.
+void test_threaded_task_runner_contention() {
+	class ShortTask : public IThreadedTask {
+	public:
+		std::atomic_uint32_t &run_count;
+		TaskPriority priority;
+
+		ShortTask(std::atomic_uint32_t &p_run_count, TaskPriority p_priority) :
+				run_count(p_run_count), priority(p_priority) {}
+
+		void run(ThreadedTaskContext &ctx) override {
+			++run_count;
+		}
+
+		TaskPriority get_priority() override {
+			return priority;
+		}
+	};
+
+	const unsigned int thread_count = math::max(Thread::get_hardware_concurrency(), 4u);
+	const unsigned int batch_count = 50;
+	const unsigned int tasks_per_batch = 1000;
+	const unsigned int task_count = batch_count * tasks_per_batch;
+
+	ThreadedTaskRunner runner;
+	runner.set_thread_count(thread_count);
+	runner.set_name("Test");
+
+	std::atomic_uint32_t run_count = { 0 };
+	RandomPCG rng;
+	StdVector<IThreadedTask *> tasks;
+
+	const uint64_t time_before = Time::get_singleton()->get_ticks_usec();
+
+	for (unsigned int batch_index = 0; batch_index < batch_count; ++batch_index) {
+		tasks.clear();
+		for (unsigned int i = 0; i < tasks_per_batch; ++i) {
+			tasks.push_back(ZN_NEW(ShortTask(run_count, TaskPriority(rng.rand(256), rng.rand(8), 0, 0))));
+		}
+		runner.enqueue(to_span(tasks), false);
+	}
+
+	runner.wait_for_all_tasks();
+
+	const uint64_t elapsed_us = Time::get_singleton()->get_ticks_usec() - time_before;
+
+	unsigned int completed_count = 0;
+	runner.dequeue_completed_tasks([&completed_count](IThreadedTask *task) {
+		ZN_DELETE(task);
+		++completed_count;
+	});
+
+	ZN_TEST_ASSERT(run_count == task_count);
+	ZN_TEST_ASSERT(completed_count == task_count);
+
+	println(format(
+			"ThreadedTaskRunner contention: {} tasks on {} threads in {} us ({} ns per task)",
+			task_count,
+			thread_count,
+			elapsed_us,
+			elapsed_us * 1000 / task_count
+	));
+}
+
 // Simulates doing work in every chunk of a grid, where each task will want to access neighbors of each block. If any
 // neighbor fails to get locked, the task is postponed.
 void test_threaded_task_postponing() {
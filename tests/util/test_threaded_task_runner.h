@@ -4,8 +4,12 @@
 namespace zylann::tests {
 
 void test_threaded_task_runner_misc();
+void test_threaded_task_runner_serial_keys();
 void test_threaded_task_runner_debug_names();
 void test_task_priority_values();
+void test_threaded_task_runner_priority_order();
+void test_threaded_task_runner_serial_not_starved();
+void test_threaded_task_runner_contention();
 void test_threaded_task_postponing();
 
 } // namespace zylann::tests
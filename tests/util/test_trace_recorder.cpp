@@ -0,0 +1,116 @@
+#include "test_trace_recorder.h"
+#include "../../util/profiling.h"
+#include "../../util/string/std_string.h"
+#include "../../util/testing/test_macros.h"
+#include "../../util/thread/thread.h"
+#include "../../util/trace_recorder.h"
+
+namespace zylann::tests {
+
+void test_trace_recorder() {
+#ifdef ZN_PROFILER_TRACE_RECORDER
+	trace_recorder::clear();
+	trace_recorder::set_enabled(true);
+
+	struct L {
+		static void thread_func(void *userdata) {
+			trace_recorder::set_thread_name("TestTraceThread");
+			for (unsigned int i = 0; i < 100; ++i) {
+				ZN_PROFILE_SCOPE_NAMED("TestTraceScope");
+			}
+			ZN_PROFILE_PLOT("TestTracePlot", 42);
+		}
+	};
+
+	Thread thread;
+	thread.start(L::thread_func, nullptr);
+	{
+		ZN_PROFILE_SCOPE_NAMED("TestTraceMainScope");
+		ZN_PROFILE_MESSAGE("TestTraceMessage");
+	}
+	thread.wait_to_finish();
+
+	trace_recorder::set_enabled(false);
+	{
+		ZN_PROFILE_SCOPE_NAMED("TestTraceNotRecorded");
+	}
+
+	StdString json;
+	trace_recorder::get_chrome_trace_json(json, 0);
+
+	ZN_TEST_ASSERT(json.find("{\"traceEvents\":[") == 0);
+	ZN_TEST_ASSERT(json.find("\"TestTraceScope\"") != StdString::npos);
+	ZN_TEST_ASSERT(json.find("\"TestTraceMainScope\"") != StdString::npos);
+	ZN_TEST_ASSERT(json.find("\"TestTraceMessage\"") != StdString::npos);
+	ZN_TEST_ASSERT(json.find("\"TestTracePlot\":42") != StdString::npos);
+	ZN_TEST_ASSERT(json.find("\"TestTraceThread\"") != StdString::npos);
+	ZN_TEST_ASSERT(json.find("TestTraceNotRecorded") == StdString::npos);
+
+	int depth = 0;
+	for (const char c : json) {
+		if (c == '{') {
+			++depth;
+		} else if (c == '}') {
+			--depth;
+			ZN_TEST_ASSERT(depth >= 0);
+		}
+	}
+	ZN_TEST_ASSERT(depth == 0);
+
+	trace_recorder::clear();
+	json.clear();
+	trace_recorder::get_chrome_trace_json(json, 0);
+	ZN_TEST_ASSERT(json.find("\"TestTraceScope\"") == StdString::npos);
+	// Thread names remain
+	ZN_TEST_ASSERT(json.find("\"TestTraceThread\"") != StdString::npos);
+#endif
+}
+
+void test_trace_recorder_thread_buffer_reuse() {
+#ifdef ZN_PROFILER_TRACE_RECORDER
+	trace_recorder::clear();
+	trace_recorder::set_enabled(true);
+
+	struct L {
+		static void thread_func_a(void *userdata) {
+			trace_recorder::set_thread_name("TestTraceThreadA");
+			ZN_PROFILE_SCOPE_NAMED("TestTraceScopeA");
+		}
+		static void thread_func_b(void *userdata) {
+			trace_recorder::set_thread_name("TestTraceThreadB");
+			ZN_PROFILE_SCOPE_NAMED("TestTraceScopeB");
+		}
+	};
+
+	{
+		Thread thread;
+		thread.start(L::thread_func_a, nullptr);
+		thread.wait_to_finish();
+	}
+
+	StdString json;
+	trace_recorder::get_chrome_trace_json(json, 0);
+	// Events remain after their thread ended
+	ZN_TEST_ASSERT(json.find("\"TestTraceScopeA\"") != StdString::npos);
+
+	{
+		Thread thread;
+		thread.start(L::thread_func_b, nullptr);
+		thread.wait_to_finish();
+	}
+
+	trace_recorder::set_enabled(false);
+
+	json.clear();
+	trace_recorder::get_chrome_trace_json(json, 0);
+	// The second thread got the buffer of the first one
+	ZN_TEST_ASSERT(json.find("\"TestTraceScopeB\"") != StdString::npos);
+	ZN_TEST_ASSERT(json.find("\"TestTraceThreadB\"") != StdString::npos);
+	ZN_TEST_ASSERT(json.find("\"TestTraceScopeA\"") == StdString::npos);
+	ZN_TEST_ASSERT(json.find("\"TestTraceThreadA\"") == StdString::npos);
+
+	trace_recorder::clear();
+#endif
+}
+
+} // namespace zylann::tests
@@ -0,0 +1,11 @@
+#ifndef ZN_TEST_TRACE_RECORDER_H
+#define ZN_TEST_TRACE_RECORDER_H
+
+namespace zylann::tests {
+
+void test_trace_recorder();
+void test_trace_recorder_thread_buffer_reuse();
+
+} // namespace zylann::tests
+
+#endif // ZN_TEST_TRACE_RECORDER_H
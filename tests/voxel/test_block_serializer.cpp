@@ -49,6 +49,53 @@ void test_block_serializer() {
 	}
 }
 
+void test_block_serializer_delta() {
+	const Vector3i block_size(16, 16, 16);
+	VoxelBuffer previous(VoxelBuffer::ALLOCATOR_DEFAULT);
+	previous.create(block_size);
+	previous.fill_area(42, Vector3i(0, 0, 0), Vector3i(16, 8, 16), 0);
+	previous.set_voxel(7, Vector3i(3, 4, 5), 1);
+	previous.get_or_create_voxel_metadata(Vector3i(1, 1, 1))->set_u64(100);
+	previous.get_or_create_voxel_metadata(Vector3i(2, 2, 2))->set_u64(200);
+
+	VoxelBuffer current(VoxelBuffer::ALLOCATOR_DEFAULT);
+	previous.copy_to(current, true);
+	// Small edits, like digging
+	current.fill_area(0, Vector3i(4, 6, 4), Vector3i(7, 8, 7), 0);
+	current.set_voxel(43, Vector3i(15, 15, 15), 0);
+	// Channel that was uniform
+	current.set_voxel(1234, Vector3i(8, 8, 8), 2);
+	current.erase_voxel_metadata(Vector3i(1, 1, 1));
+	current.get_or_create_voxel_metadata(Vector3i(2, 2, 2))->set_u64(201);
+	current.get_or_create_voxel_metadata(Vector3i(3, 3, 3))->set_u64(300);
+	current.get_block_metadata().set_u64(1);
+
+	StdVector<uint8_t> delta;
+	ZN_TEST_ASSERT(BlockSerializer::serialize_delta(previous, current, delta));
+
+	BlockSerializer::SerializeResult full_result = BlockSerializer::serialize(current);
+	ZN_TEST_ASSERT(full_result.success);
+	ZN_TEST_ASSERT(delta.size() < full_result.data.size());
+
+	VoxelBuffer received(VoxelBuffer::ALLOCATOR_DEFAULT);
+	previous.copy_to(received, true);
+	ZN_TEST_ASSERT(BlockSerializer::apply_delta(to_span_const(delta), received));
+
+	ZN_TEST_ASSERT(received.equals(current));
+	ZN_TEST_ASSERT(received.get_voxel_metadata(Vector3i(1, 1, 1)) == nullptr);
+	const VoxelMetadata *meta2 = received.get_voxel_metadata(Vector3i(2, 2, 2));
+	ZN_TEST_ASSERT(meta2 != nullptr && meta2->get_u64() == 201);
+	const VoxelMetadata *meta3 = received.get_voxel_metadata(Vector3i(3, 3, 3));
+	ZN_TEST_ASSERT(meta3 != nullptr && meta3->get_u64() == 300);
+	ZN_TEST_ASSERT(received.get_block_metadata().equals(current.get_block_metadata()));
+
+	// Buffers with different channel formats can't be diffed
+	VoxelBuffer other_format(VoxelBuffer::ALLOCATOR_DEFAULT);
+	other_format.create(block_size);
+	other_format.set_channel_depth(0, VoxelBuffer::DEPTH_8_BIT);
+	ZN_TEST_ASSERT(!BlockSerializer::serialize_delta(previous, other_format, delta));
+}
+
 void test_block_serializer_stream_peer() {
 	// Create an example buffer
 	const Vector3i block_size(8, 9, 10);
@@ -2,6 +2,7 @@
 #include "../../streams/region/region_file.h"
 #include "../../streams/region/voxel_stream_region_files.h"
 #include "../../util/containers/std_unordered_map.h"
+#include "../../util/godot/classes/file_access.h"
 #include "../../util/godot/core/random_pcg.h"
 #include "../../util/testing/test_directory.h"
 #include "../../util/testing/test_macros.h"
@@ -167,6 +168,119 @@ void test_region_file() {
 	}
 }
 
+namespace {
+
+uint8_t load_region_file_version(const String &fpath) {
+	Error err;
+	Ref<FileAccess> f = zylann::godot::open_file(fpath, FileAccess::READ, err);
+	ZN_TEST_ASSERT_V(err == OK, 0);
+	// Comes after the magic
+	f->seek(4);
+	return f->get_8();
+}
+
+} // namespace
+
+void test_region_file_deduplication() {
+	const int block_size_po2 = 4;
+	const int block_size = 1 << block_size_po2;
+	zylann::testing::TestDirectory test_dir;
+	ZN_TEST_ASSERT(test_dir.is_valid());
+	const String region_file_path = test_dir.get_path().path_join("test_region_file_deduplication.vxr");
+
+	VoxelBuffer uniform_buffer(VoxelBuffer::ALLOCATOR_DEFAULT);
+	uniform_buffer.create(Vector3iUtil::create(block_size));
+	uniform_buffer.set_channel_depth(0, VoxelBuffer::DEPTH_16_BIT);
+	uniform_buffer.clear_channel(0, 42);
+
+	RandomPCG rng;
+	rng.seed(131183);
+
+	VoxelBuffer random_buffer(VoxelBuffer::ALLOCATOR_DEFAULT);
+	random_buffer.create(Vector3iUtil::create(block_size));
+	random_buffer.set_channel_depth(0, VoxelBuffer::DEPTH_16_BIT);
+	for (int z = 0; z < block_size; ++z) {
+		for (int x = 0; x < block_size; ++x) {
+			for (int y = 0; y < block_size; ++y) {
+				random_buffer.set_voxel(rng.rand() % 256, x, y, z, 0);
+			}
+		}
+	}
+
+	const unsigned int uniform_block_count = 10;
+	const Vector3i random_block_position(0, 5, 0);
+
+	{
+		RegionFile region_file;
+
+		RegionFormat region_format = region_file.get_format();
+		region_format.block_size_po2 = block_size_po2;
+		for (unsigned int channel_index = 0; channel_index < VoxelBuffer::MAX_CHANNELS; ++channel_index) {
+			region_format.channel_depths[channel_index] = uniform_buffer.get_channel_depth(channel_index);
+		}
+		ZN_TEST_ASSERT(region_file.set_format(region_format));
+		region_file.set_deduplication_enabled(true);
+
+		ZN_TEST_ASSERT(region_file.open(region_file_path, true) == OK);
+
+		// Files without shared sectors remain readable by builds not supporting them
+		ZN_TEST_ASSERT(region_file.save_block(Vector3i(0, 0, 0), uniform_buffer) == OK);
+		region_file.flush();
+		ZN_TEST_ASSERT(load_region_file_version(region_file_path) == 3);
+
+		// Interleave identical and unique blocks so shared sectors are not only at the end of the file
+		for (unsigned int i = 0; i < uniform_block_count; ++i) {
+			ZN_TEST_ASSERT(region_file.save_block(Vector3i(i, 0, 0), uniform_buffer) == OK);
+			if (i == uniform_block_count / 2) {
+				ZN_TEST_ASSERT(region_file.save_block(random_block_position, random_buffer) == OK);
+			}
+		}
+		// Files with shared sectors get a version that builds not supporting them will refuse to modify
+		region_file.flush();
+		ZN_TEST_ASSERT(load_region_file_version(region_file_path) == 4);
+
+		const RegionFile::DeduplicationStats stats = region_file.get_deduplication_stats();
+		ZN_TEST_ASSERT(stats.block_count == uniform_block_count + 1);
+		ZN_TEST_ASSERT(stats.stored_block_count == 2);
+
+		// Overwriting a shared block must not affect the others
+		ZN_TEST_ASSERT(region_file.save_block(Vector3i(0, 0, 0), random_buffer) == OK);
+		// Overwriting the unique block with shared data must release its sectors
+		ZN_TEST_ASSERT(region_file.save_block(random_block_position, uniform_buffer) == OK);
+
+		const RegionFile::DeduplicationStats stats2 = region_file.get_deduplication_stats();
+		ZN_TEST_ASSERT(stats2.block_count == uniform_block_count + 1);
+		ZN_TEST_ASSERT(stats2.stored_block_count == 2);
+
+		ZN_TEST_ASSERT(region_file.close() == OK);
+	}
+	// Reopen without deduplication, data must read back the same and remain modifiable
+	{
+		RegionFile region_file;
+		ZN_TEST_ASSERT(region_file.open(region_file_path, false) == OK);
+
+		VoxelBuffer loaded_buffer(VoxelBuffer::ALLOCATOR_DEFAULT);
+		ZN_TEST_ASSERT(region_file.load_block(Vector3i(0, 0, 0), loaded_buffer) == OK);
+		ZN_TEST_ASSERT(loaded_buffer.equals(random_buffer));
+
+		for (unsigned int i = 1; i < uniform_block_count; ++i) {
+			ZN_TEST_ASSERT(region_file.load_block(Vector3i(i, 0, 0), loaded_buffer) == OK);
+			ZN_TEST_ASSERT(loaded_buffer.equals(uniform_buffer));
+		}
+		ZN_TEST_ASSERT(region_file.load_block(random_block_position, loaded_buffer) == OK);
+		ZN_TEST_ASSERT(loaded_buffer.equals(uniform_buffer));
+
+		// Shared sectors must be detached when written without deduplication
+		ZN_TEST_ASSERT(region_file.save_block(Vector3i(1, 0, 0), random_buffer) == OK);
+		ZN_TEST_ASSERT(region_file.load_block(Vector3i(1, 0, 0), loaded_buffer) == OK);
+		ZN_TEST_ASSERT(loaded_buffer.equals(random_buffer));
+		ZN_TEST_ASSERT(region_file.load_block(Vector3i(2, 0, 0), loaded_buffer) == OK);
+		ZN_TEST_ASSERT(loaded_buffer.equals(uniform_buffer));
+
+		region_file.debug_check();
+	}
+}
+
 // Test based on an issue from `I am the Carl` on Discord. It should only not crash or cause errors.
 void test_voxel_stream_region_files() {
 	const int block_size_po2 = 4;
@@ -4,6 +4,7 @@
 namespace zylann::voxel::tests {
 
 void test_region_file();
+void test_region_file_deduplication();
 void test_voxel_stream_region_files();
 
 } // namespace zylann::voxel::tests
@@ -0,0 +1,162 @@
+#include "test_session_trace.h"
+#include "../../engine/session_recorder.h"
+#include "../../engine/session_trace.h"
+#include "../../util/testing/test_macros.h"
+
+namespace zylann::voxel::tests {
+
+namespace {
+
+bool edits_equal(const SessionTrace::Edit &a, const SessionTrace::Edit &b) {
+	return a.type == b.type && a.mode == b.mode && a.channel == b.channel && a.value == b.value &&
+			a.eraser_value == b.eraser_value && a.sdf_scale == b.sdf_scale && a.sdf_strength == b.sdf_strength &&
+			a.position == b.position && a.end == b.end && a.param == b.param;
+}
+
+} // namespace
+
+void test_session_trace_serialization() {
+	SessionTrace trace;
+	trace.config["terrain_class"] = "VoxelLodTerrain";
+	trace.config["lod_count"] = 6;
+
+	for (unsigned int i = 0; i < 100; ++i) {
+		SessionTrace::Frame frame;
+		frame.delta_usec = 16000 + i;
+
+		if (i % 10 == 0) {
+			frame.viewers_changed = true;
+			SessionTrace::ViewerState viewer;
+			viewer.id = 1;
+			viewer.position = Vector3f(i, 2.5f, -float(i));
+			viewer.horizontal_distance = 256;
+			viewer.vertical_distance = 128;
+			viewer.requires_visuals = true;
+			viewer.requires_collisions = (i % 20) == 0;
+			frame.viewers.push_back(viewer);
+		}
+
+		if (i % 7 == 0) {
+			SessionTrace::Edit edit;
+			edit.type = SessionTrace::EDIT_SPHERE;
+			edit.mode = 1;
+			edit.channel = 1;
+			edit.value = 42;
+			edit.eraser_value = 0;
+			edit.sdf_scale = 0.5f;
+			edit.sdf_strength = 0.75f;
+			edit.position = Vector3f(i, -3.f, 10.f);
+			edit.end = Vector3i(i, -5, 3);
+			edit.param = 4.f;
+			frame.edits.push_back(edit);
+		}
+
+		trace.frames.push_back(frame);
+	}
+
+	StdVector<uint8_t> data;
+	trace.serialize(data);
+	ZN_TEST_ASSERT(data.size() > 0);
+
+	SessionTrace trace2;
+	ZN_TEST_ASSERT(trace2.deserialize(to_span_const(data)));
+
+	ZN_TEST_ASSERT(trace2.config == trace.config);
+	ZN_TEST_ASSERT(trace2.frames.size() == trace.frames.size());
+
+	for (unsigned int i = 0; i < trace.frames.size(); ++i) {
+		const SessionTrace::Frame &frame1 = trace.frames[i];
+		const SessionTrace::Frame &frame2 = trace2.frames[i];
+		ZN_TEST_ASSERT(frame1.delta_usec == frame2.delta_usec);
+		ZN_TEST_ASSERT(frame1.viewers_changed == frame2.viewers_changed);
+		ZN_TEST_ASSERT(frame1.viewers == frame2.viewers);
+		ZN_TEST_ASSERT(frame1.edits.size() == frame2.edits.size());
+		for (unsigned int j = 0; j < frame1.edits.size(); ++j) {
+			ZN_TEST_ASSERT(edits_equal(frame1.edits[j], frame2.edits[j]));
+		}
+	}
+
+	// Truncated data must be rejected rather than read out of bounds
+	StdVector<uint8_t> truncated_data = data;
+	truncated_data.resize(data.size() / 2);
+	SessionTrace trace3;
+	ZN_TEST_ASSERT(!trace3.deserialize(to_span_const(truncated_data)));
+
+	// Invalid edits must be rejected, without leaving a partial trace
+	{
+		SessionTrace invalid_trace;
+		invalid_trace.config["terrain_class"] = "VoxelTerrain";
+		SessionTrace::Frame frame;
+		SessionTrace::Edit edit;
+		edit.mode = 200;
+		frame.edits.push_back(edit);
+		invalid_trace.frames.push_back(frame);
+
+		StdVector<uint8_t> invalid_data;
+		invalid_trace.serialize(invalid_data);
+
+		ZN_TEST_ASSERT(!trace2.deserialize(to_span_const(invalid_data)));
+		ZN_TEST_ASSERT(trace2.frames.size() == 0);
+		ZN_TEST_ASSERT(trace2.config.is_empty());
+	}
+}
+
+void test_session_recorder() {
+	VolumeID volume_id;
+	volume_id.index = 3;
+	SessionRecorder recorder;
+
+	// Frames and edits are ignored when not recording
+	recorder.record_frame(16000, StdVector<SessionTrace::ViewerState>());
+	ZN_TEST_ASSERT(!recorder.is_recording());
+
+	// The volume is placed at X=10 in the world
+	Transform3f world_to_local;
+	world_to_local.origin = Vector3f(-10, 0, 0);
+	recorder.start(volume_id, world_to_local, Dictionary());
+	ZN_TEST_ASSERT(recorder.is_recording_volume(volume_id));
+
+	VolumeID other_volume_id;
+	other_volume_id.index = 4;
+	ZN_TEST_ASSERT(!recorder.is_recording_volume(other_volume_id));
+
+	StdVector<SessionTrace::ViewerState> viewers;
+	SessionTrace::ViewerState viewer;
+	viewer.id = 1;
+	viewer.position = Vector3f(1, 2, 3);
+	viewers.push_back(viewer);
+
+	recorder.record_frame(16000, viewers);
+
+	SessionTrace::Edit edit;
+	edit.type = SessionTrace::EDIT_POINT;
+	recorder.record_edit(volume_id, edit);
+	// Edits of other volumes are ignored
+	recorder.record_edit(other_volume_id, edit);
+	// Viewers didn't move
+	recorder.record_frame(17000, viewers);
+
+	viewers[0].position = Vector3f(4, 5, 6);
+	recorder.record_frame(15000, viewers);
+
+	SessionTrace trace;
+	recorder.stop(trace);
+	ZN_TEST_ASSERT(!recorder.is_recording());
+
+	ZN_TEST_ASSERT(trace.frames.size() == 3);
+
+	ZN_TEST_ASSERT(trace.frames[0].viewers_changed);
+	ZN_TEST_ASSERT(trace.frames[0].edits.size() == 0);
+	// Viewers are recorded in the local space of the volume, like edits
+	ZN_TEST_ASSERT(trace.frames[0].viewers[0].position == Vector3f(-9, 2, 3));
+
+	ZN_TEST_ASSERT(!trace.frames[1].viewers_changed);
+	ZN_TEST_ASSERT(trace.frames[1].delta_usec == 17000);
+	ZN_TEST_ASSERT(trace.frames[1].edits.size() == 1);
+
+	ZN_TEST_ASSERT(trace.frames[2].viewers_changed);
+	ZN_TEST_ASSERT(trace.frames[2].viewers.size() == 1);
+	ZN_TEST_ASSERT(trace.frames[2].viewers[0].position == Vector3f(-6, 5, 6));
+}
+
+} // namespace zylann::voxel::tests
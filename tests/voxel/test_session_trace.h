@@ -0,0 +1,11 @@
+#ifndef VOXEL_TESTS_SESSION_TRACE_H
+#define VOXEL_TESTS_SESSION_TRACE_H
+
+namespace zylann::voxel::tests {
+
+void test_session_trace_serialization();
+void test_session_recorder();
+
+} // namespace zylann::voxel::tests
+
+#endif // VOXEL_TESTS_SESSION_TRACE_H
@@ -1,7 +1,10 @@
 #include "test_stream_sqlite.h"
 #include "../../streams/sqlite/block_location.h"
+#include "../../streams/sqlite/connection.h"
 #include "../../streams/sqlite/voxel_stream_sqlite.h"
 #include "../../util/containers/container_funcs.h"
+#include "../../util/godot/classes/project_settings.h"
+#include "../../util/godot/core/string.h"
 #include "../../util/godot/core/random_pcg.h"
 #include "../../util/math/conv.h"
 #include "../../util/math/vector3i.h"
@@ -232,6 +235,102 @@ void test_voxel_stream_sqlite_coordinate_format() {
 	test_voxel_stream_sqlite_coordinate_format(VoxelStreamSQLite::COORDINATE_FORMAT_BLOB80_X25_Y25_Z25_L5);
 }
 
+void test_voxel_stream_sqlite_deduplication() {
+	zylann::testing::TestDirectory test_dir;
+	ZN_TEST_ASSERT(test_dir.is_valid());
+
+	const String database_path = test_dir.get_path().path_join("database.sqlite");
+	const Vector3i block_size = Vector3iUtil::create(1 << constants::DEFAULT_BLOCK_SIZE_PO2);
+
+	VoxelBuffer uniform_vb(VoxelBuffer::ALLOCATOR_DEFAULT);
+	uniform_vb.create(block_size);
+	uniform_vb.fill(7, 0);
+
+	VoxelBuffer unique_vb(VoxelBuffer::ALLOCATOR_DEFAULT);
+	unique_vb.create(block_size);
+	unique_vb.fill_area(1, Vector3i(5, 5, 5), Vector3i(10, 11, 12), 0);
+
+	const unsigned int uniform_block_count = 20;
+	const Vector3i unique_block_position(0, 1, 0);
+
+	{
+		Ref<VoxelStreamSQLite> stream;
+		stream.instantiate();
+		stream->set_deduplication_enabled(true);
+		stream->set_database_path(database_path);
+
+		for (unsigned int i = 0; i < uniform_block_count; ++i) {
+			VoxelStreamSQLite::VoxelQueryData q{ uniform_vb, Vector3i(i, 0, 0), 0, VoxelStream::RESULT_ERROR };
+			stream->save_voxel_block(q);
+		}
+		{
+			VoxelStreamSQLite::VoxelQueryData q{ unique_vb, unique_block_position, 0, VoxelStream::RESULT_ERROR };
+			stream->save_voxel_block(q);
+		}
+
+		const Dictionary stats = stream->get_deduplication_stats();
+		ZN_TEST_ASSERT(int64_t(stats["voxel_block_count"]) == uniform_block_count + 1);
+		ZN_TEST_ASSERT(int64_t(stats["unique_blob_count"]) == 2);
+		ZN_TEST_ASSERT(int64_t(stats["inline_block_count"]) == 0);
+		ZN_TEST_ASSERT(int64_t(stats["stored_bytes"]) < int64_t(stats["logical_bytes"]));
+
+		// Overwrite a shared block with unique data, and the unique block with shared data
+		{
+			VoxelStreamSQLite::VoxelQueryData q{ unique_vb, Vector3i(0, 0, 0), 0, VoxelStream::RESULT_ERROR };
+			stream->save_voxel_block(q);
+		}
+		{
+			VoxelStreamSQLite::VoxelQueryData q{ uniform_vb, unique_block_position, 0, VoxelStream::RESULT_ERROR };
+			stream->save_voxel_block(q);
+		}
+
+		const Dictionary stats2 = stream->get_deduplication_stats();
+		ZN_TEST_ASSERT(int64_t(stats2["voxel_block_count"]) == uniform_block_count + 1);
+		ZN_TEST_ASSERT(int64_t(stats2["unique_blob_count"]) == 2);
+	}
+	{
+		// Reopen without deduplication to make sure data is read back regardless
+		Ref<VoxelStreamSQLite> stream;
+		stream.instantiate();
+		stream->set_database_path(database_path);
+
+		VoxelBuffer loaded_vb(VoxelBuffer::ALLOCATOR_DEFAULT);
+		{
+			VoxelStreamSQLite::VoxelQueryData q{ loaded_vb, Vector3i(0, 0, 0), 0, VoxelStream::RESULT_ERROR };
+			stream->load_voxel_block(q);
+			ZN_TEST_ASSERT(q.result == VoxelStream::RESULT_BLOCK_FOUND);
+			ZN_TEST_ASSERT(loaded_vb.equals(unique_vb));
+		}
+		for (unsigned int i = 1; i < uniform_block_count; ++i) {
+			VoxelStreamSQLite::VoxelQueryData q{ loaded_vb, Vector3i(i, 0, 0), 0, VoxelStream::RESULT_ERROR };
+			stream->load_voxel_block(q);
+			ZN_TEST_ASSERT(q.result == VoxelStream::RESULT_BLOCK_FOUND);
+			ZN_TEST_ASSERT(loaded_vb.equals(uniform_vb));
+		}
+		{
+			VoxelStreamSQLite::VoxelQueryData q{ loaded_vb, unique_block_position, 0, VoxelStream::RESULT_ERROR };
+			stream->load_voxel_block(q);
+			ZN_TEST_ASSERT(q.result == VoxelStream::RESULT_BLOCK_FOUND);
+			ZN_TEST_ASSERT(loaded_vb.equals(uniform_vb));
+		}
+
+		// Saving without deduplication must release references
+		for (unsigned int i = 1; i < uniform_block_count; ++i) {
+			VoxelStreamSQLite::VoxelQueryData q{ unique_vb, Vector3i(i, 0, 0), 0, VoxelStream::RESULT_ERROR };
+			stream->save_voxel_block(q);
+		}
+		{
+			VoxelStreamSQLite::VoxelQueryData q{ unique_vb, unique_block_position, 0, VoxelStream::RESULT_ERROR };
+			stream->save_voxel_block(q);
+		}
+
+		const Dictionary stats = stream->get_deduplication_stats();
+		ZN_TEST_ASSERT(int64_t(stats["voxel_block_count"]) == uniform_block_count + 1);
+		ZN_TEST_ASSERT(int64_t(stats["inline_block_count"]) == uniform_block_count + 1);
+		ZN_TEST_ASSERT(int64_t(stats["unique_blob_count"]) == 0);
+	}
+}
+
 void test_voxel_stream_sqlite_key_string_csd_encoding(Vector3i pos, uint8_t lod_index, std::string_view expected) {
 	using namespace sqlite;
 
@@ -282,4 +381,112 @@ void test_voxel_stream_sqlite_key_blob80_encoding() {
 	test_voxel_stream_sqlite_key_blob80_encoding(Vector3i(max_pos.x, min_pos.y, max_pos.z), max_lod_index);
 }
 
+void test_voxel_stream_sqlite_new_database_version() {
+	zylann::testing::TestDirectory test_dir;
+	ZN_TEST_ASSERT(test_dir.is_valid());
+
+	const String database_path = test_dir.get_path().path_join("database.sqlite");
+	const StdString globalized_path =
+			zylann::godot::to_std_string(ProjectSettings::get_singleton()->globalize_path(database_path));
+	const Vector3i block_size = Vector3iUtil::create(1 << constants::DEFAULT_BLOCK_SIZE_PO2);
+
+	VoxelBuffer vb(VoxelBuffer::ALLOCATOR_DEFAULT);
+	vb.create(block_size);
+	vb.fill(7, 0);
+
+	{
+		Ref<VoxelStreamSQLite> stream;
+		stream.instantiate();
+		stream->set_database_path(database_path);
+		VoxelStreamSQLite::VoxelQueryData q{ vb, Vector3i(), 0, VoxelStream::RESULT_ERROR };
+		stream->save_voxel_block(q);
+		stream->flush();
+	}
+	{
+		// Without deduplication, the database must remain readable by builds that don't support it
+		sqlite::Connection con;
+		ZN_TEST_ASSERT(con.open(globalized_path.c_str(), sqlite::BlockLocation::FORMAT_INT64_X16_Y16_Z16_L16));
+		ZN_TEST_ASSERT(con.get_meta().version == sqlite::Connection::VERSION_V1);
+		ZN_TEST_ASSERT(!con.supports_deduplication());
+	}
+	{
+		Ref<VoxelStreamSQLite> stream;
+		stream.instantiate();
+		stream->set_deduplication_enabled(true);
+		stream->set_database_path(database_path);
+
+		VoxelBuffer loaded_vb(VoxelBuffer::ALLOCATOR_DEFAULT);
+		VoxelStreamSQLite::VoxelQueryData q{ loaded_vb, Vector3i(), 0, VoxelStream::RESULT_ERROR };
+		stream->load_voxel_block(q);
+		ZN_TEST_ASSERT(q.result == VoxelStream::RESULT_BLOCK_FOUND);
+		ZN_TEST_ASSERT(loaded_vb.equals(vb));
+	}
+	{
+		// Using deduplication migrates it
+		sqlite::Connection con;
+		ZN_TEST_ASSERT(con.open(globalized_path.c_str(), sqlite::BlockLocation::FORMAT_INT64_X16_Y16_Z16_L16));
+		ZN_TEST_ASSERT(con.get_meta().version == sqlite::Connection::VERSION_V2);
+	}
+}
+
+void test_voxel_stream_sqlite_migration_with_pooled_connections() {
+	zylann::testing::TestDirectory test_dir;
+	ZN_TEST_ASSERT(test_dir.is_valid());
+
+	const String database_path = test_dir.get_path().path_join("database.sqlite");
+	const Vector3i block_size = Vector3iUtil::create(1 << constants::DEFAULT_BLOCK_SIZE_PO2);
+
+	VoxelBuffer uniform_vb(VoxelBuffer::ALLOCATOR_DEFAULT);
+	uniform_vb.create(block_size);
+	uniform_vb.fill(7, 0);
+
+	VoxelBuffer unique_vb(VoxelBuffer::ALLOCATOR_DEFAULT);
+	unique_vb.create(block_size);
+	unique_vb.fill_area(1, Vector3i(5, 5, 5), Vector3i(10, 11, 12), 0);
+
+	const unsigned int block_count = 4;
+
+	Ref<VoxelStreamSQLite> stream;
+	stream.instantiate();
+	stream->set_database_path(database_path);
+
+	// Leaves a connection in the pool, opened with the V1 schema
+	{
+		VoxelStreamSQLite::VoxelQueryData q{ unique_vb, Vector3i(0, 1, 0), 0, VoxelStream::RESULT_ERROR };
+		stream->save_voxel_block(q);
+		stream->flush();
+	}
+
+	// The pooled connection must not be used to save deduplicated blocks
+	stream->set_deduplication_enabled(true);
+	for (unsigned int i = 0; i < block_count; ++i) {
+		VoxelStreamSQLite::VoxelQueryData q{ uniform_vb, Vector3i(i, 0, 0), 0, VoxelStream::RESULT_ERROR };
+		stream->save_voxel_block(q);
+	}
+	const Dictionary stats = stream->get_deduplication_stats();
+	ZN_TEST_ASSERT(int64_t(stats["unique_blob_count"]) == 1);
+	ZN_TEST_ASSERT(int64_t(stats["inline_block_count"]) == 1);
+
+	// Overwriting without deduplication must release the shared data, so it is not read back instead
+	stream->set_deduplication_enabled(false);
+	{
+		VoxelStreamSQLite::VoxelQueryData q{ unique_vb, Vector3i(0, 0, 0), 0, VoxelStream::RESULT_ERROR };
+		stream->save_voxel_block(q);
+		stream->flush();
+	}
+	VoxelBuffer loaded_vb(VoxelBuffer::ALLOCATOR_DEFAULT);
+	{
+		VoxelStreamSQLite::VoxelQueryData q{ loaded_vb, Vector3i(0, 0, 0), 0, VoxelStream::RESULT_ERROR };
+		stream->load_voxel_block(q);
+		ZN_TEST_ASSERT(q.result == VoxelStream::RESULT_BLOCK_FOUND);
+		ZN_TEST_ASSERT(loaded_vb.equals(unique_vb));
+	}
+	{
+		VoxelStreamSQLite::VoxelQueryData q{ loaded_vb, Vector3i(1, 0, 0), 0, VoxelStream::RESULT_ERROR };
+		stream->load_voxel_block(q);
+		ZN_TEST_ASSERT(q.result == VoxelStream::RESULT_BLOCK_FOUND);
+		ZN_TEST_ASSERT(loaded_vb.equals(uniform_vb));
+	}
+}
+
 } // namespace zylann::voxel::tests
@@ -5,6 +5,9 @@ namespace zylann::voxel::tests {
 
 void test_voxel_stream_sqlite_basic();
 void test_voxel_stream_sqlite_coordinate_format();
+void test_voxel_stream_sqlite_deduplication();
+void test_voxel_stream_sqlite_new_database_version();
+void test_voxel_stream_sqlite_migration_with_pooled_connections();
 void test_voxel_stream_sqlite_key_string_csd_encoding();
 void test_voxel_stream_sqlite_key_blob80_encoding();
 
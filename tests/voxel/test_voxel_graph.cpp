@@ -2440,4 +2440,509 @@ void test_voxel_graph_constant_reduction() {
 	ZN_TEST_ASSERT(graph->equals(**expected_graph));
 }
 
+void test_voxel_graph_operation_fusion() {
+	Ref<VoxelGeneratorGraph> generator;
+	generator.instantiate();
+	{
+		VoxelGraphFunction &g = **generator->get_main_function();
+
+		// Y --- Mul --- Add --- Clamp --- Out
+		//              /
+		//             X
+		//
+		// Using Y first, otherwise the multiplication would run separately as part of the XZ outer group
+
+		const uint32_t n_in_x = g.create_node(VoxelGraphFunction::NODE_INPUT_X);
+		const uint32_t n_in_y = g.create_node(VoxelGraphFunction::NODE_INPUT_Y);
+		const uint32_t n_mul = g.create_node(VoxelGraphFunction::NODE_MULTIPLY);
+		const uint32_t n_add = g.create_node(VoxelGraphFunction::NODE_ADD);
+		const uint32_t n_clamp = g.create_node(VoxelGraphFunction::NODE_CLAMP);
+		const uint32_t n_out_sdf = g.create_node(VoxelGraphFunction::NODE_OUTPUT_SDF);
+
+		g.set_node_default_input(n_mul, 1, 0.5f);
+		g.set_node_default_input(n_clamp, 1, -10.f);
+		g.set_node_default_input(n_clamp, 2, 10.f);
+
+		g.add_connection(n_in_y, 0, n_mul, 0);
+		g.add_connection(n_mul, 0, n_add, 0);
+		g.add_connection(n_in_x, 0, n_add, 1);
+		g.add_connection(n_add, 0, n_clamp, 0);
+		g.add_connection(n_clamp, 0, n_out_sdf, 0);
+	}
+
+	const CompilationResult result = generator->compile(false);
+	ZN_TEST_ASSERT(result.success);
+	// Every operation after the multiplication reads the result of the previous one
+	ZN_TEST_ASSERT(result.fusion_stats.fused_operations_count == 3);
+	ZN_TEST_ASSERT(result.fusion_stats.fused_reads_count == 3);
+	ZN_TEST_ASSERT(result.fusion_stats.buffer_passes_count > result.fusion_stats.fused_reads_count);
+
+	// Not a multiple of the tile size, nor of SIMD width
+	const unsigned int count = Runtime::TILE_SIZE * 3 + 7;
+	StdVector<float> xs;
+	StdVector<float> ys;
+	StdVector<float> zs;
+	for (unsigned int i = 0; i < count; ++i) {
+		xs.push_back(static_cast<float>(i) * 0.1f - 40.f);
+		ys.push_back(static_cast<float>(i % 13) - 6.f);
+		zs.push_back(0.f);
+	}
+
+	StdVector<float> sdf;
+	sdf.resize(count);
+	generator->generate_series(
+			to_span(xs), to_span(ys), to_span(zs), VoxelBuffer::CHANNEL_SDF, to_span(sdf), Vector3f(), Vector3f()
+	);
+
+	for (unsigned int i = 0; i < count; ++i) {
+		const float expected = math::clamp(ys[i] * 0.5f + xs[i], -10.f, 10.f);
+		ZN_TEST_ASSERT(Math::is_equal_approx(sdf[i], expected));
+	}
+}
+
+void test_voxel_graph_tile_streaming() {
+	// Larger than a tile, and not a multiple of it
+	const unsigned int count = Runtime::TILE_SIZE * 5 + 3;
+	StdVector<float> xs;
+	StdVector<float> ys;
+	StdVector<float> zs;
+	for (unsigned int i = 0; i < count; ++i) {
+		xs.push_back(static_cast<float>(i % 37) * 1.5f - 20.f);
+		ys.push_back(static_cast<float>(i % 11) - 5.f);
+		zs.push_back(static_cast<float>(i / 37) * 1.5f - 20.f);
+	}
+
+	StdVector<float> expected_sdf;
+	expected_sdf.resize(count);
+	{
+		Ref<VoxelGeneratorGraph> generator;
+		generator.instantiate();
+		load_graph_with_expression_and_noises(**generator->get_main_function(), nullptr);
+		// In debug, intermediate buffers must be inspectable, so the program runs over whole buffers
+		const CompilationResult result = generator->compile(true);
+		ZN_TEST_ASSERT(result.success);
+		ZN_TEST_ASSERT(!result.tile_streaming);
+		generator->generate_series(
+				to_span(xs),
+				to_span(ys),
+				to_span(zs),
+				VoxelBuffer::CHANNEL_SDF,
+				to_span(expected_sdf),
+				Vector3f(),
+				Vector3f()
+		);
+	}
+
+	StdVector<float> sdf;
+	sdf.resize(count);
+	{
+		Ref<VoxelGeneratorGraph> generator;
+		generator.instantiate();
+		load_graph_with_expression_and_noises(**generator->get_main_function(), nullptr);
+		const CompilationResult result = generator->compile(false);
+		ZN_TEST_ASSERT(result.success);
+		ZN_TEST_ASSERT(result.tile_streaming);
+		generator->generate_series(
+				to_span(xs), to_span(ys), to_span(zs), VoxelBuffer::CHANNEL_SDF, to_span(sdf), Vector3f(), Vector3f()
+		);
+	}
+
+	for (unsigned int i = 0; i < count; ++i) {
+		ZN_TEST_ASSERT(Math::is_equal_approx(sdf[i], expected_sdf[i]));
+	}
+}
+
+void test_voxel_graph_generate_blocks_stacked() {
+	Ref<VoxelGeneratorGraph> generator;
+	generator.instantiate();
+	load_graph_with_expression_and_noises(**generator->get_main_function(), nullptr);
+	const CompilationResult result = generator->compile(false);
+	ZN_TEST_ASSERT(result.success);
+
+	const int block_size = 16;
+	// A column of blocks crossing the surface, given in no particular order, plus a block that isn't part of it
+	const StdVector<Vector3i> origins{
+		Vector3i(-16, 0, 32), //
+		Vector3i(-16, -32, 32), //
+		Vector3i(64, 0, -16), //
+		Vector3i(-16, 16, 32), //
+		Vector3i(-16, -16, 32) //
+	};
+
+	StdVector<VoxelBuffer> batch_buffers;
+	StdVector<VoxelGenerator::VoxelQueryData> queries;
+	batch_buffers.reserve(origins.size());
+	for (const Vector3i origin : origins) {
+		batch_buffers.emplace_back(VoxelBuffer::ALLOCATOR_DEFAULT);
+		VoxelBuffer &vb = batch_buffers.back();
+		vb.create(Vector3iUtil::create(block_size));
+		queries.push_back(VoxelGenerator::VoxelQueryData{ vb, origin, 0 });
+	}
+	StdVector<VoxelGenerator::Result> results;
+	results.resize(queries.size());
+
+	generator->generate_blocks(to_span(queries), to_span(results));
+
+	// Blocks generated together must be the same as if they were generated one by one
+	for (unsigned int i = 0; i < origins.size(); ++i) {
+		VoxelBuffer expected(VoxelBuffer::ALLOCATOR_DEFAULT);
+		expected.create(Vector3iUtil::create(block_size));
+		const VoxelGenerator::Result expected_result =
+				generator->generate_block(VoxelGenerator::VoxelQueryData{ expected, origins[i], 0 });
+
+		ZN_TEST_ASSERT(batch_buffers[i].equals(expected));
+		ZN_TEST_ASSERT(results[i].max_lod_hint == expected_result.max_lod_hint);
+	}
+}
+
+void test_voxel_graph_adaptive_subdivision() {
+	Ref<VoxelGeneratorGraph> generator;
+	generator.instantiate();
+	load_graph_with_sphere_on_plane(**generator->get_main_function(), 10.f);
+	const CompilationResult result = generator->compile(false);
+	ZN_TEST_ASSERT(result.success);
+	// Range analysis runs on the whole block first, then octants are split from there
+	generator->set_use_subdivision(false);
+	generator->set_adaptive_subdivision_min_size(4);
+
+	const int block_size = 32;
+	const Vector3i origin(-16, -16, -16);
+
+	VoxelBuffer expected(VoxelBuffer::ALLOCATOR_DEFAULT);
+	expected.create(Vector3iUtil::create(block_size));
+	generator->set_use_adaptive_subdivision(false);
+	generator->generate_block(VoxelGenerator::VoxelQueryData{ expected, origin, 0 });
+
+	VoxelBuffer adaptive(VoxelBuffer::ALLOCATOR_DEFAULT);
+	adaptive.create(Vector3iUtil::create(block_size));
+	generator->set_use_adaptive_subdivision(true);
+	generator->generate_block(VoxelGenerator::VoxelQueryData{ adaptive, origin, 0 });
+
+	// Octants away from the surface are filled with clipped values, but values near the surface must be the same
+	const float sdf_scale =
+			VoxelBuffer::get_sdf_quantization_scale(expected.get_channel_depth(VoxelBuffer::CHANNEL_SDF));
+	const float clip_threshold = generator->get_sdf_clip_threshold();
+	Vector3i pos;
+	for (pos.z = 0; pos.z < block_size; ++pos.z) {
+		for (pos.x = 0; pos.x < block_size; ++pos.x) {
+			for (pos.y = 0; pos.y < block_size; ++pos.y) {
+				const float expected_sd = expected.get_voxel_f(pos, VoxelBuffer::CHANNEL_SDF);
+				const float sd = adaptive.get_voxel_f(pos, VoxelBuffer::CHANNEL_SDF);
+				if (Math::abs(expected_sd / sdf_scale) < clip_threshold) {
+					ZN_TEST_ASSERT(sd == expected_sd);
+				} else {
+					ZN_TEST_ASSERT((sd > 0.f) == (expected_sd > 0.f));
+				}
+			}
+		}
+	}
+}
+
+void test_voxel_graph_column_cache() {
+	Ref<VoxelGeneratorGraph> generator;
+	generator.instantiate();
+	load_graph_with_expression_and_noises(**generator->get_main_function(), nullptr);
+	const CompilationResult result = generator->compile(false);
+	ZN_TEST_ASSERT(result.success);
+	ZN_TEST_ASSERT(generator->is_using_column_cache());
+
+	const int block_size = 8;
+	// Blocks of the same column crossing the surface, generated separately. The last one is generated again.
+	const StdVector<Vector3i> origins{
+		Vector3i(-16, -8, 32), //
+		Vector3i(-16, 0, 32), //
+		Vector3i(-16, -8, 32) //
+	};
+
+	StdVector<VoxelBuffer> cached_buffers;
+	cached_buffers.reserve(origins.size());
+	for (const Vector3i origin : origins) {
+		cached_buffers.emplace_back(VoxelBuffer::ALLOCATOR_DEFAULT);
+		VoxelBuffer &vb = cached_buffers.back();
+		vb.create(Vector3iUtil::create(block_size));
+		generator->generate_block(VoxelGenerator::VoxelQueryData{ vb, origin, 0 });
+	}
+
+	const GraphColumnCache::Stats stats = generator->get_column_cache_stats();
+	ZN_TEST_ASSERT(stats.hit_count >= 1);
+	ZN_TEST_ASSERT(stats.entry_count >= 1);
+	ZN_TEST_ASSERT(stats.memory_usage > 0);
+
+	// Blocks using cached values must be the same as blocks computing everything
+	generator->set_use_column_cache(false);
+	for (unsigned int i = 0; i < origins.size(); ++i) {
+		VoxelBuffer expected(VoxelBuffer::ALLOCATOR_DEFAULT);
+		expected.create(Vector3iUtil::create(block_size));
+		generator->generate_block(VoxelGenerator::VoxelQueryData{ expected, origins[i], 0 });
+		ZN_TEST_ASSERT(cached_buffers[i].equals(expected));
+	}
+	ZN_TEST_ASSERT(generator->get_column_cache_stats().entry_count == 0);
+}
+
+void test_voxel_graph_block_cache() {
+	Ref<VoxelGeneratorGraph> generator;
+	generator.instantiate();
+	load_graph_with_expression_and_noises(**generator->get_main_function(), nullptr);
+	const CompilationResult result = generator->compile(false);
+	ZN_TEST_ASSERT(result.success);
+	ZN_TEST_ASSERT(!generator->is_using_block_cache());
+	generator->set_use_block_cache(true);
+
+	const int block_size = 16;
+	const StdVector<Vector3i> origins{
+		Vector3i(-16, -16, 32), //
+		Vector3i(-16, 0, 32), //
+		Vector3i(64, 0, -16) //
+	};
+
+	StdVector<VoxelBuffer> expected_buffers;
+	expected_buffers.reserve(origins.size());
+	for (const Vector3i origin : origins) {
+		expected_buffers.emplace_back(VoxelBuffer::ALLOCATOR_DEFAULT);
+		VoxelBuffer &vb = expected_buffers.back();
+		vb.create(Vector3iUtil::create(block_size));
+		generator->generate_block(VoxelGenerator::VoxelQueryData{ vb, origin, 0 });
+	}
+	{
+		const GraphBlockCache::Stats stats = generator->get_block_cache_stats();
+		ZN_TEST_ASSERT(stats.hit_count == 0);
+		ZN_TEST_ASSERT(stats.entry_count == origins.size());
+		ZN_TEST_ASSERT(stats.memory_usage > 0);
+	}
+
+	// Generating the same blocks again must give the same voxels, from the cache
+	for (unsigned int i = 0; i < origins.size(); ++i) {
+		VoxelBuffer vb(VoxelBuffer::ALLOCATOR_DEFAULT);
+		vb.create(Vector3iUtil::create(block_size));
+		generator->generate_block(VoxelGenerator::VoxelQueryData{ vb, origins[i], 0 });
+		ZN_TEST_ASSERT(vb.equals(expected_buffers[i]));
+	}
+	ZN_TEST_ASSERT(generator->get_block_cache_stats().hit_count == origins.size());
+
+	// Settings changing how blocks are generated must not use blocks generated with previous settings
+	generator->set_sdf_clip_threshold(generator->get_sdf_clip_threshold() + 1.f);
+	{
+		VoxelBuffer vb(VoxelBuffer::ALLOCATOR_DEFAULT);
+		vb.create(Vector3iUtil::create(block_size));
+		generator->generate_block(VoxelGenerator::VoxelQueryData{ vb, origins[0], 0 });
+	}
+	ZN_TEST_ASSERT(generator->get_block_cache_stats().hit_count == origins.size());
+
+	// Compiling again frees cached blocks
+	ZN_TEST_ASSERT(generator->compile(false).success);
+	ZN_TEST_ASSERT(generator->get_block_cache_stats().entry_count == 0);
+}
+
+void test_voxel_graph_sparse_sampling() {
+	// SDF = Y - X, a tilted plane. Trilinear interpolation of a linear field gives the same values.
+	Ref<VoxelGeneratorGraph> generator;
+	generator.instantiate();
+	{
+		VoxelGraphFunction &g = **generator->get_main_function();
+		const uint32_t n_in_x = g.create_node(VoxelGraphFunction::NODE_INPUT_X, Vector2());
+		const uint32_t n_in_y = g.create_node(VoxelGraphFunction::NODE_INPUT_Y, Vector2());
+		const uint32_t n_sub = g.create_node(VoxelGraphFunction::NODE_SUBTRACT, Vector2());
+		const uint32_t n_out_sdf = g.create_node(VoxelGraphFunction::NODE_OUTPUT_SDF, Vector2());
+		g.add_connection(n_in_y, 0, n_sub, 0);
+		g.add_connection(n_in_x, 0, n_sub, 1);
+		g.add_connection(n_sub, 0, n_out_sdf, 0);
+	}
+	const CompilationResult result = generator->compile(false);
+	ZN_TEST_ASSERT(result.success);
+
+	const int block_size = 16;
+	const unsigned int lod_index = 2;
+	const Vector3i origin(-32, -32, -32);
+
+	VoxelBuffer expected(VoxelBuffer::ALLOCATOR_DEFAULT);
+	expected.create(Vector3iUtil::create(block_size));
+	expected.set_channel_depth(VoxelBuffer::CHANNEL_SDF, VoxelBuffer::DEPTH_32_BIT);
+	generator->generate_block(VoxelGenerator::VoxelQueryData{ expected, origin, lod_index });
+
+	generator->set_sparse_sampling_min_lod(1);
+
+	for (const int factor : { 2, 4 }) {
+		for (const bool error_guard : { false, true }) {
+			generator->set_sparse_sampling_factor(factor);
+			generator->set_sparse_sampling_error_guard(error_guard);
+
+			VoxelBuffer sparse(VoxelBuffer::ALLOCATOR_DEFAULT);
+			sparse.create(Vector3iUtil::create(block_size));
+			sparse.set_channel_depth(VoxelBuffer::CHANNEL_SDF, VoxelBuffer::DEPTH_32_BIT);
+			generator->generate_block(VoxelGenerator::VoxelQueryData{ sparse, origin, lod_index });
+
+			Vector3i pos;
+			for (pos.z = 0; pos.z < block_size; ++pos.z) {
+				for (pos.x = 0; pos.x < block_size; ++pos.x) {
+					for (pos.y = 0; pos.y < block_size; ++pos.y) {
+						const float expected_sd = expected.get_voxel_f(pos, VoxelBuffer::CHANNEL_SDF);
+						const float sd = sparse.get_voxel_f(pos, VoxelBuffer::CHANNEL_SDF);
+						ZN_TEST_ASSERT(Math::abs(sd - expected_sd) < 0.001f);
+					}
+				}
+			}
+		}
+	}
+}
+
+void test_voxel_graph_profiling() {
+	// SDF = Y - X
+	Ref<VoxelGeneratorGraph> generator;
+	generator.instantiate();
+	uint32_t n_sub;
+	{
+		VoxelGraphFunction &g = **generator->get_main_function();
+		const uint32_t n_in_x = g.create_node(VoxelGraphFunction::NODE_INPUT_X, Vector2());
+		const uint32_t n_in_y = g.create_node(VoxelGraphFunction::NODE_INPUT_Y, Vector2());
+		n_sub = g.create_node(VoxelGraphFunction::NODE_SUBTRACT, Vector2());
+		const uint32_t n_out_sdf = g.create_node(VoxelGraphFunction::NODE_OUTPUT_SDF, Vector2());
+		g.add_connection(n_in_y, 0, n_sub, 0);
+		g.add_connection(n_in_x, 0, n_sub, 1);
+		g.add_connection(n_sub, 0, n_out_sdf, 0);
+	}
+	const CompilationResult result = generator->compile(false);
+	ZN_TEST_ASSERT(result.success);
+
+	struct L {
+		static const GraphProfiler::NodeStats *find_node(Span<const GraphProfiler::NodeStats> nodes, uint32_t id) {
+			for (const GraphProfiler::NodeStats &stats : nodes) {
+				if (stats.node_id == id) {
+					return &stats;
+				}
+			}
+			return nullptr;
+		}
+	};
+
+	const int block_size = 16;
+	StdVector<GraphProfiler::NodeStats> nodes;
+	uint64_t sample_count;
+
+	// Not measuring anything by default
+	ZN_TEST_ASSERT(!generator->is_using_profiling());
+	{
+		VoxelBuffer vb(VoxelBuffer::ALLOCATOR_DEFAULT);
+		vb.create(Vector3iUtil::create(block_size));
+		generator->generate_block(VoxelGenerator::VoxelQueryData{ vb, Vector3i(-8, -8, -8), 0 });
+	}
+	generator->get_profiling_results(nodes, sample_count);
+	ZN_TEST_ASSERT(sample_count == 0);
+	ZN_TEST_ASSERT(nodes.size() == 0);
+
+	generator->set_use_profiling(true);
+	generator->set_profiling_sample_interval(1);
+
+	// The surface crosses this block, the node runs for every slice
+	{
+		VoxelBuffer vb(VoxelBuffer::ALLOCATOR_DEFAULT);
+		vb.create(Vector3iUtil::create(block_size));
+		generator->generate_block(VoxelGenerator::VoxelQueryData{ vb, Vector3i(-8, -8, -8), 0 });
+	}
+	generator->get_profiling_results(nodes, sample_count);
+	ZN_TEST_ASSERT(sample_count == 1);
+	{
+		const GraphProfiler::NodeStats *stats = L::find_node(to_span_const(nodes), n_sub);
+		ZN_TEST_ASSERT(stats != nullptr);
+		ZN_TEST_ASSERT(stats->call_count == block_size);
+		ZN_TEST_ASSERT(stats->skip_count == 0);
+		// Cheap nodes must not be truncated to zero
+		ZN_TEST_ASSERT(stats->nanoseconds > 0);
+	}
+
+	// This block is far above the surface, range analysis skips the node
+	{
+		VoxelBuffer vb(VoxelBuffer::ALLOCATOR_DEFAULT);
+		vb.create(Vector3iUtil::create(block_size));
+		generator->generate_block(VoxelGenerator::VoxelQueryData{ vb, Vector3i(0, 1000, 0), 0 });
+	}
+	generator->get_profiling_results(nodes, sample_count);
+	ZN_TEST_ASSERT(sample_count == 2);
+	{
+		const GraphProfiler::NodeStats *stats = L::find_node(to_span_const(nodes), n_sub);
+		ZN_TEST_ASSERT(stats != nullptr);
+		ZN_TEST_ASSERT(stats->call_count == block_size);
+		ZN_TEST_ASSERT(stats->skip_count == 1);
+	}
+
+	generator->clear_profiling_results();
+	generator->get_profiling_results(nodes, sample_count);
+	ZN_TEST_ASSERT(sample_count == 0);
+	ZN_TEST_ASSERT(nodes.size() == 0);
+}
+
+#ifdef VOXEL_ENABLE_FAST_NOISE_2
+
+void test_voxel_graph_fast_noise_2_grid() {
+	// SDF = Y - (FastNoise2_2D(X, Z) + FastNoise2_3D(X, Y, Z))
+	// Noise inputs are directly connected to coordinates, so blocks can be generated using grids.
+
+	Ref<VoxelGeneratorGraph> generator;
+	generator.instantiate();
+	{
+		VoxelGraphFunction &g = **generator->get_main_function();
+
+		const uint32_t n_in_x = g.create_node(VoxelGraphFunction::NODE_INPUT_X, Vector2());
+		const uint32_t n_in_y = g.create_node(VoxelGraphFunction::NODE_INPUT_Y, Vector2());
+		const uint32_t n_in_z = g.create_node(VoxelGraphFunction::NODE_INPUT_Z, Vector2());
+		const uint32_t n_fn2_2d = g.create_node(VoxelGraphFunction::NODE_FAST_NOISE_2_2D, Vector2());
+		const uint32_t n_fn2_3d = g.create_node(VoxelGraphFunction::NODE_FAST_NOISE_2_3D, Vector2());
+		const uint32_t n_add = g.create_node(VoxelGraphFunction::NODE_ADD, Vector2());
+		const uint32_t n_sub = g.create_node(VoxelGraphFunction::NODE_SUBTRACT, Vector2());
+		const uint32_t n_out_sdf = g.create_node(VoxelGraphFunction::NODE_OUTPUT_SDF, Vector2());
+
+		Ref<FastNoise2> noise;
+		noise.instantiate();
+		noise->set_period(16.f);
+		g.set_node_param(n_fn2_2d, 0, noise);
+		g.set_node_param(n_fn2_3d, 0, noise);
+
+		g.add_connection(n_in_x, 0, n_fn2_2d, 0);
+		g.add_connection(n_in_z, 0, n_fn2_2d, 1);
+		g.add_connection(n_in_x, 0, n_fn2_3d, 0);
+		g.add_connection(n_in_y, 0, n_fn2_3d, 1);
+		g.add_connection(n_in_z, 0, n_fn2_3d, 2);
+		g.add_connection(n_fn2_2d, 0, n_add, 0);
+		g.add_connection(n_fn2_3d, 0, n_add, 1);
+		g.add_connection(n_in_y, 0, n_sub, 0);
+		g.add_connection(n_add, 0, n_sub, 1);
+		g.add_connection(n_sub, 0, n_out_sdf, 0);
+	}
+	const CompilationResult result = generator->compile(false);
+	ZN_TEST_ASSERT(result.success);
+	ZN_TEST_ASSERT(generator->is_using_grid_queries());
+
+	struct Query {
+		Vector3i origin;
+		unsigned int lod_index;
+	};
+	// The last query is not aligned to its LOD, so it can't use grids
+	const StdVector<Query> queries{
+		Query{ Vector3i(-16, -16, -16), 0 }, //
+		Query{ Vector3i(-32, -32, 0), 1 }, //
+		Query{ Vector3i(-31, -32, 0), 1 } //
+	};
+	const int block_size = 32;
+
+	// Without subdivision, slices are larger than a tile, which tests grids covering only part of a slice
+	for (const bool use_subdivision : { true, false }) {
+		generator->set_use_subdivision(use_subdivision);
+
+		for (const Query &query : queries) {
+			VoxelBuffer expected(VoxelBuffer::ALLOCATOR_DEFAULT);
+			expected.create(Vector3iUtil::create(block_size));
+			generator->set_use_grid_queries(false);
+			generator->generate_block(VoxelGenerator::VoxelQueryData{ expected, query.origin, query.lod_index });
+
+			VoxelBuffer with_grid(VoxelBuffer::ALLOCATOR_DEFAULT);
+			with_grid.create(Vector3iUtil::create(block_size));
+			generator->set_use_grid_queries(true);
+			generator->generate_block(VoxelGenerator::VoxelQueryData{ with_grid, query.origin, query.lod_index });
+
+			ZN_TEST_ASSERT(with_grid.equals(expected));
+		}
+	}
+}
+
+#endif
+
 } // namespace zylann::voxel::tests
@@ -42,6 +42,17 @@ void test_voxel_graph_non_square_image();
 void test_voxel_graph_4_default_weights();
 void test_voxel_graph_empty_image();
 void test_voxel_graph_constant_reduction();
+void test_voxel_graph_operation_fusion();
+void test_voxel_graph_tile_streaming();
+void test_voxel_graph_generate_blocks_stacked();
+void test_voxel_graph_adaptive_subdivision();
+void test_voxel_graph_column_cache();
+void test_voxel_graph_block_cache();
+void test_voxel_graph_sparse_sampling();
+void test_voxel_graph_profiling();
+#ifdef VOXEL_ENABLE_FAST_NOISE_2
+void test_voxel_graph_fast_noise_2_grid();
+#endif
 
 } // namespace zylann::voxel::tests
 
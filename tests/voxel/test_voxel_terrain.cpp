@@ -0,0 +1,317 @@
+#include "test_voxel_terrain.h"
+#include "../../constants/voxel_constants.h"
+#include "../../engine/voxel_engine.h"
+#include "../../generators/multipass/generate_column_multipass_task.h"
+#include "../../generators/multipass/voxel_generator_multipass_cb.h"
+#include "../../generators/simple/voxel_generator_flat.h"
+#include "../../meshers/cubes/voxel_mesher_cubes.h"
+#include "../../streams/voxel_stream_memory.h"
+#include "../../terrain/fixed_lod/voxel_terrain.h"
+#include "../../util/godot/classes/time.h"
+#include "../../util/testing/test_macros.h"
+#include "../../util/thread/thread.h"
+
+namespace zylann::voxel::tests {
+
+void test_voxel_terrain_generate_and_mesh_support() {
+	Ref<VoxelMesherCubes> mesher;
+	mesher.instantiate();
+
+	Ref<VoxelGeneratorFlat> flat_generator;
+	flat_generator.instantiate();
+	ZN_TEST_ASSERT(flat_generator->supports_fused_generation());
+	ZN_TEST_ASSERT(VoxelTerrain::can_generate_and_mesh_in_single_task(nullptr, flat_generator.ptr(), mesher.ptr()));
+
+	// Blocks have to be loaded before generating missing ones
+	Ref<VoxelStreamMemory> stream;
+	stream.instantiate();
+	ZN_TEST_ASSERT(
+			!VoxelTerrain::can_generate_and_mesh_in_single_task(stream.ptr(), flat_generator.ptr(), mesher.ptr())
+	);
+
+	ZN_TEST_ASSERT(!VoxelTerrain::can_generate_and_mesh_in_single_task(nullptr, nullptr, mesher.ptr()));
+	ZN_TEST_ASSERT(!VoxelTerrain::can_generate_and_mesh_in_single_task(nullptr, flat_generator.ptr(), nullptr));
+
+	// Columns of this generator can only be generated by its own tasks, calling `generate_block` produces nothing.
+	// The terrain would remain empty if it was used to generate and mesh in a single task.
+	Ref<VoxelGeneratorMultipassCB> multipass_generator;
+	multipass_generator.instantiate();
+	ZN_TEST_ASSERT(!multipass_generator->supports_fused_generation());
+	ZN_TEST_ASSERT(
+			!VoxelTerrain::can_generate_and_mesh_in_single_task(nullptr, multipass_generator.ptr(), mesher.ptr())
+	);
+}
+
+namespace {
+
+// Counts passes running on a given column, to tell whether it gets generated again
+class VoxelGeneratorMultipassCBPassCounter : public VoxelGeneratorMultipassCB {
+public:
+	Vector2i counted_column_position;
+	std::atomic_int counted_pass_count{ 0 };
+
+	void generate_pass(VoxelGeneratorMultipassCBStructs::PassInput input) override {
+		if (input.main_block_position.x == counted_column_position.x &&
+			input.main_block_position.z == counted_column_position.y) {
+			++counted_pass_count;
+		}
+	}
+};
+
+// Stands in for the block task requesting a column, so we can tell when the column task returns to it
+class MultipassTestCallerTask : public IThreadedTask {
+public:
+	MultipassTestCallerTask(std::shared_ptr<std::atomic_bool> p_done) : _done(p_done) {}
+
+	const char *get_debug_name() const override {
+		return "MultipassTestCallerTask";
+	}
+
+	void run(ThreadedTaskContext &ctx) override {
+		*_done = true;
+	}
+
+private:
+	std::shared_ptr<std::atomic_bool> _done;
+};
+
+// Flags a column as having a pending task for the given subpass, like block tasks do before they spawn one
+void set_multipass_pending_subpass_task(VoxelGeneratorMultipassCB &generator, Vector2i cpos, int subpass_index) {
+	std::shared_ptr<VoxelGeneratorMultipassCBStructs::Internal> internal = generator.get_internal();
+	VoxelGeneratorMultipassCBStructs::Map &map = internal->map;
+	SpatialLock2D::Write swlock(map.spatial_lock, BoxBounds2i::from_position(cpos));
+	MutexLock mlock(map.mutex);
+	auto it = map.columns.find(cpos);
+	ZN_TEST_ASSERT(it != map.columns.end());
+	it->second.pending_subpass_tasks_mask |= (1 << subpass_index);
+}
+
+std::shared_ptr<std::atomic_bool> schedule_multipass_column_task(
+		Ref<VoxelGeneratorMultipassCB> generator,
+		Vector2i cpos,
+		int subpass_index
+) {
+	std::shared_ptr<std::atomic_bool> done = make_shared_instance<std::atomic_bool>(false);
+	MultipassTestCallerTask *caller = ZN_NEW(MultipassTestCallerTask(done));
+	GenerateColumnMultipassTask *task = ZN_NEW(GenerateColumnMultipassTask(
+			cpos,
+			VoxelFormat(),
+			1 << constants::DEFAULT_BLOCK_SIZE_PO2,
+			subpass_index,
+			generator->get_internal(),
+			generator,
+			TaskPriority(),
+			caller,
+			make_shared_instance<std::atomic_int>(1)
+	));
+	VoxelEngine::get_singleton().push_async_task(task);
+	return done;
+}
+
+void wait_for_multipass_column_task(const std::atomic_bool &done) {
+	const uint64_t time_before = Time::get_singleton()->get_ticks_usec();
+	while (!done) {
+		Thread::sleep_usec(1000);
+
+		const uint64_t timeout_seconds = 10;
+		const uint64_t time_elapsed_microseconds = Time::get_singleton()->get_ticks_usec() - time_before;
+		ZN_TEST_ASSERT(time_elapsed_microseconds < timeout_seconds * 1'000'000);
+	}
+	// Subtasks may still be finishing after they returned to their caller
+	VoxelEngine::get_singleton().wait_and_clear_all_tasks(false);
+}
+
+void generate_multipass_column(Ref<VoxelGeneratorMultipassCB> generator, Vector2i cpos) {
+	const int final_subpass_index =
+			VoxelGeneratorMultipassCB::get_subpass_count_from_pass_count(generator->get_pass_count()) - 1;
+	set_multipass_pending_subpass_task(**generator, cpos, final_subpass_index);
+	std::shared_ptr<std::atomic_bool> done = schedule_multipass_column_task(generator, cpos, final_subpass_index);
+	wait_for_multipass_column_task(*done);
+}
+
+// Returns -2 if the column isn't in the cache
+int get_multipass_column_subpass_index(VoxelGeneratorMultipassCB &generator, Vector2i cpos) {
+	StdVector<VoxelGeneratorMultipassCB::DebugColumnState> states;
+	ZN_TEST_ASSERT(generator.debug_try_get_column_states(states));
+	for (const VoxelGeneratorMultipassCB::DebugColumnState &state : states) {
+		if (state.position == cpos) {
+			return state.subpass_index;
+		}
+	}
+	return -2;
+}
+
+ViewerID make_multipass_test_viewer_id(uint16_t index) {
+	ViewerID id;
+	id.index = index;
+	return id;
+}
+
+} // namespace
+
+void test_voxel_generator_multipass_cb_cache_hit() {
+	Ref<VoxelGeneratorMultipassCBPassCounter> generator(memnew(VoxelGeneratorMultipassCBPassCounter));
+	generator->set_pass_count(2);
+	const int final_subpass_index = VoxelGeneratorMultipassCB::get_subpass_count_from_pass_count(2) - 1;
+
+	const Vector2i cpos(0, 0);
+	generator->counted_column_position = cpos;
+
+	const ViewerID viewer_id = make_multipass_test_viewer_id(1);
+	const Box3i viewer_box(Vector3i(cpos.x, 0, cpos.y), Vector3i(1, 1, 1));
+	generator->process_viewer_diff(viewer_id, viewer_box, Box3i());
+
+	generate_multipass_column(generator, cpos);
+	ZN_TEST_ASSERT(get_multipass_column_subpass_index(**generator, cpos) == final_subpass_index);
+	const int pass_count_after_generation = generator->counted_pass_count;
+	// One pass runs per pass index, even though passes are split in subpasses
+	ZN_TEST_ASSERT(pass_count_after_generation == 2);
+
+	// Leave. Only the fully generated column gets cached, neighbors that were partially generated are removed.
+	generator->process_viewer_diff(viewer_id, Box3i(), viewer_box);
+	{
+		const VoxelGeneratorMultipassCB::Stats stats = generator->get_stats();
+		ZN_TEST_ASSERT(stats.column_count == 1);
+		ZN_TEST_ASSERT(stats.cached_column_count == 1);
+		ZN_TEST_ASSERT(stats.cached_columns_memory_usage > 0);
+		ZN_TEST_ASSERT(stats.cache_hits == 0);
+	}
+
+	// Come back
+	generator->process_viewer_diff(viewer_id, viewer_box, Box3i());
+	{
+		const VoxelGeneratorMultipassCB::Stats stats = generator->get_stats();
+		ZN_TEST_ASSERT(stats.cached_column_count == 0);
+		ZN_TEST_ASSERT(stats.cached_columns_memory_usage == 0);
+		ZN_TEST_ASSERT(stats.cache_hits == 1);
+	}
+	ZN_TEST_ASSERT(get_multipass_column_subpass_index(**generator, cpos) == final_subpass_index);
+
+	// Requesting the column again brings its neighbors back, but doesn't run its own passes again
+	generate_multipass_column(generator, cpos);
+	ZN_TEST_ASSERT(get_multipass_column_subpass_index(**generator, cpos) == final_subpass_index);
+	ZN_TEST_ASSERT(generator->counted_pass_count == pass_count_after_generation);
+
+	generator->process_viewer_diff(viewer_id, Box3i(), viewer_box);
+}
+
+void test_voxel_generator_multipass_cb_cache_eviction() {
+	Ref<VoxelGeneratorMultipassCB> generator;
+	generator.instantiate();
+	generator->set_pass_count(2);
+	const int final_subpass_index = VoxelGeneratorMultipassCB::get_subpass_count_from_pass_count(2) - 1;
+
+	// Viewer A stays, viewer B leaves columns far enough from A to not share any
+	const ViewerID viewer_a = make_multipass_test_viewer_id(1);
+	const ViewerID viewer_b = make_multipass_test_viewer_id(2);
+	const Box3i viewer_a_box(Vector3i(0, 0, 0), Vector3i(1, 1, 1));
+	const Box3i viewer_b_box(Vector3i(20, 0, 0), Vector3i(3, 1, 1));
+	generator->process_viewer_diff(viewer_a, viewer_a_box, Box3i());
+	generator->process_viewer_diff(viewer_b, viewer_b_box, Box3i());
+
+	// Viewers load columns around their box, in range of passes the requested columns depend on
+	const unsigned int viewer_a_column_count = 5 * 5;
+	const unsigned int viewer_b_column_count = 7 * 5;
+	ZN_TEST_ASSERT(generator->get_stats().column_count == viewer_a_column_count + viewer_b_column_count);
+
+	generate_multipass_column(generator, Vector2i(0, 0));
+	generate_multipass_column(generator, Vector2i(20, 0));
+	generate_multipass_column(generator, Vector2i(21, 0));
+	generate_multipass_column(generator, Vector2i(22, 0));
+
+	generator->process_viewer_diff(viewer_b, Box3i(), viewer_b_box);
+	size_t column_memory_usage = 0;
+	{
+		const VoxelGeneratorMultipassCB::Stats stats = generator->get_stats();
+		ZN_TEST_ASSERT(stats.cached_column_count == 3);
+		ZN_TEST_ASSERT(stats.cache_evictions == 0);
+		// Columns are all the same size
+		ZN_TEST_ASSERT(stats.cached_columns_memory_usage % 3 == 0);
+		column_memory_usage = stats.cached_columns_memory_usage / 3;
+		ZN_TEST_ASSERT(column_memory_usage > 0);
+	}
+
+	// Only room for two columns, the one that got cached first is evicted
+	const size_t capacity = column_memory_usage * 2;
+	generator->set_column_cache_capacity(static_cast<int>(capacity));
+	{
+		const VoxelGeneratorMultipassCB::Stats stats = generator->get_stats();
+		ZN_TEST_ASSERT(stats.cached_columns_memory_usage <= capacity);
+		ZN_TEST_ASSERT(stats.cached_column_count == 2);
+		ZN_TEST_ASSERT(stats.cache_evictions == 1);
+	}
+	ZN_TEST_ASSERT(get_multipass_column_subpass_index(**generator, Vector2i(20, 0)) == -2);
+	ZN_TEST_ASSERT(get_multipass_column_subpass_index(**generator, Vector2i(21, 0)) == final_subpass_index);
+	ZN_TEST_ASSERT(get_multipass_column_subpass_index(**generator, Vector2i(22, 0)) == final_subpass_index);
+
+	// No room at all. Columns in range of viewer A use memory too, but they are not part of the cache.
+	generator->set_column_cache_capacity(0);
+	{
+		const VoxelGeneratorMultipassCB::Stats stats = generator->get_stats();
+		ZN_TEST_ASSERT(stats.cached_columns_memory_usage == 0);
+		ZN_TEST_ASSERT(stats.cached_column_count == 0);
+		ZN_TEST_ASSERT(stats.cache_evictions == 3);
+		ZN_TEST_ASSERT(stats.column_count == viewer_a_column_count);
+	}
+	ZN_TEST_ASSERT(get_multipass_column_subpass_index(**generator, Vector2i(0, 0)) == final_subpass_index);
+
+	generator->process_viewer_diff(viewer_a, Box3i(), viewer_a_box);
+	ZN_TEST_ASSERT(generator->get_stats().column_count == 0);
+}
+
+void test_voxel_generator_multipass_cb_dependency_wait() {
+	Ref<VoxelGeneratorMultipassCB> generator;
+	generator.instantiate();
+	generator->set_pass_count(2);
+
+	const ViewerID viewer_id = make_multipass_test_viewer_id(1);
+	const Box3i viewer_box(Vector3i(0, 0, 0), Vector3i(1, 1, 1));
+	generator->process_viewer_diff(viewer_id, viewer_box, Box3i());
+
+	// The second pass of the column depends on the first pass of its neighbors. Pretend one of them already has a task
+	// pending to run it, so the column task has to wait for that task instead of spawning its own.
+	const Vector2i cpos(0, 0);
+	const Vector2i neighbor_cpos(1, 0);
+	set_multipass_pending_subpass_task(**generator, neighbor_cpos, 0);
+	set_multipass_pending_subpass_task(**generator, cpos, 1);
+	std::shared_ptr<std::atomic_bool> done = schedule_multipass_column_task(generator, cpos, 1);
+
+	// Wait until the column task subscribed to the neighbor
+	{
+		std::shared_ptr<VoxelGeneratorMultipassCBStructs::Internal> internal = generator->get_internal();
+		VoxelGeneratorMultipassCBStructs::Map &map = internal->map;
+		const uint64_t time_before = Time::get_singleton()->get_ticks_usec();
+		while (true) {
+			{
+				SpatialLock2D::Read srlock(map.spatial_lock, BoxBounds2i::from_position(neighbor_cpos));
+				MutexLock mlock(map.mutex);
+				auto it = map.columns.find(neighbor_cpos);
+				ZN_TEST_ASSERT(it != map.columns.end());
+				if (it->second.waiting_tasks.size() > 0) {
+					break;
+				}
+			}
+			Thread::sleep_usec(1000);
+
+			const uint64_t timeout_seconds = 10;
+			const uint64_t time_elapsed_microseconds = Time::get_singleton()->get_ticks_usec() - time_before;
+			ZN_TEST_ASSERT(time_elapsed_microseconds < timeout_seconds * 1'000'000);
+		}
+	}
+	ZN_TEST_ASSERT(!*done);
+
+	// Run the pending neighbor task, the column task must resume when it completes
+	std::shared_ptr<std::atomic_bool> neighbor_done = schedule_multipass_column_task(generator, neighbor_cpos, 0);
+	wait_for_multipass_column_task(*neighbor_done);
+	wait_for_multipass_column_task(*done);
+
+	ZN_TEST_ASSERT(get_multipass_column_subpass_index(**generator, neighbor_cpos) == 0);
+	ZN_TEST_ASSERT(get_multipass_column_subpass_index(**generator, cpos) == 1);
+
+	const VoxelGeneratorMultipassCB::Stats stats = generator->get_stats();
+	ZN_TEST_ASSERT(stats.dependency_wait_count > 0);
+
+	generator->process_viewer_diff(viewer_id, Box3i(), viewer_box);
+}
+
+} // namespace zylann::voxel::tests
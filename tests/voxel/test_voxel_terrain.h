@@ -0,0 +1,13 @@
+#ifndef VOXEL_TESTS_VOXEL_TERRAIN_H
+#define VOXEL_TESTS_VOXEL_TERRAIN_H
+
+namespace zylann::voxel::tests {
+
+void test_voxel_terrain_generate_and_mesh_support();
+void test_voxel_generator_multipass_cb_cache_hit();
+void test_voxel_generator_multipass_cb_cache_eviction();
+void test_voxel_generator_multipass_cb_dependency_wait();
+
+} // namespace zylann::voxel::tests
+
+#endif // VOXEL_TESTS_VOXEL_TERRAIN_H
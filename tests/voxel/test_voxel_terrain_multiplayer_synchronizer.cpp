@@ -0,0 +1,78 @@
+#include "test_voxel_terrain_multiplayer_synchronizer.h"
+#include "../../terrain/fixed_lod/voxel_terrain_multiplayer_synchronizer.h"
+#include "../../util/math/funcs.h"
+#include "../../util/testing/test_macros.h"
+
+namespace zylann::voxel::tests {
+
+void test_voxel_terrain_multiplayer_synchronizer_send_order() {
+	typedef VoxelTerrainMultiplayerSynchronizer::PendingBlock PendingBlock;
+
+	const int block_size = 16;
+
+	StdUnorderedMap<Vector3i, bool> pending_blocks;
+	pending_blocks.insert({ Vector3i(5, 0, 0), false });
+	pending_blocks.insert({ Vector3i(0, 0, -2), true });
+	pending_blocks.insert({ Vector3i(0, 0, 0), false });
+	pending_blocks.insert({ Vector3i(-10, 3, 0), false });
+	pending_blocks.insert({ Vector3i(1, 1, 1), true });
+
+	// Viewer in the middle of block (0,0,0)
+	const Vector3 viewer_position(8, 8, 8);
+
+	StdVector<PendingBlock> blocks;
+	VoxelTerrainMultiplayerSynchronizer::get_pending_blocks_by_distance(
+			pending_blocks, viewer_position, block_size, blocks
+	);
+
+	ZN_TEST_ASSERT(blocks.size() == pending_blocks.size());
+
+	ZN_TEST_ASSERT(blocks[0].position == Vector3i(0, 0, 0));
+	ZN_TEST_ASSERT(blocks[0].distance_squared == 0.f);
+	ZN_TEST_ASSERT(blocks[1].position == Vector3i(1, 1, 1));
+	ZN_TEST_ASSERT(blocks[2].position == Vector3i(0, 0, -2));
+	ZN_TEST_ASSERT(blocks[3].position == Vector3i(5, 0, 0));
+	ZN_TEST_ASSERT(blocks[4].position == Vector3i(-10, 3, 0));
+
+	for (unsigned int i = 1; i < blocks.size(); ++i) {
+		ZN_TEST_ASSERT(blocks[i - 1].distance_squared <= blocks[i].distance_squared);
+	}
+
+	// Whether blocks have to be sent in full is preserved
+	for (const PendingBlock &block : blocks) {
+		auto it = pending_blocks.find(block.position);
+		ZN_TEST_ASSERT(it != pending_blocks.end());
+		ZN_TEST_ASSERT(block.full == it->second);
+	}
+
+	// Nothing pending
+	blocks.clear();
+	VoxelTerrainMultiplayerSynchronizer::get_pending_blocks_by_distance(
+			StdUnorderedMap<Vector3i, bool>(), viewer_position, block_size, blocks
+	);
+	ZN_TEST_ASSERT(blocks.size() == 0);
+}
+
+void test_voxel_terrain_multiplayer_synchronizer_send_budget() {
+	const int bytes_per_second = 1000;
+
+	// Budget grows with time
+	float budget = 0.f;
+	budget = VoxelTerrainMultiplayerSynchronizer::replenish_send_budget(budget, bytes_per_second, 0.25f);
+	ZN_TEST_ASSERT(Math::is_equal_approx(budget, 250.f));
+	budget = VoxelTerrainMultiplayerSynchronizer::replenish_send_budget(budget, bytes_per_second, 0.25f);
+	ZN_TEST_ASSERT(Math::is_equal_approx(budget, 500.f));
+
+	// Bursts can't go beyond one second worth of data, even after a long time without sending anything
+	budget = VoxelTerrainMultiplayerSynchronizer::replenish_send_budget(budget, bytes_per_second, 10.f);
+	ZN_TEST_ASSERT(Math::is_equal_approx(budget, static_cast<float>(bytes_per_second)));
+
+	// Sending a batch bigger than the remaining budget leaves a debt, which has to be repaid before sending again
+	budget -= 1600.f;
+	budget = VoxelTerrainMultiplayerSynchronizer::replenish_send_budget(budget, bytes_per_second, 0.5f);
+	ZN_TEST_ASSERT(budget < 0.f);
+	budget = VoxelTerrainMultiplayerSynchronizer::replenish_send_budget(budget, bytes_per_second, 0.5f);
+	ZN_TEST_ASSERT(Math::is_equal_approx(budget, 400.f));
+}
+
+} // namespace zylann::voxel::tests
@@ -0,0 +1,11 @@
+#ifndef VOXEL_TESTS_VOXEL_TERRAIN_MULTIPLAYER_SYNCHRONIZER_H
+#define VOXEL_TESTS_VOXEL_TERRAIN_MULTIPLAYER_SYNCHRONIZER_H
+
+namespace zylann::voxel::tests {
+
+void test_voxel_terrain_multiplayer_synchronizer_send_order();
+void test_voxel_terrain_multiplayer_synchronizer_send_budget();
+
+} // namespace zylann::voxel::tests
+
+#endif // VOXEL_TESTS_VOXEL_TERRAIN_MULTIPLAYER_SYNCHRONIZER_H
@@ -0,0 +1,149 @@
+#ifndef ZN_LRU_CACHE_H
+#define ZN_LRU_CACHE_H
+
+#include "../errors.h"
+#include "std_unordered_map.h"
+#include "std_vector.h"
+#include <algorithm>
+#include <cstdint>
+
+namespace zylann {
+
+struct LRUCacheStats {
+	uint64_t hit_count = 0;
+	uint64_t miss_count = 0;
+	size_t memory_usage = 0;
+	unsigned int entry_count = 0;
+};
+
+// Associative container with a memory budget. When memory usage goes above capacity, the least recently used entries
+// are evicted. Memory usage of each value is given when it is stored. Also counts how often lookups succeed.
+// This is not thread-safe.
+template <typename K, typename T, typename KHasher>
+class LRUCache {
+public:
+	typedef LRUCacheStats Stats;
+
+	LRUCache(size_t capacity_bytes) : _capacity(capacity_bytes) {}
+
+	// Gets the value of a key and marks it as recently used, if it exists and `is_usable(value)` returns true.
+	// Returns null otherwise, which counts as a miss.
+	template <typename F>
+	T *get_if(const K &key, F is_usable) {
+		auto it = _entries.find(key);
+		if (it == _entries.end() || !is_usable(static_cast<const T &>(it->second.value))) {
+			++_miss_count;
+			return nullptr;
+		}
+		Entry &entry = it->second;
+		++_time;
+		entry.last_used_time = _time;
+		++_hit_count;
+		return &entry.value;
+	}
+
+	inline T *get(const K &key) {
+		return get_if(key, [](const T &) { return true; });
+	}
+
+	// Stores a value, replacing any previous one. `memory_usage` is how many bytes the value uses, not counting
+	// the size of the value itself. Does nothing if capacity is zero.
+	void set(const K &key, T &&value, size_t memory_usage) {
+		if (_capacity == 0) {
+			return;
+		}
+
+		auto insert_result = _entries.insert({ key, Entry() });
+		Entry &entry = insert_result.first->second;
+		if (!insert_result.second) {
+			_memory_usage -= entry.memory_usage;
+		}
+
+		entry.value = std::move(value);
+		entry.memory_usage = memory_usage + sizeof(Entry) + sizeof(K);
+		++_time;
+		entry.last_used_time = _time;
+
+		_memory_usage += entry.memory_usage;
+
+		if (_memory_usage > _capacity) {
+			// Evict more than necessary so it doesn't have to be done again on every store
+			evict_least_recently_used(_capacity - _capacity / 4);
+		}
+	}
+
+	void clear() {
+		_entries.clear();
+		_memory_usage = 0;
+	}
+
+	// Maximum amount of memory used by entries, in bytes
+	void set_capacity(size_t capacity_bytes) {
+		_capacity = capacity_bytes;
+		if (_memory_usage > _capacity) {
+			evict_least_recently_used(_capacity);
+		}
+	}
+
+	inline size_t get_capacity() const {
+		return _capacity;
+	}
+
+	Stats get_stats() const {
+		Stats stats;
+		stats.hit_count = _hit_count;
+		stats.miss_count = _miss_count;
+		stats.memory_usage = _memory_usage;
+		stats.entry_count = _entries.size();
+		return stats;
+	}
+
+	void reset_stats() {
+		_hit_count = 0;
+		_miss_count = 0;
+	}
+
+private:
+	struct Entry {
+		T value;
+		size_t memory_usage = 0;
+		uint64_t last_used_time = 0;
+	};
+
+	void evict_least_recently_used(size_t target_memory_usage) {
+		struct Item {
+			uint64_t last_used_time;
+			K key;
+		};
+		StdVector<Item> items;
+		items.reserve(_entries.size());
+		for (auto it = _entries.begin(); it != _entries.end(); ++it) {
+			items.push_back(Item{ it->second.last_used_time, it->first });
+		}
+		std::sort(items.begin(), items.end(), [](const Item &a, const Item &b) {
+			return a.last_used_time < b.last_used_time;
+		});
+
+		for (const Item &item : items) {
+			if (_memory_usage <= target_memory_usage) {
+				break;
+			}
+			auto it = _entries.find(item.key);
+			ZN_ASSERT_CONTINUE(it != _entries.end());
+			_memory_usage -= it->second.memory_usage;
+			_entries.erase(it);
+		}
+	}
+
+	StdUnorderedMap<K, Entry, KHasher> _entries;
+	size_t _memory_usage = 0;
+	size_t _capacity;
+	// Incremented at every access, used to find least recently used entries
+	uint64_t _time = 0;
+	uint64_t _hit_count = 0;
+	uint64_t _miss_count = 0;
+};
+
+} // namespace zylann
+
+#endif // ZN_LRU_CACHE_H
@@ -33,6 +33,19 @@ void DirectMeshInstance::create() {
 	vs.instance_set_visible(_mesh_instance, true); // TODO Is it needed?
 }
 
+void DirectMeshInstance::create_from(RID instance) {
+	ERR_FAIL_COND(_mesh_instance.is_valid());
+	ERR_FAIL_COND(!instance.is_valid());
+	_mesh_instance = instance;
+}
+
+RID DirectMeshInstance::release() {
+	const RID instance = _mesh_instance;
+	_mesh_instance = RID();
+	_mesh.unref();
+	return instance;
+}
+
 void DirectMeshInstance::destroy() {
 	if (_mesh_instance.is_valid()) {
 		ZN_PROFILE_SCOPE();
@@ -142,4 +155,44 @@ void DirectMeshInstance::operator=(DirectMeshInstance &&src) {
 	src._mesh.unref();
 }
 
+DirectMeshInstancePool::~DirectMeshInstancePool() {
+	clear();
+}
+
+void DirectMeshInstancePool::create(DirectMeshInstance &mi) {
+	if (_instances.size() == 0) {
+		mi.create();
+		return;
+	}
+	mi.create_from(_instances.back());
+	_instances.pop_back();
+	mi.set_visible(true);
+}
+
+void DirectMeshInstancePool::recycle(DirectMeshInstance &mi) {
+	if (!mi.is_valid()) {
+		return;
+	}
+	if (_instances.size() >= DEFAULT_CAPACITY) {
+		mi.destroy();
+		return;
+	}
+	ZN_PROFILE_SCOPE();
+	mi.set_world(nullptr);
+	mi.set_material_override(Ref<Material>());
+	mi.set_mesh(Ref<Mesh>());
+	_instances.push_back(mi.release());
+}
+
+void DirectMeshInstancePool::clear() {
+	if (_instances.size() == 0) {
+		return;
+	}
+	RenderingServer &rs = *RenderingServer::get_singleton();
+	for (const RID instance : _instances) {
+		free_rendering_server_rid(rs, instance);
+	}
+	_instances.clear();
+}
+
 } // namespace zylann::godot
@@ -1,6 +1,7 @@
 #ifndef DIRECT_MESH_INSTANCE_H
 #define DIRECT_MESH_INSTANCE_H
 
+#include "../containers/std_vector.h"
 #include "../non_copyable.h"
 #include "classes/geometry_instance_3d.h"
 #include "classes/mesh.h"
@@ -20,7 +21,11 @@ public:
 
 	bool is_valid() const;
 	void create();
+	// Takes ownership of an existing instance, such as one that was released earlier
+	void create_from(RID instance);
 	void destroy();
+	// Gives up ownership of the instance and returns it, without freeing it
+	RID release();
 	void set_world(World3D *world);
 	void set_transform(Transform3D world_transform);
 	void set_mesh(Ref<Mesh> mesh);
@@ -44,6 +49,31 @@ private:
 	Ref<Mesh> _mesh;
 };
 
+// Keeps mesh instances that are no longer used, so they can be reused instead of being freed and created again. This
+// is cheaper when many of them come and go every frame, like chunks of a terrain as the viewer moves.
+// Properties that owners are expected to set when creating an instance (such as GI mode or layers) are not reset.
+class DirectMeshInstancePool : public NonCopyable {
+public:
+	static constexpr unsigned int DEFAULT_CAPACITY = 256;
+
+	~DirectMeshInstancePool();
+
+	// Creates the instance, reusing a pooled one if any
+	void create(DirectMeshInstance &mi);
+	// Detaches the instance from its mesh, material and world, and keeps it for reuse. If the pool is full, the
+	// instance is destroyed.
+	void recycle(DirectMeshInstance &mi);
+
+	void clear();
+
+	inline unsigned int get_size() const {
+		return _instances.size();
+	}
+
+private:
+	StdVector<RID> _instances;
+};
+
 } // namespace zylann::godot
 
 #endif // DIRECT_MESH_INSTANCE_H
@@ -23,6 +23,26 @@ void DirectStaticBody::create() {
 	ps.body_set_mode(_body, PhysicsServer3D::BODY_MODE_STATIC);
 }
 
+void DirectStaticBody::create_from(RID body) {
+	ERR_FAIL_COND(_body.is_valid());
+	ERR_FAIL_COND(!body.is_valid());
+	_body = body;
+}
+
+RID DirectStaticBody::release() {
+	const RID body = _body;
+	if (_body.is_valid()) {
+		PhysicsServer3D::get_singleton()->body_clear_shapes(_body);
+		_body = RID();
+		// The shape need to be released after it was removed from the body
+		_shape.unref();
+	}
+	if (_debug_mesh_instance.is_valid()) {
+		_debug_mesh_instance.destroy();
+	}
+	return body;
+}
+
 void DirectStaticBody::destroy() {
 	if (_body.is_valid()) {
 		PhysicsServer3D &ps = *PhysicsServer3D::get_singleton();
@@ -138,4 +158,42 @@ void DirectStaticBody::set_debug(bool enabled, World3D *world) {
 	}
 }
 
+DirectStaticBodyPool::~DirectStaticBodyPool() {
+	clear();
+}
+
+void DirectStaticBodyPool::create(DirectStaticBody &body) {
+	if (_bodies.size() == 0) {
+		body.create();
+		return;
+	}
+	body.create_from(_bodies.back());
+	_bodies.pop_back();
+}
+
+void DirectStaticBodyPool::recycle(DirectStaticBody &body) {
+	if (!body.is_valid()) {
+		return;
+	}
+	if (_bodies.size() >= DEFAULT_CAPACITY) {
+		body.destroy();
+		return;
+	}
+	ZN_PROFILE_SCOPE();
+	body.set_world(nullptr);
+	body.set_attached_object(nullptr);
+	_bodies.push_back(body.release());
+}
+
+void DirectStaticBodyPool::clear() {
+	if (_bodies.size() == 0) {
+		return;
+	}
+	PhysicsServer3D &ps = *PhysicsServer3D::get_singleton();
+	for (const RID body : _bodies) {
+		free_physics_server_rid(ps, body);
+	}
+	_bodies.clear();
+}
+
 } // namespace zylann::godot
\ No newline at end of file
@@ -17,7 +17,11 @@ public:
 	~DirectStaticBody();
 
 	void create();
+	// Takes ownership of an existing body, such as one that was released earlier
+	void create_from(RID body);
 	void destroy();
+	// Gives up ownership of the body and returns it, without freeing it. Shapes and debug visuals are removed.
+	RID release();
 	bool is_valid() const;
 	void set_transform(Transform3D transform);
 	void add_shape(Ref<Shape3D> shape);
@@ -37,6 +41,29 @@ private:
 	DirectMeshInstance _debug_mesh_instance;
 };
 
+// Keeps static bodies that are no longer used, so they can be reused instead of being freed and created again.
+// Collision layer and mask are not reset, owners are expected to set them after creating a body.
+class DirectStaticBodyPool : public zylann::NonCopyable {
+public:
+	static constexpr unsigned int DEFAULT_CAPACITY = 256;
+
+	~DirectStaticBodyPool();
+
+	// Creates the body, reusing a pooled one if any
+	void create(DirectStaticBody &body);
+	// Removes the body from its space and keeps it for reuse. If the pool is full, the body is destroyed.
+	void recycle(DirectStaticBody &body);
+
+	void clear();
+
+	inline unsigned int get_size() const {
+		return _bodies.size();
+	}
+
+private:
+	StdVector<RID> _bodies;
+};
+
 } // namespace zylann::godot
 
 #endif // DIRECT_STATIC_BODY_H
@@ -2,6 +2,7 @@
 #define ZN_HASH_FUNCS_H
 
 #include "math/funcs.h"
+#include <cstddef>
 #include <cstdint>
 
 namespace zylann {
@@ -43,6 +44,18 @@ inline uint32_t hash_fmix32(uint32_t h) {
 	return h;
 }
 
+// FNV-1a 64-bit hash of a sequence of bytes.
+// Not cryptographic, but cheap and well-distributed enough to identify byte-identical data, as long as contents are
+// verified when a match is found.
+inline uint64_t hash_fnv1a_64(const uint8_t *p_data, size_t p_size, uint64_t p_prev = 0xcbf29ce484222325) {
+	uint64_t h = p_prev;
+	for (size_t i = 0; i < p_size; ++i) {
+		h ^= p_data[i];
+		h *= 0x100000001b3;
+	}
+	return h;
+}
+
 } // namespace zylann
 
 #endif // ZN_HASH_FUNCS_H
@@ -0,0 +1,203 @@
+#ifndef ZN_MATH_FLOAT4_H
+#define ZN_MATH_FLOAT4_H
+
+#include "funcs.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+// SSE2 is part of the baseline of x86_64, so it doesn't need runtime detection
+#define ZN_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace zylann::math {
+
+// Pack of 4 floats on which operations are done all at once. It is meant to process float arrays, and provides the same
+// functions as those used on scalars so generic code can work with both.
+// Uses SSE2 when available. Otherwise, falls back on plain floats, which compilers may still vectorize.
+struct Float4 {
+	static constexpr unsigned int SIZE = 4;
+
+#ifdef ZN_SIMD_SSE2
+	__m128 v;
+
+	inline Float4() {}
+	inline explicit Float4(float f) : v(_mm_set1_ps(f)) {}
+	inline explicit Float4(__m128 p_v) : v(p_v) {}
+
+	// Pointers don't need to be aligned
+	static inline Float4 load(const float *p) {
+		return Float4(_mm_loadu_ps(p));
+	}
+
+	inline void store(float *p) const {
+		_mm_storeu_ps(p, v);
+	}
+
+#else
+	float v[SIZE];
+
+	inline Float4() {}
+
+	inline explicit Float4(float f) {
+		for (unsigned int i = 0; i < SIZE; ++i) {
+			v[i] = f;
+		}
+	}
+
+	static inline Float4 load(const float *p) {
+		Float4 r;
+		for (unsigned int i = 0; i < SIZE; ++i) {
+			r.v[i] = p[i];
+		}
+		return r;
+	}
+
+	inline void store(float *p) const {
+		for (unsigned int i = 0; i < SIZE; ++i) {
+			p[i] = v[i];
+		}
+	}
+
+	template <typename F>
+	inline Float4 map(F f) const {
+		Float4 r;
+		for (unsigned int i = 0; i < SIZE; ++i) {
+			r.v[i] = f(v[i]);
+		}
+		return r;
+	}
+
+	template <typename F>
+	inline Float4 map(const Float4 &other, F f) const {
+		Float4 r;
+		for (unsigned int i = 0; i < SIZE; ++i) {
+			r.v[i] = f(v[i], other.v[i]);
+		}
+		return r;
+	}
+#endif
+};
+
+#ifdef ZN_SIMD_SSE2
+
+inline Float4 operator+(const Float4 a, const Float4 b) {
+	return Float4(_mm_add_ps(a.v, b.v));
+}
+
+inline Float4 operator-(const Float4 a, const Float4 b) {
+	return Float4(_mm_sub_ps(a.v, b.v));
+}
+
+inline Float4 operator*(const Float4 a, const Float4 b) {
+	return Float4(_mm_mul_ps(a.v, b.v));
+}
+
+inline Float4 operator/(const Float4 a, const Float4 b) {
+	return Float4(_mm_div_ps(a.v, b.v));
+}
+
+inline Float4 operator-(const Float4 a) {
+	return Float4(_mm_xor_ps(a.v, _mm_set1_ps(-0.f)));
+}
+
+// Same as the scalar `min`: returns `b` if either is NaN
+inline Float4 min(const Float4 a, const Float4 b) {
+	return Float4(_mm_min_ps(a.v, b.v));
+}
+
+inline Float4 max(const Float4 a, const Float4 b) {
+	return Float4(_mm_max_ps(a.v, b.v));
+}
+
+inline Float4 abs(const Float4 a) {
+	return Float4(_mm_andnot_ps(_mm_set1_ps(-0.f), a.v));
+}
+
+inline Float4 sqrt(const Float4 a) {
+	return Float4(_mm_sqrt_ps(a.v));
+}
+
+inline Float4 floor(const Float4 a) {
+	// SSE2 has no floor instruction. Truncate, then correct negative values which got rounded up.
+	const __m128 t = _mm_cvtepi32_ps(_mm_cvttps_epi32(a.v));
+	const __m128 rounded_up = _mm_cmpgt_ps(t, a.v);
+	const __m128 f = _mm_sub_ps(t, _mm_and_ps(rounded_up, _mm_set1_ps(1.f)));
+	// Values of 2^23 and beyond are already integers and might not fit in 32-bit integers. NaNs are kept as well.
+	const __m128 keep = _mm_cmpnlt_ps(_mm_andnot_ps(_mm_set1_ps(-0.f), a.v), _mm_set1_ps(8388608.f));
+	return Float4(_mm_or_ps(_mm_and_ps(keep, a.v), _mm_andnot_ps(keep, f)));
+}
+
+// Returns zero where `b` is zero, instead of infinity or NaN
+inline Float4 div_or_zero(const Float4 a, const Float4 b) {
+	const __m128 non_zero = _mm_cmpneq_ps(b.v, _mm_setzero_ps());
+	return Float4(_mm_and_ps(_mm_div_ps(a.v, b.v), non_zero));
+}
+
+#else
+
+inline Float4 operator+(const Float4 a, const Float4 b) {
+	return a.map(b, [](float x, float y) { return x + y; });
+}
+
+inline Float4 operator-(const Float4 a, const Float4 b) {
+	return a.map(b, [](float x, float y) { return x - y; });
+}
+
+inline Float4 operator*(const Float4 a, const Float4 b) {
+	return a.map(b, [](float x, float y) { return x * y; });
+}
+
+inline Float4 operator/(const Float4 a, const Float4 b) {
+	return a.map(b, [](float x, float y) { return x / y; });
+}
+
+inline Float4 operator-(const Float4 a) {
+	return a.map([](float x) { return -x; });
+}
+
+inline Float4 min(const Float4 a, const Float4 b) {
+	return a.map(b, [](float x, float y) { return min(x, y); });
+}
+
+inline Float4 max(const Float4 a, const Float4 b) {
+	return a.map(b, [](float x, float y) { return max(x, y); });
+}
+
+inline Float4 abs(const Float4 a) {
+	return a.map([](float x) { return Math::abs(x); });
+}
+
+inline Float4 sqrt(const Float4 a) {
+	return a.map([](float x) { return Math::sqrt(x); });
+}
+
+inline Float4 floor(const Float4 a) {
+	return a.map([](float x) { return Math::floor(x); });
+}
+
+inline Float4 div_or_zero(const Float4 a, const Float4 b) {
+	return a.map(b, [](float x, float y) { return y == 0.f ? 0.f : x / y; });
+}
+
+#endif
+
+inline float div_or_zero(const float a, const float b) {
+	return b == 0.f ? 0.f : a / b;
+}
+
+inline Float4 clamp(const Float4 x, const Float4 min_value, const Float4 max_value) {
+	return min(max(x, min_value), max_value);
+}
+
+inline Float4 lerp(const Float4 a, const Float4 b, const Float4 t) {
+	// Same as `Math::lerp`
+	return a + (b - a) * t;
+}
+
+inline Float4 fract(const Float4 x) {
+	return x - floor(x);
+}
+
+} // namespace zylann::math
+
+#endif // ZN_MATH_FLOAT4_H
@@ -12,6 +12,8 @@ using namespace godot;
 
 #include "constants.h"
 #include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <type_traits>
 
 namespace zylann::math {
@@ -447,6 +449,13 @@ inline bool is_inf(double p_val) {
 	return std::isinf(p_val);
 }
 
+// Gets the bits of a float, for hashing or comparing exactly, without breaking strict aliasing rules
+inline uint32_t get_float_bits(const float f) {
+	uint32_t bits;
+	memcpy(&bits, &f, sizeof(bits));
+	return bits;
+}
+
 inline double deg_to_rad(double p_y) {
 	return p_y * PI<double> / 180.0;
 }
@@ -0,0 +1,245 @@
+#ifndef ZN_MATH_INT4_H
+#define ZN_MATH_INT4_H
+
+#include "float4.h"
+#include <cstdint>
+
+namespace zylann::math {
+
+// Pack of 4 32-bit signed integers, companion of `Float4`. Arithmetic wraps around on overflow, like the two's
+// complement hashing code it is meant for.
+// Comparisons produce masks, which are Int4 with all bits set in lanes where the condition is true, and zero elsewhere.
+struct Int4 {
+	static constexpr unsigned int SIZE = 4;
+
+#ifdef ZN_SIMD_SSE2
+	__m128i v;
+
+	inline Int4() {}
+	inline explicit Int4(int32_t i) : v(_mm_set1_epi32(i)) {}
+	inline explicit Int4(__m128i p_v) : v(p_v) {}
+
+	static inline Int4 load(const int32_t *p) {
+		return Int4(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)));
+	}
+
+	inline void store(int32_t *p) const {
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(p), v);
+	}
+
+#else
+	int32_t v[SIZE];
+
+	inline Int4() {}
+
+	inline explicit Int4(int32_t i) {
+		for (unsigned int j = 0; j < SIZE; ++j) {
+			v[j] = i;
+		}
+	}
+
+	static inline Int4 load(const int32_t *p) {
+		Int4 r;
+		for (unsigned int i = 0; i < SIZE; ++i) {
+			r.v[i] = p[i];
+		}
+		return r;
+	}
+
+	inline void store(int32_t *p) const {
+		for (unsigned int i = 0; i < SIZE; ++i) {
+			p[i] = v[i];
+		}
+	}
+
+	template <typename F>
+	inline Int4 map(F f) const {
+		Int4 r;
+		for (unsigned int i = 0; i < SIZE; ++i) {
+			r.v[i] = f(v[i]);
+		}
+		return r;
+	}
+
+	template <typename F>
+	inline Int4 map(const Int4 &other, F f) const {
+		Int4 r;
+		for (unsigned int i = 0; i < SIZE; ++i) {
+			r.v[i] = f(v[i], other.v[i]);
+		}
+		return r;
+	}
+#endif
+};
+
+#ifdef ZN_SIMD_SSE2
+
+inline Int4 operator+(const Int4 a, const Int4 b) {
+	return Int4(_mm_add_epi32(a.v, b.v));
+}
+
+inline Int4 operator-(const Int4 a, const Int4 b) {
+	return Int4(_mm_sub_epi32(a.v, b.v));
+}
+
+inline Int4 operator*(const Int4 a, const Int4 b) {
+	// SSE2 has no 32-bit multiplication keeping the low bits (that's SSE4.1), so multiply even and odd lanes
+	// separately into 64-bit results and gather their low halves
+	const __m128i even = _mm_mul_epu32(a.v, b.v);
+	const __m128i odd = _mm_mul_epu32(_mm_srli_si128(a.v, 4), _mm_srli_si128(b.v, 4));
+	return Int4(_mm_unpacklo_epi32(
+			_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0))
+	));
+}
+
+inline Int4 operator&(const Int4 a, const Int4 b) {
+	return Int4(_mm_and_si128(a.v, b.v));
+}
+
+inline Int4 operator|(const Int4 a, const Int4 b) {
+	return Int4(_mm_or_si128(a.v, b.v));
+}
+
+inline Int4 operator^(const Int4 a, const Int4 b) {
+	return Int4(_mm_xor_si128(a.v, b.v));
+}
+
+inline Int4 operator<<(const Int4 a, const int shift) {
+	return Int4(_mm_sll_epi32(a.v, _mm_cvtsi32_si128(shift)));
+}
+
+// Arithmetic shift, the sign bit is preserved
+inline Int4 operator>>(const Int4 a, const int shift) {
+	return Int4(_mm_sra_epi32(a.v, _mm_cvtsi32_si128(shift)));
+}
+
+inline Int4 less_than(const Float4 a, const Float4 b) {
+	return Int4(_mm_castps_si128(_mm_cmplt_ps(a.v, b.v)));
+}
+
+inline Int4 less_equal(const Float4 a, const Float4 b) {
+	return Int4(_mm_castps_si128(_mm_cmple_ps(a.v, b.v)));
+}
+
+inline Int4 greater_than(const Float4 a, const Float4 b) {
+	return Int4(_mm_castps_si128(_mm_cmpgt_ps(a.v, b.v)));
+}
+
+inline Int4 greater_equal(const Float4 a, const Float4 b) {
+	return Int4(_mm_castps_si128(_mm_cmpge_ps(a.v, b.v)));
+}
+
+// Lanes of `mask` must be either all zeroes or all ones
+inline Int4 select(const Int4 mask, const Int4 if_true, const Int4 if_false) {
+	return Int4(_mm_or_si128(_mm_and_si128(mask.v, if_true.v), _mm_andnot_si128(mask.v, if_false.v)));
+}
+
+inline Float4 select(const Int4 mask, const Float4 if_true, const Float4 if_false) {
+	const __m128 m = _mm_castsi128_ps(mask.v);
+	return Float4(_mm_or_ps(_mm_and_ps(m, if_true.v), _mm_andnot_ps(m, if_false.v)));
+}
+
+inline Float4 to_float4(const Int4 a) {
+	return Float4(_mm_cvtepi32_ps(a.v));
+}
+
+// Rounds towards zero, same as casting a float to an int
+inline Int4 truncate_to_int4(const Float4 a) {
+	return Int4(_mm_cvttps_epi32(a.v));
+}
+
+#else
+
+inline Int4 operator+(const Int4 a, const Int4 b) {
+	return a.map(b, [](int32_t x, int32_t y) { return int32_t(uint32_t(x) + uint32_t(y)); });
+}
+
+inline Int4 operator-(const Int4 a, const Int4 b) {
+	return a.map(b, [](int32_t x, int32_t y) { return int32_t(uint32_t(x) - uint32_t(y)); });
+}
+
+inline Int4 operator*(const Int4 a, const Int4 b) {
+	return a.map(b, [](int32_t x, int32_t y) { return int32_t(uint32_t(x) * uint32_t(y)); });
+}
+
+inline Int4 operator&(const Int4 a, const Int4 b) {
+	return a.map(b, [](int32_t x, int32_t y) { return x & y; });
+}
+
+inline Int4 operator|(const Int4 a, const Int4 b) {
+	return a.map(b, [](int32_t x, int32_t y) { return x | y; });
+}
+
+inline Int4 operator^(const Int4 a, const Int4 b) {
+	return a.map(b, [](int32_t x, int32_t y) { return x ^ y; });
+}
+
+inline Int4 operator<<(const Int4 a, const int shift) {
+	return a.map([shift](int32_t x) { return int32_t(uint32_t(x) << shift); });
+}
+
+inline Int4 operator>>(const Int4 a, const int shift) {
+	return a.map([shift](int32_t x) { return x >> shift; });
+}
+
+inline Int4 less_than(const Float4 a, const Float4 b) {
+	Int4 r;
+	for (unsigned int i = 0; i < Int4::SIZE; ++i) {
+		r.v[i] = a.v[i] < b.v[i] ? -1 : 0;
+	}
+	return r;
+}
+
+inline Int4 less_equal(const Float4 a, const Float4 b) {
+	Int4 r;
+	for (unsigned int i = 0; i < Int4::SIZE; ++i) {
+		r.v[i] = a.v[i] <= b.v[i] ? -1 : 0;
+	}
+	return r;
+}
+
+inline Int4 greater_than(const Float4 a, const Float4 b) {
+	return less_than(b, a);
+}
+
+inline Int4 greater_equal(const Float4 a, const Float4 b) {
+	return less_equal(b, a);
+}
+
+inline Int4 select(const Int4 mask, const Int4 if_true, const Int4 if_false) {
+	Int4 r;
+	for (unsigned int i = 0; i < Int4::SIZE; ++i) {
+		r.v[i] = mask.v[i] != 0 ? if_true.v[i] : if_false.v[i];
+	}
+	return r;
+}
+
+inline Float4 select(const Int4 mask, const Float4 if_true, const Float4 if_false) {
+	Float4 r;
+	for (unsigned int i = 0; i < Int4::SIZE; ++i) {
+		r.v[i] = mask.v[i] != 0 ? if_true.v[i] : if_false.v[i];
+	}
+	return r;
+}
+
+inline Float4 to_float4(const Int4 a) {
+	Float4 r;
+	for (unsigned int i = 0; i < Int4::SIZE; ++i) {
+		r.v[i] = static_cast<float>(a.v[i]);
+	}
+	return r;
+}
+
+inline Int4 truncate_to_int4(const Float4 a) {
+	Int4 r;
+	for (unsigned int i = 0; i < Int4::SIZE; ++i) {
+		r.v[i] = static_cast<int32_t>(a.v[i]);
+	}
+	return r;
+}
+
+#endif
+
+} // namespace zylann::math
+
+#endif // ZN_MATH_INT4_H
@@ -421,18 +421,19 @@ void FastNoise2::get_noise_3d_series(
 	}
 }
 
-void FastNoise2::get_noise_2d_grid(Vector2 origin, Vector2i size, Span<float> dst) const {
+void FastNoise2::get_noise_2d_grid(Vector2i origin, Vector2i size, float step, Span<float> dst) const {
 	ERR_FAIL_COND(!is_valid());
 	ERR_FAIL_COND(size.x < 0 || size.y < 0);
 	ERR_FAIL_COND(dst.size() != size_t(size.x) * size_t(size.y));
-	_generator->GenUniformGrid2D(dst.data(), origin.x, origin.y, size.x, size.y, 1.f, _seed);
+	// Grid positions are computed as `index * frequency`
+	_generator->GenUniformGrid2D(dst.data(), origin.x, origin.y, size.x, size.y, step, _seed);
 }
 
-void FastNoise2::get_noise_3d_grid(Vector3 origin, Vector3i size, Span<float> dst) const {
+void FastNoise2::get_noise_3d_grid(Vector3i origin, Vector3i size, float step, Span<float> dst) const {
 	ERR_FAIL_COND(!is_valid());
 	ERR_FAIL_COND(!math::is_valid_size(size));
 	ERR_FAIL_COND(dst.size() != size_t(size.x) * size_t(size.y) * size_t(size.z));
-	_generator->GenUniformGrid3D(dst.data(), origin.x, origin.y, origin.z, size.x, size.y, size.z, 1.f, _seed);
+	_generator->GenUniformGrid3D(dst.data(), origin.x, origin.y, origin.z, size.x, size.y, size.z, step, _seed);
 }
 
 void FastNoise2::get_noise_2d_grid_tileable(Vector2i size, Span<float> dst) const {
@@ -452,7 +453,7 @@ void FastNoise2::generate_image(Ref<Image> image, bool tileable) const {
 	if (tileable) {
 		get_noise_2d_grid_tileable(Vector2i(image->get_width(), image->get_height()), to_span(buffer));
 	} else {
-		get_noise_2d_grid(Vector2(), Vector2i(image->get_width(), image->get_height()), to_span(buffer));
+		get_noise_2d_grid(Vector2i(), Vector2i(image->get_width(), image->get_height()), 1.f, to_span(buffer));
 	}
 
 	unsigned int i = 0;
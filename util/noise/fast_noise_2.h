@@ -194,8 +194,10 @@ public:
 			Span<float> dst
 	) const;
 
-	void get_noise_2d_grid(Vector2 origin, Vector2i size, Span<float> dst) const;
-	void get_noise_3d_grid(Vector3 origin, Vector3i size, Span<float> dst) const;
+	// Generates noise at positions `(origin + cell) * step` of a uniform grid, ordered with X first, then Y, then Z.
+	// This is faster than generating series, and gives the same results as series with the same positions.
+	void get_noise_2d_grid(Vector2i origin, Vector2i size, float step, Span<float> dst) const;
+	void get_noise_3d_grid(Vector3i origin, Vector3i size, float step, Span<float> dst) const;
 
 	void get_noise_2d_grid_tileable(Vector2i size, Span<float> dst) const;
 
@@ -1,6 +1,7 @@
 #include "fast_noise_lite.h"
 #include "../../godot/core/array.h"
 #include "../../math/funcs.h"
+#include "fast_noise_lite_series.h"
 
 namespace zylann {
 
@@ -222,6 +223,36 @@ ZN_FastNoiseLite::RotationType3D ZN_FastNoiseLite::get_rotation_type_3d() const
 	return _rotation_type_3d;
 }
 
+void ZN_FastNoiseLite::get_noise_2d_series(Span<const float> src_x, Span<const float> src_y, Span<float> dst) const {
+	ZN_ASSERT_RETURN(src_x.size() == dst.size() && src_y.size() == dst.size());
+	// The vectorized path works with floats, so in double-precision builds it would not give the same results
+#ifndef REAL_T_IS_DOUBLE
+	if (_warp_noise.is_null() && try_get_fast_noise_lite_2d_series(_fn, src_x, src_y, dst)) {
+		return;
+	}
+#endif
+	for (unsigned int i = 0; i < dst.size(); ++i) {
+		dst[i] = get_noise_2d(src_x[i], src_y[i]);
+	}
+}
+
+void ZN_FastNoiseLite::get_noise_3d_series(
+		Span<const float> src_x,
+		Span<const float> src_y,
+		Span<const float> src_z,
+		Span<float> dst
+) const {
+	ZN_ASSERT_RETURN(src_x.size() == dst.size() && src_y.size() == dst.size() && src_z.size() == dst.size());
+#ifndef REAL_T_IS_DOUBLE
+	if (_warp_noise.is_null() && try_get_fast_noise_lite_3d_series(_fn, src_x, src_y, src_z, dst)) {
+		return;
+	}
+#endif
+	for (unsigned int i = 0; i < dst.size(); ++i) {
+		dst[i] = get_noise_3d(src_x[i], src_y[i], src_z[i]);
+	}
+}
+
 void ZN_FastNoiseLite::_on_warp_noise_changed() {
 	emit_changed();
 }
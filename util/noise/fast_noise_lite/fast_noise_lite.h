@@ -1,6 +1,7 @@
 #ifndef ZYLANN_FAST_NOISE_LITE_H
 #define ZYLANN_FAST_NOISE_LITE_H
 
+#include "../../containers/span.h"
 #include "fast_noise_lite_gradient.h"
 
 namespace zylann {
@@ -140,6 +141,15 @@ public:
 		return _fn.GetNoise(x, y, z);
 	}
 
+	// Same as calling `get_noise_*` for each position, but faster when many values are needed
+	void get_noise_2d_series(Span<const float> src_x, Span<const float> src_y, Span<float> dst) const;
+	void get_noise_3d_series(
+			Span<const float> src_x,
+			Span<const float> src_y,
+			Span<const float> src_z,
+			Span<float> dst
+	) const;
+
 	// TODO Have a separate cell noise? It outputs multiple things, but we only get one.
 	// To get the others the API forces to calculate it a second time, and it's the most expensive noise...
 
@@ -0,0 +1,789 @@
+#include "fast_noise_lite_series.h"
+#include "../../math/int4.h"
+#include "../../profiling.h"
+
+// Vectorized ports of the functions of `FastNoiseLite`. Operations are kept in the same order as the original so
+// results are identical. Branches are replaced by computing both sides and selecting results with masks.
+
+namespace zylann {
+
+using namespace math;
+
+namespace {
+
+typedef ::fast_noise_lite::FastNoiseLite FNL;
+
+// Same as `FastNoiseLite::FastFloor`, which also subtracts 1 from negative values that are already integers
+inline Int4 fast_floor(const Float4 f) {
+	return truncate_to_int4(f) + less_than(f, Float4(0.f));
+}
+
+inline Int4 fast_round(const Float4 f) {
+	return truncate_to_int4(f + select(greater_equal(f, Float4(0.f)), Float4(0.5f), Float4(-0.5f)));
+}
+
+inline Float4 interp_hermite(const Float4 t) {
+	return t * t * (Float4(3.f) - Float4(2.f) * t);
+}
+
+inline Float4 interp_quintic(const Float4 t) {
+	return t * t * t * (t * (t * Float4(6.f) - Float4(15.f)) + Float4(10.f));
+}
+
+inline Float4 ping_pong(Float4 t) {
+	t = t - to_float4(truncate_to_int4(t * Float4(0.5f)) * Int4(2));
+	return select(less_than(t, Float4(1.f)), t, Float4(2.f) - t);
+}
+
+inline Int4 hash(const int seed, const Int4 x_primed, const Int4 y_primed) {
+	return (Int4(seed) ^ x_primed ^ y_primed) * Int4(0x27d4eb2d);
+}
+
+inline Int4 hash(const int seed, const Int4 x_primed, const Int4 y_primed, const Int4 z_primed) {
+	return (Int4(seed) ^ x_primed ^ y_primed ^ z_primed) * Int4(0x27d4eb2d);
+}
+
+inline Float4 val_coord(const int seed, const Int4 x_primed, const Int4 y_primed) {
+	Int4 h = hash(seed, x_primed, y_primed);
+	h = h * h;
+	h = h ^ (h << 19);
+	return to_float4(h) * Float4(1 / 2147483648.0f);
+}
+
+inline Float4 val_coord(const int seed, const Int4 x_primed, const Int4 y_primed, const Int4 z_primed) {
+	Int4 h = hash(seed, x_primed, y_primed, z_primed);
+	h = h * h;
+	h = h ^ (h << 19);
+	return to_float4(h) * Float4(1 / 2147483648.0f);
+}
+
+// Lookup tables are indexed per lane. SSE2 has no gather instruction, but vectors in tables are stored contiguously, so
+// each lane can load a whole vector, and results are transposed into one Float4 per component.
+
+// `table` contains 2D vectors, `indices` must be multiples of 2
+inline void gather_2(const float *table, const Int4 indices, Float4 &out_x, Float4 &out_y) {
+	int32_t i[Int4::SIZE];
+	indices.store(i);
+#ifdef ZN_SIMD_SSE2
+	__m128 v01 = _mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64 *>(table + i[0]));
+	v01 = _mm_loadh_pi(v01, reinterpret_cast<const __m64 *>(table + i[1]));
+	__m128 v23 = _mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64 *>(table + i[2]));
+	v23 = _mm_loadh_pi(v23, reinterpret_cast<const __m64 *>(table + i[3]));
+	out_x = Float4(_mm_shuffle_ps(v01, v23, _MM_SHUFFLE(2, 0, 2, 0)));
+	out_y = Float4(_mm_shuffle_ps(v01, v23, _MM_SHUFFLE(3, 1, 3, 1)));
+#else
+	const float x[Float4::SIZE] = { table[i[0]], table[i[1]], table[i[2]], table[i[3]] };
+	const float y[Float4::SIZE] = { table[i[0] | 1], table[i[1] | 1], table[i[2] | 1], table[i[3] | 1] };
+	out_x = Float4::load(x);
+	out_y = Float4::load(y);
+#endif
+}
+
+// `table` contains 3D vectors padded to 4 components, `indices` must be multiples of 4
+inline void gather_3(const float *table, const Int4 indices, Float4 &out_x, Float4 &out_y, Float4 &out_z) {
+	int32_t i[Int4::SIZE];
+	indices.store(i);
+#ifdef ZN_SIMD_SSE2
+	__m128 v0 = _mm_loadu_ps(table + i[0]);
+	__m128 v1 = _mm_loadu_ps(table + i[1]);
+	__m128 v2 = _mm_loadu_ps(table + i[2]);
+	__m128 v3 = _mm_loadu_ps(table + i[3]);
+	_MM_TRANSPOSE4_PS(v0, v1, v2, v3);
+	out_x = Float4(v0);
+	out_y = Float4(v1);
+	out_z = Float4(v2);
+#else
+	const float x[Float4::SIZE] = { table[i[0]], table[i[1]], table[i[2]], table[i[3]] };
+	const float y[Float4::SIZE] = { table[i[0] | 1], table[i[1] | 1], table[i[2] | 1], table[i[3] | 1] };
+	const float z[Float4::SIZE] = { table[i[0] | 2], table[i[1] | 2], table[i[2] | 2], table[i[3] | 2] };
+	out_x = Float4::load(x);
+	out_y = Float4::load(y);
+	out_z = Float4::load(z);
+#endif
+}
+
+inline Float4 grad_coord(const int seed, const Int4 x_primed, const Int4 y_primed, const Float4 xd, const Float4 yd) {
+	Int4 h = hash(seed, x_primed, y_primed);
+	h = h ^ (h >> 15);
+	h = h & Int4(127 << 1);
+	Float4 xg;
+	Float4 yg;
+	gather_2(FNL::Lookup<float>::Gradients2D, h, xg, yg);
+	return xd * xg + yd * yg;
+}
+
+inline Float4 grad_coord(
+		const int seed,
+		const Int4 x_primed,
+		const Int4 y_primed,
+		const Int4 z_primed,
+		const Float4 xd,
+		const Float4 yd,
+		const Float4 zd
+) {
+	Int4 h = hash(seed, x_primed, y_primed, z_primed);
+	h = h ^ (h >> 15);
+	h = h & Int4(63 << 2);
+	Float4 xg;
+	Float4 yg;
+	Float4 zg;
+	gather_3(FNL::Lookup<float>::Gradients3D, h, xg, yg, zg);
+	return xd * xg + yd * yg + zd * zg;
+}
+
+// Single noises
+
+Float4 single_simplex(const FNL &fn, const int seed, const Float4 x, const Float4 y) {
+	const float SQRT3 = 1.7320508075688772935274463415059f;
+	const float G2 = (3 - SQRT3) / 6;
+
+	Int4 i = fast_floor(x);
+	Int4 j = fast_floor(y);
+	const Float4 xi = x - to_float4(i);
+	const Float4 yi = y - to_float4(j);
+
+	const Float4 t = (xi + yi) * Float4(G2);
+	const Float4 x0 = xi - t;
+	const Float4 y0 = yi - t;
+
+	i = i * Int4(FNL::PrimeX);
+	j = j * Int4(FNL::PrimeY);
+
+	const Float4 zero(0.f);
+
+	const Float4 a = Float4(0.5f) - x0 * x0 - y0 * y0;
+	const Float4 n0 = select(less_equal(a, zero), zero, (a * a) * (a * a) * grad_coord(seed, i, j, x0, y0));
+
+	const Float4 c = Float4((float)(2 * (1 - 2 * G2) * (1 / G2 - 2))) * t +
+			(Float4((float)(-2 * (1 - 2 * G2) * (1 - 2 * G2))) + a);
+	const Float4 x2 = x0 + Float4(2 * (float)G2 - 1);
+	const Float4 y2 = y0 + Float4(2 * (float)G2 - 1);
+	const Float4 n2 = select(
+			less_equal(c, zero),
+			zero,
+			(c * c) * (c * c) * grad_coord(seed, i + Int4(FNL::PrimeX), j + Int4(FNL::PrimeY), x2, y2)
+	);
+
+	const Int4 y_greater = greater_than(y0, x0);
+	const Float4 x1 = x0 + select(y_greater, Float4((float)G2), Float4((float)G2 - 1));
+	const Float4 y1 = y0 + select(y_greater, Float4((float)G2 - 1), Float4((float)G2));
+	const Int4 i1 = i + select(y_greater, Int4(0), Int4(FNL::PrimeX));
+	const Int4 j1 = j + select(y_greater, Int4(FNL::PrimeY), Int4(0));
+	const Float4 b = Float4(0.5f) - x1 * x1 - y1 * y1;
+	const Float4 n1 = select(less_equal(b, zero), zero, (b * b) * (b * b) * grad_coord(seed, i1, j1, x1, y1));
+
+	return (n0 + n1 + n2) * Float4(99.83685446303647f);
+}
+
+Float4 single_open_simplex_2(const FNL &fn, int seed, const Float4 x, const Float4 y, const Float4 z) {
+	Int4 i = fast_round(x);
+	Int4 j = fast_round(y);
+	Int4 k = fast_round(z);
+	Float4 x0 = x - to_float4(i);
+	Float4 y0 = y - to_float4(j);
+	Float4 z0 = z - to_float4(k);
+
+	Int4 x_nsign = truncate_to_int4(Float4(-1.f) - x0) | Int4(1);
+	Int4 y_nsign = truncate_to_int4(Float4(-1.f) - y0) | Int4(1);
+	Int4 z_nsign = truncate_to_int4(Float4(-1.f) - z0) | Int4(1);
+
+	Float4 ax0 = to_float4(x_nsign) * -x0;
+	Float4 ay0 = to_float4(y_nsign) * -y0;
+	Float4 az0 = to_float4(z_nsign) * -z0;
+
+	i = i * Int4(FNL::PrimeX);
+	j = j * Int4(FNL::PrimeY);
+	k = k * Int4(FNL::PrimeZ);
+
+	const Float4 zero(0.f);
+
+	Float4 value(0.f);
+	Float4 a = (Float4(0.6f) - x0 * x0) - (y0 * y0 + z0 * z0);
+
+	for (int l = 0;; l++) {
+		value = value +
+				select(greater_than(a, zero), (a * a) * (a * a) * grad_coord(seed, i, j, k, x0, y0, z0), zero);
+
+		const Float4 fx_nsign = to_float4(x_nsign);
+		const Float4 fy_nsign = to_float4(y_nsign);
+		const Float4 fz_nsign = to_float4(z_nsign);
+
+		const Int4 along_x = greater_equal(ax0, ay0) & greater_equal(ax0, az0);
+		const Int4 along_y = select(along_x, Int4(0), greater_than(ay0, ax0) & greater_equal(ay0, az0));
+		const Int4 along_z = select(along_x | along_y, Int4(0), Int4(-1));
+
+		const Float4 x1 = select(along_x, x0 + fx_nsign, x0);
+		const Float4 y1 = select(along_y, y0 + fy_nsign, y0);
+		const Float4 z1 = select(along_z, z0 + fz_nsign, z0);
+
+		Float4 b = a + Float4(1.f);
+		b = select(
+				along_x,
+				b - fx_nsign * Float4(2.f) * x1,
+				select(along_y, b - fy_nsign * Float4(2.f) * y1, b - fz_nsign * Float4(2.f) * z1)
+		);
+
+		const Int4 i1 = select(along_x, i - x_nsign * Int4(FNL::PrimeX), i);
+		const Int4 j1 = select(along_y, j - y_nsign * Int4(FNL::PrimeY), j);
+		const Int4 k1 = select(along_z, k - z_nsign * Int4(FNL::PrimeZ), k);
+
+		value = value +
+				select(greater_than(b, zero), (b * b) * (b * b) * grad_coord(seed, i1, j1, k1, x1, y1, z1), zero);
+
+		if (l == 1) {
+			break;
+		}
+
+		ax0 = Float4(0.5f) - ax0;
+		ay0 = Float4(0.5f) - ay0;
+		az0 = Float4(0.5f) - az0;
+
+		x0 = fx_nsign * ax0;
+		y0 = fy_nsign * ay0;
+		z0 = fz_nsign * az0;
+
+		a = a + ((Float4(0.75f) - ax0) - (ay0 + az0));
+
+		i = i + ((x_nsign >> 1) & Int4(FNL::PrimeX));
+		j = j + ((y_nsign >> 1) & Int4(FNL::PrimeY));
+		k = k + ((z_nsign >> 1) & Int4(FNL::PrimeZ));
+
+		x_nsign = Int4(0) - x_nsign;
+		y_nsign = Int4(0) - y_nsign;
+		z_nsign = Int4(0) - z_nsign;
+
+		seed = ~seed;
+	}
+
+	return value * Float4(32.69428253173828125f);
+}
+
+inline Float4 get_cellular_distance(const FNL &fn, const Float4 vec_x, const Float4 vec_y) {
+	switch (fn.mCellularDistanceFunction) {
+		case FNL::CellularDistanceFunction_Manhattan:
+			return abs(vec_x) + abs(vec_y);
+		case FNL::CellularDistanceFunction_Hybrid:
+			return (abs(vec_x) + abs(vec_y)) + (vec_x * vec_x + vec_y * vec_y);
+		default:
+			return vec_x * vec_x + vec_y * vec_y;
+	}
+}
+
+inline Float4 get_cellular_distance(const FNL &fn, const Float4 vec_x, const Float4 vec_y, const Float4 vec_z) {
+	switch (fn.mCellularDistanceFunction) {
+		case FNL::CellularDistanceFunction_Manhattan:
+			return abs(vec_x) + abs(vec_y) + abs(vec_z);
+		case FNL::CellularDistanceFunction_Hybrid:
+			return (abs(vec_x) + abs(vec_y) + abs(vec_z)) + (vec_x * vec_x + vec_y * vec_y + vec_z * vec_z);
+		default:
+			return vec_x * vec_x + vec_y * vec_y + vec_z * vec_z;
+	}
+}
+
+Float4 get_cellular_result(const FNL &fn, Float4 distance0, Float4 distance1, const Int4 closest_hash) {
+	if (fn.mCellularDistanceFunction == FNL::CellularDistanceFunction_Euclidean &&
+		fn.mCellularReturnType >= FNL::CellularReturnType_Distance) {
+		distance0 = sqrt(distance0);
+
+		if (fn.mCellularReturnType >= FNL::CellularReturnType_Distance2) {
+			distance1 = sqrt(distance1);
+		}
+	}
+
+	const Float4 one(1.f);
+
+	switch (fn.mCellularReturnType) {
+		case FNL::CellularReturnType_CellValue:
+			return to_float4(closest_hash) * Float4(1 / 2147483648.0f);
+		case FNL::CellularReturnType_Distance:
+			return distance0 - one;
+		case FNL::CellularReturnType_Distance2:
+			return distance1 - one;
+		case FNL::CellularReturnType_Distance2Add:
+			return (distance1 + distance0) * Float4(0.5f) - one;
+		case FNL::CellularReturnType_Distance2Sub:
+			return distance1 - distance0 - one;
+		case FNL::CellularReturnType_Distance2Mul:
+			return distance1 * distance0 * Float4(0.5f) - one;
+		case FNL::CellularReturnType_Distance2Div:
+			return distance0 / distance1 - one;
+		default:
+			return Float4(0.f);
+	}
+}
+
+Float4 single_cellular(const FNL &fn, const int seed, const Float4 x, const Float4 y) {
+	const Int4 xr = fast_round(x);
+	const Int4 yr = fast_round(y);
+
+	Float4 distance0(1e10f);
+	Float4 distance1(1e10f);
+	Int4 closest_hash(0);
+
+	const Float4 cellular_jitter(0.43701595f * fn.mCellularJitterModifier);
+
+	Int4 x_primed = (xr - Int4(1)) * Int4(FNL::PrimeX);
+	const Int4 y_primed_base = (yr - Int4(1)) * Int4(FNL::PrimeY);
+
+	for (int xo = -1; xo <= 1; ++xo) {
+		const Float4 xi = to_float4(xr + Int4(xo));
+		Int4 y_primed = y_primed_base;
+
+		for (int yo = -1; yo <= 1; ++yo) {
+			const Float4 yi = to_float4(yr + Int4(yo));
+
+			const Int4 h = hash(seed, x_primed, y_primed);
+			Float4 rx;
+			Float4 ry;
+			gather_2(FNL::Lookup<float>::RandVecs2D, h & Int4(255 << 1), rx, ry);
+
+			const Float4 vec_x = (xi - x) + rx * cellular_jitter;
+			const Float4 vec_y = (yi - y) + ry * cellular_jitter;
+
+			const Float4 new_distance = get_cellular_distance(fn, vec_x, vec_y);
+
+			distance1 = max(min(distance1, new_distance), distance0);
+			const Int4 closer = less_than(new_distance, distance0);
+			distance0 = select(closer, new_distance, distance0);
+			closest_hash = select(closer, h, closest_hash);
+
+			y_primed = y_primed + Int4(FNL::PrimeY);
+		}
+		x_primed = x_primed + Int4(FNL::PrimeX);
+	}
+
+	return get_cellular_result(fn, distance0, distance1, closest_hash);
+}
+
+Float4 single_cellular(const FNL &fn, const int seed, const Float4 x, const Float4 y, const Float4 z) {
+	const Int4 xr = fast_round(x);
+	const Int4 yr = fast_round(y);
+	const Int4 zr = fast_round(z);
+
+	Float4 distance0(1e10f);
+	Float4 distance1(1e10f);
+	Int4 closest_hash(0);
+
+	const Float4 cellular_jitter(0.39614353f * fn.mCellularJitterModifier);
+
+	Int4 x_primed = (xr - Int4(1)) * Int4(FNL::PrimeX);
+	const Int4 y_primed_base = (yr - Int4(1)) * Int4(FNL::PrimeY);
+	const Int4 z_primed_base = (zr - Int4(1)) * Int4(FNL::PrimeZ);
+
+	for (int xo = -1; xo <= 1; ++xo) {
+		const Float4 xi = to_float4(xr + Int4(xo));
+		Int4 y_primed = y_primed_base;
+
+		for (int yo = -1; yo <= 1; ++yo) {
+			const Float4 yi = to_float4(yr + Int4(yo));
+			Int4 z_primed = z_primed_base;
+
+			for (int zo = -1; zo <= 1; ++zo) {
+				const Float4 zi = to_float4(zr + Int4(zo));
+
+				const Int4 h = hash(seed, x_primed, y_primed, z_primed);
+				Float4 rx;
+				Float4 ry;
+				Float4 rz;
+				gather_3(FNL::Lookup<float>::RandVecs3D, h & Int4(255 << 2), rx, ry, rz);
+
+				const Float4 vec_x = (xi - x) + rx * cellular_jitter;
+				const Float4 vec_y = (yi - y) + ry * cellular_jitter;
+				const Float4 vec_z = (zi - z) + rz * cellular_jitter;
+
+				const Float4 new_distance = get_cellular_distance(fn, vec_x, vec_y, vec_z);
+
+				distance1 = max(min(distance1, new_distance), distance0);
+				const Int4 closer = less_than(new_distance, distance0);
+				distance0 = select(closer, new_distance, distance0);
+				closest_hash = select(closer, h, closest_hash);
+
+				z_primed = z_primed + Int4(FNL::PrimeZ);
+			}
+			y_primed = y_primed + Int4(FNL::PrimeY);
+		}
+		x_primed = x_primed + Int4(FNL::PrimeX);
+	}
+
+	return get_cellular_result(fn, distance0, distance1, closest_hash);
+}
+
+Float4 single_perlin(const FNL &fn, const int seed, const Float4 x, const Float4 y) {
+	Int4 x0 = fast_floor(x);
+	Int4 y0 = fast_floor(y);
+
+	const Float4 xd0 = x - to_float4(x0);
+	const Float4 yd0 = y - to_float4(y0);
+	const Float4 xd1 = xd0 - Float4(1.f);
+	const Float4 yd1 = yd0 - Float4(1.f);
+
+	const Float4 xs = interp_quintic(xd0);
+	const Float4 ys = interp_quintic(yd0);
+
+	x0 = x0 * Int4(FNL::PrimeX);
+	y0 = y0 * Int4(FNL::PrimeY);
+	const Int4 x1 = x0 + Int4(FNL::PrimeX);
+	const Int4 y1 = y0 + Int4(FNL::PrimeY);
+
+	const Float4 xf0 = lerp(grad_coord(seed, x0, y0, xd0, yd0), grad_coord(seed, x1, y0, xd1, yd0), xs);
+	const Float4 xf1 = lerp(grad_coord(seed, x0, y1, xd0, yd1), grad_coord(seed, x1, y1, xd1, yd1), xs);
+
+	return lerp(xf0, xf1, ys) * Float4(1.4247691104677813f);
+}
+
+Float4 single_perlin(const FNL &fn, const int seed, const Float4 x, const Float4 y, const Float4 z) {
+	Int4 x0 = fast_floor(x);
+	Int4 y0 = fast_floor(y);
+	Int4 z0 = fast_floor(z);
+
+	const Float4 xd0 = x - to_float4(x0);
+	const Float4 yd0 = y - to_float4(y0);
+	const Float4 zd0 = z - to_float4(z0);
+	const Float4 xd1 = xd0 - Float4(1.f);
+	const Float4 yd1 = yd0 - Float4(1.f);
+	const Float4 zd1 = zd0 - Float4(1.f);
+
+	const Float4 xs = interp_quintic(xd0);
+	const Float4 ys = interp_quintic(yd0);
+	const Float4 zs = interp_quintic(zd0);
+
+	x0 = x0 * Int4(FNL::PrimeX);
+	y0 = y0 * Int4(FNL::PrimeY);
+	z0 = z0 * Int4(FNL::PrimeZ);
+	const Int4 x1 = x0 + Int4(FNL::PrimeX);
+	const Int4 y1 = y0 + Int4(FNL::PrimeY);
+	const Int4 z1 = z0 + Int4(FNL::PrimeZ);
+
+	const Float4 xf00 =
+			lerp(grad_coord(seed, x0, y0, z0, xd0, yd0, zd0), grad_coord(seed, x1, y0, z0, xd1, yd0, zd0), xs);
+	const Float4 xf10 =
+			lerp(grad_coord(seed, x0, y1, z0, xd0, yd1, zd0), grad_coord(seed, x1, y1, z0, xd1, yd1, zd0), xs);
+	const Float4 xf01 =
+			lerp(grad_coord(seed, x0, y0, z1, xd0, yd0, zd1), grad_coord(seed, x1, y0, z1, xd1, yd0, zd1), xs);
+	const Float4 xf11 =
+			lerp(grad_coord(seed, x0, y1, z1, xd0, yd1, zd1), grad_coord(seed, x1, y1, z1, xd1, yd1, zd1), xs);
+
+	const Float4 yf0 = lerp(xf00, xf10, ys);
+	const Float4 yf1 = lerp(xf01, xf11, ys);
+
+	return lerp(yf0, yf1, zs) * Float4(0.964921414852142333984375f);
+}
+
+Float4 single_value(const FNL &fn, const int seed, const Float4 x, const Float4 y) {
+	Int4 x0 = fast_floor(x);
+	Int4 y0 = fast_floor(y);
+
+	const Float4 xs = interp_hermite(x - to_float4(x0));
+	const Float4 ys = interp_hermite(y - to_float4(y0));
+
+	x0 = x0 * Int4(FNL::PrimeX);
+	y0 = y0 * Int4(FNL::PrimeY);
+	const Int4 x1 = x0 + Int4(FNL::PrimeX);
+	const Int4 y1 = y0 + Int4(FNL::PrimeY);
+
+	const Float4 xf0 = lerp(val_coord(seed, x0, y0), val_coord(seed, x1, y0), xs);
+	const Float4 xf1 = lerp(val_coord(seed, x0, y1), val_coord(seed, x1, y1), xs);
+
+	return lerp(xf0, xf1, ys);
+}
+
+Float4 single_value(const FNL &fn, const int seed, const Float4 x, const Float4 y, const Float4 z) {
+	Int4 x0 = fast_floor(x);
+	Int4 y0 = fast_floor(y);
+	Int4 z0 = fast_floor(z);
+
+	const Float4 xs = interp_hermite(x - to_float4(x0));
+	const Float4 ys = interp_hermite(y - to_float4(y0));
+	const Float4 zs = interp_hermite(z - to_float4(z0));
+
+	x0 = x0 * Int4(FNL::PrimeX);
+	y0 = y0 * Int4(FNL::PrimeY);
+	z0 = z0 * Int4(FNL::PrimeZ);
+	const Int4 x1 = x0 + Int4(FNL::PrimeX);
+	const Int4 y1 = y0 + Int4(FNL::PrimeY);
+	const Int4 z1 = z0 + Int4(FNL::PrimeZ);
+
+	const Float4 xf00 = lerp(val_coord(seed, x0, y0, z0), val_coord(seed, x1, y0, z0), xs);
+	const Float4 xf10 = lerp(val_coord(seed, x0, y1, z0), val_coord(seed, x1, y1, z0), xs);
+	const Float4 xf01 = lerp(val_coord(seed, x0, y0, z1), val_coord(seed, x1, y0, z1), xs);
+	const Float4 xf11 = lerp(val_coord(seed, x0, y1, z1), val_coord(seed, x1, y1, z1), xs);
+
+	const Float4 yf0 = lerp(xf00, xf10, ys);
+	const Float4 yf1 = lerp(xf01, xf11, ys);
+
+	return lerp(yf0, yf1, zs);
+}
+
+// Coordinate transforms
+
+void transform_noise_coordinate(const FNL &fn, Float4 &x, Float4 &y) {
+	const Float4 frequency(fn.mFrequency);
+	x = x * frequency;
+	y = y * frequency;
+
+	switch (fn.mNoiseType) {
+		case FNL::NoiseType_OpenSimplex2:
+		case FNL::NoiseType_OpenSimplex2S: {
+			const float SQRT3 = 1.7320508075688772935274463415059f;
+			const float F2 = 0.5f * (SQRT3 - 1);
+			const Float4 t = (x + y) * Float4(F2);
+			x = x + t;
+			y = y + t;
+		} break;
+		default:
+			break;
+	}
+}
+
+void transform_noise_coordinate(const FNL &fn, Float4 &x, Float4 &y, Float4 &z) {
+	const Float4 frequency(fn.mFrequency);
+	x = x * frequency;
+	y = y * frequency;
+	z = z * frequency;
+
+	switch (fn.mTransformType3D) {
+		case FNL::TransformType3D_ImproveXYPlanes: {
+			const Float4 xy = x + y;
+			const Float4 s2 = xy * Float4(-0.211324865405187f);
+			z = z * Float4(0.577350269189626f);
+			x = x + (s2 - z);
+			y = y + s2 - z;
+			z = z + xy * Float4(0.577350269189626f);
+		} break;
+		case FNL::TransformType3D_ImproveXZPlanes: {
+			const Float4 xz = x + z;
+			const Float4 s2 = xz * Float4(-0.211324865405187f);
+			y = y * Float4(0.577350269189626f);
+			x = x + (s2 - y);
+			z = z + (s2 - y);
+			y = y + xz * Float4(0.577350269189626f);
+		} break;
+		case FNL::TransformType3D_DefaultOpenSimplex2: {
+			const Float4 r = (x + y + z) * Float4((float)(2.0 / 3.0));
+			x = r - x;
+			y = r - y;
+			z = r - z;
+		} break;
+		default:
+			break;
+	}
+}
+
+// Fractals. The single noise function is a template parameter so it can be inlined in the octave loop.
+
+typedef Float4 (*SingleNoise2DFunc)(const FNL &, int, Float4, Float4);
+typedef Float4 (*SingleNoise3DFunc)(const FNL &, int, Float4, Float4, Float4);
+
+template <SingleNoise2DFunc single>
+Float4 get_noise(const FNL &fn, Float4 x, Float4 y) {
+	transform_noise_coordinate(fn, x, y);
+
+	if (fn.mFractalType != FNL::FractalType_FBm && fn.mFractalType != FNL::FractalType_Ridged &&
+		fn.mFractalType != FNL::FractalType_PingPong) {
+		return single(fn, fn.mSeed, x, y);
+	}
+
+	int seed = fn.mSeed;
+	Float4 sum(0.f);
+	Float4 amp(fn.mFractalBounding);
+	const Float4 one(1.f);
+	const Float4 weighted_strength(fn.mWeightedStrength);
+
+	for (int i = 0; i < fn.mOctaves; i++) {
+		switch (fn.mFractalType) {
+			case FNL::FractalType_FBm: {
+				const Float4 noise = single(fn, seed++, x, y);
+				sum = sum + noise * amp;
+				amp = amp * lerp(one, min(noise + one, Float4(2.f)) * Float4(0.5f), weighted_strength);
+			} break;
+			case FNL::FractalType_Ridged: {
+				const Float4 noise = abs(single(fn, seed++, x, y));
+				sum = sum + (noise * Float4(-2.f) + one) * amp;
+				amp = amp * lerp(one, one - noise, weighted_strength);
+			} break;
+			default: {
+				const Float4 noise = ping_pong((single(fn, seed++, x, y) + one) * Float4(fn.mPingPongStrength));
+				sum = sum + (noise - Float4(0.5f)) * Float4(2.f) * amp;
+				amp = amp * lerp(one, noise, weighted_strength);
+			} break;
+		}
+
+		x = x * Float4(fn.mLacunarity);
+		y = y * Float4(fn.mLacunarity);
+		amp = amp * Float4(fn.mGain);
+	}
+
+	return sum;
+}
+
+template <SingleNoise3DFunc single>
+Float4 get_noise(const FNL &fn, Float4 x, Float4 y, Float4 z) {
+	transform_noise_coordinate(fn, x, y, z);
+
+	if (fn.mFractalType != FNL::FractalType_FBm && fn.mFractalType != FNL::FractalType_Ridged &&
+		fn.mFractalType != FNL::FractalType_PingPong) {
+		return single(fn, fn.mSeed, x, y, z);
+	}
+
+	int seed = fn.mSeed;
+	Float4 sum(0.f);
+	Float4 amp(fn.mFractalBounding);
+	const Float4 one(1.f);
+	const Float4 weighted_strength(fn.mWeightedStrength);
+
+	for (int i = 0; i < fn.mOctaves; i++) {
+		switch (fn.mFractalType) {
+			case FNL::FractalType_FBm: {
+				// Unlike 2D, the original doesn't clamp the noise here
+				const Float4 noise = single(fn, seed++, x, y, z);
+				sum = sum + noise * amp;
+				amp = amp * lerp(one, (noise + one) * Float4(0.5f), weighted_strength);
+			} break;
+			case FNL::FractalType_Ridged: {
+				const Float4 noise = abs(single(fn, seed++, x, y, z));
+				sum = sum + (noise * Float4(-2.f) + one) * amp;
+				amp = amp * lerp(one, one - noise, weighted_strength);
+			} break;
+			default: {
+				const Float4 noise = ping_pong((single(fn, seed++, x, y, z) + one) * Float4(fn.mPingPongStrength));
+				sum = sum + (noise - Float4(0.5f)) * Float4(2.f) * amp;
+				amp = amp * lerp(one, noise, weighted_strength);
+			} break;
+		}
+
+		x = x * Float4(fn.mLacunarity);
+		y = y * Float4(fn.mLacunarity);
+		z = z * Float4(fn.mLacunarity);
+		amp = amp * Float4(fn.mGain);
+	}
+
+	return sum;
+}
+
+// Series
+
+template <SingleNoise2DFunc single>
+void get_noise_series(const FNL &fn, Span<const float> src_x, Span<const float> src_y, Span<float> dst) {
+	const unsigned int count = dst.size();
+	const unsigned int vector_count = count - count % Float4::SIZE;
+
+	unsigned int i = 0;
+	for (; i < vector_count; i += Float4::SIZE) {
+		const Float4 x = Float4::load(src_x.data() + i);
+		const Float4 y = Float4::load(src_y.data() + i);
+		get_noise<single>(fn, x, y).store(dst.data() + i);
+	}
+
+	if (i < count) {
+		// Remaining values are padded into a full vector
+		float x[Float4::SIZE] = { 0.f };
+		float y[Float4::SIZE] = { 0.f };
+		float n[Float4::SIZE];
+		for (unsigned int j = 0; i + j < count; ++j) {
+			x[j] = src_x[i + j];
+			y[j] = src_y[i + j];
+		}
+		get_noise<single>(fn, Float4::load(x), Float4::load(y)).store(n);
+		for (unsigned int j = 0; i + j < count; ++j) {
+			dst[i + j] = n[j];
+		}
+	}
+}
+
+template <SingleNoise3DFunc single>
+void get_noise_series(
+		const FNL &fn,
+		Span<const float> src_x,
+		Span<const float> src_y,
+		Span<const float> src_z,
+		Span<float> dst
+) {
+	const unsigned int count = dst.size();
+	const unsigned int vector_count = count - count % Float4::SIZE;
+
+	unsigned int i = 0;
+	for (; i < vector_count; i += Float4::SIZE) {
+		const Float4 x = Float4::load(src_x.data() + i);
+		const Float4 y = Float4::load(src_y.data() + i);
+		const Float4 z = Float4::load(src_z.data() + i);
+		get_noise<single>(fn, x, y, z).store(dst.data() + i);
+	}
+
+	if (i < count) {
+		float x[Float4::SIZE] = { 0.f };
+		float y[Float4::SIZE] = { 0.f };
+		float z[Float4::SIZE] = { 0.f };
+		float n[Float4::SIZE];
+		for (unsigned int j = 0; i + j < count; ++j) {
+			x[j] = src_x[i + j];
+			y[j] = src_y[i + j];
+			z[j] = src_z[i + j];
+		}
+		get_noise<single>(fn, Float4::load(x), Float4::load(y), Float4::load(z)).store(n);
+		for (unsigned int j = 0; i + j < count; ++j) {
+			dst[i + j] = n[j];
+		}
+	}
+}
+
+} // namespace
+
+bool try_get_fast_noise_lite_2d_series(
+		const FNL &fn,
+		Span<const float> src_x,
+		Span<const float> src_y,
+		Span<float> dst
+) {
+	ZN_PROFILE_SCOPE();
+	ZN_ASSERT_RETURN_V(src_x.size() == dst.size() && src_y.size() == dst.size(), false);
+
+	switch (fn.mNoiseType) {
+		case FNL::NoiseType_OpenSimplex2:
+			get_noise_series<single_simplex>(fn, src_x, src_y, dst);
+			return true;
+		case FNL::NoiseType_Cellular:
+			get_noise_series<single_cellular>(fn, src_x, src_y, dst);
+			return true;
+		case FNL::NoiseType_Perlin:
+			get_noise_series<single_perlin>(fn, src_x, src_y, dst);
+			return true;
+		case FNL::NoiseType_Value:
+			get_noise_series<single_value>(fn, src_x, src_y, dst);
+			return true;
+		default:
+			// OpenSimplex2S and ValueCubic
+			return false;
+	}
+}
+
+bool try_get_fast_noise_lite_3d_series(
+		const FNL &fn,
+		Span<const float> src_x,
+		Span<const float> src_y,
+		Span<const float> src_z,
+		Span<float> dst
+) {
+	ZN_PROFILE_SCOPE();
+	ZN_ASSERT_RETURN_V(
+			src_x.size() == dst.size() && src_y.size() == dst.size() && src_z.size() == dst.size(), false
+	);
+
+	switch (fn.mNoiseType) {
+		case FNL::NoiseType_OpenSimplex2:
+			get_noise_series<single_open_simplex_2>(fn, src_x, src_y, src_z, dst);
+			return true;
+		case FNL::NoiseType_Cellular:
+			get_noise_series<single_cellular>(fn, src_x, src_y, src_z, dst);
+			return true;
+		case FNL::NoiseType_Perlin:
+			get_noise_series<single_perlin>(fn, src_x, src_y, src_z, dst);
+			return true;
+		case FNL::NoiseType_Value:
+			get_noise_series<single_value>(fn, src_x, src_y, src_z, dst);
+			return true;
+		default:
+			return false;
+	}
+}
+
+} // namespace zylann
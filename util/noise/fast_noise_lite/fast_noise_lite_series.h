@@ -0,0 +1,31 @@
+#ifndef ZN_FAST_NOISE_LITE_SERIES_H
+#define ZN_FAST_NOISE_LITE_SERIES_H
+
+#include "../../../thirdparty/fast_noise/FastNoiseLite.h"
+#include "../../containers/span.h"
+
+namespace zylann {
+
+// Batched equivalents of `FastNoiseLite::GetNoise`, computing 4 values at a time with SIMD. They produce the same
+// results as the scalar implementation, so they can be used with noise that has to stay deterministic.
+// Supported noise types are OpenSimplex2, Cellular, Perlin and Value, with any fractal type.
+// Returns false if the settings of `fn` are not supported, in which case nothing is written to `dst`.
+
+bool try_get_fast_noise_lite_2d_series(
+		const ::fast_noise_lite::FastNoiseLite &fn,
+		Span<const float> src_x,
+		Span<const float> src_y,
+		Span<float> dst
+);
+
+bool try_get_fast_noise_lite_3d_series(
+		const ::fast_noise_lite::FastNoiseLite &fn,
+		Span<const float> src_x,
+		Span<const float> src_y,
+		Span<const float> src_z,
+		Span<float> dst
+);
+
+} // namespace zylann
+
+#endif // ZN_FAST_NOISE_LITE_SERIES_H
@@ -17,17 +17,35 @@
 
 #else
 
-#define ZN_PROFILE_SCOPE()
+// Built-in recorder, disabled by default but can be turned on at runtime.
+// See `trace_recorder.h`.
+
+#include "macros.h"
+#include "trace_recorder.h"
+
+// Not defining `ZN_PROFILER_ENABLED`, which is reserved to code that should only run with Tracy
+#define ZN_PROFILER_TRACE_RECORDER
+
+#define ZN_PROFILE_SCOPE() zylann::trace_recorder::Scope ZN_CONCAT(zn_profile_scope_, __LINE__)(__FUNCTION__)
 // Name must be static const char* (usually string litteral)
-#define ZN_PROFILE_SCOPE_NAMED(name)
-#define ZN_PROFILE_MARK_FRAME()
-#define ZN_PROFILE_PLOT(name, number)
-#define ZN_PROFILE_MESSAGE(message)
-// Name must be const char*. An internal copy will be made so it can be temporary.
-// Size does not include the terminating character.
+#define ZN_PROFILE_SCOPE_NAMED(name) zylann::trace_recorder::Scope ZN_CONCAT(zn_profile_scope_, __LINE__)(name)
+#define ZN_PROFILE_MARK_FRAME() zylann::trace_recorder::record_now(zylann::trace_recorder::EVENT_FRAME, "Frame", 0)
+// Name must be static const char* (usually string litteral)
+// The number is not evaluated when recording is off.
+#define ZN_PROFILE_PLOT(name, number)                                                                                  \
+	do {                                                                                                               \
+		if (zylann::trace_recorder::is_enabled()) {                                                                    \
+			zylann::trace_recorder::record_now(                                                                        \
+					zylann::trace_recorder::EVENT_PLOT, name, static_cast<int64_t>(number)                             \
+			);                                                                                                         \
+		}                                                                                                              \
+	} while (false)
+// Message must be static const char* (usually string litteral)
+#define ZN_PROFILE_MESSAGE(message) zylann::trace_recorder::record_now(zylann::trace_recorder::EVENT_MESSAGE, message, 0)
+// Dynamic messages are not supported by the built-in recorder, because it does not store strings
 #define ZN_PROFILE_MESSAGE_DYN(message, size)
 // Name must be const char*. An internal copy will be made so it can be temporary.
-#define ZN_PROFILE_SET_THREAD_NAME(name)
+#define ZN_PROFILE_SET_THREAD_NAME(name) zylann::trace_recorder::set_thread_name(name)
 
 #endif
 
@@ -2,6 +2,8 @@
 #define PROFILING_CLOCK_H
 
 #include "godot/classes/time.h"
+#include <chrono>
+#include <cstdint>
 
 namespace zylann {
 
@@ -19,7 +21,21 @@ struct ProfilingClock {
 	inline uint64_t restart() {
 		const uint64_t now = Time::get_singleton()->get_ticks_usec();
 		const uint64_t time_spent = now - time_before;
-		time_before = Time::get_singleton()->get_ticks_usec();
+		time_before = now;
+		return time_spent;
+	}
+};
+
+// Measures time with nanosecond resolution, for sections too short to be measured in microseconds. It does not start
+// on construction, so it costs nothing if `restart` is never called.
+struct PreciseProfilingClock {
+	std::chrono::steady_clock::time_point time_before;
+
+	// Returns nanoseconds elapsed since the last restart
+	inline uint64_t restart() {
+		const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		const uint64_t time_spent = std::chrono::duration_cast<std::chrono::nanoseconds>(now - time_before).count();
+		time_before = now;
 		return time_spent;
 	}
 };
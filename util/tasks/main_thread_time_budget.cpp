@@ -0,0 +1,184 @@
+#include "main_thread_time_budget.h"
+#include "../errors.h"
+#include "../godot/classes/time.h"
+#include "../math/funcs.h"
+
+namespace zylann {
+
+namespace {
+
+// How fast smoothed values follow new measurements
+const float SMOOTHING_FACTOR = 0.25f;
+
+inline float lerp_smooth(const float average, const float value) {
+	return average + (value - average) * SMOOTHING_FACTOR;
+}
+
+} // namespace
+
+void MainThreadTimeBudget::set_fixed_budget_usec(const uint32_t usec) {
+	_fixed_budget_usec = usec;
+	if (!_adaptive_enabled) {
+		_budget_usec = usec;
+	}
+}
+
+uint32_t MainThreadTimeBudget::get_fixed_budget_usec() const {
+	return _fixed_budget_usec;
+}
+
+void MainThreadTimeBudget::set_adaptive_enabled(const bool enabled) {
+	if (enabled == _adaptive_enabled) {
+		return;
+	}
+	_adaptive_enabled = enabled;
+	// Start from the fixed budget, it will adapt from there
+	_budget_usec = enabled ? math::clamp(_fixed_budget_usec, MIN_ADAPTIVE_BUDGET_USEC, get_max_adaptive_budget_usec())
+						   : _fixed_budget_usec;
+	_average_frame_time_usec = 0;
+}
+
+bool MainThreadTimeBudget::is_adaptive_enabled() const {
+	return _adaptive_enabled;
+}
+
+void MainThreadTimeBudget::set_target_frame_time_usec(const uint32_t usec) {
+	ZN_ASSERT_RETURN(usec > 0);
+	_target_frame_time_usec = usec;
+	if (_adaptive_enabled) {
+		_budget_usec = math::clamp(_budget_usec, MIN_ADAPTIVE_BUDGET_USEC, get_max_adaptive_budget_usec());
+	}
+}
+
+uint32_t MainThreadTimeBudget::get_target_frame_time_usec() const {
+	return _target_frame_time_usec;
+}
+
+uint32_t MainThreadTimeBudget::get_max_adaptive_budget_usec() const {
+	// Leave at least half of the frame to the rest of the game
+	return math::max(_target_frame_time_usec / 2, MIN_ADAPTIVE_BUDGET_USEC);
+}
+
+void MainThreadTimeBudget::set_category_ratio(const unsigned int category, const float ratio) {
+	ZN_ASSERT_RETURN(category < _categories.size());
+	_categories[category].ratio = math::clamp(ratio, 0.f, 1.f);
+}
+
+float MainThreadTimeBudget::get_category_ratio(const unsigned int category) const {
+	ZN_ASSERT_RETURN_V(category < _categories.size(), 0.f);
+	return _categories[category].ratio;
+}
+
+void MainThreadTimeBudget::begin_frame(const uint64_t frame_time_usec, const bool has_pending_work) {
+	for (Category &category : _categories) {
+		category.last_spent_usec = category.spent_usec;
+		category.average_spent_usec = lerp_smooth(category.average_spent_usec, category.spent_usec);
+		category.spent_usec = 0;
+	}
+
+	if (!_adaptive_enabled) {
+		_budget_usec = _fixed_budget_usec;
+		return;
+	}
+	if (frame_time_usec == 0) {
+		// No measurement yet
+		return;
+	}
+
+	// Frames can take very long when the game is paused in a debugger or when loading, don't let that skew the average
+	const uint32_t clamped_frame_time_usec =
+			static_cast<uint32_t>(math::min(frame_time_usec, uint64_t(_target_frame_time_usec) * 4));
+
+	if (_average_frame_time_usec == 0) {
+		_average_frame_time_usec = clamped_frame_time_usec;
+	} else {
+		_average_frame_time_usec = static_cast<uint32_t>(
+				lerp_smooth(static_cast<float>(_average_frame_time_usec), static_cast<float>(clamped_frame_time_usec))
+		);
+	}
+
+	const uint32_t max_budget_usec = get_max_adaptive_budget_usec();
+	// Tolerate small variations, frame times are never perfectly stable
+	const uint32_t late_threshold_usec = _target_frame_time_usec + _target_frame_time_usec / 20;
+
+	int64_t budget_usec = _budget_usec;
+
+	if (_average_frame_time_usec > late_threshold_usec) {
+		// Give back part of the time frames are late by. Not all of it, because the average lags behind and we would
+		// overcorrect.
+		budget_usec -= (_average_frame_time_usec - _target_frame_time_usec) / 4;
+
+	} else if (has_pending_work && _average_frame_time_usec <= _target_frame_time_usec) {
+		// Frames are on time, take more time to drain the backlog. When the frame rate is capped (V-Sync), frame time
+		// doesn't tell how much time is left, so we still grow by a minimum step.
+		// Between the target and the late threshold, the budget is kept as is, so it settles instead of oscillating.
+		const uint32_t slack_usec = _target_frame_time_usec - _average_frame_time_usec;
+		budget_usec += math::max(slack_usec / 2, max_budget_usec / 32);
+	}
+
+	_budget_usec = static_cast<uint32_t>(
+			math::clamp(budget_usec, int64_t(MIN_ADAPTIVE_BUDGET_USEC), int64_t(max_budget_usec))
+	);
+}
+
+uint32_t MainThreadTimeBudget::get_category_budget_usec(const unsigned int category) const {
+	ZN_ASSERT_RETURN_V(category < _categories.size(), 0);
+	return static_cast<uint32_t>(_budget_usec * _categories[category].ratio);
+}
+
+uint32_t MainThreadTimeBudget::get_category_spent_usec(const unsigned int category) const {
+	ZN_ASSERT_RETURN_V(category < _categories.size(), 0);
+	uint32_t spent_usec = _categories[category].spent_usec;
+	if (_current_scope != nullptr && _current_scope->_category == category) {
+		spent_usec += Time::get_singleton()->get_ticks_usec() - _current_scope->_begin_time_usec;
+	}
+	return spent_usec;
+}
+
+uint32_t MainThreadTimeBudget::get_category_remaining_usec(const unsigned int category) const {
+	ZN_ASSERT_RETURN_V(category < _categories.size(), 0);
+	const uint32_t budget_usec = get_category_budget_usec(category);
+	const uint32_t spent_usec = get_category_spent_usec(category);
+	return budget_usec > spent_usec ? budget_usec - spent_usec : 0;
+}
+
+bool MainThreadTimeBudget::is_category_exhausted(const unsigned int category) const {
+	return get_category_remaining_usec(category) == 0;
+}
+
+void MainThreadTimeBudget::add_category_time_usec(const unsigned int category, const uint32_t usec) {
+	ZN_ASSERT_RETURN(category < _categories.size());
+	_categories[category].spent_usec += usec;
+}
+
+MainThreadTimeBudget::CategoryStats MainThreadTimeBudget::get_category_stats(const unsigned int category) const {
+	ZN_ASSERT_RETURN_V(category < _categories.size(), CategoryStats());
+	const Category &c = _categories[category];
+	CategoryStats stats;
+	stats.budget_usec = get_category_budget_usec(category);
+	stats.spent_usec = c.last_spent_usec;
+	stats.average_spent_usec = static_cast<uint32_t>(c.average_spent_usec);
+	return stats;
+}
+
+MainThreadTimeBudgetScope::MainThreadTimeBudgetScope(MainThreadTimeBudget &budget, const unsigned int category) :
+		_budget(budget), _parent(budget._current_scope), _category(category) {
+	_begin_time_usec = Time::get_singleton()->get_ticks_usec();
+	if (_parent != nullptr) {
+		// Pause the outer scope
+		_budget.add_category_time_usec(_parent->_category, _begin_time_usec - _parent->_begin_time_usec);
+	}
+	_budget._current_scope = this;
+}
+
+MainThreadTimeBudgetScope::~MainThreadTimeBudgetScope() {
+	const uint64_t end_time_usec = Time::get_singleton()->get_ticks_usec();
+	_budget.add_category_time_usec(_category, end_time_usec - _begin_time_usec);
+	if (_parent != nullptr) {
+		// Resume the outer scope
+		_parent->_begin_time_usec = end_time_usec;
+	}
+	_budget._current_scope = _parent;
+}
+
+} // namespace zylann
@@ -0,0 +1,112 @@
+#ifndef ZN_MAIN_THREAD_TIME_BUDGET_H
+#define ZN_MAIN_THREAD_TIME_BUDGET_H
+
+#include "../containers/fixed_array.h"
+#include <cstdint>
+
+namespace zylann {
+
+class MainThreadTimeBudgetScope;
+
+// Tracks how much time is spent per frame on work that must run on the main thread, split in categories, and how much
+// each category is allowed to use.
+//
+// The total budget is either fixed, or adaptive. In adaptive mode, it is adjusted every frame from the measured frame
+// time: it grows while frames are on time and work is still pending, and shrinks when frames take longer than the
+// target. Each category may use a portion of the total budget.
+//
+// Not thread-safe, it is meant to be used from the main thread only.
+class MainThreadTimeBudget {
+public:
+	static constexpr unsigned int MAX_CATEGORIES = 4;
+	static constexpr uint32_t DEFAULT_TARGET_FRAME_TIME_USEC = 1'000'000 / 60;
+	// The adaptive budget doesn't go below this, so work can still progress when frames are slow for other reasons
+	static constexpr uint32_t MIN_ADAPTIVE_BUDGET_USEC = 1000;
+
+	struct CategoryStats {
+		uint32_t budget_usec = 0;
+		// Time spent during the last complete frame
+		uint32_t spent_usec = 0;
+		// Smoothed over recent frames
+		uint32_t average_spent_usec = 0;
+	};
+
+	void set_fixed_budget_usec(uint32_t usec);
+	uint32_t get_fixed_budget_usec() const;
+
+	void set_adaptive_enabled(bool enabled);
+	bool is_adaptive_enabled() const;
+
+	void set_target_frame_time_usec(uint32_t usec);
+	uint32_t get_target_frame_time_usec() const;
+
+	// Portion of the total budget a category may use, from 0 to 1. Defaults to 1, so categories are only limited by the
+	// total budget.
+	void set_category_ratio(unsigned int category, float ratio);
+	float get_category_ratio(unsigned int category) const;
+
+	// Call once at the beginning of every frame. `frame_time_usec` is the duration of the previous frame.
+	// `has_pending_work` tells if some work could not be done within the budget of the previous frame.
+	void begin_frame(uint64_t frame_time_usec, bool has_pending_work);
+
+	// Gets the total budget for the current frame
+	inline uint32_t get_budget_usec() const {
+		return _budget_usec;
+	}
+
+	uint32_t get_category_budget_usec(unsigned int category) const;
+	// Gets time spent by a category in the current frame, including the scope currently measuring it, if any
+	uint32_t get_category_spent_usec(unsigned int category) const;
+	uint32_t get_category_remaining_usec(unsigned int category) const;
+	bool is_category_exhausted(unsigned int category) const;
+	void add_category_time_usec(unsigned int category, uint32_t usec);
+
+	CategoryStats get_category_stats(unsigned int category) const;
+
+	// Smoothed frame time measured in adaptive mode
+	inline uint32_t get_average_frame_time_usec() const {
+		return _average_frame_time_usec;
+	}
+
+private:
+	friend class MainThreadTimeBudgetScope;
+
+	uint32_t get_max_adaptive_budget_usec() const;
+
+	struct Category {
+		float ratio = 1.f;
+		uint32_t spent_usec = 0;
+		uint32_t last_spent_usec = 0;
+		float average_spent_usec = 0.f;
+	};
+
+	FixedArray<Category, MAX_CATEGORIES> _categories;
+	uint32_t _fixed_budget_usec = 8000;
+	uint32_t _budget_usec = 8000;
+	uint32_t _target_frame_time_usec = DEFAULT_TARGET_FRAME_TIME_USEC;
+	uint32_t _average_frame_time_usec = 0;
+	bool _adaptive_enabled = false;
+
+	// Innermost scope currently measuring time
+	MainThreadTimeBudgetScope *_current_scope = nullptr;
+};
+
+// Measures time spent in a C++ scope and adds it to a category. Scopes can be nested, in which case time spent in the
+// inner scope is not counted in the outer one.
+class MainThreadTimeBudgetScope {
+public:
+	MainThreadTimeBudgetScope(MainThreadTimeBudget &budget, unsigned int category);
+	~MainThreadTimeBudgetScope();
+
+private:
+	friend class MainThreadTimeBudget;
+
+	MainThreadTimeBudget &_budget;
+	MainThreadTimeBudgetScope *_parent;
+	uint64_t _begin_time_usec;
+	unsigned int _category;
+};
+
+} // namespace zylann
+
+#endif // ZN_MAIN_THREAD_TIME_BUDGET_H
@@ -0,0 +1,220 @@
+#include "task_latency_stats.h"
+#include "../errors.h"
+#include "../math/funcs.h"
+#include <cstring>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace zylann {
+
+namespace {
+
+inline unsigned int get_highest_bit_index(const uint64_t v) {
+#if defined(__GNUC__)
+	return 63 - __builtin_clzll(v);
+#elif defined(_MSC_VER) && defined(_WIN64)
+	unsigned long index;
+	_BitScanReverse64(&index, v);
+	return index;
+#else
+	unsigned int index = 0;
+	for (uint64_t x = v >> 1; x != 0; x >>= 1) {
+		++index;
+	}
+	return index;
+#endif
+}
+
+} // namespace
+
+LatencyHistogram::LatencyHistogram() {
+	clear();
+}
+
+unsigned int LatencyHistogram::get_bucket_index(const uint64_t value_usec) {
+	if (value_usec < SUB_BUCKET_COUNT) {
+		return value_usec;
+	}
+	const unsigned int msb = get_highest_bit_index(value_usec);
+	if (msb >= MAX_VALUE_BITS) {
+		return BUCKET_COUNT - 1;
+	}
+	const unsigned int shift = msb - SUB_BUCKET_BITS;
+	return (shift + 1) * SUB_BUCKET_COUNT + ((value_usec >> shift) & (SUB_BUCKET_COUNT - 1));
+}
+
+uint64_t LatencyHistogram::get_bucket_value(const unsigned int bucket_index) {
+	if (bucket_index < SUB_BUCKET_COUNT) {
+		return bucket_index;
+	}
+	const unsigned int shift = bucket_index / SUB_BUCKET_COUNT - 1;
+	const uint64_t sub_bucket = bucket_index % SUB_BUCKET_COUNT;
+	const uint64_t min_value = (SUB_BUCKET_COUNT + sub_bucket) << shift;
+	const uint64_t width = uint64_t(1) << shift;
+	return min_value + width / 2;
+}
+
+void LatencyHistogram::add(const uint64_t value_usec) {
+	std::atomic_uint32_t &count = _counts[get_bucket_index(value_usec)];
+	// Only one thread writes, so there is no need for an atomic increment
+	count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::clear() {
+	for (unsigned int i = 0; i < _counts.size(); ++i) {
+		_counts[i].store(0, std::memory_order_relaxed);
+	}
+}
+
+LatencyHistogram::Snapshot::Snapshot() {
+	fill(counts, uint64_t(0));
+}
+
+void LatencyHistogram::Snapshot::add(const LatencyHistogram &histogram) {
+	for (unsigned int i = 0; i < counts.size(); ++i) {
+		const uint32_t count = histogram._counts[i].load(std::memory_order_relaxed);
+		counts[i] += count;
+		total_count += count;
+	}
+}
+
+uint64_t LatencyHistogram::Snapshot::get_percentile(const float p) const {
+	if (total_count == 0) {
+		return 0;
+	}
+	const uint64_t target_count =
+			math::max(static_cast<uint64_t>(Math::ceil(p * static_cast<double>(total_count))), uint64_t(1));
+	uint64_t cumulated_count = 0;
+	for (unsigned int i = 0; i < counts.size(); ++i) {
+		cumulated_count += counts[i];
+		if (cumulated_count >= target_count) {
+			return get_bucket_value(i);
+		}
+	}
+	return get_bucket_value(counts.size() - 1);
+}
+
+TaskLatencyStats::ThreadSlot::ThreadSlot() {
+	for (unsigned int i = 0; i < MAX_TASK_TYPES; ++i) {
+		names[i] = nullptr;
+		histograms[i] = nullptr;
+	}
+}
+
+TaskLatencyStats::TaskLatencyStats(unsigned int thread_count) {
+	_thread_slots.resize(thread_count);
+	for (UniquePtr<ThreadSlot> &slot : _thread_slots) {
+		slot = make_unique_instance<ThreadSlot>();
+	}
+}
+
+TaskLatencyStats::~TaskLatencyStats() {
+	for (UniquePtr<ThreadSlot> &slot : _thread_slots) {
+		for (unsigned int i = 0; i < slot->count; ++i) {
+			ZN_DELETE(slot->histograms[i].load());
+		}
+	}
+}
+
+TaskLatencyStats::TaskTypeHistograms *TaskLatencyStats::get_or_create_histograms(ThreadSlot &slot, const char *name) {
+	const unsigned int count = slot.count.load(std::memory_order_relaxed);
+	// There are usually few task types, and names are compared by pointer
+	for (unsigned int i = 0; i < count; ++i) {
+		if (slot.names[i].load(std::memory_order_relaxed) == name) {
+			return slot.histograms[i].load(std::memory_order_relaxed);
+		}
+	}
+	if (count == MAX_TASK_TYPES) {
+		return nullptr;
+	}
+	TaskTypeHistograms *histograms = ZN_NEW(TaskTypeHistograms);
+	slot.names[count].store(name, std::memory_order_relaxed);
+	slot.histograms[count].store(histograms, std::memory_order_relaxed);
+	// Publish after the entry is fully written
+	slot.count.store(count + 1, std::memory_order_release);
+	return histograms;
+}
+
+void TaskLatencyStats::record(
+		const unsigned int thread_index,
+		const char *name,
+		const Metric metric,
+		const uint64_t duration_usec
+) {
+#ifdef DEBUG_ENABLED
+	ZN_ASSERT(thread_index < _thread_slots.size());
+#endif
+	TaskTypeHistograms *histograms = get_or_create_histograms(*_thread_slots[thread_index], name);
+	if (histograms == nullptr) {
+		return;
+	}
+	histograms->histograms[metric].add(duration_usec);
+}
+
+void TaskLatencyStats::get_stats(StdVector<TaskTypeStats> &out_stats) const {
+	struct TypeSnapshot {
+		const char *name;
+		FixedArray<LatencyHistogram::Snapshot, METRIC_COUNT> metrics;
+	};
+
+	StdVector<TypeSnapshot> snapshots;
+
+	for (const UniquePtr<ThreadSlot> &slot : _thread_slots) {
+		const unsigned int count = slot->count.load(std::memory_order_acquire);
+
+		for (unsigned int type_index = 0; type_index < count; ++type_index) {
+			const char *name = slot->names[type_index].load(std::memory_order_relaxed);
+			const TaskTypeHistograms &histograms = *slot->histograms[type_index].load(std::memory_order_relaxed);
+
+			// The same name can have different pointers if it was defined in multiple places
+			TypeSnapshot *snapshot = nullptr;
+			for (TypeSnapshot &s : snapshots) {
+				if (s.name == name || std::strcmp(s.name, name) == 0) {
+					snapshot = &s;
+					break;
+				}
+			}
+			if (snapshot == nullptr) {
+				snapshots.push_back(TypeSnapshot{ name, {} });
+				snapshot = &snapshots.back();
+			}
+
+			for (unsigned int metric = 0; metric < METRIC_COUNT; ++metric) {
+				snapshot->metrics[metric].add(histograms.histograms[metric]);
+			}
+		}
+	}
+
+	out_stats.clear();
+	out_stats.reserve(snapshots.size());
+
+	for (const TypeSnapshot &snapshot : snapshots) {
+		TaskTypeStats stats;
+		stats.name = snapshot.name;
+		for (unsigned int metric = 0; metric < METRIC_COUNT; ++metric) {
+			const LatencyHistogram::Snapshot &hs = snapshot.metrics[metric];
+			stats.counts[metric] = hs.total_count;
+			Percentiles &percentiles = stats.percentiles_usec[metric];
+			percentiles.p50 = hs.get_percentile(0.5f);
+			percentiles.p90 = hs.get_percentile(0.9f);
+			percentiles.p99 = hs.get_percentile(0.99f);
+		}
+		out_stats.push_back(stats);
+	}
+}
+
+void TaskLatencyStats::clear() {
+	for (const UniquePtr<ThreadSlot> &slot : _thread_slots) {
+		const unsigned int count = slot->count.load(std::memory_order_acquire);
+		for (unsigned int type_index = 0; type_index < count; ++type_index) {
+			TaskTypeHistograms &histograms = *slot->histograms[type_index].load(std::memory_order_relaxed);
+			for (unsigned int metric = 0; metric < METRIC_COUNT; ++metric) {
+				histograms.histograms[metric].clear();
+			}
+		}
+	}
+}
+
+} // namespace zylann
@@ -0,0 +1,115 @@
+#ifndef ZN_TASK_LATENCY_STATS_H
+#define ZN_TASK_LATENCY_STATS_H
+
+#include "../containers/fixed_array.h"
+#include "../containers/std_vector.h"
+#include "../memory/memory.h"
+#include <atomic>
+#include <cstdint>
+
+namespace zylann {
+
+// Histogram of durations in microseconds. Buckets have logarithmic size, with a fixed number of linear sub-buckets per
+// power of two (like HdrHistogram), so the relative error stays the same at any magnitude.
+// It can be written by only one thread at a time, but can be read from other threads at any time.
+class LatencyHistogram {
+public:
+	// 16 sub-buckets per power of two, so reported values are within about 6% of the actual value
+	static constexpr unsigned int SUB_BUCKET_BITS = 4;
+	static constexpr unsigned int SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+	// Values beyond 2^32 microseconds (more than an hour) go in the last bucket
+	static constexpr unsigned int MAX_VALUE_BITS = 32;
+	static constexpr unsigned int BUCKET_COUNT = SUB_BUCKET_COUNT * (MAX_VALUE_BITS - SUB_BUCKET_BITS + 1);
+
+	LatencyHistogram();
+
+	// Must be called from the thread owning the histogram
+	void add(uint64_t value_usec);
+
+	void clear();
+
+	static unsigned int get_bucket_index(uint64_t value_usec);
+	// Gets the middle value of the range covered by a bucket
+	static uint64_t get_bucket_value(unsigned int bucket_index);
+
+	// Sum of counts from multiple histograms, which can be queried.
+	struct Snapshot {
+		FixedArray<uint64_t, BUCKET_COUNT> counts;
+		uint64_t total_count = 0;
+
+		Snapshot();
+		void add(const LatencyHistogram &histogram);
+		// `p` is from 0 to 1
+		uint64_t get_percentile(float p) const;
+	};
+
+private:
+	FixedArray<std::atomic_uint32_t, BUCKET_COUNT> _counts;
+};
+
+// Records how long tasks wait in queue, run and get their results applied, per type of task, without locking.
+// Each thread records in its own set of histograms. Task types are identified by their debug name.
+class TaskLatencyStats {
+public:
+	enum Metric {
+		// From the moment the task is scheduled to the moment a thread starts running it
+		METRIC_WAIT,
+		// Time spent in `run()`
+		METRIC_RUN,
+		// Time spent applying results (usually on the main thread)
+		METRIC_APPLY,
+		// From the moment the task is scheduled to the moment its results are applied
+		METRIC_TOTAL,
+		METRIC_COUNT
+	};
+
+	// Distinct task names each thread can record. Names beyond this are ignored.
+	static constexpr unsigned int MAX_TASK_TYPES = 64;
+
+	struct Percentiles {
+		uint64_t p50 = 0;
+		uint64_t p90 = 0;
+		uint64_t p99 = 0;
+	};
+
+	struct TaskTypeStats {
+		const char *name = nullptr;
+		FixedArray<uint64_t, METRIC_COUNT> counts;
+		FixedArray<Percentiles, METRIC_COUNT> percentiles_usec;
+	};
+
+	TaskLatencyStats(unsigned int thread_count);
+	~TaskLatencyStats();
+
+	// Must be called from the thread matching `thread_index`, or from one thread at a time for the same index.
+	// `name` is expected to remain valid for the lifetime of the stats (usually a string literal).
+	void record(unsigned int thread_index, const char *name, Metric metric, uint64_t duration_usec);
+
+	// Can be called from any thread. Counts of tasks recorded at the same time may be partially missed.
+	void get_stats(StdVector<TaskTypeStats> &out_stats) const;
+
+	// Can be called from any thread. Recording at the same time may leave some counts from before the reset.
+	void clear();
+
+private:
+	struct TaskTypeHistograms {
+		FixedArray<LatencyHistogram, METRIC_COUNT> histograms;
+	};
+
+	struct ThreadSlot {
+		// Only written by the owning thread. Names are published after their histograms were created.
+		FixedArray<std::atomic<const char *>, MAX_TASK_TYPES> names;
+		FixedArray<std::atomic<TaskTypeHistograms *>, MAX_TASK_TYPES> histograms;
+		std::atomic_uint32_t count = { 0 };
+
+		ThreadSlot();
+	};
+
+	TaskTypeHistograms *get_or_create_histograms(ThreadSlot &slot, const char *name);
+
+	StdVector<UniquePtr<ThreadSlot>> _thread_slots;
+};
+
+} // namespace zylann
+
+#endif // ZN_TASK_LATENCY_STATS_H
@@ -0,0 +1,349 @@
+#ifndef ZN_TASK_PRIORITY_QUEUE_H
+#define ZN_TASK_PRIORITY_QUEUE_H
+
+#include "../containers/fixed_array.h"
+#include "../containers/std_vector.h"
+#include "../errors.h"
+#include "../memory/memory.h"
+#include "task_priority.h"
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace zylann {
+
+// Priority queue of items keyed by `TaskPriority`, where pushing and popping the highest priority item is O(1).
+//
+// Items are stored in one bucket per exact priority value, organized as a 4-level tree indexed by bands, from band3
+// down to band0. Each level has a 256-bit mask of which children have items, so finding the highest priority is done
+// with at most 16 bit scans, regardless of how many items are in the queue.
+// Items having the same priority are not ordered.
+//
+// Nodes are allocated the first time a priority prefix is used, and are kept around when they become empty. Tasks
+// typically use a small set of band1/band2/band3 combinations, so the number of nodes remains small.
+template <typename T>
+class TaskPriorityQueue {
+public:
+	void push(TaskPriority priority, const T &item) {
+		Band2Node &node2 = _root.get_or_create(priority.band3);
+		Band1Node &node1 = node2.get_or_create(priority.band2);
+		Leaf &leaf = node1.get_or_create(priority.band1);
+		leaf.buckets[priority.band0].push_back(item);
+		leaf.mask.set(priority.band0);
+		node1.mask.set(priority.band1);
+		node2.mask.set(priority.band2);
+		_root.mask.set(priority.band3);
+		++_size;
+	}
+
+	// Removes the item having the highest priority. Returns `false` if the queue is empty.
+	bool pop(T &out_item, TaskPriority *out_priority = nullptr) {
+		if (_size == 0) {
+			return false;
+		}
+
+		const uint8_t band3 = _root.mask.find_last();
+		Band2Node &node2 = *_root.children[band3];
+		const uint8_t band2 = node2.mask.find_last();
+		Band1Node &node1 = *node2.children[band2];
+		const uint8_t band1 = node1.mask.find_last();
+		Leaf &leaf = *node1.children[band1];
+		const uint8_t band0 = leaf.mask.find_last();
+
+		StdVector<T> &bucket = leaf.buckets[band0];
+		out_item = std::move(bucket.back());
+		bucket.pop_back();
+		--_size;
+
+		if (bucket.size() == 0) {
+			unset_empty(node2, node1, leaf, TaskPriority(band0, band1, band2, band3));
+		}
+
+		if (out_priority != nullptr) {
+			*out_priority = TaskPriority(band0, band1, band2, band3);
+		}
+		return true;
+	}
+
+	// Removes the item having the highest priority among those for which `predicate(const T &item)` returns `true`.
+	// Returns `false` if there is no such item. This is slower than `pop`, as it may have to visit every item.
+	template <typename F>
+	bool pop_first_if(F predicate, T &out_item, TaskPriority *out_priority = nullptr) {
+		bool found = false;
+
+		_root.mask.find_set_bit([&](const uint8_t band3) {
+			Band2Node &node2 = *_root.children[band3];
+
+			return node2.mask.find_set_bit([&](const uint8_t band2) {
+				Band1Node &node1 = *node2.children[band2];
+
+				return node1.mask.find_set_bit([&](const uint8_t band1) {
+					Leaf &leaf = *node1.children[band1];
+
+					return leaf.mask.find_set_bit([&](const uint8_t band0) {
+						StdVector<T> &bucket = leaf.buckets[band0];
+
+						for (size_t i = 0; i < bucket.size(); ++i) {
+							if (!predicate(static_cast<const T &>(bucket[i]))) {
+								continue;
+							}
+							out_item = std::move(bucket[i]);
+							if (i + 1 != bucket.size()) {
+								// Order within a bucket doesn't matter
+								bucket[i] = std::move(bucket.back());
+							}
+							bucket.pop_back();
+							--_size;
+
+							const TaskPriority priority(band0, band1, band2, band3);
+							if (bucket.size() == 0) {
+								unset_empty(node2, node1, leaf, priority);
+							}
+							if (out_priority != nullptr) {
+								*out_priority = priority;
+							}
+							found = true;
+							return true;
+						}
+						return false;
+					});
+				});
+			});
+		});
+
+		return found;
+	}
+
+	// Gets the highest priority among queued items, or the minimum priority if the queue is empty.
+	TaskPriority get_top_priority() const {
+		if (_size == 0) {
+			return TaskPriority::min();
+		}
+		const uint8_t band3 = _root.mask.find_last();
+		const Band2Node &node2 = *_root.children[band3];
+		const uint8_t band2 = node2.mask.find_last();
+		const Band1Node &node1 = *node2.children[band2];
+		const uint8_t band1 = node1.mask.find_last();
+		const Leaf &leaf = *node1.children[band1];
+		const uint8_t band0 = leaf.mask.find_last();
+		return TaskPriority(band0, band1, band2, band3);
+	}
+
+	// Visits all items in order to update their priority.
+	// `f` has signature `bool f(T &item, TaskPriority &inout_priority)`. It receives the current priority of the item,
+	// which it may modify. If it returns `false`, the item is removed from the queue.
+	// Only items whose priority changed are moved to another bucket.
+	template <typename F>
+	void update(F f) {
+		_moved_items.clear();
+
+		_root.mask.for_each_set_bit([this, &f](const uint8_t band3) {
+			Band2Node &node2 = *_root.children[band3];
+
+			node2.mask.for_each_set_bit([this, &f, &node2, band3](const uint8_t band2) {
+				Band1Node &node1 = *node2.children[band2];
+
+				node1.mask.for_each_set_bit([this, &f, &node2, &node1, band2, band3](const uint8_t band1) {
+					Leaf &leaf = *node1.children[band1];
+
+					leaf.mask.for_each_set_bit([this, &f, &node2, &node1, &leaf, band1, band2, band3](
+													   const uint8_t band0
+											   ) {
+						const TaskPriority bucket_priority(band0, band1, band2, band3);
+						StdVector<T> &bucket = leaf.buckets[band0];
+
+						for (size_t i = 0; i < bucket.size();) {
+							TaskPriority priority = bucket_priority;
+							const bool keep = f(bucket[i], priority);
+
+							if (keep && priority.whole == bucket_priority.whole) {
+								++i;
+								continue;
+							}
+							if (keep) {
+								_moved_items.push_back(MovedItem{ std::move(bucket[i]), priority });
+							}
+							// Order within a bucket doesn't matter
+							bucket[i] = std::move(bucket.back());
+							bucket.pop_back();
+							--_size;
+						}
+
+						if (bucket.size() == 0) {
+							unset_empty(node2, node1, leaf, bucket_priority);
+						}
+					});
+				});
+			});
+		});
+
+		for (MovedItem &moved_item : _moved_items) {
+			push(moved_item.priority, moved_item.item);
+		}
+		_moved_items.clear();
+	}
+
+	// Calls `f(const T &item, TaskPriority priority)` on every item, in no particular order.
+	template <typename F>
+	void for_each(F f) const {
+		_root.mask.for_each_set_bit([this, &f](const uint8_t band3) {
+			const Band2Node &node2 = *_root.children[band3];
+			node2.mask.for_each_set_bit([&f, &node2, band3](const uint8_t band2) {
+				const Band1Node &node1 = *node2.children[band2];
+				node1.mask.for_each_set_bit([&f, &node1, band2, band3](const uint8_t band1) {
+					const Leaf &leaf = *node1.children[band1];
+					leaf.mask.for_each_set_bit([&f, &leaf, band1, band2, band3](const uint8_t band0) {
+						const TaskPriority priority(band0, band1, band2, band3);
+						for (const T &item : leaf.buckets[band0]) {
+							f(item, priority);
+						}
+					});
+				});
+			});
+		});
+	}
+
+	void clear() {
+		update([](T &, TaskPriority &) { return false; });
+	}
+
+	inline size_t size() const {
+		return _size;
+	}
+
+	inline bool is_empty() const {
+		return _size == 0;
+	}
+
+private:
+	struct Bitset256 {
+		uint64_t words[4] = { 0, 0, 0, 0 };
+
+		inline void set(const uint8_t i) {
+			words[i >> 6] |= (uint64_t(1) << (i & 63));
+		}
+
+		inline void unset(const uint8_t i) {
+			words[i >> 6] &= ~(uint64_t(1) << (i & 63));
+		}
+
+		inline bool is_empty() const {
+			return (words[0] | words[1] | words[2] | words[3]) == 0;
+		}
+
+		// Gets the index of the highest set bit. The bitset must not be empty.
+		inline uint8_t find_last() const {
+			for (int wi = 3; wi >= 0; --wi) {
+				const uint64_t w = words[wi];
+				if (w != 0) {
+					return (wi << 6) + get_highest_bit_index(w);
+				}
+			}
+#ifdef DEBUG_ENABLED
+			ZN_CRASH_MSG("Bitset is empty");
+#endif
+			return 0;
+		}
+
+		// Iterates set bits from highest to lowest. Bits may be modified during iteration.
+		template <typename F>
+		inline void for_each_set_bit(F f) const {
+			for (int wi = 3; wi >= 0; --wi) {
+				uint64_t w = words[wi];
+				while (w != 0) {
+					const unsigned int bi = get_highest_bit_index(w);
+					w &= ~(uint64_t(1) << bi);
+					f(static_cast<uint8_t>((wi << 6) + bi));
+				}
+			}
+		}
+
+		// Iterates set bits from highest to lowest, until `f` returns `true`. Returns whether it did.
+		template <typename F>
+		inline bool find_set_bit(F f) const {
+			for (int wi = 3; wi >= 0; --wi) {
+				uint64_t w = words[wi];
+				while (w != 0) {
+					const unsigned int bi = get_highest_bit_index(w);
+					w &= ~(uint64_t(1) << bi);
+					if (f(static_cast<uint8_t>((wi << 6) + bi))) {
+						return true;
+					}
+				}
+			}
+			return false;
+		}
+
+		static inline unsigned int get_highest_bit_index(const uint64_t w) {
+#if defined(__GNUC__)
+			return 63 - __builtin_clzll(w);
+#elif defined(_MSC_VER) && defined(_WIN64)
+			unsigned long index;
+			_BitScanReverse64(&index, w);
+			return index;
+#else
+			unsigned int index = 0;
+			for (uint64_t v = w >> 1; v != 0; v >>= 1) {
+				++index;
+			}
+			return index;
+#endif
+		}
+	};
+
+	struct Leaf {
+		Bitset256 mask;
+		FixedArray<StdVector<T>, 256> buckets;
+	};
+
+	template <typename TChild>
+	struct Node {
+		Bitset256 mask;
+		FixedArray<UniquePtr<TChild>, 256> children;
+
+		inline TChild &get_or_create(const uint8_t i) {
+			UniquePtr<TChild> &child = children[i];
+			if (child == nullptr) {
+				child = make_unique_instance<TChild>();
+			}
+			return *child;
+		}
+	};
+
+	typedef Node<Leaf> Band1Node;
+	typedef Node<Band1Node> Band2Node;
+	typedef Node<Band2Node> RootNode;
+
+	struct MovedItem {
+		T item;
+		TaskPriority priority;
+	};
+
+	// Call when the bucket at the given priority became empty, to clear it from masks of every level.
+	inline void unset_empty(Band2Node &node2, Band1Node &node1, Leaf &leaf, const TaskPriority priority) {
+		leaf.mask.unset(priority.band0);
+		if (!leaf.mask.is_empty()) {
+			return;
+		}
+		node1.mask.unset(priority.band1);
+		if (!node1.mask.is_empty()) {
+			return;
+		}
+		node2.mask.unset(priority.band2);
+		if (!node2.mask.is_empty()) {
+			return;
+		}
+		_root.mask.unset(priority.band3);
+	}
+
+	RootNode _root;
+	size_t _size = 0;
+	// Temporary storage for items changing priority during updates. Kept as member to reuse capacity.
+	StdVector<MovedItem> _moved_items;
+};
+
+} // namespace zylann
+
+#endif // ZN_TASK_PRIORITY_QUEUE_H
@@ -67,6 +67,13 @@ public:
 		return false;
 	}
 
+	// If not null, the task will run in serial with other tasks returning the same key, even if it was not scheduled
+	// as serial. Tasks with different keys can still run in parallel. This is useful when tasks lock a shared resource,
+	// to avoid clogging up threads waiting on each other. The key must not change while the task is scheduled.
+	virtual const void *get_serial_key() const {
+		return nullptr;
+	}
+
 	// Gets the name of the task for debug purposes. The returned name's lifetime must span the execution of the engine
 	// (usually a string literal).
 	virtual const char *get_debug_name() const {
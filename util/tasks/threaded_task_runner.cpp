@@ -1,22 +1,26 @@
 #include "threaded_task_runner.h"
 #include "../dstack.h"
 #include "../godot/classes/time.h"
+#include "../math/funcs.h"
 #include "../profiling.h"
 #include "../string/format.h"
 
 namespace zylann {
 
-ThreadedTaskRunner::ThreadedTaskRunner() {}
+ThreadedTaskRunner::ThreadedTaskRunner() : _latency_stats(MAX_THREADS + 1) {}
 
 ThreadedTaskRunner::~ThreadedTaskRunner() {
 	destroy_all_threads();
 
 	// We don't have ownership over tasks, so it's an error to destroy the pool without handling them
-	if (_staged_tasks.size() != 0) {
-		ZN_PRINT_ERROR("There are staged tasks remaining!");
+	for (unsigned int i = 0; i < _queues.size(); ++i) {
+		if (_queues[i].size != 0) {
+			ZN_PRINT_ERROR("There are tasks remaining!");
+			break;
+		}
 	}
-	if (_tasks.size() != 0) {
-		ZN_PRINT_ERROR("There are tasks remaining!");
+	if (_serial_tasks.size != 0) {
+		ZN_PRINT_ERROR("There are serial tasks remaining!");
 	}
 	if (_spinning_tasks.size() != 0) {
 		ZN_PRINT_ERROR("There are spinning tasks remaining!");
@@ -91,6 +95,28 @@ void ThreadedTaskRunner::set_thread_count(uint32_t count) {
 	}
 	destroy_all_threads();
 	_thread_count = count;
+
+	// Queues of threads that no longer exist would never be picked from, move their tasks to remaining ones
+	const uint32_t queue_count = get_queue_count();
+	for (uint32_t i = queue_count; i < _queues.size(); ++i) {
+		TaskQueue &src = _queues[i];
+		if (src.size == 0) {
+			continue;
+		}
+		TaskQueue &dst = _queues[i % queue_count];
+		append_array(dst.staged_tasks, src.staged_tasks);
+		TaskItem item;
+		while (src.tasks.pop(item)) {
+			dst.staged_tasks.push_back(item);
+		}
+		dst.size += src.size;
+		dst.has_staged_tasks = true;
+		src.staged_tasks.clear();
+		src.size = 0;
+		src.top_priority = 0;
+		src.has_staged_tasks = false;
+	}
+
 	for (uint32_t i = 0; i < _thread_count; ++i) {
 		ThreadData &d = _threads[i];
 		create_thread(d, i);
@@ -101,21 +127,43 @@ void ThreadedTaskRunner::set_priority_update_period(uint32_t milliseconds) {
 	_priority_update_period_ms = milliseconds;
 }
 
-void ThreadedTaskRunner::enqueue(IThreadedTask *task, bool serial) {
-	ZN_PROFILE_SCOPE();
-	ZN_ASSERT(task != nullptr);
-	TaskItem t;
-	t.task = task;
-	t.is_serial = serial;
-	{
-		MutexLock lock(_staged_tasks_mutex);
-		_staged_tasks.push_back(t);
-		++_debug_received_tasks;
+void ThreadedTaskRunner::push_tasks(TaskQueue &queue, Span<IThreadedTask *> new_tasks, bool serial) {
+	const uint64_t now_usec = get_time_usec();
+	MutexLock lock(queue.staged_tasks_mutex);
+	const size_t dst_begin = queue.staged_tasks.size();
+	queue.staged_tasks.resize(queue.staged_tasks.size() + new_tasks.size());
+	for (size_t i = 0; i < new_tasks.size(); ++i) {
+		IThreadedTask *new_task = new_tasks[i];
+		TaskItem t;
+		t.task = new_task;
+		if (serial) {
+			const void *serial_key = new_task->get_serial_key();
+			// Tasks without a key are all serial with each other
+			t.serial_key = serial_key != nullptr ? serial_key : &_serial_tasks;
+		}
+		t.enqueue_time_usec = now_usec;
+		t.queued_time_usec = now_usec;
+		queue.staged_tasks[dst_begin + i] = t;
 
 #ifdef ZN_THREADED_TASK_RUNNER_CHECK_DUPLICATE_TASKS
-		debug_add_owned_task(task);
+		debug_add_owned_task(new_task);
 #endif
 	}
+	queue.size += new_tasks.size();
+	queue.has_staged_tasks = true;
+}
+
+void ThreadedTaskRunner::enqueue(IThreadedTask *task, bool serial) {
+	ZN_PROFILE_SCOPE();
+	ZN_ASSERT(task != nullptr);
+	if (serial || task->get_serial_key() != nullptr) {
+		push_tasks(_serial_tasks, Span<IThreadedTask *>(&task, 1), true);
+		_serial_tasks_blocked = false;
+	} else {
+		const uint32_t queue_index = _next_queue_index++ % get_queue_count();
+		push_tasks(_queues[queue_index], Span<IThreadedTask *>(&task, 1), false);
+	}
+	++_debug_received_tasks;
 	// TODO Do I need to post a certain amount of times?
 	// I feel like this causes the semaphore to be passed too many times when tasks become empty
 	_tasks_semaphore.post();
@@ -127,30 +175,276 @@ void ThreadedTaskRunner::enqueue(Span<IThreadedTask *> new_tasks, bool serial) {
 		ZN_ASSERT(new_tasks[i] != nullptr);
 	}
 #endif
-	{
-		MutexLock lock(_staged_tasks_mutex);
-		const size_t dst_begin = _staged_tasks.size();
-		_staged_tasks.resize(_staged_tasks.size() + new_tasks.size());
+	if (new_tasks.size() == 0) {
+		return;
+	}
+	const uint32_t queue_count = get_queue_count();
+
+	Span<IThreadedTask *> parallel_tasks;
+
+	if (serial) {
+		push_tasks(_serial_tasks, new_tasks, true);
+		_serial_tasks_blocked = false;
+
+	} else {
+		// Tasks having a serial key go to the serial queue regardless
+		size_t serial_count = 0;
 		for (size_t i = 0; i < new_tasks.size(); ++i) {
-			IThreadedTask *new_task = new_tasks[i];
-			TaskItem t;
-			t.task = new_task;
-			t.is_serial = serial;
-			_staged_tasks[dst_begin + i] = t;
+			if (new_tasks[i]->get_serial_key() != nullptr) {
+				++serial_count;
+			}
+		}
 
-#ifdef ZN_THREADED_TASK_RUNNER_CHECK_DUPLICATE_TASKS
-			debug_add_owned_task(new_task);
-#endif
+		if (serial_count == 0) {
+			parallel_tasks = new_tasks;
+
+		} else if (serial_count == new_tasks.size()) {
+			push_tasks(_serial_tasks, new_tasks, true);
+			_serial_tasks_blocked = false;
+
+		} else {
+			static thread_local StdVector<IThreadedTask *> tls_serial_tasks;
+			static thread_local StdVector<IThreadedTask *> tls_parallel_tasks;
+			tls_serial_tasks.clear();
+			tls_parallel_tasks.clear();
+			for (size_t i = 0; i < new_tasks.size(); ++i) {
+				IThreadedTask *task = new_tasks[i];
+				if (task->get_serial_key() != nullptr) {
+					tls_serial_tasks.push_back(task);
+				} else {
+					tls_parallel_tasks.push_back(task);
+				}
+			}
+			push_tasks(_serial_tasks, to_span(tls_serial_tasks), true);
+			_serial_tasks_blocked = false;
+			parallel_tasks = to_span(tls_parallel_tasks);
 		}
-		_debug_received_tasks += new_tasks.size();
 	}
-	// TODO Do I need to post a certain amount of times?
-	// Should it be the number of threads instead of number of tasks?
-	for (size_t i = 0; i < new_tasks.size(); ++i) {
+
+	if (parallel_tasks.size() > 0) {
+		// Split in contiguous chunks, one per queue. Tasks scheduled together are often close to each other, so each
+		// thread gets a share of tasks of similar priority.
+		const size_t chunk_size = (parallel_tasks.size() + queue_count - 1) / queue_count;
+		uint32_t queue_index = _next_queue_index.fetch_add(queue_count);
+		for (size_t i = 0; i < parallel_tasks.size(); i += chunk_size) {
+			const size_t count = math::min(chunk_size, parallel_tasks.size() - i);
+			push_tasks(_queues[queue_index % queue_count], parallel_tasks.sub(i, count), false);
+			++queue_index;
+		}
+	}
+	_debug_received_tasks += new_tasks.size();
+
+	// Threads keep picking tasks until queues are empty, so we only need to wake up as many as there are tasks.
+	const uint32_t wake_count = math::min(static_cast<uint32_t>(new_tasks.size()), _thread_count);
+	for (uint32_t i = 0; i < wake_count; ++i) {
 		_tasks_semaphore.post();
 	}
 }
 
+// Must be called with the tasks mutex locked.
+// If `serial` is true, tasks whose serial key is already running are skipped.
+bool ThreadedTaskRunner::pop_task(
+		TaskQueue &queue,
+		TaskItem &out_item,
+		StdVector<IThreadedTask *> &cancelled_tasks,
+		const bool serial
+) {
+	TaskPriorityQueue<TaskItem> &tasks = queue.tasks;
+
+	// Move tasks from the staging list.
+	// Lock with minimal risk of blocking the main thread, it should be very short.
+	if (queue.staged_tasks_mutex.try_lock()) {
+		for (TaskItem &item : queue.staged_tasks) {
+			item.cached_priority = item.task->get_priority();
+			tasks.push(item.cached_priority, item);
+		}
+		queue.staged_tasks.clear();
+		queue.has_staged_tasks = false;
+		queue.staged_tasks_mutex.unlock();
+	}
+
+	if (tasks.is_empty()) {
+		queue.top_priority = 0;
+		return false;
+	}
+
+	// Update periodically.
+	// The point to keep updating after tasks have been inserted is in case there are lots of pending tasks, which can
+	// take more than a few seconds to be processed. A player can move fast and the priority location can change. Some
+	// tasks can even become irrelevant before they are run, so we may remove them from the list so they don't slow
+	// down the process.
+	// Tasks whose priority didn't change stay in their bucket, and tasks depending on viewers can skip most of the
+	// evaluation when viewers didn't move enough (see `PriorityDependency`).
+	const uint64_t now = Time::get_singleton()->get_ticks_msec();
+	if (now - queue.last_priority_update_time_ms > _priority_update_period_ms) {
+		ZN_PROFILE_SCOPE_NAMED("Update priorities");
+
+		const size_t size_before = tasks.size();
+
+		tasks.update([&cancelled_tasks](TaskItem &item, TaskPriority &inout_priority) {
+			if (item.task->is_cancelled()) {
+				cancelled_tasks.push_back(item.task);
+				return false;
+			}
+			item.cached_priority = item.task->get_priority();
+			inout_priority = item.cached_priority;
+			return true;
+		});
+
+		queue.size -= size_before - tasks.size();
+
+		queue.last_priority_update_time_ms = Time::get_singleton()->get_ticks_msec();
+
+		if (tasks.is_empty()) {
+			queue.top_priority = 0;
+			return false;
+		}
+	}
+
+	bool popped = true;
+	if (serial) {
+		popped = tasks.pop_first_if(
+				[this](const TaskItem &item) { return !is_serial_key_running(item.serial_key); }, out_item
+		);
+	} else {
+		tasks.pop(out_item);
+	}
+
+	if (popped) {
+		--queue.size;
+	}
+
+	// Published even if no task was runnable, because staged tasks and priority updates can change it, and threads
+	// compare it when choosing which queue to pick from
+	queue.top_priority = tasks.get_top_priority().whole;
+
+	return popped;
+}
+
+namespace {
+
+// Threads only pick from another queue if it has tasks in a strictly higher priority bucket. Buckets ignore band0
+// (usually fine-grained distance), otherwise threads would keep stealing from each other for very little gain.
+template <typename TaskQueue_T>
+inline uint32_t get_priority_bucket(const TaskQueue_T &queue) {
+	if (queue.has_staged_tasks) {
+		return 0xffffff;
+	}
+	return queue.top_priority >> 8;
+}
+
+} // namespace
+
+ThreadedTaskRunner::PickResult ThreadedTaskRunner::pick_task(
+		const uint32_t thread_index,
+		TaskItem &out_item,
+		StdVector<IThreadedTask *> &cancelled_tasks
+) {
+	const uint32_t queue_count = get_queue_count();
+	const uint32_t own_queue_index = thread_index < queue_count ? thread_index : 0;
+
+	while (true) {
+		// Find which queue has the most important tasks, without locking
+		int best_queue_index = -1;
+		uint32_t best_bucket = 0;
+
+		for (uint32_t i = 0; i < queue_count; ++i) {
+			const TaskQueue &queue = _queues[i];
+			if (queue.size == 0) {
+				continue;
+			}
+			const uint32_t bucket = get_priority_bucket(queue);
+			if (best_queue_index == -1 || bucket > best_bucket || (bucket == best_bucket && i == own_queue_index)) {
+				best_queue_index = i;
+				best_bucket = bucket;
+			}
+		}
+
+		bool serial_blocked = false;
+		if (_serial_tasks.size != 0) {
+			if (_serial_tasks_blocked) {
+				serial_blocked = true;
+
+			} else if (best_queue_index == -1 || get_priority_bucket(_serial_tasks) >= best_bucket) {
+				// Serial tasks win ties, otherwise they would never run while threads have other tasks of similar
+				// priority to do
+				MutexLock lock(_serial_tasks.tasks_mutex);
+				// Serial tasks are a bit annoying...
+				// We could make the save/load tasks accept more than one work, which is the best way to do serial
+				// work, but in some cases it's harder to know in advance...
+				if (pop_task(_serial_tasks, out_item, cancelled_tasks, true)) {
+					_running_serial_keys.push_back(out_item.serial_key);
+					return PICK_TASK;
+				}
+				if (_serial_tasks.size == 0 || _serial_tasks.has_staged_tasks || _running_serial_keys.size() == 0) {
+					// Tasks got picked or cancelled in the meantime, or were not moved out of staging yet
+					continue;
+				}
+				// All waiting serial tasks have a key already used by a running task. Releasing that key will unblock
+				// them.
+				_serial_tasks_blocked = true;
+				serial_blocked = true;
+			}
+		}
+
+		if (best_queue_index == -1) {
+			return serial_blocked ? PICK_BLOCKED : PICK_EMPTY;
+		}
+
+		TaskQueue &queue = _queues[best_queue_index];
+
+		if (static_cast<uint32_t>(best_queue_index) == own_queue_index) {
+			MutexLock lock(queue.tasks_mutex);
+			if (pop_task(queue, out_item, cancelled_tasks, false)) {
+				return PICK_TASK;
+			}
+
+		} else if (queue.tasks_mutex.try_lock()) {
+			// Steal from another thread
+			const bool popped = pop_task(queue, out_item, cancelled_tasks, false);
+			queue.tasks_mutex.unlock();
+			if (popped) {
+				return PICK_TASK;
+			}
+
+		} else {
+			// Another thread is picking from it, fallback on our own queue if any
+			TaskQueue &own_queue = _queues[own_queue_index];
+			if (own_queue.size != 0) {
+				MutexLock lock(own_queue.tasks_mutex);
+				if (pop_task(own_queue, out_item, cancelled_tasks, false)) {
+					return PICK_TASK;
+				}
+			} else {
+				MutexLock lock(queue.tasks_mutex);
+				if (pop_task(queue, out_item, cancelled_tasks, false)) {
+					return PICK_TASK;
+				}
+			}
+		}
+		// Tasks got picked by other threads in the meantime, or were cancelled. Try again.
+	}
+}
+
+// Must be called with the serial tasks mutex locked.
+bool ThreadedTaskRunner::is_serial_key_running(const void *key) const {
+	for (const void *running_key : _running_serial_keys) {
+		if (running_key == key) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool ThreadedTaskRunner::has_waiting_tasks() {
+	for (uint32_t i = 0; i < _queues.size(); ++i) {
+		if (_queues[i].size != 0) {
+			return true;
+		}
+	}
+	return _serial_tasks.size != 0;
+}
+
 void ThreadedTaskRunner::thread_func_static(void *p_data) {
 	ThreadData &data = *static_cast<ThreadData *>(p_data);
 	ThreadedTaskRunner &pool = *data.pool;
@@ -158,7 +452,7 @@ void ThreadedTaskRunner::thread_func_static(void *p_data) {
 	if (!data.name.empty()) {
 		Thread::set_name(data.name.c_str());
 
-#ifdef ZN_PROFILER_ENABLED
+#if defined(ZN_PROFILER_ENABLED) || defined(ZN_PROFILER_TRACE_RECORDER)
 		ZN_PROFILE_SET_THREAD_NAME(data.name.c_str());
 #endif
 	}
@@ -174,8 +468,7 @@ void ThreadedTaskRunner::thread_func(ThreadData &data) {
 	StdVector<IThreadedTask *> cancelled_tasks;
 
 	while (!data.stop) {
-		bool is_running_serial_task = false;
-		bool task_queue_was_empty = false;
+		PickResult pick_result = PICK_EMPTY;
 		{
 			ZN_PROFILE_SCOPE_NAMED("Task pickup");
 
@@ -184,118 +477,51 @@ void ThreadedTaskRunner::thread_func(ThreadData &data) {
 			ZN_ASSERT(tasks.size() == 0);
 
 			// Pick a postponed task if any.
-			// We will still run a task from the main prioritized queue as well so postponed tasks will not
+			// We will still run a task from the prioritized queues as well so postponed tasks will not
 			// monopolize execution.
 			//
 			// TODO What if postponed tasks remain while one big task is locking what they need to access?
 			// Those postponed tasks will sort of spinlock with no sleeping. Is that a bad thing?
+			bool spinning_task_blocked = false;
 			{
 				MutexLock lock2(_spinning_tasks_mutex);
 				if (_spinning_tasks.size() > 0) {
-					tasks.push_back(_spinning_tasks.front());
+					const TaskItem item = _spinning_tasks.front();
 					_spinning_tasks.pop();
-				}
-			}
-
-			{
-				// TODO When tasks are very short and there are a lot of tasks, one thread can monopolize this mutex.
-				//
-				MutexLock lock(_tasks_mutex);
-
-				// Move tasks from the staging queue.
-				// Lock with minimal risk of blocking the main thread, it should be very short.
-				if (_staged_tasks_mutex.try_lock()) {
-					append_array(_tasks, _staged_tasks);
-					_staged_tasks.clear();
-					_staged_tasks_mutex.unlock();
-				}
-
-				// Pick best tasks from the prioritized queue
-				if (_tasks.size() != 0) {
-					// Sort periodically.
-					// The point to keep sorting after tasks have been inserted is in case there are lots of pending
-					// tasks, which can take more than a few seconds to be processed. A player can move fast and the
-					// priority location can change. Some tasks can even become irrelevant before they are run,so we
-					// may remove them from the list so they don't slow down the process.
-					const uint64_t now = Time::get_singleton()->get_ticks_msec();
-					if (now - _last_priority_update_time_ms > _priority_update_period_ms) {
-						ZN_PROFILE_SCOPE_NAMED("Sorting");
-
-						{
-							ZN_PROFILE_SCOPE_NAMED("Update priorities");
-							for (unsigned int i = 0; i < _tasks.size();) {
-								TaskItem &item = _tasks[i];
-								item.cached_priority = item.task->get_priority();
-
-								if (item.task->is_cancelled()) {
-									cancelled_tasks.push_back(item.task);
-									_tasks[i] = _tasks.back();
-									_tasks.pop_back();
-									continue;
-								}
-
-								++i;
-							}
-						}
-
-						struct TaskComparator {
-							inline bool operator()(const TaskItem &a, const TaskItem &b) const {
-								// Tasks with highest priority come last (easier pop back)
-								return a.cached_priority < b.cached_priority;
-							}
-						};
-						SortArray<TaskItem, TaskComparator> sorter;
-						sorter.sort(_tasks.data(), _tasks.size());
-
-						_last_priority_update_time_ms = Time::get_singleton()->get_ticks_msec();
-					}
-
-					// Pick task with highest priority if possible
-					// for (int i = int(_tasks.size()) - 1; i >= 0; --i) {
-					for (unsigned int i = _tasks.size(); i-- > 0;) {
-						const TaskItem item = _tasks[i];
-						// Serial tasks are a bit annoying in that regard...
-						// We could make the save/load tasks accept more than one work, which is the best way to do
-						// serial work, but in some cases it's harder to know in advance...
-						if (item.is_serial && _is_serial_task_running) {
-							// Try previous task
-							continue;
-						}
-
+					if (item.serial_key == nullptr) {
 						tasks.push_back(item);
-						// We don't just pop the last item because of serial task handling. But ordered removal should
-						// be fast enough since serial tasks aren't common.
-						_tasks.erase(_tasks.begin() + i);
-						break;
-					}
-
-				} // For each task to pick
-
-				// If we picked up a serial task, we must set the shared boolean to `true`.
-				// More than one serial task can be in the list of tasks the current thread picks up,
-				// so we update the boolean after picking them all.
-				// This must be the only place it can be set to `true`, and is guarded by mutex.
-				if (_is_serial_task_running == false) { // Only an optimization, this doesnt actually do thread-safety
-					for (unsigned int i = 0; i < tasks.size(); ++i) {
-						if (tasks[i].is_serial) {
-							// Write to member var so all threads can check this
-							_is_serial_task_running = true;
-							// Write to thread-local variable so we know it is the current thread
-							is_running_serial_task = true;
-							break;
+					} else {
+						MutexLock lock3(_serial_tasks.tasks_mutex);
+						if (is_serial_key_running(item.serial_key)) {
+							// Try again later
+							_spinning_tasks.push(item);
+							spinning_task_blocked = true;
+						} else {
+							_running_serial_keys.push_back(item.serial_key);
+							tasks.push_back(item);
 						}
 					}
 				}
+			}
 
-				task_queue_was_empty = _tasks.size() == 0;
+			TaskItem item;
+			pick_result = pick_task(data.index, item, cancelled_tasks);
+			if (pick_result == PICK_TASK) {
+				// If the task is serial, `pick_task` marked its key as running for us
+				tasks.push_back(item);
 
-			} // Tasks queue mutex lock
+			} else if (pick_result == PICK_EMPTY && spinning_task_blocked) {
+				// Don't wait for new tasks, the postponed task must be retried
+				pick_result = PICK_BLOCKED;
+			}
 		}
 
 		if (cancelled_tasks.size() > 0) {
 			MutexLock lock(_completed_tasks_mutex);
 			const size_t count = cancelled_tasks.size();
-			append_array(_completed_tasks, cancelled_tasks);
+			for (IThreadedTask *task : cancelled_tasks) {
+				_completed_tasks.push_back(CompletedTask{ task, 0 });
+			}
 			_debug_completed_tasks += count;
 			cancelled_tasks.clear();
 		}
@@ -303,7 +529,7 @@ void ThreadedTaskRunner::thread_func(ThreadData &data) {
 		// print_line(String("Processing {0} tasks").format(varray(tasks.size())));
 
 		if (tasks.empty()) {
-			if (task_queue_was_empty) {
+			if (pick_result == PICK_EMPTY) {
 				// The task queue is empty, will wait until more tasks are posted.
 				// If a task is posted between the moment we last checked the queue and now,
 				// the semaphore will have one count to decrement and we'll not stop here.
@@ -316,8 +542,8 @@ void ThreadedTaskRunner::thread_func(ThreadData &data) {
 				data.waiting = false;
 
 			} else {
-				// The current thread was not allowed to pick tasks currently in the queue (they could be serial and one
-				// is already running). So we'll wait for a very short time before retrying.
+				// The current thread was not allowed to pick tasks currently in the queue (they could be serial and
+				// others with the same key are already running). So we'll wait for a very short time before retrying.
 				// (alternative would be to post the semaphore after each serial task?)
 				Thread::sleep_usec(1000);
 			}
@@ -329,10 +555,31 @@ void ThreadedTaskRunner::thread_func(ThreadData &data) {
 			for (size_t i = 0; i < tasks.size(); ++i) {
 				TaskItem &item = tasks[i];
 
-				if (!item.task->is_cancelled()) {
+				if (item.task->is_cancelled()) {
+					// Not worth recording
+					item.enqueue_time_usec = 0;
+
+				} else {
 					ThreadedTaskContext ctx(data.index, item.cached_priority);
-					data.debug_running_task_name = item.task->get_debug_name();
+					const char *task_name = item.task->get_debug_name();
+					data.debug_running_task_name = task_name;
+
+					const uint64_t start_time_usec = get_time_usec();
 					item.task->run(ctx);
+					const uint64_t end_time_usec = get_time_usec();
+
+					// The task must not be accessed after being taken out, but we got its name before
+					_latency_stats.record(
+							data.index,
+							task_name,
+							TaskLatencyStats::METRIC_WAIT,
+							start_time_usec - math::min(item.queued_time_usec, start_time_usec)
+					);
+					_latency_stats.record(
+							data.index, task_name, TaskLatencyStats::METRIC_RUN, end_time_usec - start_time_usec
+					);
+					item.queued_time_usec = end_time_usec;
+
 #ifdef ZN_THREADED_TASK_RUNNER_CHECK_DUPLICATE_TASKS
 					if (ctx.status == ThreadedTaskContext::STATUS_TAKEN_OUT) {
 						debug_remove_owned_task(item.task);
@@ -354,13 +601,15 @@ void ThreadedTaskRunner::thread_func(ThreadData &data) {
 				}
 			}
 
-			// If the current thread just ran serial tasks
-			if (is_running_serial_task) {
-				ZN_ASSERT(_is_serial_task_running);
-				// Reset back the boolean so any thread can pick serial tasks now.
-				// This is the only place we set it to `false`, and can only be `true` already when that happens,
-				// so locking the mutex should not be necessary.
-				_is_serial_task_running = false;
+			// If the current thread just ran serial tasks, release their keys so any thread can pick tasks having
+			// them now
+			for (const TaskItem &item : tasks) {
+				if (item.serial_key != nullptr) {
+					MutexLock lock(_serial_tasks.tasks_mutex);
+					const bool removed = unordered_remove_value(_running_serial_keys, item.serial_key);
+					ZN_ASSERT(removed);
+					_serial_tasks_blocked = false;
+				}
 			}
 
 			{
@@ -369,7 +618,7 @@ void ThreadedTaskRunner::thread_func(ThreadData &data) {
 					const TaskItem &item = tasks[i];
 					switch (item.status) {
 						case ThreadedTaskContext::STATUS_COMPLETE:
-							_completed_tasks.push_back(item.task);
+							_completed_tasks.push_back(CompletedTask{ item.task, item.enqueue_time_usec });
 							++_debug_completed_tasks;
 							break;
 
@@ -415,18 +664,10 @@ void ThreadedTaskRunner::wait_for_all_tasks() {
 	while (true) {
 		// TODO this is not really precise, because running tasks can schedule more tasks. Not sure if we need it?
 		// Waiting for all threads to be in waiting state is a more definitive solution.
-		bool any_staged_tasks = false;
-		{
-			MutexLock lock3(_staged_tasks_mutex);
-			any_staged_tasks = _staged_tasks.size() > 0;
-		}
-		if (!any_staged_tasks) {
-			MutexLock lock(_tasks_mutex);
-			if (_tasks.size() == 0) {
-				MutexLock lock2(_spinning_tasks_mutex);
-				if (_spinning_tasks.size() == 0) {
-					break;
-				}
+		if (!has_waiting_tasks()) {
+			MutexLock lock2(_spinning_tasks_mutex);
+			if (_spinning_tasks.size() == 0) {
+				break;
 			}
 		}
 
@@ -478,9 +719,34 @@ unsigned int ThreadedTaskRunner::get_debug_remaining_tasks() const {
 	return _debug_received_tasks - _debug_completed_tasks - _debug_taken_out_tasks;
 }
 
-StdVector<IThreadedTask *> &ThreadedTaskRunner::get_completed_tasks_temp_tls() {
-	static thread_local StdVector<IThreadedTask *> tls_temp;
+StdVector<ThreadedTaskRunner::CompletedTask> &ThreadedTaskRunner::get_completed_tasks_temp_tls() {
+	static thread_local StdVector<CompletedTask> tls_temp;
 	return tls_temp;
 }
 
+uint64_t ThreadedTaskRunner::get_time_usec() {
+	return Time::get_singleton()->get_ticks_usec();
+}
+
+void ThreadedTaskRunner::record_applied_task(
+		const char *name,
+		const uint64_t enqueue_time_usec,
+		const uint64_t apply_begin_time_usec
+) {
+	const uint64_t now_usec = get_time_usec();
+	// The last slot is reserved to the thread dequeuing completed tasks
+	_latency_stats.record(MAX_THREADS, name, TaskLatencyStats::METRIC_APPLY, now_usec - apply_begin_time_usec);
+	_latency_stats.record(
+			MAX_THREADS, name, TaskLatencyStats::METRIC_TOTAL, now_usec - math::min(enqueue_time_usec, now_usec)
+	);
+}
+
+void ThreadedTaskRunner::get_task_latency_stats(StdVector<TaskLatencyStats::TaskTypeStats> &out_stats) const {
+	_latency_stats.get_stats(out_stats);
+}
+
+void ThreadedTaskRunner::clear_task_latency_stats() {
+	_latency_stats.clear();
+}
+
 } // namespace zylann
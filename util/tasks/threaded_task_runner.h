@@ -11,6 +11,8 @@
 #include "../thread/mutex.h"
 #include "../thread/semaphore.h"
 #include "../thread/thread.h"
+#include "task_latency_stats.h"
+#include "task_priority_queue.h"
 #include "threaded_task.h"
 
 // For debugging
@@ -60,18 +62,20 @@ public:
 
 	// Schedules a task.
 	// Ownership is NOT passed to the pool, so make sure you get them back when completed if you want to delete them.
-	// All tasks scheduled with `serial=true` will run one after the other, using one thread at a time.
-	// Tasks scheduled with `serial=false` can run in parallel using multiple threads.
+	// Tasks scheduled with `serial=true` run one at a time among those returning the same `get_serial_key()`. Tasks
+	// without a key all share the same group. Tasks with different keys can run in parallel.
+	// Tasks scheduled with `serial=false` can run in parallel using multiple threads, unless they have a serial key.
 	// Serial execution is useful when such tasks cannot run in parallel due to locking a shared resource. This avoids
 	// clogging up all threads with waiting tasks.
 	void enqueue(IThreadedTask *task, bool serial);
 	// Schedules multiple tasks at once. Involves less internal locking.
 	void enqueue(Span<IThreadedTask *> new_tasks, bool serial);
 
+	// Must be called from one thread at a time (usually the main thread).
 	template <typename F>
 	void dequeue_completed_tasks(F f) {
 		ZN_PROFILE_SCOPE();
-		StdVector<IThreadedTask *> &temp = get_completed_tasks_temp_tls();
+		StdVector<CompletedTask> &temp = get_completed_tasks_temp_tls();
 		ZN_ASSERT(temp.size() == 0);
 		{
 			MutexLock lock(_completed_tasks_mutex);
@@ -80,11 +84,21 @@ public:
 			// std::move doesn't guarantee preservation of vector capacity
 			// temp = std::move(_completed_tasks);
 		}
-		for (IThreadedTask *task : temp) {
+		for (const CompletedTask &completed_task : temp) {
+			IThreadedTask *task = completed_task.task;
 #ifdef ZN_THREADED_TASK_RUNNER_CHECK_DUPLICATE_TASKS
 			debug_remove_owned_task(task);
 #endif
+			if (completed_task.enqueue_time_usec == 0) {
+				// Cancelled
+				f(task);
+				continue;
+			}
+			// Get it before, the task may be destroyed by `f`
+			const char *name = task->get_debug_name();
+			const uint64_t apply_begin_time_usec = get_time_usec();
 			f(task);
+			record_applied_task(name, completed_task.enqueue_time_usec, apply_begin_time_usec);
 		}
 		temp.clear();
 	}
@@ -92,18 +106,39 @@ public:
 	// Blocks and wait for all tasks to finish (assuming no more are getting added!)
 	void wait_for_all_tasks();
 
+	// Tells if tasks are waiting to be picked by a thread
+	bool has_waiting_tasks();
+
 	State get_thread_debug_state(uint32_t i) const;
 	const char *get_thread_debug_task_name(unsigned int thread_index) const;
 	unsigned int get_debug_remaining_tasks() const;
 
+	// Gets how long tasks waited, ran and were applied, per type of task
+	void get_task_latency_stats(StdVector<TaskLatencyStats::TaskTypeStats> &out_stats) const;
+	void clear_task_latency_stats();
+
 private:
-	static StdVector<IThreadedTask *> &get_completed_tasks_temp_tls();
+	struct CompletedTask {
+		IThreadedTask *task;
+		// Zero if the task was cancelled
+		uint64_t enqueue_time_usec;
+	};
+
+	static StdVector<CompletedTask> &get_completed_tasks_temp_tls();
+	static uint64_t get_time_usec();
+
+	void record_applied_task(const char *name, uint64_t enqueue_time_usec, uint64_t apply_begin_time_usec);
 
 	struct TaskItem {
 		IThreadedTask *task = nullptr;
 		TaskPriority cached_priority;
-		bool is_serial = false;
+		// Not null if the task is serial
+		const void *serial_key = nullptr;
 		ThreadedTaskContext::Status status = ThreadedTaskContext::STATUS_COMPLETE;
+		// When the task was scheduled
+		uint64_t enqueue_time_usec = 0;
+		// When the task was last put in a queue. Differs from enqueue time if the task got postponed.
+		uint64_t queued_time_usec = 0;
 	};
 
 	struct ThreadData {
@@ -127,12 +162,54 @@ private:
 		}
 	};
 
+	// Waiting tasks. Each thread has one, and can steal tasks from the others when they have higher priority or when
+	// its own is empty. This spreads locking over many mutexes instead of one, which otherwise becomes a bottleneck
+	// with a lot of threads and tasks.
+	struct TaskQueue {
+		// Scheduled tasks are put here first. They will be moved to the priority queue by the next thread picking
+		// from this queue, which also computes their priority. This is because the priority queue can be locked for
+		// longer due to priority updates.
+		StdVector<TaskItem> staged_tasks;
+		Mutex staged_tasks_mutex;
+
+		// Tasks bucketed by cached priority. Priority can change while tasks are in there, so they are
+		// periodically re-evaluated, and those whose priority changed are moved to another bucket.
+		TaskPriorityQueue<TaskItem> tasks;
+		Mutex tasks_mutex;
+		uint64_t last_priority_update_time_ms = 0;
+
+		// Published so threads can choose where to pick tasks from without locking.
+		// Includes staged tasks.
+		std::atomic_uint32_t size = { 0 };
+		std::atomic_uint32_t top_priority = { 0 };
+		// Staged tasks have unknown priority, so they are moved to the priority queue as soon as possible
+		std::atomic_bool has_staged_tasks = { false };
+	};
+
+	enum PickResult { //
+		PICK_TASK,
+		// No task is waiting
+		PICK_EMPTY,
+		// Only serial tasks are waiting, and tasks with the same keys are already running
+		PICK_BLOCKED
+	};
+
 	static void thread_func_static(void *p_data);
 	void thread_func(ThreadData &data);
 
 	void create_thread(ThreadData &d, uint32_t i);
 	void destroy_all_threads();
 
+	inline uint32_t get_queue_count() const {
+		// There is always at least one queue so tasks can be scheduled before threads are created
+		return _thread_count > 0 ? _thread_count : 1;
+	}
+
+	void push_tasks(TaskQueue &queue, Span<IThreadedTask *> new_tasks, bool serial);
+	PickResult pick_task(uint32_t thread_index, TaskItem &out_item, StdVector<IThreadedTask *> &cancelled_tasks);
+	bool pop_task(TaskQueue &queue, TaskItem &out_item, StdVector<IThreadedTask *> &cancelled_tasks, bool serial);
+	bool is_serial_key_running(const void *key) const;
+
 #ifdef ZN_THREADED_TASK_RUNNER_CHECK_DUPLICATE_TASKS
 	void debug_add_owned_task(IThreadedTask *task);
 	void debug_remove_owned_task(IThreadedTask *task);
@@ -141,35 +218,34 @@ private:
 	FixedArray<ThreadData, MAX_THREADS> _threads;
 	uint32_t _thread_count = 0;
 
-	// Scheduled tasks are put here first. They will be moved to the main waiting queue by the next available thread.
-	// This is because the main waiting queue can be locked for longer due to dynamic priority sorting.
-	StdVector<TaskItem> _staged_tasks;
-	Mutex _staged_tasks_mutex;
-
-	// Main waiting list. Tasks are picked from it by priority. Priority can also change while tasks are in this list,
-	// so we can't use a simple queue or sort at insertion. Every available thread has to find it and potentially update
-	// it every once in a while.
-	StdVector<TaskItem> _tasks;
-	Mutex _tasks_mutex;
+	FixedArray<TaskQueue, MAX_THREADS> _queues;
+	// Where the next scheduled tasks will go. Tasks are distributed to queues in round-robin.
+	std::atomic_uint32_t _next_queue_index = { 0 };
 	Semaphore _tasks_semaphore;
 
+	// Tasks marked as "serial" have their own queue, since only one of them can run at a time per serial key.
+	TaskQueue _serial_tasks;
+	// Serial keys of tasks currently running. Protected by the mutex of the serial task queue.
+	StdVector<const void *> _running_serial_keys;
+	// Set when all waiting serial tasks have a key that is already running, so threads don't need to look them up
+	// until a key is released or new serial tasks are scheduled.
+	std::atomic_bool _serial_tasks_blocked = { false };
+
 	// Ongoing tasks that may take more than one iteration
 	StdQueue<TaskItem> _spinning_tasks;
 	Mutex _spinning_tasks_mutex;
 
-	StdVector<IThreadedTask *> _completed_tasks;
+	StdVector<CompletedTask> _completed_tasks;
 	Mutex _completed_tasks_mutex;
 
-	uint32_t _priority_update_period_ms = 32;
-	uint64_t _last_priority_update_time_ms = 0;
+	// One slot per thread, plus one for the thread dequeuing completed tasks
+	TaskLatencyStats _latency_stats;
 
-	// This boolean is also guarded with `_tasks_mutex`.
-	// Tasks marked as "serial" must be executed by only one thread at a time.
-	bool _is_serial_task_running = false;
+	uint32_t _priority_update_period_ms = 32;
 
 	StdString _name;
 
-	unsigned int _debug_received_tasks = 0;
+	std::atomic_uint32_t _debug_received_tasks = { 0 };
 	unsigned int _debug_completed_tasks = 0;
 	unsigned int _debug_taken_out_tasks = 0;
 
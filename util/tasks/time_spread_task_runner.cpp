@@ -65,6 +65,10 @@ void TimeSpreadTaskRunner::process(uint64_t time_budget_usec) {
 			ZN_DELETE(task);
 		}
 
+		if (ctx.stop) {
+			break;
+		}
+
 	} while (time.get_ticks_usec() - time_before < time_budget_usec);
 
 	// Push postponed task back into queues
@@ -14,6 +14,9 @@ struct TimeSpreadTaskContext {
 	// it will be re-scheduled to run again, the next time the runner is processed.
 	// Otherwise, the task will be destroyed after it runs.
 	bool postpone = false;
+	// If this is set to `true` by a task, the runner won't run more tasks until the next time it is processed.
+	// Can be used when tasks are limited by other time budgets than the one given to the runner.
+	bool stop = false;
 };
 
 class ITimeSpreadTask {
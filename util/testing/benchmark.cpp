@@ -0,0 +1,105 @@
+#include "benchmark.h"
+#include "../errors.h"
+#include "../io/log.h"
+#include "../math/funcs.h"
+#include "../string/format.h"
+#include "../string/std_stringstream.h"
+#include <algorithm>
+
+namespace zylann::testing {
+
+double BenchmarkRunner::Result::get_units_per_second() const {
+	if (median_usec == 0) {
+		return 0.0;
+	}
+	return static_cast<double>(units_per_iteration) * 1'000'000.0 / static_cast<double>(median_usec);
+}
+
+BenchmarkRunner::BenchmarkRunner(const TestOptions &options, unsigned int iterations) :
+		_options(options), _iterations(math::max(iterations, 1u)) {}
+
+bool BenchmarkRunner::can_run(const char *name) const {
+	return _options.can_run_print(name);
+}
+
+void BenchmarkRunner::add_result(
+		const char *name,
+		const char *unit,
+		uint64_t units_per_iteration,
+		Span<const uint64_t> durations_usec
+) {
+	ZN_ASSERT_RETURN(durations_usec.size() > 0);
+
+	StdVector<uint64_t> sorted_durations;
+	sorted_durations.resize(durations_usec.size());
+	for (unsigned int i = 0; i < durations_usec.size(); ++i) {
+		sorted_durations[i] = durations_usec[i];
+	}
+	std::sort(sorted_durations.begin(), sorted_durations.end());
+
+	Result result;
+	result.name = name;
+	result.unit = unit;
+	result.units_per_iteration = units_per_iteration;
+	result.iterations = sorted_durations.size();
+	result.min_usec = sorted_durations.front();
+	result.median_usec = sorted_durations[sorted_durations.size() / 2];
+	result.max_usec = sorted_durations.back();
+	_results.push_back(result);
+}
+
+void BenchmarkRunner::add_skipped(const char *name, const char *reason) {
+	Result result;
+	result.name = name;
+	result.skip_reason = reason;
+	_results.push_back(result);
+	print_line(format("Skipping benchmark `{}`: {}", name, reason));
+}
+
+void BenchmarkRunner::print_results() const {
+	for (const Result &result : _results) {
+		if (!result.skip_reason.empty()) {
+			continue;
+		}
+		print_line(format(
+				"{}: {} {}/s (median {} us, min {} us, max {} us)",
+				result.name,
+				static_cast<uint64_t>(result.get_units_per_second()),
+				result.unit,
+				result.median_usec,
+				result.min_usec,
+				result.max_usec
+		));
+	}
+}
+
+void BenchmarkRunner::get_json(FwdMutableStdString out_json) const {
+	// Names are identifiers chosen in code, they don't need escaping
+	StdStringStream ss;
+	ss << "{\"version\":1,\"iterations\":" << _iterations << ",\"benchmarks\":[";
+
+	for (unsigned int i = 0; i < _results.size(); ++i) {
+		const Result &result = _results[i];
+		if (i > 0) {
+			ss << ",";
+		}
+		ss << "{\"name\":\"" << result.name << "\"";
+		if (!result.skip_reason.empty()) {
+			ss << ",\"skipped\":\"" << result.skip_reason << "\"}";
+			continue;
+		}
+		ss << ",\"unit\":\"" << result.unit << "\"";
+		ss << ",\"units_per_iteration\":" << result.units_per_iteration;
+		ss << ",\"iterations\":" << result.iterations;
+		ss << ",\"min_usec\":" << result.min_usec;
+		ss << ",\"median_usec\":" << result.median_usec;
+		ss << ",\"max_usec\":" << result.max_usec;
+		ss << ",\"units_per_second\":" << static_cast<uint64_t>(result.get_units_per_second());
+		ss << "}";
+	}
+
+	ss << "]}";
+	out_json.s = ss.str();
+}
+
+} // namespace zylann::testing
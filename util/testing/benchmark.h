@@ -0,0 +1,86 @@
+#ifndef ZN_BENCHMARK_H
+#define ZN_BENCHMARK_H
+
+#include "../containers/std_vector.h"
+#include "../profiling_clock.h"
+#include "../string/fwd_std_string.h"
+#include "../string/std_string.h"
+#include "test_options.h"
+#include <cstdint>
+
+namespace zylann::testing {
+
+// Runs benchmarks and collects their timings, so they can be compared between versions.
+// Each benchmark runs a function a fixed number of times after a warmup run, and reports how many units of work (such
+// as blocks) it processed per second, based on the median time. Benchmarks are expected to use fixed seeds and inputs,
+// so results only vary with performance of the code and the machine.
+class BenchmarkRunner {
+public:
+	static constexpr unsigned int DEFAULT_ITERATIONS = 10;
+
+	struct Result {
+		StdString name;
+		// What a unit of work is, like "blocks"
+		const char *unit = "";
+		uint64_t units_per_iteration = 0;
+		uint32_t iterations = 0;
+		uint64_t min_usec = 0;
+		uint64_t median_usec = 0;
+		uint64_t max_usec = 0;
+		// Empty if the benchmark ran, otherwise tells why it didn't
+		StdString skip_reason;
+
+		double get_units_per_second() const;
+	};
+
+	BenchmarkRunner(const TestOptions &options, unsigned int iterations);
+
+	// Runs `f()` multiple times and records how long it takes. `f` must process `units_per_iteration` units every time
+	// it is called.
+	template <typename F>
+	void run(const char *name, const char *unit, uint64_t units_per_iteration, F f) {
+		if (!_options.can_run_print(name)) {
+			return;
+		}
+		// Warmup, so first-time allocations and caches don't skew results
+		f();
+
+		_durations_usec.clear();
+		for (unsigned int i = 0; i < _iterations; ++i) {
+			ProfilingClock clock;
+			f();
+			_durations_usec.push_back(clock.get_elapsed_microseconds());
+		}
+		add_result(name, unit, units_per_iteration, to_span_const(_durations_usec));
+	}
+
+	// For benchmarks which can't be repeated easily and measure themselves
+	void add_result(const char *name, const char *unit, uint64_t units_per_iteration, Span<const uint64_t> durations_usec);
+	void add_skipped(const char *name, const char *reason);
+
+	// Tells if a benchmark measuring itself should run
+	bool can_run(const char *name) const;
+
+	unsigned int get_iterations() const {
+		return _iterations;
+	}
+
+	const StdVector<Result> &get_results() const {
+		return _results;
+	}
+
+	void print_results() const;
+
+	// Results are written in the order benchmarks ran, with a fixed layout so files can be diffed and parsed by tools
+	void get_json(FwdMutableStdString out_json) const;
+
+private:
+	const TestOptions &_options;
+	unsigned int _iterations;
+	StdVector<Result> _results;
+	StdVector<uint64_t> _durations_usec;
+};
+
+} // namespace zylann::testing
+
+#endif // ZN_BENCHMARK_H
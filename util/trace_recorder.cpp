@@ -0,0 +1,267 @@
+#include "trace_recorder.h"
+#include "containers/std_vector.h"
+#include "errors.h"
+#include "godot/classes/time.h"
+#include "math/funcs.h"
+#include "memory/memory.h"
+#include "string/std_string.h"
+#include "string/std_stringstream.h"
+#include "thread/mutex.h"
+#include <sstream>
+
+namespace zylann::trace_recorder {
+
+namespace detail {
+std::atomic_bool g_enabled = { false };
+} // namespace detail
+
+namespace {
+
+struct Event {
+	const char *name;
+	uint64_t time_usec;
+	// Duration for scopes, value for plots
+	int64_t value;
+	EventType type;
+};
+
+struct ThreadBuffer {
+	// Ring buffer only written by the owning thread. Allocated when the thread records its first event.
+	StdVector<Event> events;
+	// Total number of events written so far. The last `events.size()` ones are available.
+	std::atomic_uint64_t write_count = { 0 };
+	// Used as thread ID in traces
+	uint32_t index = 0;
+	// Protected by the registry mutex
+	StdString name;
+	// False once the owning thread ended, in which case the buffer can be given to another thread. Protected by the
+	// registry mutex.
+	bool in_use = true;
+};
+
+struct Registry {
+	Mutex mutex;
+	StdVector<UniquePtr<ThreadBuffer>> buffers;
+	uint32_t buffer_capacity = 32 * 1024;
+	// Events before this time are ignored. Clearing is done this way, so we don't have to synchronize with threads
+	// writing in their buffers.
+	std::atomic_uint64_t clear_time_usec = { 0 };
+};
+
+Registry &get_registry() {
+	static Registry s_registry;
+	return s_registry;
+}
+
+// Gives back the buffer of a thread when it ends
+struct ThreadBufferHandle {
+	ThreadBuffer *buffer = nullptr;
+
+	~ThreadBufferHandle() {
+		if (buffer != nullptr) {
+			Registry &registry = get_registry();
+			MutexLock mlock(registry.mutex);
+			buffer->in_use = false;
+		}
+	}
+};
+
+ThreadBuffer &get_thread_buffer() {
+	// Buffers are not destroyed when their thread ends, so their events can still be dumped. They get reused by the
+	// next thread that needs one, so threads that come and go don't keep adding memory.
+	static thread_local ThreadBufferHandle tls_handle;
+	if (tls_handle.buffer == nullptr) {
+		Registry &registry = get_registry();
+		MutexLock mlock(registry.mutex);
+		for (UniquePtr<ThreadBuffer> &buffer : registry.buffers) {
+			if (!buffer->in_use) {
+				buffer->in_use = true;
+				buffer->name.clear();
+				// Events of the previous thread are discarded, but their memory is kept for this one
+				buffer->events.clear();
+				buffer->write_count = 0;
+				tls_handle.buffer = buffer.get();
+				return *tls_handle.buffer;
+			}
+		}
+		UniquePtr<ThreadBuffer> buffer = make_unique_instance<ThreadBuffer>();
+		buffer->index = registry.buffers.size();
+		tls_handle.buffer = buffer.get();
+		registry.buffers.push_back(std::move(buffer));
+	}
+	return *tls_handle.buffer;
+}
+
+void write_json_string(StdStringStream &ss, const char *s) {
+	ss << '"';
+	for (; *s != '\0'; ++s) {
+		const char c = *s;
+		switch (c) {
+			case '"':
+				ss << "\\\"";
+				break;
+			case '\\':
+				ss << "\\\\";
+				break;
+			default:
+				// Control characters are not expected in names
+				ss << (static_cast<unsigned char>(c) < 0x20 ? ' ' : c);
+				break;
+		}
+	}
+	ss << '"';
+}
+
+void write_event_json(StdStringStream &ss, const Event &event, const uint32_t thread_index) {
+	ss << "{\"name\":";
+	write_json_string(ss, event.name);
+	ss << ",\"ts\":" << event.time_usec << ",\"pid\":0,\"tid\":" << thread_index;
+
+	switch (event.type) {
+		case EVENT_SCOPE:
+			ss << ",\"ph\":\"X\",\"dur\":" << event.value;
+			break;
+
+		case EVENT_MESSAGE:
+			ss << ",\"ph\":\"i\",\"s\":\"t\"";
+			break;
+
+		case EVENT_FRAME:
+			ss << ",\"ph\":\"i\",\"s\":\"g\"";
+			break;
+
+		case EVENT_PLOT:
+			ss << ",\"ph\":\"C\",\"args\":{";
+			write_json_string(ss, event.name);
+			ss << ":" << event.value << "}";
+			break;
+
+		default:
+			ZN_PRINT_ERROR("Unknown event type");
+			break;
+	}
+
+	ss << "}";
+}
+
+} // namespace
+
+void set_enabled(bool enabled) {
+	detail::g_enabled = enabled;
+}
+
+void set_buffer_capacity(uint32_t event_count) {
+	Registry &registry = get_registry();
+	MutexLock mlock(registry.mutex);
+	registry.buffer_capacity = math::max(event_count, uint32_t(1));
+}
+
+uint32_t get_buffer_capacity() {
+	Registry &registry = get_registry();
+	MutexLock mlock(registry.mutex);
+	return registry.buffer_capacity;
+}
+
+void clear() {
+	get_registry().clear_time_usec = get_time_usec();
+}
+
+uint64_t get_time_usec() {
+	return Time::get_singleton()->get_ticks_usec();
+}
+
+void record(const EventType type, const char *name, const uint64_t time_usec, const int64_t value) {
+	ThreadBuffer &buffer = get_thread_buffer();
+
+	if (ZN_UNLIKELY(buffer.events.size() == 0)) {
+		Registry &registry = get_registry();
+		MutexLock mlock(registry.mutex);
+		buffer.events.resize(registry.buffer_capacity);
+	}
+
+	// Only this thread writes, no need for an atomic increment
+	const uint64_t write_count = buffer.write_count.load(std::memory_order_relaxed);
+	Event &event = buffer.events[write_count % buffer.events.size()];
+	event.name = name;
+	event.time_usec = time_usec;
+	event.value = value;
+	event.type = type;
+	buffer.write_count.store(write_count + 1, std::memory_order_release);
+}
+
+void set_thread_name(const char *name) {
+	ThreadBuffer &buffer = get_thread_buffer();
+	Registry &registry = get_registry();
+	MutexLock mlock(registry.mutex);
+	buffer.name = name;
+}
+
+void get_chrome_trace_json(FwdMutableStdString out_json, const uint64_t window_usec) {
+	Registry &registry = get_registry();
+
+	const uint64_t now_usec = get_time_usec();
+	uint64_t min_time_usec = registry.clear_time_usec;
+	if (window_usec != 0 && now_usec > window_usec) {
+		min_time_usec = math::max(min_time_usec, now_usec - window_usec);
+	}
+
+	StdStringStream ss;
+	StdVector<Event> events;
+
+	ss << "{\"traceEvents\":[";
+	bool first = true;
+
+	MutexLock mlock(registry.mutex);
+
+	for (const UniquePtr<ThreadBuffer> &buffer_ptr : registry.buffers) {
+		const ThreadBuffer &buffer = *buffer_ptr;
+
+		if (!buffer.name.empty()) {
+			if (!first) {
+				ss << ",";
+			}
+			first = false;
+			ss << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << buffer.index << ",\"args\":{\"name\":";
+			write_json_string(ss, buffer.name.c_str());
+			ss << "}}";
+		}
+
+		const uint64_t capacity = buffer.events.size();
+		if (capacity == 0) {
+			continue;
+		}
+
+		// Copy events first, because the owning thread can keep writing while we do this
+		const uint64_t end_count = buffer.write_count.load(std::memory_order_acquire);
+		const uint64_t begin_count = end_count > capacity ? end_count - capacity : 0;
+		events.clear();
+		for (uint64_t i = begin_count; i < end_count; ++i) {
+			events.push_back(buffer.events[i % capacity]);
+		}
+
+		// Discard events that may have been overwritten while we were copying them. That includes the slot following
+		// the last written event, which the owning thread may have been writing without having counted it yet.
+		const uint64_t end_count_after = buffer.write_count.load(std::memory_order_acquire);
+		const uint64_t valid_begin_count = end_count_after + 1 > capacity ? end_count_after + 1 - capacity : 0;
+		const size_t first_valid_index = valid_begin_count > begin_count ? valid_begin_count - begin_count : 0;
+
+		for (size_t i = first_valid_index; i < events.size(); ++i) {
+			const Event &event = events[i];
+			const uint64_t end_time_usec = event.type == EVENT_SCOPE ? event.time_usec + event.value : event.time_usec;
+			if (end_time_usec < min_time_usec) {
+				continue;
+			}
+			if (!first) {
+				ss << ",";
+			}
+			first = false;
+			write_event_json(ss, event, buffer.index);
+		}
+	}
+
+	ss << "],\"displayTimeUnit\":\"ms\"}";
+
+	out_json.s = ss.str();
+}
+
+} // namespace zylann::trace_recorder
@@ -0,0 +1,89 @@
+#ifndef ZN_TRACE_RECORDER_H
+#define ZN_TRACE_RECORDER_H
+
+#include "string/fwd_std_string.h"
+#include <atomic>
+#include <cstdint>
+
+namespace zylann {
+
+// Lightweight profiler which can be turned on at runtime, without having to rebuild with an external profiler.
+// Each thread records events into its own ring buffer, so only the most recent events are kept. They can be exported
+// in Chrome's trace event format, which can be opened with `chrome://tracing` or https://ui.perfetto.dev.
+// This is the backend of `ZN_PROFILE_*` macros when Tracy is not enabled.
+namespace trace_recorder {
+
+enum EventType : uint8_t {
+	// A scope with a duration
+	EVENT_SCOPE,
+	// A point in time
+	EVENT_MESSAGE,
+	// A point in time, marking the end of a frame
+	EVENT_FRAME,
+	// A value at a point in time
+	EVENT_PLOT
+};
+
+namespace detail {
+extern std::atomic_bool g_enabled;
+} // namespace detail
+
+inline bool is_enabled() {
+	return detail::g_enabled.load(std::memory_order_relaxed);
+}
+
+// Starts or stops recording. When stopped, recorded events are kept until they are cleared.
+void set_enabled(bool enabled);
+
+// Sets how many events each thread can keep before older ones get overwritten.
+// Only applies to threads that did not record anything yet.
+void set_buffer_capacity(uint32_t event_count);
+uint32_t get_buffer_capacity();
+
+// Discards events recorded so far
+void clear();
+
+// Names must have static lifetime (usually string literals)
+void record(EventType type, const char *name, uint64_t time_usec, int64_t value);
+uint64_t get_time_usec();
+
+// An internal copy of the name will be made
+void set_thread_name(const char *name);
+
+// Gets recorded events that happened in the last `window_usec` microseconds, in Chrome's trace event JSON format.
+// If `window_usec` is zero, all recorded events are returned.
+// Can be called while recording, although events recorded at the same time may not be included.
+void get_chrome_trace_json(FwdMutableStdString out_json, uint64_t window_usec);
+
+// Records the duration of a C++ scope
+class Scope {
+public:
+	inline Scope(const char *name) {
+		if (is_enabled()) {
+			_name = name;
+			_begin_time_usec = get_time_usec();
+		}
+	}
+
+	inline ~Scope() {
+		if (_name != nullptr) {
+			record(EVENT_SCOPE, _name, _begin_time_usec, get_time_usec() - _begin_time_usec);
+		}
+	}
+
+private:
+	const char *_name = nullptr;
+	uint64_t _begin_time_usec;
+};
+
+inline void record_now(const EventType type, const char *name, const int64_t value) {
+	if (is_enabled()) {
+		record(type, name, get_time_usec(), value);
+	}
+}
+
+} // namespace trace_recorder
+
+} // namespace zylann
+
+#endif // ZN_TRACE_RECORDER_H